@@ -0,0 +1,288 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/resource.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+#define BENCH_MAX_CONNS 8192
+#define BENCH_TIMEOUT_MS 5000            // Give up on connects / replies after this long
+#define BENCH_EVENTS 256
+
+// State of one benchmark connection
+typedef enum {
+    CONN_CONNECTING,
+    CONN_WAIT_REPLY,
+    CONN_DONE,                   // Reply received
+    CONN_FAILED                  // Refused, reset or closed by the server
+} ConnState;
+
+typedef struct {
+    int fd;
+    ConnState state;
+    uint64_t start_ns;
+    uint64_t connect_ns;
+    uint64_t reply_ns;
+    uint8_t rx_buf[8];           // MBAP header + function code of the reply
+    int rx_len;
+} BenchConn;
+
+// Results of one round
+typedef struct {
+    int established;
+    int replied;
+    int exceptions;              // Replies that were Modbus exceptions (e.g. 0x06 slave busy)
+    int failed;
+    int timeout;
+    uint64_t elapsed_ns;
+} BenchRound;
+
+static BenchConn g_conns[BENCH_MAX_CONNS];
+static uint64_t g_samples[BENCH_MAX_CONNS];
+
+/**
+ * Get monotonic time in nanoseconds
+ * @return Current CLOCK_MONOTONIC time (ns)
+ */
+static uint64_t bench_now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/**
+ * Compare two uint64_t (qsort)
+ * @param a: Pointer to first value
+ * @param b: Pointer to second value
+ * @return <0, 0 or >0
+ */
+static int bench_cmp_u64(const void* a, const void* b)
+{
+    uint64_t x = *(const uint64_t*)a;
+    uint64_t y = *(const uint64_t*)b;
+    return x < y ? -1 : x > y;
+}
+
+/**
+ * Print percentiles of the samples collected in g_samples
+ * @param name: Row label
+ * @param n: Number of samples
+ */
+static void bench_print_latency(const char* name, int n)
+{
+    if (n == 0) {
+        printf("  %-8s no samples\n", name);
+        return;
+    }
+    qsort(g_samples, n, sizeof(uint64_t), bench_cmp_u64);
+    printf("  %-8s p50 %8.3f ms  p90 %8.3f ms  p99 %8.3f ms  max %8.3f ms\n", name,
+           g_samples[n / 2] / 1e6, g_samples[n * 9 / 10] / 1e6,
+           g_samples[n * 99 / 100] / 1e6, g_samples[n - 1] / 1e6);
+}
+
+/**
+ * Close a connection and mark its final state
+ * @param conn: Pointer to BenchConn
+ * @param state: CONN_DONE or CONN_FAILED
+ */
+static void bench_finish(BenchConn* conn, ConnState state)
+{
+    close(conn->fd);
+    conn->fd = -1;
+    conn->state = state;
+}
+
+/**
+ * Open n connections at once, send one FC03 request on each and wait for every reply
+ * @param addr: Server address
+ * @param n: Number of connections
+ * @param unit_id: MBAP unit ID (UART index of the target bus)
+ * @param distinct: 1 = every connection reads its own register (no coalescing), 0 = all read register 0
+ * @param round: Result counters
+ * @return 0 on success, -1 on failure
+ */
+static int bench_round(const struct sockaddr_in* addr, int n, uint8_t unit_id, int distinct, BenchRound* round)
+{
+    int epfd = epoll_create1(EPOLL_CLOEXEC);
+    if (epfd < 0) {
+        perror("epoll_create1");
+        return -1;
+    }
+    memset(round, 0, sizeof(BenchRound));
+
+    uint64_t start = bench_now_ns();
+    int pending = 0;
+    for (int i = 0; i < n; i++) {
+        BenchConn* conn = &g_conns[i];
+        memset(conn, 0, sizeof(BenchConn));
+        conn->start_ns = bench_now_ns();
+        conn->fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (conn->fd < 0) {
+            perror("socket");
+            conn->state = CONN_FAILED;
+            continue;
+        }
+        int opt = 1;
+        setsockopt(conn->fd, IPPROTO_TCP, TCP_NODELAY, &opt, sizeof(opt));
+        if (connect(conn->fd, (const struct sockaddr*)addr, sizeof(*addr)) < 0 && errno != EINPROGRESS) {
+            bench_finish(conn, CONN_FAILED);
+            continue;
+        }
+
+        struct epoll_event ev;
+        ev.events = EPOLLOUT | EPOLLIN | EPOLLRDHUP;
+        ev.data.u32 = i;
+        epoll_ctl(epfd, EPOLL_CTL_ADD, conn->fd, &ev);
+        pending++;
+    }
+
+    struct epoll_event events[BENCH_EVENTS];
+    uint64_t deadline = bench_now_ns() + BENCH_TIMEOUT_MS * 1000000ULL;
+    while (pending > 0) {
+        uint64_t now = bench_now_ns();
+        if (now >= deadline) break;
+        int nfds = epoll_wait(epfd, events, BENCH_EVENTS, (int)((deadline - now) / 1000000) + 1);
+        if (nfds < 0 && errno != EINTR) break;
+
+        for (int e = 0; e < nfds; e++) {
+            BenchConn* conn = &g_conns[events[e].data.u32];
+            if (conn->fd < 0) continue;
+            now = bench_now_ns();
+
+            if (conn->state == CONN_CONNECTING) {
+                int err = 0;
+                socklen_t len = sizeof(err);
+                getsockopt(conn->fd, SOL_SOCKET, SO_ERROR, &err, &len);
+                if (err != 0 || (events[e].events & (EPOLLERR | EPOLLHUP))) {
+                    bench_finish(conn, CONN_FAILED);
+                    pending--;
+                    continue;
+                }
+                conn->connect_ns = now - conn->start_ns;
+                conn->start_ns = now;
+                round->established++;
+
+                // FC03, 1 register; transaction ID = connection index
+                uint16_t tid = (uint16_t)events[e].data.u32;
+                uint16_t reg = distinct ? tid : 0;
+                uint8_t req[12] = { tid >> 8, tid & 0xFF, 0, 0, 0, 6, unit_id, 0x03, reg >> 8, reg & 0xFF, 0, 1 };
+                if (send(conn->fd, req, sizeof(req), MSG_NOSIGNAL) != (ssize_t)sizeof(req)) {
+                    bench_finish(conn, CONN_FAILED);
+                    pending--;
+                    continue;
+                }
+                conn->state = CONN_WAIT_REPLY;
+                struct epoll_event ev;
+                ev.events = EPOLLIN | EPOLLRDHUP;
+                ev.data.u32 = events[e].data.u32;
+                epoll_ctl(epfd, EPOLL_CTL_MOD, conn->fd, &ev);
+                continue;
+            }
+
+            uint8_t buf[300];
+            ssize_t ret = recv(conn->fd, buf, sizeof(buf), 0);
+            if (ret > 0) {
+                if (conn->rx_len < (int)sizeof(conn->rx_buf)) {
+                    int take = sizeof(conn->rx_buf) - conn->rx_len;
+                    memcpy(conn->rx_buf + conn->rx_len, buf, ret < take ? ret : take);
+                }
+                conn->rx_len += ret;
+                // MBAP header + function code: enough to tell a reply (or exception) arrived
+                if (conn->rx_len >= 8) {
+                    conn->reply_ns = now - conn->start_ns;
+                    round->replied++;
+                    if (conn->rx_buf[7] & 0x80) round->exceptions++;
+                    bench_finish(conn, CONN_DONE);
+                    pending--;
+                }
+            } else if (ret == 0 || (errno != EAGAIN && errno != EINTR)) {
+                bench_finish(conn, CONN_FAILED);
+                pending--;
+            }
+        }
+    }
+    round->elapsed_ns = bench_now_ns() - start;
+
+    for (int i = 0; i < n; i++) {
+        if (g_conns[i].state == CONN_FAILED) {
+            round->failed++;
+        } else if (g_conns[i].fd >= 0) {
+            round->timeout++;
+            bench_finish(&g_conns[i], CONN_FAILED);
+        }
+    }
+    close(epfd);
+    return 0;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 3) {
+        printf("Usage: %s <ip> <port> [conns] [rounds] [unit_id] [distinct]\n", argv[0]);
+        printf("Open [conns] connections at once (default 500), send one FC03 request on each\n"
+               "and wait for the replies; repeated [rounds] times (default 5). With [distinct] = 1\n"
+               "every connection reads a different register, so the requests cannot be coalesced\n");
+        return 1;
+    }
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(atoi(argv[2]));
+    if (inet_pton(AF_INET, argv[1], &addr.sin_addr) <= 0) {
+        printf("Invalid ip: %s\n", argv[1]);
+        return 1;
+    }
+    int conns = argc > 3 ? atoi(argv[3]) : 500;
+    int rounds = argc > 4 ? atoi(argv[4]) : 5;
+    uint8_t unit_id = argc > 5 ? (uint8_t)atoi(argv[5]) : 1;
+    int distinct = argc > 6 ? atoi(argv[6]) != 0 : 0;
+    if (conns <= 0 || conns > BENCH_MAX_CONNS || rounds <= 0) {
+        printf("conns must be 1..%d, rounds > 0\n", BENCH_MAX_CONNS);
+        return 1;
+    }
+
+    struct rlimit rl;
+    if (getrlimit(RLIMIT_NOFILE, &rl) == 0 && rl.rlim_cur < (rlim_t)conns + 16) {
+        rl.rlim_cur = rl.rlim_max < (rlim_t)conns + 16 ? rl.rlim_max : (rlim_t)conns + 16;
+        setrlimit(RLIMIT_NOFILE, &rl);
+    }
+
+    printf("%d connections x %d rounds to %s:%s (unit %u, %s reads)\n", conns, rounds, argv[1], argv[2], unit_id,
+           distinct ? "distinct" : "identical");
+    int failed_rounds = 0;
+    for (int r = 0; r < rounds; r++) {
+        BenchRound round;
+        if (bench_round(&addr, conns, unit_id, distinct, &round) != 0) return 1;
+
+        printf("round %d: %d established, %d replied (%d exceptions), %d failed, %d timeout in %.1f ms (%.0f conn/s)\n",
+               r + 1, round.established, round.replied, round.exceptions, round.failed, round.timeout,
+               round.elapsed_ns / 1e6, round.established * 1e9 / round.elapsed_ns);
+        int n = 0;
+        for (int i = 0; i < conns; i++) {
+            if (g_conns[i].connect_ns) g_samples[n++] = g_conns[i].connect_ns;
+        }
+        bench_print_latency("connect", n);
+        n = 0;
+        for (int i = 0; i < conns; i++) {
+            if (g_conns[i].state == CONN_DONE) g_samples[n++] = g_conns[i].reply_ns;
+        }
+        bench_print_latency("reply", n);
+        if (round.replied != conns) failed_rounds++;
+
+        // Let the server reap the closed connections before the next storm
+        usleep(200000);
+    }
+
+    return failed_rounds == 0 ? 0 : 2;
+}
@@ -0,0 +1,127 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../modbus/modbus_crc.h"
+
+#define BENCH_MAX_LEN 256
+#define BENCH_BUF_NUM 64                 // Rotate buffers so the data is not always the same
+#define BENCH_MIN_NS 200000000ULL        // Run each case for at least 200 ms
+
+static const size_t bench_sizes[] = { 4, 8, 16, 32, 64, 128, 256 };
+
+/**
+ * Get monotonic time in nanoseconds
+ * @return Current CLOCK_MONOTONIC time (ns)
+ */
+static uint64_t bench_now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/**
+ * Compare an implementation against the bitwise reference, incl. split (streaming) updates
+ * @param fn: Implementation to check
+ * @param ref: Reference implementation
+ * @return 0 if all results match, -1 otherwise
+ */
+static int bench_verify(ModbusCrc16Fn fn, ModbusCrc16Fn ref)
+{
+    uint8_t buf[BENCH_MAX_LEN * 2];
+    for (int round = 0; round < 2000; round++) {
+        size_t len = (size_t)(rand() % (int)sizeof(buf)) + 1;
+        for (size_t i = 0; i < len; i++) {
+            buf[i] = (uint8_t)rand();
+        }
+
+        uint16_t expect = ref(MODBUS_CRC16_INIT, buf, len);
+        if (fn(MODBUS_CRC16_INIT, buf, len) != expect) {
+            printf("mismatch: len %zu\n", len);
+            return -1;
+        }
+
+        size_t split = (size_t)rand() % (len + 1);
+        uint16_t crc = fn(MODBUS_CRC16_INIT, buf, split);
+        if (fn(crc, buf + split, len - split) != expect) {
+            printf("mismatch: len %zu split at %zu\n", len, split);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * Measure average time of one CRC call
+ * @param fn: Implementation to measure
+ * @param bufs: Input buffers
+ * @param len: Buffer length
+ * @return Nanoseconds per call
+ */
+static double bench_run(ModbusCrc16Fn fn, uint8_t bufs[][BENCH_MAX_LEN], size_t len)
+{
+    volatile uint16_t sink = 0;
+    uint64_t iters = 0;
+    uint64_t start = bench_now_ns();
+    uint64_t elapsed;
+
+    do {
+        for (int n = 0; n < 10000; n++) {
+            sink ^= fn(MODBUS_CRC16_INIT, bufs[n % BENCH_BUF_NUM], len);
+        }
+        iters += 10000;
+        elapsed = bench_now_ns() - start;
+    } while (elapsed < BENCH_MIN_NS);
+
+    (void)sink;
+    return (double)elapsed / iters;
+}
+
+int main(void)
+{
+    static uint8_t bufs[BENCH_BUF_NUM][BENCH_MAX_LEN];
+    ModbusCrc16Fn ref = modbus_crc16_get_impl(MODBUS_CRC_IMPL_BITWISE);
+
+    srand(1);
+    for (int b = 0; b < BENCH_BUF_NUM; b++) {
+        for (int i = 0; i < BENCH_MAX_LEN; i++) {
+            bufs[b][i] = (uint8_t)rand();
+        }
+    }
+
+    printf("Active implementation: %s\n", modbus_crc16_impl_name(modbus_crc16_active()));
+    for (int impl = MODBUS_CRC_IMPL_TABLE; impl < MODBUS_CRC_IMPL_NUM; impl++) {
+        ModbusCrc16Fn fn = modbus_crc16_get_impl((ModbusCrcImpl)impl);
+        if (!fn) continue;
+        if (bench_verify(fn, ref) != 0) {
+            printf("%s: results differ from bitwise CRC\n", modbus_crc16_impl_name((ModbusCrcImpl)impl));
+            return 1;
+        }
+    }
+
+    printf("%-6s", "bytes");
+    for (int impl = 0; impl < MODBUS_CRC_IMPL_NUM; impl++) {
+        if (modbus_crc16_get_impl((ModbusCrcImpl)impl)) {
+            printf(" %20s", modbus_crc16_impl_name((ModbusCrcImpl)impl));
+        }
+    }
+    printf("\n");
+
+    for (size_t s = 0; s < sizeof(bench_sizes) / sizeof(bench_sizes[0]); s++) {
+        size_t len = bench_sizes[s];
+        double base_ns = bench_run(ref, bufs, len);
+
+        printf("%-6zu %11.1f ns     1.0x", len, base_ns);
+        for (int impl = MODBUS_CRC_IMPL_TABLE; impl < MODBUS_CRC_IMPL_NUM; impl++) {
+            ModbusCrc16Fn fn = modbus_crc16_get_impl((ModbusCrcImpl)impl);
+            if (!fn) continue;
+            double ns = bench_run(fn, bufs, len);
+            printf(" %11.1f ns %6.1fx", ns, base_ns / ns);
+        }
+        printf("\n");
+    }
+
+    return 0;
+}
@@ -0,0 +1,349 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <getopt.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+#include "pty_sim.h"
+
+#define BENCH_MAX_CONNS 1024
+#define BENCH_MAX_WINDOW 64              // Requests in flight per connection
+#define BENCH_MAX_SAMPLES 4000000
+#define BENCH_WARMUP_MS 1000             // Traffic before the measurement starts (not reported)
+#define BENCH_EVENTS 256
+
+// One load generator connection (all its requests go to one bus)
+typedef struct {
+    int fd;
+    uint8_t unit_id;
+    uint16_t next_tid;
+    int inflight;
+    uint64_t sent_ns[BENCH_MAX_WINDOW];  // By transaction ID % BENCH_MAX_WINDOW
+    uint8_t rx_buf[4096];
+    int rx_len;
+} BenchConn;
+
+// Results of the measured phase
+typedef struct {
+    uint64_t replied;
+    uint64_t exceptions;
+    uint64_t tcp_bytes;
+    uint64_t samples;
+} BenchResult;
+
+static BenchConn g_conns[BENCH_MAX_CONNS];
+static uint64_t* g_samples;
+
+/**
+ * Get monotonic time in nanoseconds
+ * @return Current CLOCK_MONOTONIC time (ns)
+ */
+static uint64_t bench_now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/**
+ * Compare two uint64_t (qsort)
+ * @param a: Pointer to first value
+ * @param b: Pointer to second value
+ * @return <0, 0 or >0
+ */
+static int bench_cmp_u64(const void* a, const void* b)
+{
+    uint64_t x = *(const uint64_t*)a;
+    uint64_t y = *(const uint64_t*)b;
+    return x < y ? -1 : x > y;
+}
+
+/**
+ * Fill the window of a connection with FC03 requests
+ * @param conn: Pointer to BenchConn
+ * @param window: Requests in flight
+ * @param quantity: Registers per read
+ * @param result: Counters (NULL during warmup)
+ * @return 0 on success, -1 on failure
+ */
+static int bench_top_up(BenchConn* conn, int window, int quantity, BenchResult* result)
+{
+    uint8_t buf[BENCH_MAX_WINDOW * 12];
+    int cnt = 0;
+    while (conn->inflight + cnt < window) {
+        uint16_t tid = conn->next_tid++;
+        uint8_t req[12] = { tid >> 8, tid & 0xFF, 0, 0, 0, 6, conn->unit_id, 0x03,
+                            0, (uint8_t)(tid % 100), quantity >> 8, quantity & 0xFF };
+        memcpy(buf + cnt * 12, req, sizeof(req));
+        conn->sent_ns[tid % BENCH_MAX_WINDOW] = bench_now_ns();
+        cnt++;
+    }
+    if (cnt == 0) return 0;
+    if (send(conn->fd, buf, cnt * 12, MSG_NOSIGNAL) != cnt * 12) {
+        perror("send");
+        return -1;
+    }
+    conn->inflight += cnt;
+    if (result) result->tcp_bytes += cnt * 12;
+    return 0;
+}
+
+/**
+ * Read replies of a connection and account them
+ * @param conn: Pointer to BenchConn
+ * @param result: Counters (NULL during warmup)
+ * @return 0 on success, -1 if the server closed the connection
+ */
+static int bench_on_readable(BenchConn* conn, BenchResult* result)
+{
+    for (;;) {
+        ssize_t ret = recv(conn->fd, conn->rx_buf + conn->rx_len, sizeof(conn->rx_buf) - conn->rx_len, MSG_DONTWAIT);
+        if (ret == 0) return -1;
+        if (ret < 0) {
+            if (errno == EINTR) continue;
+            return errno == EAGAIN ? 0 : -1;
+        }
+        conn->rx_len += ret;
+        uint64_t now = bench_now_ns();
+
+        int off = 0;
+        while (conn->rx_len - off >= 8) {
+            const uint8_t* adu = conn->rx_buf + off;
+            int frame_len = 6 + ((adu[4] << 8) | adu[5]);
+            if (conn->rx_len - off < frame_len) break;
+            uint16_t tid = (adu[0] << 8) | adu[1];
+            conn->inflight--;
+            if (result) {
+                result->replied++;
+                result->tcp_bytes += frame_len;
+                if (adu[7] & 0x80) result->exceptions++;
+                if (result->samples < BENCH_MAX_SAMPLES) {
+                    g_samples[result->samples++] = now - conn->sent_ns[tid % BENCH_MAX_WINDOW];
+                }
+            }
+            off += frame_len;
+        }
+        memmove(conn->rx_buf, conn->rx_buf + off, conn->rx_len - off);
+        conn->rx_len -= off;
+    }
+}
+
+/**
+ * Run the load: warmup, then duration_s of measured traffic
+ * @param conns: Number of connections
+ * @param ports: Number of buses (connection i targets unit i % ports + 1)
+ * @param window: Requests in flight per connection
+ * @param quantity: Registers per read
+ * @param tcp_port: Gateway port
+ * @param duration_s: Measured time
+ * @param pid: Server pid (CPU accounting)
+ * @param sim: Simulated slaves (serial byte accounting)
+ * @param result: Output counters
+ * @param cpu_ns: Output server CPU time used while measuring
+ * @param elapsed_ns: Output measured time
+ * @param serial_bytes: Output bytes moved over the simulated lines while measuring
+ * @return 0 on success, -1 on failure
+ */
+static int bench_run(int conns, int ports, int window, int quantity, int tcp_port, int duration_s,
+                     pid_t pid, PtySim* sim, BenchResult* result, uint64_t* cpu_ns,
+                     uint64_t* elapsed_ns, uint64_t* serial_bytes)
+{
+    int epfd = epoll_create1(EPOLL_CLOEXEC);
+    if (epfd < 0) {
+        perror("epoll_create1");
+        return -1;
+    }
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(tcp_port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    int ret = -1;
+    int opened = 0;
+    for (; opened < conns; opened++) {
+        BenchConn* conn = &g_conns[opened];
+        memset(conn, 0, sizeof(BenchConn));
+        conn->unit_id = (uint8_t)(opened % ports + 1);
+        conn->fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (conn->fd < 0 || connect(conn->fd, (const struct sockaddr*)&addr, sizeof(addr)) < 0) {
+            perror("connect");
+            if (conn->fd >= 0) close(conn->fd);
+            goto out;
+        }
+        int opt = 1;
+        setsockopt(conn->fd, IPPROTO_TCP, TCP_NODELAY, &opt, sizeof(opt));
+        struct epoll_event ev;
+        ev.events = EPOLLIN;
+        ev.data.ptr = conn;
+        epoll_ctl(epfd, EPOLL_CTL_ADD, conn->fd, &ev);
+    }
+
+    memset(result, 0, sizeof(BenchResult));
+    for (int i = 0; i < conns; i++) {
+        if (bench_top_up(&g_conns[i], window, quantity, NULL) != 0) goto out;
+    }
+
+    uint64_t start = bench_now_ns();
+    uint64_t measure_ns = start + BENCH_WARMUP_MS * 1000000ULL;
+    uint64_t end_ns = measure_ns + (uint64_t)duration_s * 1000000000ULL;
+    BenchResult* acct = NULL;
+    uint64_t cpu0 = 0;
+    uint64_t frames0 = 0;
+    uint64_t bytes0 = 0;
+    struct epoll_event events[BENCH_EVENTS];
+    for (;;) {
+        uint64_t now = bench_now_ns();
+        if (!acct && now >= measure_ns) {
+            acct = result;
+            cpu0 = pty_sim_cpu_ns(pid);
+            pty_sim_totals(sim, &frames0, &bytes0);
+            measure_ns = now;
+        }
+        if (now >= end_ns) break;
+
+        int nfds = epoll_wait(epfd, events, BENCH_EVENTS, 100);
+        if (nfds < 0 && errno != EINTR) break;
+        for (int e = 0; e < nfds; e++) {
+            BenchConn* conn = (BenchConn*)events[e].data.ptr;
+            if (bench_on_readable(conn, acct) != 0) {
+                fprintf(stderr, "Connection to unit %d closed by the server\n", conn->unit_id);
+                goto out;
+            }
+            if (bench_top_up(conn, window, quantity, acct) != 0) goto out;
+        }
+    }
+    *elapsed_ns = bench_now_ns() - measure_ns;
+    *cpu_ns = pty_sim_cpu_ns(pid) - cpu0;
+    uint64_t frames1;
+    uint64_t bytes1;
+    pty_sim_totals(sim, &frames1, &bytes1);
+    *serial_bytes = bytes1 - bytes0;
+    ret = 0;
+
+out:
+    for (int i = 0; i < opened; i++) {
+        close(g_conns[i].fd);
+    }
+    close(epfd);
+    return ret;
+}
+
+/**
+ * Print usage
+ * @param prog: Program name
+ */
+static void bench_usage(const char* prog)
+{
+    printf("Usage: %s [-s serial_server] [-n ports] [-b baud] [-d delay_us] [-c conns] [-w window]\n"
+           "          [-q registers] [-t seconds] [-p tcp_port]\n", prog);
+    printf("Create [ports] pseudo-terminals (default 4) with a simulated Modbus RTU slave each,\n"
+           "paced at [baud] (default 115200, 0 = unpaced) plus [delay_us] per reply, start\n"
+           "serial_server on them, listening on [tcp_port] (default 8888), and drive it with\n"
+           "[conns] Modbus TCP connections (default 16), [window] requests in flight on each\n"
+           "(default 1), for [seconds] (default 10)\n");
+}
+
+int main(int argc, char** argv)
+{
+    const char* server = "./serial_server";
+    int ports = 4;
+    int baud = 115200;
+    int delay_us = 0;
+    int conns = 16;
+    int window = 1;
+    int quantity = 10;
+    int duration_s = 10;
+    int tcp_port = 8888;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "s:n:b:d:c:w:q:t:p:h")) != -1) {
+        switch (opt) {
+            case 's': server = optarg; break;
+            case 'n': ports = atoi(optarg); break;
+            case 'b': baud = atoi(optarg); break;
+            case 'd': delay_us = atoi(optarg); break;
+            case 'c': conns = atoi(optarg); break;
+            case 'w': window = atoi(optarg); break;
+            case 'q': quantity = atoi(optarg); break;
+            case 't': duration_s = atoi(optarg); break;
+            case 'p': tcp_port = atoi(optarg); break;
+            default:
+                bench_usage(argv[0]);
+                return 1;
+        }
+    }
+    if (ports <= 0 || ports > PTY_SIM_MAX_PORTS || baud < 0 || delay_us < 0 || conns <= 0 ||
+        conns > BENCH_MAX_CONNS || window <= 0 || window > BENCH_MAX_WINDOW || quantity <= 0 ||
+        quantity > 125 || duration_s <= 0) {
+        printf("ports must be 1..%d, conns 1..%d, window 1..%d, registers 1..125\n",
+               PTY_SIM_MAX_PORTS, BENCH_MAX_CONNS, BENCH_MAX_WINDOW);
+        return 1;
+    }
+
+    g_samples = (uint64_t*)malloc(BENCH_MAX_SAMPLES * sizeof(uint64_t));
+    PtySim* sim = pty_sim_create(ports, baud, delay_us);
+    if (!g_samples || !sim) {
+        fprintf(stderr, "Create simulated ports failed\n");
+        return 1;
+    }
+    char config_path[64];
+    char log_path[64];
+    snprintf(config_path, sizeof(config_path), "/tmp/gw_bench_%d.yaml", (int)getpid());
+    snprintf(log_path, sizeof(log_path), "/tmp/gw_bench_%d.log", (int)getpid());
+    if (pty_sim_write_config(sim, config_path, conns + 16, tcp_port, 0) != 0) {
+        pty_sim_destroy(sim);
+        return 1;
+    }
+    pid_t pid = pty_sim_start_server(server, config_path, log_path, tcp_port);
+    if (pid < 0) {
+        pty_sim_destroy(sim);
+        return 1;
+    }
+
+    printf("%d ports @ %d baud (slave delay %d us), %d connections x window %d, %d registers/read, %d s\n",
+           ports, baud, delay_us, conns, window, quantity, duration_s);
+    BenchResult result;
+    uint64_t cpu_ns = 0;
+    uint64_t elapsed_ns = 1;
+    uint64_t serial_bytes = 0;
+    int ret = bench_run(conns, ports, window, quantity, tcp_port, duration_s, pid, sim,
+                        &result, &cpu_ns, &elapsed_ns, &serial_bytes);
+    pty_sim_stop_server(pid);
+    pty_sim_destroy(sim);
+    if (ret != 0) {
+        fprintf(stderr, "Benchmark aborted, server log: %s\n", log_path);
+        return 1;
+    }
+    unlink(config_path);
+
+    double secs = elapsed_ns / 1e9;
+    printf("requests     %10llu (%llu exceptions)  %12.1f req/s\n", (unsigned long long)result.replied,
+           (unsigned long long)result.exceptions, result.replied / secs);
+    printf("tcp bytes    %10llu                  %12.1f bytes/s\n", (unsigned long long)result.tcp_bytes,
+           result.tcp_bytes / secs);
+    printf("serial bytes %10llu                  %12.1f bytes/s\n", (unsigned long long)serial_bytes,
+           serial_bytes / secs);
+    uint64_t n = result.samples;
+    if (n > 0) {
+        qsort(g_samples, n, sizeof(uint64_t), bench_cmp_u64);
+        printf("latency      p50 %8.3f ms  p99 %8.3f ms  p999 %8.3f ms  max %8.3f ms\n",
+               g_samples[n / 2] / 1e6, g_samples[n * 99 / 100] / 1e6,
+               g_samples[n * 999 / 1000] / 1e6, g_samples[n - 1] / 1e6);
+    }
+    printf("server cpu   %.1f%% of a core, %.2f us/request\n", cpu_ns * 100.0 / elapsed_ns,
+           result.replied ? cpu_ns / 1e3 / result.replied : 0.0);
+    printf("server log   %s\n", log_path);
+
+    free(g_samples);
+    return result.replied > 0 ? 0 : 2;
+}
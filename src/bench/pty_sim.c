@@ -0,0 +1,382 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pty.h>
+#include <signal.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#include "pty_sim.h"
+#include "../modbus/modbus_crc.h"
+
+#define PTY_SIM_CHAR_BITS 11             // start + 8 data + parity/stop + stop
+
+/**
+ * Sleep for a number of nanoseconds (no-op for 0)
+ * @param ns: Sleep time
+ */
+static void pty_sim_sleep_ns(uint64_t ns)
+{
+    if (ns == 0) return;
+    struct timespec ts = { (time_t)(ns / 1000000000ULL), (long)(ns % 1000000000ULL) };
+    while (nanosleep(&ts, &ts) != 0 && errno == EINTR) {
+    }
+}
+
+/**
+ * Get length of the RTU request at the head of the buffer
+ * @param buf: Received bytes
+ * @param len: Number of received bytes
+ * @return Request length incl. CRC, 0 if more bytes are needed
+ */
+static int pty_sim_req_len(const uint8_t* buf, int len)
+{
+    if (len < 2) return 0;
+    switch (buf[1]) {
+        case 0x01: case 0x02: case 0x03: case 0x04: case 0x05: case 0x06:
+            return len >= 8 ? 8 : 0;
+        case 0x0F: case 0x10:
+            if (len < 7) return 0;
+            return len >= 9 + buf[6] ? 9 + buf[6] : 0;
+        default:
+            // Unknown request: whatever arrived in one piece
+            return len;
+    }
+}
+
+/**
+ * Build the reply of the simulated slave (holding / input register N reads back as N)
+ * @param req: RTU request incl. CRC
+ * @param len: Request length
+ * @param resp: Output RTU response incl. CRC
+ * @return Response length, 0 for no reply (broadcast)
+ */
+static int pty_sim_reply(const uint8_t* req, int len, uint8_t* resp)
+{
+    if (req[0] == 0) return 0;
+
+    int n = 0;
+    uint8_t fc = req[1];
+    uint16_t start = (req[2] << 8) | req[3];
+    uint16_t quantity = (req[4] << 8) | req[5];
+    resp[n++] = req[0];
+    if ((fc == 0x03 || fc == 0x04) && len == 8) {
+        if (quantity == 0 || quantity > 125) {
+            resp[n++] = fc | 0x80;
+            resp[n++] = 0x03;
+        } else {
+            resp[n++] = fc;
+            resp[n++] = (uint8_t)(quantity * 2);
+            for (int i = 0; i < quantity; i++) {
+                uint16_t v = (uint16_t)(start + i);
+                resp[n++] = v >> 8;
+                resp[n++] = v & 0xFF;
+            }
+        }
+    } else if ((fc == 0x06 || fc == 0x10) && len >= 8) {
+        memcpy(resp, req, 6);
+        n = 6;
+    } else {
+        resp[n++] = fc | 0x80;
+        resp[n++] = 0x01;
+    }
+
+    uint16_t crc = modbus_crc16_update(MODBUS_CRC16_INIT, resp, n);
+    resp[n++] = crc & 0xFF;
+    resp[n++] = crc >> 8;
+    return n;
+}
+
+/**
+ * Slave thread: answer every request written to the pty, paced like a real line
+ * @param arg: Pointer to PtySimPort
+ * @return NULL
+ */
+static void* pty_sim_slave_loop(void* arg)
+{
+    PtySimPort* port = (PtySimPort*)arg;
+    PtySim* sim = port->sim;
+    uint64_t char_ns = sim->baudrate > 0 ? PTY_SIM_CHAR_BITS * 1000000000ULL / sim->baudrate : 0;
+    uint8_t buf[PTY_SIM_FRAME_MAX * 2];
+    int len = 0;
+
+    while (!sim->stop) {
+        struct pollfd pfd = { port->master_fd, POLLIN, 0 };
+        if (poll(&pfd, 1, 100) <= 0) continue;
+        ssize_t ret = read(port->master_fd, buf + len, sizeof(buf) - len);
+        if (ret <= 0) {
+            // EIO until serial_server opens the slave side
+            if (ret < 0 && errno != EAGAIN && errno != EINTR) pty_sim_sleep_ns(10000000ULL);
+            continue;
+        }
+        len += ret;
+        __atomic_fetch_add(&port->rx_bytes, ret, __ATOMIC_RELAXED);
+
+        int off = 0;
+        int req_len;
+        while ((req_len = pty_sim_req_len(buf + off, len - off)) > 0) {
+            if (req_len > PTY_SIM_FRAME_MAX ||
+                modbus_crc16_update(MODBUS_CRC16_INIT, buf + off, req_len) != 0) {
+                // Lost sync: drop everything and wait for the gateway's next request
+                __atomic_fetch_add(&port->crc_err, 1, __ATOMIC_RELAXED);
+                off = len;
+                break;
+            }
+
+            uint8_t resp[PTY_SIM_FRAME_MAX];
+            uint64_t delay_ns = 0;
+            int resp_len = -1;
+            if (sim->responder) {
+                resp_len = sim->responder(port, buf + off, req_len, resp, &delay_ns, sim->responder_arg);
+            }
+            if (resp_len < 0) {
+                resp_len = pty_sim_reply(buf + off, req_len, resp);
+                // Request and response on the wire, plus the slave's own processing time
+                delay_ns = char_ns * (req_len + resp_len) + sim->delay_us * 1000ULL;
+            }
+            pty_sim_sleep_ns(delay_ns);
+            for (int sent = 0; sent < resp_len; ) {
+                ssize_t w = write(port->master_fd, resp + sent, resp_len - sent);
+                if (w < 0 && errno == EINTR) continue;
+                if (w < 0) break;
+                sent += w;
+            }
+            __atomic_fetch_add(&port->tx_bytes, resp_len, __ATOMIC_RELAXED);
+            __atomic_fetch_add(&port->frames, 1, __ATOMIC_RELAXED);
+            off += req_len;
+        }
+        memmove(buf, buf + off, len - off);
+        len -= off;
+    }
+    return NULL;
+}
+
+/**
+ * Create pseudo-terminals with a simulated Modbus RTU slave on each
+ * @param port_count: Number of ports (1~PTY_SIM_MAX_PORTS, UART idx 1~port_count)
+ * @param baudrate: Line rate to pace replies at (0 = as fast as possible)
+ * @param delay_us: Slave processing time before each reply
+ * @return Pointer to PtySim on success, NULL on failure
+ */
+PtySim* pty_sim_create(int port_count, int baudrate, int delay_us)
+{
+    if (port_count <= 0 || port_count > PTY_SIM_MAX_PORTS) return NULL;
+
+    PtySim* sim = (PtySim*)malloc(sizeof(PtySim));
+    if (!sim) return NULL;
+    memset(sim, 0, sizeof(PtySim));
+    sim->baudrate = baudrate;
+    sim->delay_us = delay_us;
+
+    for (int i = 0; i < port_count; i++) {
+        PtySimPort* port = &sim->ports[i];
+        port->idx = i + 1;
+        port->sim = sim;
+        if (openpty(&port->master_fd, &port->slave_fd, NULL, NULL, NULL) < 0 ||
+            ptsname_r(port->master_fd, port->path, sizeof(port->path)) != 0) {
+            perror("openpty");
+            pty_sim_destroy(sim);
+            return NULL;
+        }
+        fcntl(port->master_fd, F_SETFD, FD_CLOEXEC);
+        fcntl(port->slave_fd, F_SETFD, FD_CLOEXEC);
+        struct termios attr;
+        tcgetattr(port->master_fd, &attr);
+        cfmakeraw(&attr);
+        tcsetattr(port->master_fd, TCSANOW, &attr);
+
+        if (pthread_create(&port->thread, NULL, pty_sim_slave_loop, port) != 0) {
+            close(port->master_fd);
+            close(port->slave_fd);
+            pty_sim_destroy(sim);
+            return NULL;
+        }
+        sim->port_count++;
+    }
+    return sim;
+}
+
+/**
+ * Stop the slaves and close the pseudo-terminals
+ * @param sim: Pointer to PtySim
+ */
+void pty_sim_destroy(PtySim* sim)
+{
+    if (!sim) return;
+    sim->stop = 1;
+    for (int i = 0; i < sim->port_count; i++) {
+        pthread_join(sim->ports[i].thread, NULL);
+        close(sim->ports[i].master_fd);
+        close(sim->ports[i].slave_fd);
+    }
+    free(sim);
+}
+
+/**
+ * Answer requests with a custom responder (set before the server is started)
+ * @param sim: Pointer to PtySim
+ * @param responder: Reply callback, NULL = built-in reply
+ * @param arg: Callback argument
+ */
+void pty_sim_set_responder(PtySim* sim, PtySimResponder responder, void* arg)
+{
+    sim->responder_arg = arg;
+    sim->responder = responder;
+}
+
+/**
+ * Write a serial_server config with one Modbus port per simulated slave
+ * @param sim: Pointer to PtySim
+ * @param path: Output YAML file
+ * @param max_clients: Root key max_clients (0 = default)
+ * @param tcp_port: Root key server_port (0 = default 8888)
+ * @param udp_port: Root key udp_port (0 = no Modbus/UDP)
+ * @return 0 on success, -1 on failure
+ */
+int pty_sim_write_config(PtySim* sim, const char* path, int max_clients, int tcp_port, int udp_port)
+{
+    FILE* fp = fopen(path, "w");
+    if (!fp) {
+        perror(path);
+        return -1;
+    }
+    if (max_clients > 0) {
+        fprintf(fp, "max_clients: %d\n", max_clients);
+    }
+    if (tcp_port > 0) {
+        fprintf(fp, "server_port: %d\n", tcp_port);
+    }
+    if (udp_port > 0) {
+        fprintf(fp, "udp_port: %d\n", udp_port);
+    }
+    fprintf(fp, "uart_list:\n");
+    for (int i = 0; i < sim->port_count; i++) {
+        fprintf(fp, "  - idx: %d\n    dev_path: \"%s\"\n    baudrate: %d\n    databit: 8\n    stopbit: 1\n"
+                    "    parity: \"N\"\n    flow_ctrl: 0\n    enable: true\n    modbus_enable: true\n",
+                sim->ports[i].idx, sim->ports[i].path, sim->baudrate > 0 ? sim->baudrate : 115200);
+    }
+    fclose(fp);
+    return 0;
+}
+
+/**
+ * Start serial_server and wait until it accepts TCP connections
+ * @param binary: Path to serial_server
+ * @param config_path: YAML config passed to it
+ * @param log_path: File receiving its stdout / stderr
+ * @param tcp_port: Port to wait for (server_port of the config)
+ * @return Server pid on success, -1 on failure
+ */
+pid_t pty_sim_start_server(const char* binary, const char* config_path, const char* log_path, int tcp_port)
+{
+    pid_t pid = fork();
+    if (pid < 0) {
+        perror("fork");
+        return -1;
+    }
+    if (pid == 0) {
+        int null_fd = open("/dev/null", O_RDONLY);
+        int log_fd = open(log_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (null_fd >= 0) dup2(null_fd, STDIN_FILENO);
+        if (log_fd >= 0) {
+            dup2(log_fd, STDOUT_FILENO);
+            dup2(log_fd, STDERR_FILENO);
+        }
+        execl(binary, binary, config_path, (char*)NULL);
+        perror(binary);
+        _exit(127);
+    }
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(tcp_port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    for (int waited = 0; waited < PTY_SIM_READY_MS; waited += 50) {
+        int status;
+        if (waitpid(pid, &status, WNOHANG) == pid) {
+            fprintf(stderr, "%s exited during startup, see %s\n", binary, log_path);
+            return -1;
+        }
+        int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd >= 0 && connect(fd, (const struct sockaddr*)&addr, sizeof(addr)) == 0) {
+            close(fd);
+            return pid;
+        }
+        if (fd >= 0) close(fd);
+        pty_sim_sleep_ns(50000000ULL);
+    }
+    fprintf(stderr, "%s not listening on %d after %d ms\n", binary, tcp_port, PTY_SIM_READY_MS);
+    pty_sim_stop_server(pid);
+    return -1;
+}
+
+/**
+ * Stop serial_server (SIGINT, SIGKILL if it does not exit in time)
+ * @param pid: Server pid
+ */
+void pty_sim_stop_server(pid_t pid)
+{
+    if (pid <= 0) return;
+    kill(pid, SIGINT);
+    for (int waited = 0; waited < PTY_SIM_READY_MS; waited += 50) {
+        if (waitpid(pid, NULL, WNOHANG) == pid) return;
+        pty_sim_sleep_ns(50000000ULL);
+    }
+    kill(pid, SIGKILL);
+    waitpid(pid, NULL, 0);
+}
+
+/**
+ * Get CPU time (user + system) a process has used so far
+ * @param pid: Process ID
+ * @return CPU time (ns), 0 if unavailable
+ */
+uint64_t pty_sim_cpu_ns(pid_t pid)
+{
+    char path[64];
+    char buf[1024];
+    snprintf(path, sizeof(path), "/proc/%d/stat", (int)pid);
+    FILE* fp = fopen(path, "r");
+    if (!fp) return 0;
+    size_t n = fread(buf, 1, sizeof(buf) - 1, fp);
+    fclose(fp);
+    buf[n] = '\0';
+
+    // Fields after the command name: state ppid pgrp session tty tpgid flags minflt cminflt majflt cmajflt utime stime
+    char* p = strrchr(buf, ')');
+    unsigned long long utime = 0;
+    unsigned long long stime = 0;
+    if (!p || sscanf(p + 2, "%*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %llu %llu", &utime, &stime) != 2) {
+        return 0;
+    }
+    return (utime + stime) * 1000000000ULL / (uint64_t)sysconf(_SC_CLK_TCK);
+}
+
+/**
+ * Sum the counters of all simulated slaves
+ * @param sim: Pointer to PtySim
+ * @param frames: Output requests answered
+ * @param bytes: Output bytes moved over the simulated lines (both directions)
+ */
+void pty_sim_totals(PtySim* sim, uint64_t* frames, uint64_t* bytes)
+{
+    *frames = 0;
+    *bytes = 0;
+    for (int i = 0; i < sim->port_count; i++) {
+        PtySimPort* port = &sim->ports[i];
+        *frames += __atomic_load_n(&port->frames, __ATOMIC_RELAXED);
+        *bytes += __atomic_load_n(&port->rx_bytes, __ATOMIC_RELAXED) +
+                  __atomic_load_n(&port->tx_bytes, __ATOMIC_RELAXED);
+    }
+}
@@ -0,0 +1,59 @@
+#ifndef PTY_SIM_H
+#define PTY_SIM_H
+
+#include <stdint.h>
+#include <pthread.h>
+#include <sys/types.h>
+
+// Constants for the simulated serial side of the benchmarks
+#define PTY_SIM_MAX_PORTS 16             // UART idx 1~16 (unit ID 0 is broadcast)
+#define PTY_SIM_FRAME_MAX 256
+#define PTY_SIM_READY_MS 5000            // Wait this long for serial_server to accept connections
+
+// Simulated Modbus RTU slave on the master side of one pseudo-terminal
+typedef struct {
+    int idx;                     // UART idx in the generated config (= unit ID / slave address)
+    int master_fd;
+    int slave_fd;                // Kept open so the pty survives until serial_server opens it
+    char path[64];               // Slave device serial_server is pointed at
+    pthread_t thread;
+    uint64_t frames;             // Requests answered (atomic)
+    uint64_t rx_bytes;           // Request bytes read from the gateway (atomic)
+    uint64_t tx_bytes;           // Response bytes written to the gateway (atomic)
+    uint64_t crc_err;            // Requests dropped for a bad CRC (atomic)
+    struct PtySim* sim;
+} PtySimPort;
+
+// Custom reply of a simulated slave (called on the port's slave thread)
+// Fill resp (RTU frame incl. CRC) and *delay_ns (total time before the reply, wire time included),
+// return the response length, 0 for no reply, -1 for the built-in reply paced at the line rate
+typedef int (*PtySimResponder)(PtySimPort* port, const uint8_t* req, int len, uint8_t* resp,
+                               uint64_t* delay_ns, void* arg);
+
+typedef struct PtySim {
+    PtySimPort ports[PTY_SIM_MAX_PORTS];
+    int port_count;
+    int baudrate;                // Line rate the slaves pace their replies at (0 = no pacing)
+    int delay_us;                // Slave processing time before a reply
+    PtySimResponder responder;   // NULL = built-in reply for every request
+    void* responder_arg;
+    volatile int stop;
+} PtySim;
+
+PtySim* pty_sim_create(int port_count, int baudrate, int delay_us);
+
+void pty_sim_destroy(PtySim* sim);
+
+void pty_sim_set_responder(PtySim* sim, PtySimResponder responder, void* arg);
+
+int pty_sim_write_config(PtySim* sim, const char* path, int max_clients, int tcp_port, int udp_port);
+
+pid_t pty_sim_start_server(const char* binary, const char* config_path, const char* log_path, int tcp_port);
+
+void pty_sim_stop_server(pid_t pid);
+
+uint64_t pty_sim_cpu_ns(pid_t pid);
+
+void pty_sim_totals(PtySim* sim, uint64_t* frames, uint64_t* bytes);
+
+#endif // !PTY_SIM_H
@@ -0,0 +1,774 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <getopt.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+#include "pty_sim.h"
+#include "../modbus/modbus_crc.h"
+#include "../trace/trace.h"
+
+#define REPLAY_MAX_STREAMS 1024          // Recorded connections replayed (one connection each)
+#define REPLAY_SLOTS 256                 // Send times kept per connection (by transaction ID)
+#define REPLAY_IDLE_MS 5000              // Give up when no reply arrives for this long
+#define REPLAY_CLIENT_KEYS 4098          // Recorded client IDs: slot 0~4095, poll (-1), UDP (-2)
+#define REPLAY_LAT_FLOOR_US 200          // Latency deviations below this never fail (scheduler noise)
+#define REPLAY_THRESHOLD_PCT 10          // Default allowed deviation of the candidate
+#define REPLAY_EVENTS 256
+
+// Client request taken from the trace
+typedef struct {
+    uint64_t at_us;              // Offset from the first recorded request
+    int stream;                  // Replay connection (recorded connection)
+    uint32_t off;                // MBAP frame in the blob (unit ID rewritten to the replay port)
+    uint16_t len;
+} ReplayReq;
+
+// Recorded bus exchange: request written to the UART, response read from it (PDUs, no address / CRC)
+typedef struct {
+    uint32_t req_off;
+    uint16_t req_len;
+    uint32_t resp_off;
+    uint16_t resp_len;
+    uint32_t delay_us;           // Request written -> response complete
+} ReplayExchange;
+
+// Exchanges of one replay port, consumed by its slave thread
+typedef struct {
+    ReplayExchange* ex;
+    int count;
+    int cap;
+    int cursor;                  // Next exchange expected (slave thread only)
+    uint64_t matched;            // Requests answered from the trace (atomic)
+    uint64_t synthesized;        // Requests not in the trace, answered by the built-in slave (atomic)
+} ReplayBus;
+
+// Loaded trace
+typedef struct {
+    uint8_t* blob;               // Frame bytes referenced by requests and exchanges
+    uint32_t blob_len;
+    uint32_t blob_cap;
+    ReplayReq* reqs;
+    int req_count;
+    int req_cap;
+    uint64_t span_us;            // First to last request
+    int stream_count;
+    int port_count;
+    int port_of[TRACE_MAX_PORTS];          // Recorded UART -> replay port (UART idx 1~), 0 = unused
+    ReplayBus buses[PTY_SIM_MAX_PORTS + 1]; // By replay port
+    uint32_t median_delay_us;
+    int skipped;                 // Frames of raw ports (not replayable as Modbus)
+} Replay;
+
+// One replay connection
+typedef struct {
+    int fd;
+    uint16_t next_tid;
+    int inflight;
+    int* reqs;                   // Requests of the stream in trace order
+    int req_count;
+    int pos;                     // Next request of the stream to send (across loops)
+    uint64_t sent_ns[REPLAY_SLOTS];
+    uint8_t rx_buf[4096];
+    int rx_len;
+} ReplayConn;
+
+// Results of one build
+typedef struct {
+    uint64_t sent;
+    uint64_t replied;
+    uint64_t exceptions;
+    uint64_t missing;
+    uint64_t elapsed_ns;
+    uint64_t cpu_ns;
+    uint64_t p50_ns;
+    uint64_t p99_ns;
+    uint64_t p999_ns;
+    uint64_t max_ns;
+    uint64_t matched;
+    uint64_t synthesized;
+} ReplayResult;
+
+static ReplayConn g_conns[REPLAY_MAX_STREAMS];
+static uint64_t* g_samples;
+static uint64_t g_sample_count;
+
+/**
+ * Get monotonic time in nanoseconds
+ * @return Current CLOCK_MONOTONIC time (ns)
+ */
+static uint64_t replay_now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/**
+ * Compare two uint64_t (qsort)
+ * @param a: Pointer to first value
+ * @param b: Pointer to second value
+ * @return <0, 0 or >0
+ */
+static int replay_cmp_u64(const void* a, const void* b)
+{
+    uint64_t x = *(const uint64_t*)a;
+    uint64_t y = *(const uint64_t*)b;
+    return x < y ? -1 : x > y;
+}
+
+/**
+ * Grow an array to hold one more element
+ * @param arr: Pointer to the array pointer
+ * @param cap: Pointer to the capacity (elements)
+ * @param count: Elements in use
+ * @param size: Element size
+ * @return 0 on success, -1 on failure
+ */
+static int replay_grow(void** arr, int* cap, int count, size_t size)
+{
+    if (count < *cap) return 0;
+    int new_cap = *cap ? *cap * 2 : 1024;
+    void* p = realloc(*arr, new_cap * size);
+    if (!p) return -1;
+    *arr = p;
+    *cap = new_cap;
+    return 0;
+}
+
+/**
+ * Copy bytes into the blob
+ * @param rp: Pointer to Replay
+ * @param data: Bytes
+ * @param len: Length
+ * @return Blob offset, -1 on failure
+ */
+static int64_t replay_blob_add(Replay* rp, const uint8_t* data, int len)
+{
+    if (rp->blob_len + len > rp->blob_cap) {
+        uint32_t new_cap = rp->blob_cap ? rp->blob_cap * 2 : 65536;
+        while (new_cap < rp->blob_len + len) new_cap *= 2;
+        uint8_t* p = (uint8_t*)realloc(rp->blob, new_cap);
+        if (!p) return -1;
+        rp->blob = p;
+        rp->blob_cap = new_cap;
+    }
+    memcpy(rp->blob + rp->blob_len, data, len);
+    rp->blob_len += len;
+    return rp->blob_len - len;
+}
+
+/**
+ * Get the replay port of a recorded UART (assigned in order of appearance)
+ * @param rp: Pointer to Replay
+ * @param port: Recorded UART index
+ * @return Replay port (1~PTY_SIM_MAX_PORTS), -1 if there are too many ports
+ */
+static int replay_port(Replay* rp, int port)
+{
+    if (rp->port_of[port] == 0) {
+        if (rp->port_count >= PTY_SIM_MAX_PORTS) return -1;
+        rp->port_of[port] = ++rp->port_count;
+    }
+    return rp->port_of[port];
+}
+
+/**
+ * Load a trace recorded with "trace record" (client requests + bus exchanges)
+ * @param rp: Output Replay
+ * @param path: Trace file
+ * @return 0 on success, -1 on failure
+ */
+static int replay_load(Replay* rp, const char* path)
+{
+    FILE* fp = fopen(path, "rb");
+    if (!fp) {
+        perror(path);
+        return -1;
+    }
+    fseek(fp, 0, SEEK_END);
+    long size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    uint8_t* file = (uint8_t*)malloc(size > 0 ? size : 1);
+    if (!file || fread(file, 1, size, fp) != (size_t)size) {
+        fprintf(stderr, "Read %s failed\n", path);
+        fclose(fp);
+        free(file);
+        return -1;
+    }
+    fclose(fp);
+
+    const TraceFileHeader* hdr = (const TraceFileHeader*)file;
+    if (size < (long)sizeof(TraceFileHeader) || hdr->magic != TRACE_FILE_MAGIC) {
+        fprintf(stderr, "%s is not a replay trace (record one with: trace record all <file>)\n", path);
+        free(file);
+        return -1;
+    }
+    if (hdr->version != TRACE_FILE_VERSION) {
+        fprintf(stderr, "%s is a version %u trace, this build reads version %d (record it again)\n", path,
+                hdr->version, TRACE_FILE_VERSION);
+        free(file);
+        return -1;
+    }
+
+    // Pass 1: ports carrying RTU frames are Modbus buses, the others raw ports
+    int rtu_port[256] = { 0 };
+    long off = sizeof(TraceFileHeader);
+    while (off + (long)sizeof(TraceFileRecord) <= size) {
+        const TraceFileRecord* rec = (const TraceFileRecord*)(file + off);
+        if (off + (long)sizeof(TraceFileRecord) + rec->len > size) break;
+        if (rec->flags & TRACE_FLAG_RTU) rtu_port[rec->port] = 1;
+        off += sizeof(TraceFileRecord) + rec->len;
+    }
+
+    // Pass 2: requests per connection, exchanges per bus
+    int stream_of[REPLAY_CLIENT_KEYS];
+    uint32_t stream_conn[REPLAY_MAX_STREAMS];
+    memset(stream_of, -1, sizeof(stream_of));
+    uint64_t tx_us[256] = { 0 };
+    int64_t tx_off[256];
+    int tx_len[256];
+    for (int i = 0; i < 256; i++) tx_off[i] = -1;
+    uint64_t now_us = 0;
+    uint64_t first_us = 0;
+    int ret = -1;
+    off = sizeof(TraceFileHeader);
+    while (off + (long)sizeof(TraceFileRecord) <= size) {
+        const TraceFileRecord* rec = (const TraceFileRecord*)(file + off);
+        const uint8_t* data = file + off + sizeof(TraceFileRecord);
+        if (off + (long)sizeof(TraceFileRecord) + rec->len > size) break;
+        off += sizeof(TraceFileRecord) + rec->len;
+        now_us += rec->delta_us;
+        if (rec->port >= TRACE_MAX_PORTS) continue;
+
+        if (rec->dir == TRACE_TCP_RX) {
+            if (!rtu_port[rec->port] || rec->len < 8) {
+                rp->skipped++;
+                continue;
+            }
+            int port = replay_port(rp, rec->port);
+            int key = rec->client + 2;
+            if (port < 0 || key < 0 || key >= REPLAY_CLIENT_KEYS) {
+                rp->skipped++;
+                continue;
+            }
+            // A new connection on the slot is a new stream (the previous one is closed by then)
+            if (stream_of[key] < 0 || stream_conn[stream_of[key]] != rec->conn) {
+                if (rp->stream_count >= REPLAY_MAX_STREAMS) {
+                    rp->skipped++;
+                    continue;
+                }
+                stream_of[key] = rp->stream_count;
+                stream_conn[rp->stream_count++] = rec->conn;
+            }
+            if (rp->req_count == 0) first_us = now_us;
+            if (replay_grow((void**)&rp->reqs, &rp->req_cap, rp->req_count, sizeof(ReplayReq)) != 0) goto out;
+            int64_t at = replay_blob_add(rp, data, rec->len);
+            if (at < 0) goto out;
+            rp->blob[at + 6] = (uint8_t)port;
+            ReplayReq* req = &rp->reqs[rp->req_count++];
+            req->at_us = now_us - first_us;
+            req->stream = stream_of[key];
+            req->off = (uint32_t)at;
+            req->len = rec->len;
+            rp->span_us = req->at_us;
+        } else if (rec->dir == TRACE_UART_TX && (rec->flags & TRACE_FLAG_RTU) && rec->len >= 4) {
+            int64_t at = replay_blob_add(rp, data + 1, rec->len - 3);
+            if (at < 0) goto out;
+            tx_us[rec->port] = now_us;
+            tx_off[rec->port] = at;
+            tx_len[rec->port] = rec->len - 3;
+        } else if (rec->dir == TRACE_UART_RX && (rec->flags & TRACE_FLAG_RTU) && rec->len >= 4 &&
+                   tx_off[rec->port] >= 0) {
+            int port = replay_port(rp, rec->port);
+            if (port < 0) continue;
+            ReplayBus* bus = &rp->buses[port];
+            int64_t at = replay_blob_add(rp, data + 1, rec->len - 3);
+            if (at < 0 || replay_grow((void**)&bus->ex, &bus->cap, bus->count, sizeof(ReplayExchange)) != 0) goto out;
+            ReplayExchange* ex = &bus->ex[bus->count++];
+            ex->req_off = (uint32_t)tx_off[rec->port];
+            ex->req_len = (uint16_t)tx_len[rec->port];
+            ex->resp_off = (uint32_t)at;
+            ex->resp_len = rec->len - 3;
+            ex->delay_us = (uint32_t)(now_us - tx_us[rec->port]);
+            tx_off[rec->port] = -1;
+        }
+    }
+
+    if (rp->req_count == 0) {
+        fprintf(stderr, "%s holds no Modbus client requests\n", path);
+        goto out;
+    }
+
+    // Requests the trace has no answer for are answered after the typical delay
+    int total = 0;
+    for (int p = 1; p <= rp->port_count; p++) total += rp->buses[p].count;
+    if (total > 0) {
+        uint64_t* delays = (uint64_t*)malloc(total * sizeof(uint64_t));
+        if (!delays) goto out;
+        int n = 0;
+        for (int p = 1; p <= rp->port_count; p++) {
+            for (int i = 0; i < rp->buses[p].count; i++) delays[n++] = rp->buses[p].ex[i].delay_us;
+        }
+        qsort(delays, n, sizeof(uint64_t), replay_cmp_u64);
+        rp->median_delay_us = (uint32_t)delays[n / 2];
+        free(delays);
+    }
+    ret = 0;
+
+out:
+    free(file);
+    return ret;
+}
+
+/**
+ * Slave responder: answer with the recorded response of the same request, after the recorded delay
+ * @param port: Simulated port
+ * @param req: RTU request incl. CRC
+ * @param len: Request length
+ * @param resp: Output RTU response incl. CRC
+ * @param delay_ns: Output time before the reply
+ * @param arg: Pointer to Replay
+ * @return Response length, 0 for no reply, -1 for the built-in reply
+ */
+static int replay_respond(PtySimPort* port, const uint8_t* req, int len, uint8_t* resp, uint64_t* delay_ns, void* arg)
+{
+    Replay* rp = (Replay*)arg;
+    ReplayBus* bus = &rp->buses[port->idx];
+    if (req[0] == 0) return 0;
+    if (len < 4 || bus->count == 0) {
+        __atomic_fetch_add(&bus->synthesized, 1, __ATOMIC_RELAXED);
+        return -1;
+    }
+
+    // Usually the next exchange, so search onwards from the cursor and wrap around
+    const uint8_t* pdu = req + 1;
+    int pdu_len = len - 3;
+    int found = -1;
+    for (int i = 0; i < bus->count && found < 0; i++) {
+        int idx = (bus->cursor + i) % bus->count;
+        const ReplayExchange* ex = &bus->ex[idx];
+        if (ex->req_len == pdu_len && memcmp(rp->blob + ex->req_off, pdu, pdu_len) == 0) found = idx;
+    }
+    if (found < 0) {
+        __atomic_fetch_add(&bus->synthesized, 1, __ATOMIC_RELAXED);
+        return -1;
+    }
+
+    const ReplayExchange* ex = &bus->ex[found];
+    bus->cursor = (found + 1) % bus->count;
+    resp[0] = req[0];
+    memcpy(resp + 1, rp->blob + ex->resp_off, ex->resp_len);
+    int n = 1 + ex->resp_len;
+    uint16_t crc = modbus_crc16_update(MODBUS_CRC16_INIT, resp, n);
+    resp[n++] = crc & 0xFF;
+    resp[n++] = crc >> 8;
+    *delay_ns = (uint64_t)ex->delay_us * 1000ULL;
+    __atomic_fetch_add(&bus->matched, 1, __ATOMIC_RELAXED);
+    return n;
+}
+
+/**
+ * Send one recorded request on its connection
+ * @param rp: Pointer to Replay
+ * @param req: Request
+ * @param result: Counters
+ * @return 0 on success, -1 on failure
+ */
+static int replay_send(Replay* rp, const ReplayReq* req, ReplayResult* result)
+{
+    ReplayConn* conn = &g_conns[req->stream];
+    uint8_t buf[TRACE_FRAME_MAX];
+    memcpy(buf, rp->blob + req->off, req->len);
+    uint16_t tid = conn->next_tid++;
+    buf[0] = tid >> 8;
+    buf[1] = tid & 0xFF;
+    conn->sent_ns[tid % REPLAY_SLOTS] = replay_now_ns();
+    if (send(conn->fd, buf, req->len, MSG_NOSIGNAL) != req->len) {
+        perror("send");
+        return -1;
+    }
+    conn->inflight++;
+    result->sent++;
+    return 0;
+}
+
+/**
+ * Read replies of a connection and account them
+ * @param conn: Pointer to ReplayConn
+ * @param result: Counters
+ * @return Replies read, -1 if the server closed the connection
+ */
+static int replay_on_readable(ReplayConn* conn, ReplayResult* result)
+{
+    int replies = 0;
+    for (;;) {
+        ssize_t ret = recv(conn->fd, conn->rx_buf + conn->rx_len, sizeof(conn->rx_buf) - conn->rx_len, MSG_DONTWAIT);
+        if (ret == 0) return -1;
+        if (ret < 0) {
+            if (errno == EINTR) continue;
+            return errno == EAGAIN ? replies : -1;
+        }
+        conn->rx_len += ret;
+        uint64_t now = replay_now_ns();
+
+        int off = 0;
+        while (conn->rx_len - off >= 8) {
+            const uint8_t* adu = conn->rx_buf + off;
+            int frame_len = 6 + ((adu[4] << 8) | adu[5]);
+            if (conn->rx_len - off < frame_len) break;
+            uint16_t tid = (adu[0] << 8) | adu[1];
+            conn->inflight--;
+            result->replied++;
+            if (adu[7] & 0x80) result->exceptions++;
+            g_samples[g_sample_count++] = now - conn->sent_ns[tid % REPLAY_SLOTS];
+            replies++;
+            off += frame_len;
+        }
+        memmove(conn->rx_buf, conn->rx_buf + off, conn->rx_len - off);
+        conn->rx_len -= off;
+    }
+}
+
+/**
+ * Open the replay connection of a stream
+ * @param conn: Pointer to ReplayConn
+ * @param epfd: epoll instance the replies are read from
+ * @param addr: Gateway address
+ * @return 0 on success, -1 on failure
+ */
+static int replay_connect(ReplayConn* conn, int epfd, const struct sockaddr_in* addr)
+{
+    conn->fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (conn->fd < 0 || connect(conn->fd, (const struct sockaddr*)addr, sizeof(*addr)) < 0) {
+        perror("connect");
+        if (conn->fd >= 0) close(conn->fd);
+        conn->fd = -1;
+        return -1;
+    }
+    int opt = 1;
+    setsockopt(conn->fd, IPPROTO_TCP, TCP_NODELAY, &opt, sizeof(opt));
+    struct epoll_event ev;
+    ev.events = EPOLLIN;
+    ev.data.ptr = conn;
+    epoll_ctl(epfd, EPOLL_CTL_ADD, conn->fd, &ev);
+    return 0;
+}
+
+/**
+ * Replay the trace against one serial_server build
+ * Paced mode sends every request at its recorded offset (open loop) and opens each recorded connection
+ * at its first request and closes it once its last one is answered, so connection churn is replayed too.
+ * Fast mode keeps every connection open and sends the next request of a connection as soon as the
+ * previous one is answered (closed loop, as fast as possible)
+ * @param rp: Pointer to Replay
+ * @param server: serial_server binary
+ * @param fast: 1 = closed loop, 0 = recorded pacing
+ * @param loops: Times the trace is replayed
+ * @param tcp_port: Gateway port
+ * @param result: Output results
+ * @return 0 on success, -1 on failure
+ */
+static int replay_run(Replay* rp, const char* server, int fast, int loops, int tcp_port, ReplayResult* result)
+{
+    memset(result, 0, sizeof(ReplayResult));
+    for (int p = 1; p <= rp->port_count; p++) {
+        rp->buses[p].cursor = 0;
+        rp->buses[p].matched = 0;
+        rp->buses[p].synthesized = 0;
+    }
+    g_sample_count = 0;
+
+    // Slaves answer at the recorded speed, requests missing from the trace after the median delay
+    PtySim* sim = pty_sim_create(rp->port_count, 0, rp->median_delay_us);
+    if (!sim) {
+        fprintf(stderr, "Create simulated ports failed\n");
+        return -1;
+    }
+    pty_sim_set_responder(sim, replay_respond, rp);
+    char config_path[64];
+    char log_path[64];
+    snprintf(config_path, sizeof(config_path), "/tmp/replay_bench_%d.yaml", (int)getpid());
+    snprintf(log_path, sizeof(log_path), "/tmp/replay_bench_%d.log", (int)getpid());
+    if (pty_sim_write_config(sim, config_path, rp->stream_count + 16, tcp_port, 0) != 0) {
+        pty_sim_destroy(sim);
+        return -1;
+    }
+    pid_t pid = pty_sim_start_server(server, config_path, log_path, tcp_port);
+    if (pid < 0) {
+        pty_sim_destroy(sim);
+        return -1;
+    }
+
+    int ret = -1;
+    int epfd = epoll_create1(EPOLL_CLOEXEC);
+    if (epfd < 0) {
+        perror("epoll_create1");
+        goto out;
+    }
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(tcp_port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    for (int s = 0; s < rp->stream_count; s++) {
+        ReplayConn* conn = &g_conns[s];
+        int* reqs = conn->reqs;
+        int req_count = conn->req_count;
+        memset(conn, 0, sizeof(ReplayConn));
+        conn->reqs = reqs;
+        conn->req_count = req_count;
+        conn->fd = -1;
+        if (fast && replay_connect(conn, epfd, &addr) != 0) goto out;
+    }
+
+    // A gap of one millisecond between loops keeps the last and first requests apart
+    uint64_t loop_us = rp->span_us + 1000;
+    uint64_t total = (uint64_t)rp->req_count * loops;
+    uint64_t next = 0;
+    uint64_t inflight = 0;
+    uint64_t cpu0 = pty_sim_cpu_ns(pid);
+    uint64_t start = replay_now_ns();
+    uint64_t last_reply = start;
+    uint64_t progress = start;
+    if (fast) {
+        for (int s = 0; s < rp->stream_count; s++) {
+            ReplayConn* conn = &g_conns[s];
+            if (replay_send(rp, &rp->reqs[conn->reqs[0]], result) != 0) goto out;
+            conn->pos = 1;
+            next++;
+            inflight++;
+        }
+    }
+
+    struct epoll_event events[REPLAY_EVENTS];
+    for (;;) {
+        uint64_t now = replay_now_ns();
+        int timeout_ms = 100;
+        if (!fast) {
+            while (next < total) {
+                const ReplayReq* req = &rp->reqs[next % rp->req_count];
+                uint64_t due = start + ((next / rp->req_count) * loop_us + req->at_us) * 1000ULL;
+                if (due > now) {
+                    uint64_t wait_ms = (due - now + 999999) / 1000000;
+                    if (wait_ms < (uint64_t)timeout_ms) timeout_ms = (int)wait_ms;
+                    break;
+                }
+                ReplayConn* conn = &g_conns[req->stream];
+                if (conn->fd < 0 && replay_connect(conn, epfd, &addr) != 0) goto out;
+                if (replay_send(rp, req, result) != 0) goto out;
+                conn->pos++;
+                next++;
+                inflight++;
+                progress = now;
+            }
+        }
+        if (next >= total && inflight == 0) break;
+        if (now - progress > REPLAY_IDLE_MS * 1000000ULL) {
+            // Requests the server never answered (or, in fast mode, never let us send)
+            result->missing = inflight + (fast ? total - next : 0);
+            break;
+        }
+
+        int nfds = epoll_wait(epfd, events, REPLAY_EVENTS, timeout_ms);
+        if (nfds < 0 && errno != EINTR) break;
+        for (int e = 0; e < nfds; e++) {
+            ReplayConn* conn = (ReplayConn*)events[e].data.ptr;
+            int replies = replay_on_readable(conn, result);
+            if (replies < 0) {
+                fprintf(stderr, "Connection %d closed by the server\n", (int)(conn - g_conns));
+                goto out;
+            }
+            if (replies == 0) continue;
+            inflight -= replies;
+            last_reply = progress = replay_now_ns();
+            if (!fast && conn->inflight == 0 && conn->pos % conn->req_count == 0) {
+                // Last request of the recorded connection answered: hang up as the client did
+                close(conn->fd);
+                conn->fd = -1;
+                continue;
+            }
+            if (fast && conn->inflight == 0 && (uint64_t)conn->pos < (uint64_t)conn->req_count * loops) {
+                if (replay_send(rp, &rp->reqs[conn->reqs[conn->pos % conn->req_count]], result) != 0) goto out;
+                conn->pos++;
+                next++;
+                inflight++;
+            }
+        }
+    }
+    result->elapsed_ns = last_reply - start;
+    result->cpu_ns = pty_sim_cpu_ns(pid) - cpu0;
+    for (int p = 1; p <= rp->port_count; p++) {
+        result->matched += __atomic_load_n(&rp->buses[p].matched, __ATOMIC_RELAXED);
+        result->synthesized += __atomic_load_n(&rp->buses[p].synthesized, __ATOMIC_RELAXED);
+    }
+    uint64_t n = g_sample_count;
+    if (n > 0) {
+        qsort(g_samples, n, sizeof(uint64_t), replay_cmp_u64);
+        result->p50_ns = g_samples[n / 2];
+        result->p99_ns = g_samples[n * 99 / 100];
+        result->p999_ns = g_samples[n * 999 / 1000];
+        result->max_ns = g_samples[n - 1];
+    }
+    ret = 0;
+
+out:
+    for (int s = 0; s < rp->stream_count; s++) {
+        if (g_conns[s].fd >= 0) close(g_conns[s].fd);
+        g_conns[s].fd = -1;
+    }
+    if (epfd >= 0) close(epfd);
+    pty_sim_stop_server(pid);
+    pty_sim_destroy(sim);
+    if (ret != 0) {
+        fprintf(stderr, "Replay against %s aborted, server log: %s\n", server, log_path);
+    } else {
+        unlink(config_path);
+    }
+    return ret;
+}
+
+/**
+ * Print the results of one build
+ * @param name: Build label
+ * @param result: Results
+ */
+static void replay_print(const char* name, const ReplayResult* result)
+{
+    double secs = result->elapsed_ns > 0 ? result->elapsed_ns / 1e9 : 1e-9;
+    printf("%-9s requests %8llu replied %8llu (%llu exceptions, %llu missing)  %10.1f req/s\n", name,
+           (unsigned long long)result->sent, (unsigned long long)result->replied,
+           (unsigned long long)result->exceptions, (unsigned long long)result->missing, result->replied / secs);
+    printf("%-9s latency  p50 %8.3f ms  p99 %8.3f ms  p999 %8.3f ms  max %8.3f ms\n", name,
+           result->p50_ns / 1e6, result->p99_ns / 1e6, result->p999_ns / 1e6, result->max_ns / 1e6);
+    printf("%-9s server CPU %.1f us/request, bus requests %llu from trace / %llu not in trace\n", name,
+           result->replied > 0 ? result->cpu_ns / 1e3 / result->replied : 0.0,
+           (unsigned long long)result->matched, (unsigned long long)result->synthesized);
+}
+
+/**
+ * Compare one metric of the candidate against the baseline
+ * @param name: Metric label
+ * @param base: Baseline value
+ * @param cand: Candidate value
+ * @param higher_better: 1 if a larger value is better
+ * @param threshold_pct: Allowed deviation (%)
+ * @param floor: Absolute deviation that never fails
+ * @return 1 if the candidate is within the limit, 0 otherwise
+ */
+static int replay_check(const char* name, double base, double cand, int higher_better, int threshold_pct,
+                        double floor)
+{
+    double change = base > 0 ? (cand - base) * 100.0 / base : 0.0;
+    int pass;
+    if (higher_better) {
+        pass = cand >= base * (1.0 - threshold_pct / 100.0) || base - cand <= floor;
+    } else {
+        pass = cand <= base * (1.0 + threshold_pct / 100.0) || cand - base <= floor;
+    }
+    printf("%-12s %12.3f %12.3f %+8.1f%%   %s\n", name, base, cand, change, pass ? "PASS" : "FAIL");
+    return pass;
+}
+
+/**
+ * Print usage
+ * @param prog: Program name
+ */
+static void replay_usage(const char* prog)
+{
+    printf("Usage: %s [-f] [-n loops] [-T threshold_pct] [-p tcp_port] <trace> <serial_server> [<candidate>]\n",
+           prog);
+    printf("Replay a trace recorded with \"trace record all <file>\" against serial_server: every\n"
+           "recorded connection gets its own Modbus TCP connection, pseudo-terminal slaves answer with\n"
+           "the recorded responses after the recorded delays. Requests follow the recorded timing\n"
+           "unless -f sends them back to back. The server listens on [tcp_port] (default 8888).\n"
+           "With a candidate build both are replayed and the\n"
+           "candidate fails if throughput, p50 or p99 latency is more than [threshold_pct] (default %d)\n"
+           "worse, or it leaves more requests unanswered (exit status 3)\n", REPLAY_THRESHOLD_PCT);
+}
+
+int main(int argc, char** argv)
+{
+    int fast = 0;
+    int loops = 1;
+    int threshold_pct = REPLAY_THRESHOLD_PCT;
+    int tcp_port = 8888;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "fn:T:p:h")) != -1) {
+        switch (opt) {
+            case 'f': fast = 1; break;
+            case 'n': loops = atoi(optarg); break;
+            case 'T': threshold_pct = atoi(optarg); break;
+            case 'p': tcp_port = atoi(optarg); break;
+            default:
+                replay_usage(argv[0]);
+                return 1;
+        }
+    }
+    if (argc - optind < 2 || argc - optind > 3 || loops <= 0 || threshold_pct < 0) {
+        replay_usage(argv[0]);
+        return 1;
+    }
+    const char* trace_path = argv[optind];
+    const char* baseline = argv[optind + 1];
+    const char* candidate = argc - optind == 3 ? argv[optind + 2] : NULL;
+
+    Replay* rp = (Replay*)malloc(sizeof(Replay));
+    if (!rp) return 1;
+    memset(rp, 0, sizeof(Replay));
+    if (replay_load(rp, trace_path) != 0) return 1;
+
+    // Requests of each connection in trace order
+    for (int i = 0; i < rp->req_count; i++) g_conns[rp->reqs[i].stream].req_count++;
+    for (int s = 0; s < rp->stream_count; s++) {
+        g_conns[s].reqs = (int*)malloc(g_conns[s].req_count * sizeof(int));
+        if (!g_conns[s].reqs) return 1;
+        g_conns[s].req_count = 0;
+        g_conns[s].fd = -1;
+    }
+    for (int i = 0; i < rp->req_count; i++) {
+        ReplayConn* conn = &g_conns[rp->reqs[i].stream];
+        conn->reqs[conn->req_count++] = i;
+    }
+    g_samples = (uint64_t*)malloc((size_t)rp->req_count * loops * sizeof(uint64_t));
+    if (!g_samples) return 1;
+
+    int exchanges = 0;
+    for (int p = 1; p <= rp->port_count; p++) exchanges += rp->buses[p].count;
+    printf("%s: %d requests from %d connections over %.3f s, %d buses, %d bus exchanges (median %u us)",
+           trace_path, rp->req_count, rp->stream_count, rp->span_us / 1e6, rp->port_count, exchanges,
+           rp->median_delay_us);
+    if (rp->skipped > 0) printf(", %d frames skipped", rp->skipped);
+    printf("\nreplay: %s, %d loop(s)\n", fast ? "back to back" : "recorded timing", loops);
+
+    ReplayResult base;
+    if (replay_run(rp, baseline, fast, loops, tcp_port, &base) != 0) return 1;
+    replay_print("baseline", &base);
+    if (!candidate) return base.missing > 0 ? 3 : 0;
+
+    ReplayResult cand;
+    if (replay_run(rp, candidate, fast, loops, tcp_port, &cand) != 0) return 1;
+    replay_print("candidate", &cand);
+
+    double base_secs = base.elapsed_ns > 0 ? base.elapsed_ns / 1e9 : 1e-9;
+    double cand_secs = cand.elapsed_ns > 0 ? cand.elapsed_ns / 1e9 : 1e-9;
+    double floor_ms = REPLAY_LAT_FLOOR_US / 1e3;
+    printf("\n%-12s %12s %12s %9s   (threshold %d%%)\n", "metric", "baseline", "candidate", "change", threshold_pct);
+    int pass = 1;
+    pass &= replay_check("req/s", base.replied / base_secs, cand.replied / cand_secs, 1, threshold_pct, 0.0);
+    pass &= replay_check("p50 ms", base.p50_ns / 1e6, cand.p50_ns / 1e6, 0, threshold_pct, floor_ms);
+    pass &= replay_check("p99 ms", base.p99_ns / 1e6, cand.p99_ns / 1e6, 0, threshold_pct, floor_ms);
+    pass &= replay_check("missing", (double)base.missing, (double)cand.missing, 0, 0, 0.0);
+    printf("RESULT: %s\n", pass ? "PASS" : "FAIL");
+    return pass ? 0 : 3;
+}
@@ -0,0 +1,363 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <poll.h>
+#include <getopt.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+#include "pty_sim.h"
+
+#define BENCH_MAX_REQS 1000000
+#define BENCH_MAX_WINDOW 1024
+#define BENCH_DEFAULT_WINDOW 8           // Below the per-requester read cap (14 with queue_depth 32)
+#define BENCH_TIMEOUT_MS 2000            // Stop when no reply arrives for this long
+#define BENCH_BATCH 32                   // Datagrams per sendmmsg / recvmmsg call
+
+// Results of one transport run
+typedef struct {
+    int sent;
+    int replied;
+    int exceptions;
+    uint64_t elapsed_ns;
+} BenchRun;
+
+static uint64_t g_sent_ns[65536];        // Send time by transaction ID
+static uint64_t g_samples[BENCH_MAX_REQS];
+
+/**
+ * Get monotonic time in nanoseconds
+ * @return Current CLOCK_MONOTONIC time (ns)
+ */
+static uint64_t bench_now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/**
+ * Compare two uint64_t (qsort)
+ * @param a: Pointer to first value
+ * @param b: Pointer to second value
+ * @return <0, 0 or >0
+ */
+static int bench_cmp_u64(const void* a, const void* b)
+{
+    uint64_t x = *(const uint64_t*)a;
+    uint64_t y = *(const uint64_t*)b;
+    return x < y ? -1 : x > y;
+}
+
+/**
+ * Build an FC03 request (address 0, 1 register)
+ * @param tid: Transaction ID
+ * @param unit_id: MBAP unit ID (UART index of the target bus)
+ * @param req: Output buffer (12 bytes)
+ */
+static void bench_build_req(uint16_t tid, uint8_t unit_id, uint8_t* req)
+{
+    uint8_t tmpl[12] = { tid >> 8, tid & 0xFF, 0, 0, 0, 6, unit_id, 0x03, 0, 0, 0, 1 };
+    memcpy(req, tmpl, sizeof(tmpl));
+}
+
+/**
+ * Account one reply
+ * @param adu: MBAP reply
+ * @param len: Reply length
+ * @param run: Result counters
+ */
+static void bench_on_reply(const uint8_t* adu, int len, BenchRun* run)
+{
+    if (len < 8) return;
+    uint16_t tid = (adu[0] << 8) | adu[1];
+    if (g_sent_ns[tid] == 0) return;
+    g_samples[run->replied++] = bench_now_ns() - g_sent_ns[tid];
+    g_sent_ns[tid] = 0;
+    if (adu[7] & 0x80) run->exceptions++;
+}
+
+/**
+ * Print throughput and latency percentiles of a run
+ * @param name: Row label
+ * @param run: Result counters
+ */
+static void bench_print(const char* name, BenchRun* run)
+{
+    // Exceptions (e.g. 0x06 slave busy) never reach the bus: count them apart from real replies
+    double secs = (run->elapsed_ns ? run->elapsed_ns : 1) / 1e9;
+    printf("%-4s %d sent, %d replied (%d exceptions) in %.1f ms: %.0f req/s, %.0f non-exception req/s\n",
+           name, run->sent, run->replied, run->exceptions, run->elapsed_ns / 1e6, run->replied / secs,
+           (run->replied - run->exceptions) / secs);
+    int n = run->replied;
+    if (n == 0) return;
+    qsort(g_samples, n, sizeof(uint64_t), bench_cmp_u64);
+    printf("     p50 %8.3f ms  p90 %8.3f ms  p99 %8.3f ms  max %8.3f ms\n",
+           g_samples[n / 2] / 1e6, g_samples[n * 9 / 10] / 1e6,
+           g_samples[n * 99 / 100] / 1e6, g_samples[n - 1] / 1e6);
+}
+
+/**
+ * Run n requests over Modbus/UDP with up to window requests in flight
+ * @param addr: Server UDP address
+ * @param n: Number of requests
+ * @param window: Requests in flight
+ * @param unit_id: MBAP unit ID
+ * @param run: Result counters
+ * @return 0 on success, -1 on failure
+ */
+static int bench_udp(const struct sockaddr_in* addr, int n, int window, uint8_t unit_id, BenchRun* run)
+{
+    int fd = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    if (fd < 0 || connect(fd, (const struct sockaddr*)addr, sizeof(*addr)) < 0) {
+        perror("udp socket");
+        if (fd >= 0) close(fd);
+        return -1;
+    }
+    int rcvbuf = 4 * 1024 * 1024;
+    setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+
+    struct mmsghdr msgs[BENCH_BATCH];
+    struct iovec iov[BENCH_BATCH];
+    uint8_t bufs[BENCH_BATCH][300];
+    memset(g_sent_ns, 0, sizeof(g_sent_ns));
+    memset(run, 0, sizeof(BenchRun));
+
+    uint64_t start = bench_now_ns();
+    uint64_t last_rx = start;
+    while (run->replied < n) {
+        // Top the window up, one sendmmsg per BENCH_BATCH requests
+        while (run->sent < n && run->sent - run->replied < window) {
+            int cnt = 0;
+            memset(msgs, 0, sizeof(msgs));
+            while (cnt < BENCH_BATCH && run->sent + cnt < n && run->sent + cnt - run->replied < window) {
+                uint16_t tid = (uint16_t)(run->sent + cnt);
+                bench_build_req(tid, unit_id, bufs[cnt]);
+                iov[cnt].iov_base = bufs[cnt];
+                iov[cnt].iov_len = 12;
+                msgs[cnt].msg_hdr.msg_iov = &iov[cnt];
+                msgs[cnt].msg_hdr.msg_iovlen = 1;
+                g_sent_ns[tid] = bench_now_ns();
+                cnt++;
+            }
+            int ret = sendmmsg(fd, msgs, cnt, 0);
+            if (ret <= 0) {
+                perror("sendmmsg");
+                close(fd);
+                return -1;
+            }
+            run->sent += ret;
+        }
+
+        struct pollfd pfd = { fd, POLLIN, 0 };
+        if (poll(&pfd, 1, 100) <= 0) {
+            if (bench_now_ns() - last_rx > BENCH_TIMEOUT_MS * 1000000ULL) break;
+            continue;
+        }
+        memset(msgs, 0, sizeof(msgs));
+        for (int i = 0; i < BENCH_BATCH; i++) {
+            iov[i].iov_base = bufs[i];
+            iov[i].iov_len = sizeof(bufs[i]);
+            msgs[i].msg_hdr.msg_iov = &iov[i];
+            msgs[i].msg_hdr.msg_iovlen = 1;
+        }
+        int ret = recvmmsg(fd, msgs, BENCH_BATCH, MSG_DONTWAIT, NULL);
+        for (int i = 0; i < ret; i++) {
+            bench_on_reply(bufs[i], msgs[i].msg_len, run);
+        }
+        if (ret > 0) last_rx = bench_now_ns();
+        // Lost datagrams are never answered: the window shrinks instead of stalling forever
+        if (run->sent == n && bench_now_ns() - last_rx > BENCH_TIMEOUT_MS * 1000000ULL) break;
+    }
+    run->elapsed_ns = bench_now_ns() - start;
+    close(fd);
+    return 0;
+}
+
+/**
+ * Run n requests over one Modbus TCP connection with up to window requests in flight
+ * @param addr: Server TCP address
+ * @param n: Number of requests
+ * @param window: Requests in flight
+ * @param unit_id: MBAP unit ID
+ * @param run: Result counters
+ * @return 0 on success, -1 on failure
+ */
+static int bench_tcp(const struct sockaddr_in* addr, int n, int window, uint8_t unit_id, BenchRun* run)
+{
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0 || connect(fd, (const struct sockaddr*)addr, sizeof(*addr)) < 0) {
+        perror("tcp connect");
+        if (fd >= 0) close(fd);
+        return -1;
+    }
+    int opt = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &opt, sizeof(opt));
+
+    uint8_t txbuf[BENCH_MAX_WINDOW * 12];
+    uint8_t rxbuf[8192];
+    int rx_len = 0;
+    memset(g_sent_ns, 0, sizeof(g_sent_ns));
+    memset(run, 0, sizeof(BenchRun));
+
+    uint64_t start = bench_now_ns();
+    uint64_t last_rx = start;
+    while (run->replied < n) {
+        int cnt = 0;
+        while (run->sent + cnt < n && run->sent + cnt - run->replied < window) {
+            uint16_t tid = (uint16_t)(run->sent + cnt);
+            bench_build_req(tid, unit_id, txbuf + cnt * 12);
+            g_sent_ns[tid] = bench_now_ns();
+            cnt++;
+        }
+        if (cnt > 0) {
+            if (send(fd, txbuf, cnt * 12, MSG_NOSIGNAL) != cnt * 12) {
+                perror("send");
+                close(fd);
+                return -1;
+            }
+            run->sent += cnt;
+        }
+
+        struct pollfd pfd = { fd, POLLIN, 0 };
+        if (poll(&pfd, 1, 100) <= 0) {
+            if (bench_now_ns() - last_rx > BENCH_TIMEOUT_MS * 1000000ULL) break;
+            continue;
+        }
+        ssize_t ret = recv(fd, rxbuf + rx_len, sizeof(rxbuf) - rx_len, MSG_DONTWAIT);
+        if (ret == 0) break;
+        if (ret < 0) {
+            if (errno == EAGAIN || errno == EINTR) continue;
+            break;
+        }
+        rx_len += ret;
+        last_rx = bench_now_ns();
+
+        // Split the stream into MBAP frames
+        int off = 0;
+        while (rx_len - off >= 6) {
+            int frame_len = 6 + ((rxbuf[off + 4] << 8) | rxbuf[off + 5]);
+            if (rx_len - off < frame_len) break;
+            bench_on_reply(rxbuf + off, frame_len, run);
+            off += frame_len;
+        }
+        memmove(rxbuf, rxbuf + off, rx_len - off);
+        rx_len -= off;
+    }
+    run->elapsed_ns = bench_now_ns() - start;
+    close(fd);
+    return 0;
+}
+
+/**
+ * Print usage
+ * @param prog: Program name
+ */
+static void bench_usage(const char* prog)
+{
+    printf("Usage: %s [-s serial_server] [-b baud] <ip> <udp_port> <tcp_port> [requests] [window] [unit_id]\n",
+           prog);
+    printf("Send [requests] FC03 requests (default 10000) with [window] in flight (default %d)\n"
+           "over Modbus/UDP, then over one Modbus TCP connection, and compare the two.\n"
+           "With -s, serial_server is started on those ports with a simulated Modbus RTU slave\n"
+           "behind unit [unit_id] on a pseudo-terminal, paced at [baud] (default 0 = unpaced),\n"
+           "so every request goes through the RTU conversion path; <ip> must be local then.\n"
+           "Keep [window] at or below the per-requester read cap ((queue_depth - 4 + 1) / 2),\n"
+           "larger windows measure 0x06 slave busy exceptions\n", BENCH_DEFAULT_WINDOW);
+}
+
+int main(int argc, char** argv)
+{
+    const char* server = NULL;
+    int baud = 0;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "s:b:h")) != -1) {
+        switch (opt) {
+            case 's': server = optarg; break;
+            case 'b': baud = atoi(optarg); break;
+            default:
+                bench_usage(argv[0]);
+                return 1;
+        }
+    }
+    argc -= optind - 1;
+    argv += optind - 1;
+    if (argc < 4) {
+        bench_usage(argv[0]);
+        return 1;
+    }
+
+    struct sockaddr_in udp_addr;
+    memset(&udp_addr, 0, sizeof(udp_addr));
+    udp_addr.sin_family = AF_INET;
+    if (inet_pton(AF_INET, argv[1], &udp_addr.sin_addr) <= 0) {
+        printf("Invalid ip: %s\n", argv[1]);
+        return 1;
+    }
+    struct sockaddr_in tcp_addr = udp_addr;
+    udp_addr.sin_port = htons(atoi(argv[2]));
+    tcp_addr.sin_port = htons(atoi(argv[3]));
+    int n = argc > 4 ? atoi(argv[4]) : 10000;
+    int window = argc > 5 ? atoi(argv[5]) : BENCH_DEFAULT_WINDOW;
+    uint8_t unit_id = argc > 6 ? (uint8_t)atoi(argv[6]) : 1;
+    if (n <= 0 || n > BENCH_MAX_REQS || window <= 0 || window > BENCH_MAX_WINDOW) {
+        printf("requests must be 1..%d, window 1..%d\n", BENCH_MAX_REQS, BENCH_MAX_WINDOW);
+        return 1;
+    }
+    if (server && (unit_id < 1 || unit_id > PTY_SIM_MAX_PORTS || baud < 0)) {
+        printf("With -s, unit_id must be 1..%d\n", PTY_SIM_MAX_PORTS);
+        return 1;
+    }
+
+    // Slaves 1..unit_id on pseudo-terminals, only the benchmarked one sees traffic
+    PtySim* sim = NULL;
+    pid_t pid = -1;
+    char config_path[64];
+    char log_path[64];
+    if (server) {
+        snprintf(config_path, sizeof(config_path), "/tmp/udp_bench_%d.yaml", (int)getpid());
+        snprintf(log_path, sizeof(log_path), "/tmp/udp_bench_%d.log", (int)getpid());
+        sim = pty_sim_create(unit_id, baud, 0);
+        if (!sim || pty_sim_write_config(sim, config_path, 0, atoi(argv[3]), atoi(argv[2])) != 0) {
+            fprintf(stderr, "Create simulated ports failed\n");
+            pty_sim_destroy(sim);
+            return 1;
+        }
+        pid = pty_sim_start_server(server, config_path, log_path, atoi(argv[3]));
+        if (pid < 0) {
+            pty_sim_destroy(sim);
+            return 1;
+        }
+    }
+
+    printf("%d requests, window %d, unit %u%s\n", n, window, unit_id,
+           server ? " (simulated RTU slave)" : "");
+    BenchRun udp_run;
+    BenchRun tcp_run;
+    int ret = 1;
+    if (bench_udp(&udp_addr, n, window, unit_id, &udp_run) == 0) {
+        bench_print("UDP", &udp_run);
+        if (bench_tcp(&tcp_addr, n, window, unit_id, &tcp_run) == 0) {
+            bench_print("TCP", &tcp_run);
+            ret = udp_run.replied == n && tcp_run.replied == n ? 0 : 2;
+        }
+    }
+    if (server) {
+        pty_sim_stop_server(pid);
+        pty_sim_destroy(sim);
+        if (ret == 1) {
+            fprintf(stderr, "Benchmark aborted, server log: %s\n", log_path);
+        } else {
+            unlink(config_path);
+        }
+    }
+    return ret;
+}
@@ -1,13 +1,12 @@
+#define LOG_MODULE LOG_MOD_CLI
 #include "cli_mgr.h"
 
-/*
 static char* cli_command_generator(const char* text, int state);
 static char** cli_command_completion(const char* text, int start, int end);
-*/
 
 //brief List of supported CLI commands (NULL-terminated)
 static const char* cli_cmd_list[] = {
-    "uart_status", "uart_set", "net_status", "log_level", "help", "exit", NULL
+    "uart_status", "uart_set", "net_status", "log_level", "loop_status", "poll_status", "trace", "stats", "help", "exit", NULL
 };  
 
 /**
@@ -45,6 +44,10 @@ static CliCmdType cli_parse_cmd(int argc, char** argv)
     if (strcmp(argv[0], "uart_set") == 0) return CMD_UART_SET;
     if (strcmp(argv[0], "net_status") == 0) return CMD_NET_STATUS;
     if (strcmp(argv[0], "log_level") == 0) return CMD_LOG_LEVEL;
+    if (strcmp(argv[0], "loop_status") == 0) return CMD_LOOP_STATUS;
+    if (strcmp(argv[0], "poll_status") == 0) return CMD_POLL_STATUS;
+    if (strcmp(argv[0], "trace") == 0) return CMD_TRACE;
+    if (strcmp(argv[0], "stats") == 0) return CMD_STATS;
     if (strcmp(argv[0], "help") == 0) return CMD_HELP;
     if (strcmp(argv[0], "exit") == 0) return CMD_EXIT;
 
@@ -69,8 +72,9 @@ static void cli_exec_uart_status(int argc, char** argv)
         return;
     }
 
-    UartDev status;
+    UartStatus status;
     uart_mgr_get_status(g_uart_mgr, uart_idx, &status);
+    const UartCounters* ctr = &status.counters;
     printf("========= UART %d Status =========\n", uart_idx);
     printf("Dev Path:    %s\n", status.config.dev_path);
     printf("Enable:      %s\n", status.config.enable ? "YES" : "NO");
@@ -80,9 +84,72 @@ static void cli_exec_uart_status(int argc, char** argv)
     printf("Stopbit:     %d\n", status.config.stopbit);
     printf("Parity:      %c\n", status.config.parity);
     printf("Flow Ctrl:   %d\n", status.config.flow_ctrl);
-    printf("RX Bytes:    %lu\n", status.rx_bytes);
-    printf("TX Bytes:    %lu\n", status.tx_bytes);
-    printf("Error Count: %u\n", status.err_count);
+    if (status.config.tcp_port > 0) {
+        printf("TCP Port:    %d\n", status.config.tcp_port);
+    }
+    printf("RX Bytes:    %lu\n", ctr->rx_bytes);
+    printf("TX Bytes:    %lu\n", ctr->tx_bytes);
+    printf("Error Count: %lu\n", ctr->err_count);
+    if (!status.config.modbus_enable) {
+        printf("RX Path:     splice %lu bytes, copy %lu bytes (%s)\n",
+               ctr->rx_splice_bytes, ctr->rx_copy_bytes,
+               status.splice_active ? "splice" : "copy");
+        printf("TX Path:     splice %lu bytes, copy %lu bytes (%s)\n",
+               ctr->tx_splice_bytes, ctr->tx_copy_bytes,
+               status.tx_splice_active ? "splice" : "copy");
+    }
+    if (status.config.modbus_enable) {
+        printf("Event Loop:  %s", status.worker > 0 ? "worker" : "main");
+        uint32_t req_full = 0, resp_full = 0;
+        if (modbus_gw_get_queue_stats(g_modbus_gw, uart_idx, &req_full, &resp_full) == 0) {
+            printf(" %d (cpu %d), req queue full %u, resp queue full %u",
+                   status.worker, status.worker_cpu, req_full, resp_full);
+        }
+        printf("\n");
+        printf("RTU t1.5/t3.5: %u/%u us\n", status.t15_us, status.t35_us);
+        printf("RTU Frames:  %lu\n", ctr->rtu_frames);
+        printf("RTU Errors:  framing %lu, crc %lu, overrun %lu\n",
+               ctr->rtu_frame_err, ctr->rtu_crc_err, ctr->rtu_overrun_err);
+
+        ModbusBusStats bus_stats;
+        int depth = 0;
+        memset(&bus_stats, 0, sizeof(bus_stats));
+        modbus_gw_get_bus_stats(g_modbus_gw, uart_idx, &bus_stats, &depth);
+        printf("Txn Queue:   %d outstanding (max %u, full %u)\n", depth, bus_stats.max_depth, bus_stats.queue_full);
+        printf("Txn Stats:   req %lu, resp %lu, timeout %u, unmatched %u, dropped %u, coalesced %lu\n",
+               bus_stats.requests, bus_stats.responses, bus_stats.timeouts,
+               bus_stats.unmatched, bus_stats.dropped, bus_stats.coalesced);
+        ModbusSchedStats sched_stats[MODBUS_CLASS_NUM];
+        int max_depth = 0;
+        if (modbus_gw_get_sched_stats(g_modbus_gw, uart_idx, sched_stats, &max_depth) == 0) {
+            static const char* cls_names[MODBUS_CLASS_NUM] = { "write", "read", "poll" };
+            printf("Scheduler:   depth limit %d (%d reserved for writes)\n", max_depth,
+                   max_depth > MODBUS_SCHED_WRITE_RESERVE * 2 ? MODBUS_SCHED_WRITE_RESERVE : 0);
+            for (int c = 0; c < MODBUS_CLASS_NUM; c++) {
+                const ModbusSchedStats* st = &sched_stats[c];
+                printf("  %-6s     queued %u, sent %lu, rejected %u, wait avg %lu us, max %lu us\n",
+                       cls_names[c], st->queued, st->dispatched, st->rejected,
+                       st->dispatched ? st->wait_ns_total / st->dispatched / 1000 : 0,
+                       st->wait_ns_max / 1000);
+            }
+        }
+        if (status.config.merge_max_regs > 0) {
+            printf("Read Merge:  max %d regs, gap %d, %lu reads in %lu requests, fallback %u\n",
+                   status.config.merge_max_regs, status.config.merge_gap,
+                   bus_stats.merged, bus_stats.merge_txns, bus_stats.merge_fallbacks);
+        }
+
+        ModbusCacheStats cache_stats;
+        uint32_t ttl_ms = 0;
+        if (modbus_gw_get_cache_stats(g_modbus_gw, uart_idx, &cache_stats, &ttl_ms) == 0) {
+            uint64_t lookups = cache_stats.hits + cache_stats.misses;
+            printf("Cache:       ttl %u ms, hit %lu, miss %lu (%.1f%% hit)\n", ttl_ms,
+                   cache_stats.hits, cache_stats.misses,
+                   lookups ? cache_stats.hits * 100.0 / lookups : 0.0);
+            printf("Cache Drops: expired %u, evicted %u, invalidated %u\n",
+                   cache_stats.expired, cache_stats.evictions, cache_stats.invalidations);
+        }
+    }
     printf("FD:          %d\n", status.fd);
     printf("==================================\n");
 }
@@ -108,13 +175,8 @@ static void cli_exec_uart_set(int argc, char** argv)
         return;
     }
 
-    UartDev uart_dev;
-    uart_mgr_get_status(g_uart_mgr, uart_idx, &uart_dev);
-    if (&uart_dev == 0) {
-        LOG_ERROR("Failed to get UART %d status", uart_idx);
-        return;
-    }
-    UartConfig new_config = uart_dev.config;
+    UartConfig new_config;
+    uart_mgr_get_config(g_uart_mgr, uart_idx, &new_config);
 
     for (int i = 3; i < argc; i += 2) {
         if (i + 1 >= argc) {
@@ -180,8 +242,8 @@ static void cli_exec_uart_set(int argc, char** argv)
         return;
     }
 
-    LOG_INFO("UART %d configuration updated successfully!", uart_idx);
-    printf("===== Updated UART %d Config =====\n", uart_idx);
+    LOG_INFO("UART %d reconfiguration queued, applied once the port is idle", uart_idx);
+    printf("===== Requested UART %d Config =====\n", uart_idx);
     printf("Enable:      %s\n", new_config.enable ? "YES" : "NO");
     printf("Modbus Enable: %s\n", new_config.modbus_enable ? "YES" : "NO");
     printf("Baudrate:    %d\n", new_config.baudrate);
@@ -195,27 +257,41 @@ static void cli_exec_uart_set(int argc, char** argv)
 /**
  * @brief Execute log_level command
  * @param argc: Number of arguments
- * @param argv: Argument array (argv[1] = log level string)
+ * @param argv: Argument array (argv[1] = log level string, argv[2] = module, default all)
  */
 static void cli_exec_log_level(int argc, char** argv)
 {
     if (argc < 2) {
-        LOG_WARN("Usage: log_level <debug/info/warn/error/fatal>");
+        printf("Log levels (build minimum %s):", log_level_to_str((LogLevel)LOG_COMPILE_LEVEL));
+        for (int i = 0; i < LOG_MOD_NUM; i++) {
+            printf(" %s=%s", log_module_to_str((LogModule)i), log_level_to_str(g_log_levels[i]));
+        }
+        printf("\n");
+        printf("Log records dropped: %lu\n", log_get_dropped());
         return;
     }
 
-    LogLevel level = LOG_LEVEL_DEFAULT;
-    if (strcmp(argv[1], "debug") == 0) level = LOG_LEVEL_DEBUG;
-    if (strcmp(argv[1], "info") == 0) level = LOG_LEVEL_INFO;
-    if (strcmp(argv[1], "warn") == 0) level = LOG_LEVEL_WARN;
-    if (strcmp(argv[1], "error") == 0) level = LOG_LEVEL_ERROR;
-    if (strcmp(argv[1], "fatal") == 0) level = LOG_LEVEL_FATAL;
-    else {
+    LogLevel level;
+    if (log_level_from_str(argv[1], &level) != 0) {
         LOG_WARN("Invalid log level %s", argv[1]);
+        LOG_WARN("Usage: log_level [<debug/info/warn/error/fatal> [core/uart/net/modbus/cli]]");
+        return;
+    }
+
+    if (argc >= 3) {
+        LogModule module;
+        if (log_module_from_str(argv[2], &module) != 0) {
+            LOG_WARN("Invalid log module %s", argv[2]);
+            return;
+        }
+        g_log_levels[module] = level;
+        LOG_INFO("Log level of %s set to %s", log_module_to_str(module), log_level_to_str(level));
         return;
     }
 
-    g_log_level = level;
+    for (int i = 0; i < LOG_MOD_NUM; i++) {
+        g_log_levels[i] = level;
+    }
     LOG_INFO("Log level set to %s", log_level_to_str(level));
 }
 
@@ -236,25 +312,362 @@ static void cli_exec_net_status(int argc, char** argv)
            g_net_mgr->mode == NET_MODE_TCP_SERVER ? "TCP Server" :
            g_net_mgr->mode == NET_MODE_TCP_CLIENT ? "TCP Client" : "UDP");
     printf("Server FD: %d\n", g_net_mgr->server_fd);
+    if (g_net_mgr->udp_fd >= 0) {
+        uint64_t udp[NET_UDP_CTR_NUM];
+        stats_ctr_snapshot(&g_net_mgr->udp_ctr, udp, NET_UDP_CTR_NUM);
+        printf("UDP: port %d, RX %lu datagrams in %lu batches (%lu truncated), "
+               "TX %lu datagrams in %lu batches, drops %lu\n",
+               g_net_mgr->udp_port,
+               udp[NET_UDP_CTR_RX_DATAGRAMS], udp[NET_UDP_CTR_RX_BATCHES], udp[NET_UDP_CTR_RX_ERRORS],
+               udp[NET_UDP_CTR_TX_DATAGRAMS], udp[NET_UDP_CTR_TX_BATCHES], udp[NET_UDP_CTR_TX_DROPS]);
+    }
 
-    if (g_net_mgr->mode == NET_MODE_TCP_SERVER) {
+    if (g_net_mgr->mode != NET_MODE_UDP) {
+        printf("TX Policy: %s (max %d bytes per client)\n",
+               g_net_mgr->tx_policy == NET_TX_POLICY_DISCONNECT ? "disconnect" : "drop",
+               g_net_mgr->tx_max_bytes);
+        printf("Clients: %d connected, max %d, backlog %d, %d slots, %u rejected\n",
+               g_net_mgr->client_count, g_net_mgr->max_clients, g_net_mgr->backlog,
+               net_mgr_get_slot_count(g_net_mgr), g_net_mgr->rejected);
+        printf("Listeners:");
+        for (int i = 0; i < g_net_mgr->listener_count; i++) {
+            printf(" %d (%d clients)", g_net_mgr->listeners[i].port, g_net_mgr->listeners[i].client_count);
+        }
+        printf("\n");
         printf("Active TCP Clients:\n");
-        for (int i = 0; i < MAX_CLIENT_NUM; i++) {
-            if (g_net_mgr->clients[i].connected) {
-                printf("  Client %d: %s:%d, RX Bytes: %lu, TX Bytes: %lu\n",
+        int slots = net_mgr_get_slot_count(g_net_mgr);
+        for (int i = 0; i < slots; i++) {
+            TcpClient* client = net_mgr_get_client(g_net_mgr, i);
+            if (client && client->connected) {
+                NetClientCounters ctr;
+                net_mgr_get_client_counters(g_net_mgr, i, &ctr);
+                char via[16];
+                if (client->upstream) {
+                    snprintf(via, sizeof(via), "upstream");
+                } else {
+                    snprintf(via, sizeof(via), "port %d", client->listener->port);
+                }
+                printf("  Client %d: %s:%d -> %s, RX Bytes: %lu, TX Bytes: %lu\n",
                        i,
-                       inet_ntoa(g_net_mgr->clients[i].addr.sin_addr),
-                       ntohs(g_net_mgr->clients[i].addr.sin_port),
-                       g_net_mgr->clients[i].rx_bytes,
-                       g_net_mgr->clients[i].tx_bytes);
+                       inet_ntoa(client->addr.sin_addr),
+                       ntohs(client->addr.sin_port),
+                       via,
+                       ctr.rx_bytes,
+                       ctr.tx_bytes);
+                printf("    TX Queue: %d bytes in %d msgs (max %d), drops %lu\n",
+                       client->tx_queued_bytes,
+                       client->tx_count,
+                       client->tx_max_queued,
+                       ctr.tx_drops);
             }
         }
-    } else if (g_net_mgr->mode == NET_MODE_TCP_CLIENT) {
-        printf("Client FD: %d\n", g_net_mgr->client_fd);
+    }
+    if (g_net_mgr->upstream_count > 0) {
+        printf("Upstreams:\n");
+        for (int i = 0; i < g_net_mgr->upstream_count; i++) {
+            NetUpstream* up = &g_net_mgr->upstreams[i];
+            printf("  %s:%d: %s", up->host, up->port,
+                   up->state == NET_UPSTREAM_CONNECTED ? "connected" :
+                   up->state == NET_UPSTREAM_CONNECTING ? "connecting" : "waiting to retry");
+            if (up->state == NET_UPSTREAM_CONNECTED) {
+                printf(" (client %d)", up->client_idx);
+            }
+            printf(", %u connects, %u failures\n", up->connects, up->failures);
+        }
     }
     printf("==================================\n");
 }
 
+/**
+ * @brief Print utilisation of the bus worker loops (lifetime averages)
+ */
+static void cli_print_worker_status(void)
+{
+    for (int g = 1; g <= MAX_UART_NUM; g++) {
+        Reactor* worker = g_uart_mgr ? g_uart_mgr->workers[g] : NULL;
+        if (!worker) continue;
+
+        ReactorStats st;
+        reactor_get_stats(worker, &st);
+        if (st.uptime_ns == 0) continue;
+
+        char uarts[64] = {0};
+        int off = 0;
+        for (int i = 0; i < MAX_UART_NUM && off < (int)sizeof(uarts) - 4; i++) {
+            if (g_uart_mgr->uarts[i].fd >= 0 && g_uart_mgr->uarts[i].reactor == worker) {
+                off += snprintf(uarts + off, sizeof(uarts) - off, "%s%d", off ? "," : "", i);
+            }
+        }
+
+        double up_s = st.uptime_ns / 1e9;
+        printf("Worker %-2d:     uart %s, cpu %d, %.1f wakeups/s, %.2f events/wakeup, CPU %.3f%%, busy %.3f%%\n",
+               g, uarts, worker->cpu, st.wakeups / up_s,
+               st.wakeups ? (double)st.events / st.wakeups : 0.0,
+               100.0 * st.cpu_ns / st.uptime_ns,
+               100.0 * st.busy_ns / (double)(st.idle_ns + st.busy_ns + 1));
+    }
+}
+
+/**
+ * @brief Execute loop_status command (event loop wake-up rate and idle CPU)
+ *
+ * Prints lifetime averages and the rates since the previous loop_status call.
+ * @param argc: Number of arguments
+ * @param argv: Argument array
+ */
+static void cli_exec_loop_status(int argc, char** argv)
+{
+    static ReactorStats last;
+    ReactorStats now;
+
+    if (!g_reactor) {
+        LOG_WARN("Reactor not initialized");
+        return;
+    }
+    reactor_get_stats(g_reactor, &now);
+    if (now.uptime_ns == 0) {
+        LOG_WARN("Reactor not running");
+        return;
+    }
+
+    double up_s = now.uptime_ns / 1e9;
+    double win_s = (now.uptime_ns - last.uptime_ns) / 1e9;
+    uint64_t win_wakeups = now.wakeups - last.wakeups;
+    uint64_t win_events = now.events - last.events;
+    uint64_t win_busy = now.busy_ns - last.busy_ns;
+    uint64_t win_idle = now.idle_ns - last.idle_ns;
+    uint64_t win_cpu = now.cpu_ns - last.cpu_ns;
+
+    printf("========= Event Loop Status =========\n");
+    printf("Uptime:        %.1f s\n", up_s);
+    printf("Wakeups:       %lu (%.1f/s avg)\n", now.wakeups, now.wakeups / up_s);
+    printf("Events:        %lu (%.2f per wakeup)\n", now.events,
+           now.wakeups ? (double)now.events / now.wakeups : 0.0);
+    printf("Loop CPU:      %.3f%% avg\n", 100.0 * now.cpu_ns / now.uptime_ns);
+    printf("Idle:          %.3f%% avg\n",
+           100.0 * now.idle_ns / (double)(now.idle_ns + now.busy_ns + 1));
+    if (win_s > 0) {
+        printf("Last %.1f s:   %.1f wakeups/s, %.1f events/s, CPU %.3f%%, idle %.3f%%\n",
+               win_s, win_wakeups / win_s, win_events / win_s,
+               100.0 * win_cpu / (win_s * 1e9),
+               100.0 * win_idle / (double)(win_idle + win_busy + 1));
+    }
+    cli_print_worker_status();
+    printf("=====================================\n");
+
+    last = now;
+}
+
+/**
+ * @brief Execute poll_status command (gateway poll blocks and age of their image data)
+ * @param argc: Number of arguments
+ * @param argv: Argument array
+ */
+static void cli_exec_poll_status(int argc, char** argv)
+{
+    ModbusPoller* poller = g_modbus_gw ? g_modbus_gw->poller : NULL;
+    if (!poller) {
+        LOG_WARN("No poll_list configured");
+        return;
+    }
+
+    uint64_t now = reactor_now_ns();
+    printf("========= Poll Status =========\n");
+    printf("%-3s %-4s %-5s %-4s %-11s %-7s %-4s %-9s %-8s %-8s %-6s %-8s %-8s %-6s\n",
+           "#", "uart", "slave", "fc", "regs", "cycle", "prio", "age", "version",
+           "polls", "errors", "overrun", "hits", "rtt");
+    for (int i = 0; i < poller->count; i++) {
+        ModbusPollBlock b;
+        if (modbus_poll_get_block(poller, i, &b) != 0) continue;
+
+        char age[24];
+        if (b.updated_ns) {
+            snprintf(age, sizeof(age), "%lu ms", (now - b.updated_ns) / 1000000);
+        } else {
+            snprintf(age, sizeof(age), "-");
+        }
+        char regs[16];
+        snprintf(regs, sizeof(regs), "%d+%d", b.config.start, b.config.quantity);
+        char cycle[16];
+        snprintf(cycle, sizeof(cycle), "%d ms", b.config.cycle_ms);
+        printf("%-3d %-4d %-5d 0x%02X %-11s %-7s %-4d %-9s %-8u %-8lu %-6u %-8u %-8lu %u us\n",
+               i, b.config.uart_idx, b.config.slave_addr, b.config.func_code, regs, cycle,
+               b.config.priority, age, b.version / 2, b.polls, b.errors, b.overruns,
+               b.image_hits, b.last_rtt_us);
+    }
+    printf("===============================\n");
+}
+
+/**
+ * @brief Parse trace port argument
+ * @param arg: UART index or "all"
+ * @param mask: Output port mask
+ * @return 0 on success, -1 on invalid port
+ */
+static int cli_trace_mask(const char* arg, uint32_t* mask)
+{
+    if (!arg || strcmp(arg, "all") == 0) {
+        *mask = (1u << MAX_UART_NUM) - 1;
+        return 0;
+    }
+    int idx = atoi(arg);
+    if (!isdigit((unsigned char)arg[0]) || idx < 0 || idx >= MAX_UART_NUM) {
+        LOG_WARN("Invalid uart_idx %s! Must be 0~%d or all", arg, MAX_UART_NUM - 1);
+        return -1;
+    }
+    *mask = 1u << idx;
+    return 0;
+}
+
+/**
+ * @brief Execute trace command (capture UART / TCP frames, write pcap)
+ * @param argc: Number of arguments
+ * @param argv: Argument array (argv[1] = start/stop/dump/status)
+ */
+static void cli_exec_trace(int argc, char** argv)
+{
+    uint32_t mask;
+
+    if (argc >= 2 && strcmp(argv[1], "start") == 0) {
+        if (cli_trace_mask(argc >= 3 ? argv[2] : NULL, &mask) == 0) {
+            trace_start(mask);
+        }
+        return;
+    }
+    if (argc >= 3 && strcmp(argv[1], "record") == 0) {
+        // trace record [<idx>|all] <file>
+        if (cli_trace_mask(argc >= 4 ? argv[2] : NULL, &mask) == 0) {
+            trace_record_file(mask, argv[argc >= 4 ? 3 : 2]);
+        }
+        return;
+    }
+    if (argc >= 2 && strcmp(argv[1], "stop") == 0) {
+        trace_stop();
+        LOG_INFO("Trace stopped");
+        return;
+    }
+    if (argc >= 3 && strcmp(argv[1], "dump") == 0) {
+        if (cli_trace_mask(argv[2], &mask) != 0) return;
+        char path[128];
+        if (argc >= 4) {
+            snprintf(path, sizeof(path), "%s", argv[3]);
+        } else {
+            snprintf(path, sizeof(path), "/tmp/trace_uart%s.pcap", argv[2]);
+        }
+        TraceFormat fmt = argc >= 5 && strcmp(argv[4], "user") == 0 ? TRACE_FMT_USER : TRACE_FMT_MBTCP;
+        int count = trace_dump(mask, path, fmt);
+        if (count < 0) {
+            LOG_WARN("Trace dump to %s failed", path);
+            return;
+        }
+        printf("%d frames written to %s (%s)\n", count, path, fmt == TRACE_FMT_USER ? "DLT_USER0" : "Modbus/TCP");
+        return;
+    }
+    if (argc >= 2 && strcmp(argv[1], "status") != 0) {
+        LOG_WARN("Usage: trace start [<uart_idx>|all] | record [<uart_idx>|all] <file> | stop | "
+                 "dump <uart_idx>|all [file] [mbtcp|user] | status");
+        return;
+    }
+
+    TraceStats st;
+    trace_get_stats(&st);
+    printf("========= Trace Status =========\n");
+    printf("Capture:     %s (port mask 0x%X)\n", st.mask ? "ON" : "OFF", st.mask);
+    printf("Frames:      %lu captured, %lu bytes, %lu overwritten, %lu truncated\n",
+           st.records, st.bytes, st.overwritten, st.truncated);
+    if (st.recording || st.written) {
+        printf("Recording:   %s, %lu frames written, %lu lost\n", st.recording ? "ON" : "done", st.written, st.lost);
+    }
+    printf("Ring:        %d frames x %d bytes\n", TRACE_RING_SLOTS, TRACE_FRAME_MAX);
+    printf("Cost:        %lu ns/frame (sampled 1/%d)\n",
+           st.cost_samples ? st.cost_ns / st.cost_samples : 0, TRACE_COST_SAMPLE);
+    printf("================================\n");
+}
+
+/**
+ * @brief Print one latency histogram row (microseconds)
+ * @param name: Row label
+ * @param kind: Latency kind label
+ * @param snap: Histogram snapshot
+ */
+static void cli_print_hist(const char* name, const char* kind, const StatsHist* snap)
+{
+    printf("%-12s %-9s %-9lu %-8lu %-8lu %-8lu %-8lu %-8lu %lu\n", name, kind, snap->count,
+           stats_hist_percentile(snap, 50.0), stats_hist_percentile(snap, 90.0),
+           stats_hist_percentile(snap, 99.0), stats_hist_percentile(snap, 99.9),
+           snap->max_us, snap->count ? snap->sum_us / snap->count : 0);
+}
+
+/**
+ * @brief Print latency histograms of a bus or slave (rows without samples are skipped)
+ * @param name: Row label
+ * @param lat: Histogram snapshots
+ */
+static void cli_print_latency(const char* name, const ModbusLatency* lat)
+{
+    static const char* kinds[MODBUS_LAT_NUM] = {"queue", "response", "rtt"};
+    for (int k = 0; k < MODBUS_LAT_NUM; k++) {
+        if (lat->hist[k].count > 0) {
+            cli_print_hist(name, kinds[k], &lat->hist[k]);
+        }
+    }
+}
+
+/**
+ * @brief Execute stats command (latency percentiles per bus, slave and client)
+ * @param argc: Number of arguments
+ * @param argv: Argument array (argv[1] = uart_idx, clients or reset)
+ */
+static void cli_exec_stats(int argc, char** argv)
+{
+    if (!g_modbus_gw) return;
+    if (argc >= 2 && strcmp(argv[1], "reset") == 0) {
+        modbus_gw_reset_latency(g_modbus_gw);
+        LOG_INFO("Latency histograms cleared");
+        return;
+    }
+
+    int clients = argc >= 2 && strcmp(argv[1], "clients") == 0;
+    int uart_idx = -1;
+    if (argc >= 2 && !clients) {
+        uart_idx = atoi(argv[1]);
+        if (!isdigit((unsigned char)argv[1][0]) || uart_idx < 0 || uart_idx >= MAX_UART_NUM) {
+            LOG_WARN("Usage: stats [<uart_idx>|clients|reset]");
+            return;
+        }
+    }
+
+    ModbusLatency lat;
+    char name[32];
+    printf("========= Latency (us) =========\n");
+    printf("%-12s %-9s %-9s %-8s %-8s %-8s %-8s %-8s %s\n",
+           "source", "latency", "count", "p50", "p90", "p99", "p99.9", "max", "mean");
+    if (clients) {
+        int slots = net_mgr_get_slot_count(g_net_mgr);
+        for (int i = 0; i < slots; i++) {
+            if (modbus_gw_get_client_rtt(g_modbus_gw, i, &lat.hist[MODBUS_LAT_RTT]) != 0) continue;
+            snprintf(name, sizeof(name), "client %d", i);
+            cli_print_hist(name, "rtt", &lat.hist[MODBUS_LAT_RTT]);
+        }
+    } else {
+        for (int i = 0; i < MAX_UART_NUM; i++) {
+            if ((uart_idx >= 0 && i != uart_idx) || modbus_gw_get_latency(g_modbus_gw, i, -1, &lat) != 0) continue;
+            snprintf(name, sizeof(name), "uart %d", i);
+            cli_print_latency(name, &lat);
+            for (int j = 0; uart_idx >= 0 && j < MODBUS_GW_MAX_SLAVES; j++) {
+                if (modbus_gw_get_latency(g_modbus_gw, i, j, &lat) != 0) continue;
+                snprintf(name, sizeof(name), " slave %d", j);
+                cli_print_latency(name, &lat);
+            }
+        }
+    }
+    if (g_stats_srv) {
+        printf("Metrics:     http://127.0.0.1:%d/metrics (%lu scrapes, %u rejected)\n",
+               g_stats_srv->port, g_stats_srv->scrapes, g_stats_srv->rejected);
+    }
+    printf("================================\n");
+}
+
 /**
  * @brief Execute help command (show usage of all supported commands)
  */
@@ -264,8 +677,15 @@ static void cli_exec_help(void)
     printf("uart_status <idx>    - Query UART <idx> status\n");
     printf("uart_set -i <idx> [-b <baud>] [-d <databit>] [-s <stopbit>] [-p <parity>]\n");
     printf("                     - Modify UART params (parity: N/E/O)\n");
-    printf("log_level <level>    - Set log level (debug/info/warn/error/fatal)\n");
+    printf("log_level [<level> [<module>]]\n");
+    printf("                     - Show / set log level (debug/info/warn/error/fatal) of all or one module\n");
     printf("net_status           - Show network status\n");
+    printf("loop_status          - Show event loop wake-up rate and idle CPU\n");
+    printf("poll_status          - Show gateway poll blocks (data age, overruns)\n");
+    printf("trace start [<idx>|all] | record [<idx>|all] <file> | stop | dump <idx>|all [file] [mbtcp|user] | status\n");
+    printf("                     - Capture UART / TCP frames and write them as pcap, or record a replay trace\n");
+    printf("stats [<idx>|clients|reset]\n");
+    printf("                     - Show latency percentiles of all buses, one bus and its slaves, or clients\n");
     printf("help                 - Show this help\n");
     printf("exit                 - Exit CLI (server continues running)\n");
     printf("==================================\n");
@@ -277,6 +697,7 @@ static void cli_exec_help(void)
 static void cli_exec_exit(void)
 {
     g_running = 0;
+    reactor_stop(g_reactor);
 }
 
 /**
@@ -300,6 +721,18 @@ static void cli_exec_cmd(int argc, char** argv)
         case CMD_LOG_LEVEL:
             cli_exec_log_level(argc, argv);
             break;
+        case CMD_LOOP_STATUS:
+            cli_exec_loop_status(argc, argv);
+            break;
+        case CMD_POLL_STATUS:
+            cli_exec_poll_status(argc, argv);
+            break;
+        case CMD_TRACE:
+            cli_exec_trace(argc, argv);
+            break;
+        case CMD_STATS:
+            cli_exec_stats(argc, argv);
+            break;
         case CMD_HELP:
             cli_exec_help();
             break;
@@ -359,6 +792,8 @@ static char* cli_command_generator(const char* text, int state)
  */
 int cli_mgr_init(void)
 {
+    // Leave SIGINT to the main signal handler, readline would defer it to the CLI thread
+    rl_catch_signals = 0;
     rl_initialize();
     rl_attempted_completion_function = cli_command_completion;
 
@@ -12,12 +12,18 @@
 #include "../uart/uart_mgr.h"
 #include "../net/net_mgr.h"
 #include "../log/log.h"
+#include "../reactor/reactor.h"
+#include "../modbus/modbus_gw.h"
+#include "../trace/trace.h"
+#include "../stats/stats.h"
 
 
 extern UartMgr* g_uart_mgr;  
 extern NetMgr*  g_net_mgr; 
+extern Reactor* g_reactor;
+extern ModbusGw* g_modbus_gw;
+extern StatsSrv* g_stats_srv;
 extern volatile int g_running;
-extern LogLevel g_log_level;
 
 typedef enum {
     CMD_UNKNOWN,
@@ -25,6 +31,10 @@ typedef enum {
     CMD_UART_SET,       
     CMD_NET_STATUS,        
     CMD_LOG_LEVEL,      
+    CMD_LOOP_STATUS,
+    CMD_POLL_STATUS,
+    CMD_TRACE,
+    CMD_STATS,
     CMD_HELP,           
     CMD_EXIT            
 } CliCmdType;
@@ -1,9 +1,41 @@
+#define _GNU_SOURCE
 #include "log.h"
+#include <stdlib.h>
+#include <strings.h>
+#include <pthread.h>
+
+// One queued log call (formatted on the calling thread, written by the writer thread)
+typedef struct {
+    uint32_t seq;                   /**< Slot sequence: pos + 1 = filled, pos + LOG_RING_SIZE = free */
+    LogLevel level;
+    int line;
+    const char *file;
+    time_t sec;
+    char msg[LOG_MSG_MAX];
+} LogRecord;
+
+LogLevel g_log_levels[LOG_MOD_NUM] = {
+    LOG_LEVEL_DEFAULT, LOG_LEVEL_DEFAULT, LOG_LEVEL_DEFAULT, LOG_LEVEL_DEFAULT, LOG_LEVEL_DEFAULT
+};
 
 // Static global variables (file scope only)
 static FILE *g_log_fp = NULL;          /**< Log file handle */
 static unsigned long g_log_file_size = 0;  /**< Current log file size (bytes) */
 
+static LogRecord g_log_ring[LOG_RING_SIZE];  /**< MPSC ring: any thread pushes, the writer pops */
+static uint32_t g_log_head = 0;        /**< Next slot claimed by a producer */
+static uint32_t g_log_tail = 0;        /**< Next slot read by the writer */
+static uint64_t g_log_dropped = 0;     /**< Records lost since the last report (ring full) */
+static uint64_t g_log_dropped_total = 0;
+static int g_log_async = 0;            /**< Writer thread running */
+static int g_log_stop = 0;
+static pthread_t g_log_thread;
+
+static time_t g_log_time_sec = -1;     /**< Second of the cached timestamp */
+static char g_log_time_str[32] = {0};
+static char g_log_screen[LOG_SCREEN_BUF];
+static size_t g_log_screen_len = 0;
+
 /**
  * Convert log level to string
  * @param level: Log level to convert
@@ -21,6 +53,100 @@ const char *log_level_to_str(LogLevel level)
     }
 }
 
+/**
+ * Parse log level name
+ * @param str: Level name (debug/info/warn/error/fatal)
+ * @param level: Output log level
+ * @return 0 on success, -1 on unknown name
+ */
+int log_level_from_str(const char *str, LogLevel *level)
+{
+    for (int i = LOG_LEVEL_DEBUG; i <= LOG_LEVEL_FATAL; i++) {
+        if (strcasecmp(str, log_level_to_str((LogLevel)i)) == 0) {
+            *level = (LogLevel)i;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+/**
+ * Convert log module to string
+ * @param module: Log module to convert
+ * @return Const string of module name
+ */
+const char *log_module_to_str(LogModule module)
+{
+    switch (module) {
+        case LOG_MOD_CORE:      return "core";
+        case LOG_MOD_UART:      return "uart";
+        case LOG_MOD_NET:       return "net";
+        case LOG_MOD_MODBUS:    return "modbus";
+        case LOG_MOD_CLI:       return "cli";
+        default:                return "unknown";
+    }
+}
+
+/**
+ * Parse log module name
+ * @param str: Module name (core/uart/net/modbus/cli)
+ * @param module: Output log module
+ * @return 0 on success, -1 on unknown name
+ */
+int log_module_from_str(const char *str, LogModule *module)
+{
+    for (int i = 0; i < LOG_MOD_NUM; i++) {
+        if (strcmp(str, log_module_to_str((LogModule)i)) == 0) {
+            *module = (LogModule)i;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+/**
+ * Take a token from the bucket of a call site
+ * Concurrent callers of one site race on a single CAS, no lock
+ * @param rl: Rate limit state of the call site
+ * @param suppressed: Output messages dropped since the last written one
+ * @return 1 if the message may be written, 0 if it is suppressed
+ */
+int log_ratelimit(LogRateLimit *rl, uint32_t *suppressed)
+{
+    const uint64_t interval_ns = 1000000000ULL / LOG_RATELIMIT_PER_SEC;
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+    uint64_t now = (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+
+    uint64_t tat = __atomic_load_n(&rl->tat_ns, __ATOMIC_RELAXED);
+    for (;;) {
+        uint64_t base = tat > now ? tat : now;
+        if (base - now > (LOG_RATELIMIT_BURST - 1) * interval_ns) {
+            __atomic_fetch_add(&rl->suppressed, 1, __ATOMIC_RELAXED);
+            return 0;
+        }
+        if (__atomic_compare_exchange_n(&rl->tat_ns, &tat, base + interval_ns, 1,
+                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+            break;
+        }
+    }
+    *suppressed = __atomic_exchange_n(&rl->suppressed, 0, __ATOMIC_RELAXED);
+    return 1;
+}
+
+/**
+ * Append suppression summary to a formatted message
+ * @param msg: Message buffer (LOG_MSG_MAX bytes)
+ * @param suppressed: Messages of the call site dropped before this one
+ */
+static void log_append_suppressed(char *msg, uint32_t suppressed)
+{
+    if (suppressed > 0) {
+        size_t len = strlen(msg);
+        snprintf(msg + len, LOG_MSG_MAX - len, " (%u messages suppressed)", suppressed);
+    }
+}
+
 /**
  * Check log file size and rotate if needed
  * Rename old log file with timestamp when max size reached
@@ -36,11 +162,12 @@ static int log_check_rotate(void)
 
         char old_log_path[256] = {0};
         time_t now = time(NULL);
-        struct tm *tm_now = localtime(&now);
+        struct tm tm_now;
+        localtime_r(&now, &tm_now);
         snprintf(old_log_path, sizeof(old_log_path),
                 "%s.%04d%02d%02d_%02d%02d%02d", LOG_FILE_PATH,
-                tm_now->tm_year + 1900, tm_now->tm_mon + 1, tm_now->tm_mday,
-                tm_now->tm_hour, tm_now->tm_min, tm_now->tm_sec);
+                tm_now.tm_year + 1900, tm_now.tm_mon + 1, tm_now.tm_mday,
+                tm_now.tm_hour, tm_now.tm_min, tm_now.tm_sec);
         rename(LOG_FILE_PATH, old_log_path);
 
         g_log_file_size = 0;
@@ -52,20 +179,121 @@ static int log_check_rotate(void)
             fprintf(stderr, "[ERROR] Faile to open log file: %s\n", LOG_FILE_PATH);
             return -1;
         }
-        setvbuf(g_log_fp, NULL, _IOLBF, 0);
     }
     return 0;
 }
 
+/**
+ * Write buffered file and screen output (end of a writer pass)
+ */
+static void log_flush(void)
+{
+    if (g_log_fp) {
+        fflush(g_log_fp);
+    }
+    if (g_log_screen_len > 0) {
+        fwrite(g_log_screen, 1, g_log_screen_len, stderr);
+        g_log_screen_len = 0;
+    }
+}
+
+/**
+ * Format one record into the file and screen buffers (writer thread, or caller while no writer runs)
+ * @param level: Log severity level
+ * @param file: Source file name
+ * @param line: Line number in source file
+ * @param sec: Wall-clock time of the log call
+ * @param msg: Formatted message
+ */
+static void log_emit(LogLevel level, const char *file, int line, time_t sec, const char *msg)
+{
+    if (log_check_rotate() != 0) return;
+
+    // localtime_r once per second, not per record
+    if (sec != g_log_time_sec) {
+        struct tm tm_now;
+        localtime_r(&sec, &tm_now);
+        strftime(g_log_time_str, sizeof(g_log_time_str), "%Y-%m-%d %H:%M:%S", &tm_now);
+        g_log_time_sec = sec;
+    }
+
+    int len = fprintf(g_log_fp, "[%s] [%s] [%s:%d]%s\n",
+                      g_log_time_str, log_level_to_str(level), file, line, msg);
+    if (len > 0) {
+        g_log_file_size += len;
+    }
+
+    if (is_output_screen) {
+        size_t need = strlen(log_level_to_str(level)) + strlen(msg) + 5;
+        if (g_log_screen_len + need >= sizeof(g_log_screen)) {
+            log_flush();
+        }
+        snprintf(g_log_screen + g_log_screen_len, sizeof(g_log_screen) - g_log_screen_len,
+                 "[%s] %s\n", log_level_to_str(level), msg);
+        g_log_screen_len += strlen(g_log_screen + g_log_screen_len);
+    }
+}
+
+/**
+ * Write every published record, then report drops
+ * @return Number of lines written
+ */
+static int log_drain(void)
+{
+    int count = 0;
+    for (;;) {
+        LogRecord *rec = &g_log_ring[g_log_tail & (LOG_RING_SIZE - 1)];
+        if (__atomic_load_n(&rec->seq, __ATOMIC_ACQUIRE) != g_log_tail + 1) break;
+
+        log_emit(rec->level, rec->file, rec->line, rec->sec, rec->msg);
+        __atomic_store_n(&rec->seq, g_log_tail + LOG_RING_SIZE, __ATOMIC_RELEASE);
+        g_log_tail++;
+        count++;
+    }
+
+    uint64_t dropped = __atomic_exchange_n(&g_log_dropped, 0, __ATOMIC_RELAXED);
+    if (dropped > 0) {
+        char msg[64];
+        snprintf(msg, sizeof(msg), "%lu log records dropped (ring full)", (unsigned long)dropped);
+        log_emit(LOG_LEVEL_WARN, __FILE__, __LINE__, time(NULL), msg);
+        count++;
+    }
+
+    if (count > 0) {
+        log_flush();
+    }
+    return count;
+}
+
+/**
+ * Writer thread: format, batch and rotate queued records
+ * @param arg: Unused
+ * @return NULL
+ */
+static void *log_writer_loop(void *arg)
+{
+    (void)arg;
+    struct timespec idle = { 0, LOG_WRITER_IDLE_MS * 1000000L };
+
+    for (;;) {
+        int stop = __atomic_load_n(&g_log_stop, __ATOMIC_ACQUIRE);
+        if (log_drain() == 0) {
+            if (stop) break;
+            nanosleep(&idle, NULL);
+        }
+    }
+    return NULL;
+}
+
 /**
  * Initialize log system implementation
- * Create log directory if not exists, open log file
+ * Create log directory if not exists, open log file, start writer thread
  * @return 0 on success, -1 on failure
  */
-int log_init(void) 
+int log_init(void)
 {
     char log_dir[256] = {0};
-    strncpy(log_dir, LOG_FILE_PATH, sizeof(log_dir));
+    strncpy(log_dir, LOG_FILE_PATH, sizeof(log_dir) - 1);
     char *last_slash = strrchr(log_dir, '/');
     if (last_slash) {
         *last_slash = '\0';
@@ -83,11 +311,24 @@ int log_init(void)
         return -1;
     }
 
-    setvbuf(g_log_fp, NULL, _IOLBF, 0);
-
     fseek(g_log_fp, 0, SEEK_END);
     g_log_file_size = ftell(g_log_fp);
 
+    for (uint32_t i = 0; i < LOG_RING_SIZE; i++) {
+        g_log_ring[i].seq = i;
+    }
+    g_log_head = 0;
+    g_log_tail = 0;
+    g_log_stop = 0;
+    if (pthread_create(&g_log_thread, NULL, log_writer_loop, NULL) == 0) {
+        pthread_setname_np(g_log_thread, "log-writer");
+        __atomic_store_n(&g_log_async, 1, __ATOMIC_RELEASE);
+        // Early exits of main still get queued records written
+        atexit(log_destroy);
+    } else {
+        LOG_WARN("Create log writer thread failed, logging synchronously");
+    }
+
     LOG_INFO("Serial server log system init success");
     LOG_INFO("Log file: %s, Max size: %d MB", LOG_FILE_PATH, (LOG_MAX_SIZE / (1024 * 1024)));
 
@@ -95,66 +336,88 @@ int log_init(void)
 }
 
 /**
- * Log write function implementation
- * Filter logs by level, format and write to file
+ * Log write function implementation (LOG_* macros filter level and rate first)
+ * Format the message into the ring (no syscall);
+ * the writer thread adds the header and writes it to file / screen
  * @param level: Log severity level (LogLevel enum)
  * @param file: Source file name where log is generated
  * @param line: Line number in source file
+ * @param suppressed: Messages of the call site suppressed before this one
  * @param fmt: Format string (same as printf)
  * @param ...: Variable arguments for format string
  */
-void log_write(LogLevel level, const char *file, int line, const char *fmt, ...)
+void log_write(LogLevel level, const char *file, int line, uint32_t suppressed, const char *fmt, ...)
 {
-    if (level < g_log_level) {
+    va_list args;
+    if (!__atomic_load_n(&g_log_async, __ATOMIC_ACQUIRE)) {
+        // No writer (before log_init / after log_destroy): write on the calling thread
+        char msg[LOG_MSG_MAX];
+        va_start(args, fmt);
+        vsnprintf(msg, sizeof(msg), fmt, args);
+        va_end(args);
+        log_append_suppressed(msg, suppressed);
+        log_emit(level, file, line, time(NULL), msg);
+        log_flush();
         return;
     }
 
-    if (log_check_rotate() != 0) return;    
-
-    time_t now = time(NULL);
-    struct tm *tm_now = localtime(&now);
-    char time_str[32] = {0};
-    strftime(time_str, sizeof(time_str), "%Y-%m-%d %H:%M:%S", tm_now);
-
-    char log_header[128] = {0};
-    snprintf(log_header, sizeof(log_header), "[%s] [%s] [%s:%d]",
-            time_str, log_level_to_str(level), file, line);
-
-    fputs(log_header, g_log_fp);
-    g_log_file_size += strlen(log_header);  
-
-    va_list args, args_screen;
-    va_start(args, fmt);
-    
-    g_log_file_size += vfprintf(g_log_fp, fmt, args);
-
-    if(is_output_screen) {
-        va_start(args_screen, fmt);
-        fprintf(stderr, "[%s] ", log_level_to_str(level));
-        vfprintf(stderr, fmt, args_screen);
-        fprintf(stderr, "\n");
-        va_end(args_screen);
+    // Claim a slot: the CAS on the head serializes producers, full ring drops the record
+    uint32_t pos = __atomic_load_n(&g_log_head, __ATOMIC_RELAXED);
+    LogRecord *rec;
+    for (;;) {
+        rec = &g_log_ring[pos & (LOG_RING_SIZE - 1)];
+        int32_t diff = (int32_t)(__atomic_load_n(&rec->seq, __ATOMIC_ACQUIRE) - pos);
+        if (diff == 0) {
+            if (__atomic_compare_exchange_n(&g_log_head, &pos, pos + 1, 1,
+                                            __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                break;
+            }
+        } else if (diff < 0) {
+            __atomic_fetch_add(&g_log_dropped, 1, __ATOMIC_RELAXED);
+            __atomic_fetch_add(&g_log_dropped_total, 1, __ATOMIC_RELAXED);
+            return;
+        } else {
+            pos = __atomic_load_n(&g_log_head, __ATOMIC_RELAXED);
+        }
     }
 
+    // CLOCK_REALTIME_COARSE is served by the vDSO
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME_COARSE, &ts);
+    rec->level = level;
+    rec->file = file;
+    rec->line = line;
+    rec->sec = ts.tv_sec;
+    va_start(args, fmt);
+    vsnprintf(rec->msg, sizeof(rec->msg), fmt, args);
     va_end(args);
-    
-
-    fputs("\n", g_log_fp);
-    g_log_file_size += 1;
+    log_append_suppressed(rec->msg, suppressed);
+    __atomic_store_n(&rec->seq, pos + 1, __ATOMIC_RELEASE);
+}
 
-    fflush(g_log_fp);
+/**
+ * Get number of log records dropped because the ring was full
+ * @return Dropped records since start
+ */
+uint64_t log_get_dropped(void)
+{
+    return __atomic_load_n(&g_log_dropped_total, __ATOMIC_RELAXED);
 }
 
 /**
  * Destroy log system implementation
- * Close log file and release resources
+ * Stop writer thread (queued records are written first), close log file
  */
 void log_destroy(void)
 {
-    LOG_INFO("Serial server log system destroyed");
+    if (__atomic_load_n(&g_log_async, __ATOMIC_ACQUIRE)) {
+        LOG_INFO("Serial server log system destroyed");
+        __atomic_store_n(&g_log_stop, 1, __ATOMIC_RELEASE);
+        pthread_join(g_log_thread, NULL);
+        __atomic_store_n(&g_log_async, 0, __ATOMIC_RELEASE);
+    }
     if (g_log_fp) {
         fclose(g_log_fp);
         g_log_fp = NULL;
     }
 }
-
@@ -3,6 +3,7 @@
 
 #include <stdio.h>
 #include <stdarg.h>
+#include <stdint.h>
 #include <time.h>
 #include <string.h>
 #include <unistd.h>
@@ -17,21 +18,74 @@ typedef enum {
     LOG_LEVEL_FATAL
 } LogLevel;
 
+// Source module of a log call (define LOG_MODULE before the first #include of a .c file)
+typedef enum {
+    LOG_MOD_CORE,       // main, reactor, log
+    LOG_MOD_UART,
+    LOG_MOD_NET,
+    LOG_MOD_MODBUS,
+    LOG_MOD_CLI,
+    LOG_MOD_NUM
+} LogModule;
+
+#ifndef LOG_MODULE
+#define LOG_MODULE          LOG_MOD_CORE
+#endif
+
+// Minimum level built into the binary (0 debug ... 4 fatal), lower LOG_* sites are compiled out
+#ifndef LOG_COMPILE_LEVEL
+#define LOG_COMPILE_LEVEL   0
+#endif
+
 #define LOG_FILE_PATH       "/root/serial_server.log"
 #define LOG_MAX_SIZE        (1024 * 1024 * 5)
-#define LOG_LEVEL_DEFAULT   LOG_LEVEL_DEBUG
+#define LOG_LEVEL_DEFAULT   LOG_LEVEL_INFO
+#define LOG_RING_SIZE       1024                // Records queued for the writer thread (power of 2)
+#define LOG_MSG_MAX         256                 // Formatted message size (longer messages are truncated)
+#define LOG_WRITER_IDLE_MS  20                  // Writer poll period while the ring is empty
+#define LOG_SCREEN_BUF      8192                // Screen output batched per writer pass
+#define LOG_RATELIMIT_BURST 20                  // Messages a call site may write back to back
+#define LOG_RATELIMIT_PER_SEC 10                // Sustained messages per second of a call site
 #define is_output_screen    1
-static LogLevel g_log_level = LOG_LEVEL_DEFAULT;
 
-void log_write(LogLevel level, const char *file, int line, const char *fmt, ...);
+// Token bucket of one LOG_* call site (GCRA form: one timestamp instead of a token count)
+typedef struct {
+    uint64_t tat_ns;                            // Time the bucket is full again
+    uint32_t suppressed;                        // Messages dropped since the last written one
+} LogRateLimit;
+
+// Runtime level of each module (process wide, set by the log_level command)
+extern LogLevel g_log_levels[LOG_MOD_NUM];
+
+void log_write(LogLevel level, const char *file, int line, uint32_t suppressed, const char *fmt, ...);
+
+int log_ratelimit(LogRateLimit *rl, uint32_t *suppressed);
 
 const char *log_level_to_str(LogLevel level);
 
-#define LOG_DEBUG(fmt, ...) log_write(LOG_LEVEL_DEBUG, __FILE__, __LINE__, fmt, ##__VA_ARGS__)
-#define LOG_INFO(fmt, ...)  log_write(LOG_LEVEL_INFO,  __FILE__, __LINE__, fmt, ##__VA_ARGS__)
-#define LOG_WARN(fmt, ...)  log_write(LOG_LEVEL_WARN,  __FILE__, __LINE__, fmt, ##__VA_ARGS__)
-#define LOG_ERROR(fmt, ...) log_write(LOG_LEVEL_ERROR, __FILE__, __LINE__, fmt, ##__VA_ARGS__)
-#define LOG_FATAL(fmt, ...) log_write(LOG_LEVEL_FATAL, __FILE__, __LINE__, fmt, ##__VA_ARGS__)
+int log_level_from_str(const char *str, LogLevel *level);
+
+const char *log_module_to_str(LogModule module);
+
+int log_module_from_str(const char *str, LogModule *module);
+
+uint64_t log_get_dropped(void);
+
+#define LOG_AT(level, fmt, ...) do { \
+    if ((level) >= LOG_COMPILE_LEVEL && (level) >= g_log_levels[LOG_MODULE]) { \
+        static LogRateLimit log_rl_; \
+        uint32_t log_suppressed_ = 0; \
+        if (log_ratelimit(&log_rl_, &log_suppressed_)) { \
+            log_write((level), __FILE__, __LINE__, log_suppressed_, fmt, ##__VA_ARGS__); \
+        } \
+    } \
+} while (0)
+
+#define LOG_DEBUG(fmt, ...) LOG_AT(LOG_LEVEL_DEBUG, fmt, ##__VA_ARGS__)
+#define LOG_INFO(fmt, ...)  LOG_AT(LOG_LEVEL_INFO,  fmt, ##__VA_ARGS__)
+#define LOG_WARN(fmt, ...)  LOG_AT(LOG_LEVEL_WARN,  fmt, ##__VA_ARGS__)
+#define LOG_ERROR(fmt, ...) LOG_AT(LOG_LEVEL_ERROR, fmt, ##__VA_ARGS__)
+#define LOG_FATAL(fmt, ...) LOG_AT(LOG_LEVEL_FATAL, fmt, ##__VA_ARGS__)
 
 int log_init(void);
 
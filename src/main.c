@@ -1,74 +1,171 @@
+#define LOG_MODULE LOG_MOD_CORE
 #include <stdio.h>
 #include <stdlib.h>
 #include <unistd.h>
 #include <pthread.h>
 #include <signal.h>
+#include <sys/signalfd.h>
 #include <string.h>
 #include <errno.h>
-#include <sys/epoll.h> 
 #include <arpa/inet.h>
 
 #include "./log/log.h"
 #include "./cli/cli_mgr.h"
 #include "./modbus/modbus_core.h"
+#include "./modbus/modbus_gw.h"
 #include "./net/net_mgr.h"
 #include "./uart/uart_mgr.h"
+#include "./reactor/reactor.h"
+#include "./trace/trace.h"
+#include "./stats/stats.h"
 
 
 // Global manager instances (cross-thread shared)
 UartMgr*    g_uart_mgr  = NULL;  // Global UART manager instance (manages all UART devices)
 NetMgr*     g_net_mgr   = NULL;  // Global network manager instance (handles TCP/UDP communication)
+Reactor*    g_reactor   = NULL;  // Global event loop (UART fds, sockets and timers)
+ModbusGw*   g_modbus_gw = NULL;  // Global Modbus gateway engine (per-bus transaction tables)
+StatsSrv*   g_stats_srv = NULL;  // Global metrics endpoint (NULL: metrics_port not set)
 volatile int g_running   = 1;    // Global flag to control program running state (0: exit)
-pthread_t   g_modbus_thread;     // Modbus protocol processing thread ID
 pthread_t   g_cli_thread;        // CLI processing thread ID
-ModbusRTUFrame g_modbus_rtu;     // Global Modbus RTU frame (for TCP-RTU conversion)
 ModbusTCPFrame g_modbus_tcp;     // Global Modbus TCP frame (for network data parsing)
+static int  g_port_listener[MAX_UART_NUM];  // Own TCP listener of each UART (0 = shared port)
+static ReactorHandler g_sighup_handler;  // signalfd of SIGHUP on the main loop
 
 /**
- * Modbus data process thread (TCP -> RTU conversion & UART write)
- * @param arg: Unused
- * @return NULL on exit
+ * Route a Modbus TCP / UDP frame to a UART (TCP -> RTU conversion & UART write)
+ * @param origin: Requester (client_idx, conn_id and peer set by the caller, the rest is filled in)
+ * @param uart_idx: Target UART (-1 = selected by the unit ID)
+ * @param data: MBAP frame
+ * @param len: Length of MBAP frame
  */
-void* modbus_process_thread(void* arg)
+static void gw_rx_frame(ModbusOrigin* origin, int uart_idx, const uint8_t* data, int len)
 {
-    uint8_t net_recv_buf[BUF_SIZE];
-
-    while (g_running) {
-        memset(net_recv_buf, 0, sizeof(net_recv_buf));
-        for(int client_idx=0; client_idx<MAX_CLIENT_NUM; client_idx++)
-        {
-            ssize_t net_recv_len = net_mgr_recv_tcp(g_net_mgr, client_idx, net_recv_buf, sizeof(net_recv_buf)-1);
-            // Modbus TCP data example：00 01 00 00 00 06 03 03 00 00 00 01
-            if (net_recv_len <= 0) continue;
-            if (modbus_parse_tcp_data(net_recv_buf, net_recv_len, &g_modbus_tcp) != 0) {
-                LOG_ERROR("Tcp_client %d send data is error", client_idx);
-                continue;
-            }
-
-            if (modbus_tcp_to_rtu(&g_modbus_tcp, &g_modbus_rtu) != 0) {
-                LOG_ERROR("Tcp to rtu failed, client idx: %d", client_idx);
-                continue;
-            }
-
-            UartDev* p_uart = uart_mgr_get_uart_by_idx(g_uart_mgr, g_modbus_rtu.slave_addr);
-            if (p_uart == NULL || p_uart->fd < 0 || !p_uart->config.enable) {
-                LOG_ERROR("UART %d is unenable", g_modbus_rtu.slave_addr);
-                continue;
-            }
-
-            if (p_uart->config.modbus_enable) {
-                if (modbus_rtu_frame_write(g_uart_mgr,g_modbus_rtu.slave_addr, &g_modbus_rtu) <= 0) {
-                    LOG_ERROR("UART %d write failed", g_modbus_rtu.slave_addr);
-                }
-            } else {
-                if (uart_mgr_write(g_uart_mgr, g_modbus_rtu.slave_addr, g_modbus_rtu.data, g_modbus_rtu.data_len) <= 0) {
-                    LOG_ERROR("UART %d write failed", g_modbus_rtu.slave_addr);
-                }
-            }
+    // Modbus TCP data example：00 01 00 00 00 06 03 03 00 00 00 01
+    if (modbus_parse_tcp_data(data, len, &g_modbus_tcp) != 0) {
+        LOG_ERROR("Tcp_client %d send data is error", origin->client_idx);
+        return;
+    }
+    // Shared port: unit ID selects the UART
+    if (uart_idx < 0) {
+        uart_idx = g_modbus_tcp.slave_addr;
+    }
+    TRACE_FRAME(uart_idx, TRACE_TCP_RX, 0, origin->client_idx, origin->conn_id, data, len);
+
+    origin->trans_id = g_modbus_tcp.transaction_id;
+    origin->unit_id = g_modbus_tcp.slave_addr;
+    origin->uart_idx = uart_idx;
+    origin->rx_ns = reactor_now_ns();
+
+    UartDev* p_uart = uart_mgr_get_uart_by_idx(g_uart_mgr, uart_idx);
+    if (p_uart == NULL || p_uart->fd < 0 || !p_uart->config.enable) {
+        LOG_ERROR("UART %d is unenable", uart_idx);
+        modbus_gw_send_exception(g_modbus_gw, origin, g_modbus_tcp.func_code, MODBUS_EX_GATEWAY_PATH);
+        return;
+    }
+
+    if (p_uart->config.modbus_enable) {
+        modbus_gw_submit(g_modbus_gw, uart_idx, origin, &g_modbus_tcp);
+    } else {
+        if (uart_mgr_write(g_uart_mgr, uart_idx, (const char*)g_modbus_tcp.data, g_modbus_tcp.data_len) <= 0) {
+            LOG_ERROR("UART %d write failed", uart_idx);
         }
-        usleep(10000);
     }
-    pthread_exit(NULL);
+}
+
+/**
+ * Route a Modbus TCP frame received from a client
+ * @param mgr: Pointer to NetMgr instance
+ * @param client_idx: Index of the client that sent the frame
+ * @param uart_idx: Target UART (-1 = selected by the unit ID)
+ * @param data: MBAP frame
+ * @param len: Length of MBAP frame
+ */
+static void tcp_rx_frame(NetMgr* mgr, int client_idx, int uart_idx, const uint8_t* data, int len)
+{
+    ModbusOrigin origin;
+    memset(&origin, 0, sizeof(origin));
+    origin.client_idx = client_idx;
+    origin.conn_id = net_mgr_get_conn_id(mgr, client_idx);
+    gw_rx_frame(&origin, uart_idx, data, len);
+}
+
+/**
+ * TCP receive callback of the shared port (unit ID selects the UART)
+ * Called once per complete MBAP frame extracted from the client stream
+ * @param mgr: Pointer to NetMgr instance
+ * @param client_idx: Index of the client that sent the frame
+ * @param data: MBAP frame
+ * @param len: Length of MBAP frame
+ * @param arg: Unused
+ */
+static void on_tcp_rx(NetMgr* mgr, int client_idx, const uint8_t* data, int len, void* arg)
+{
+    tcp_rx_frame(mgr, client_idx, -1, data, len);
+}
+
+/**
+ * TCP receive callback of a port owned by one UART
+ * Modbus ports get MBAP frames (unit ID = slave address), raw ports get the byte stream as received
+ * @param mgr: Pointer to NetMgr instance
+ * @param client_idx: Index of the client that sent the data
+ * @param data: MBAP frame / raw bytes
+ * @param len: Data length
+ * @param arg: Pointer to UartDev
+ */
+static void on_port_tcp_rx(NetMgr* mgr, int client_idx, const uint8_t* data, int len, void* arg)
+{
+    UartDev* uart = (UartDev*)arg;
+    if (uart->config.modbus_enable) {
+        tcp_rx_frame(mgr, client_idx, uart->config.idx, data, len);
+        return;
+    }
+
+    TRACE_FRAME(uart->config.idx, TRACE_TCP_RX, 0, client_idx, net_mgr_get_conn_id(mgr, client_idx), data, len);
+    if (uart_mgr_write(g_uart_mgr, uart->config.idx, (const char*)data, len) != len) {
+        LOG_ERROR("UART %d write failed", uart->config.idx);
+    }
+}
+
+/**
+ * TCP splice callback of a raw port with its own listener (client data waiting in a pipe,
+ * written to the UART without user-space copy)
+ * @param mgr: Pointer to NetMgr instance
+ * @param client_idx: Index of the client that sent the data
+ * @param pipe_fd: Pipe holding the data
+ * @param len: Length of data in the pipe
+ * @param arg: Pointer to UartDev
+ */
+static void on_port_tcp_splice(NetMgr* mgr, int client_idx, int pipe_fd, int len, void* arg)
+{
+    UartDev* uart = (UartDev*)arg;
+    if (uart_mgr_write_splice(g_uart_mgr, uart->config.idx, pipe_fd, len) != len) {
+        LOG_ERROR("UART %d write failed", uart->config.idx);
+    }
+}
+
+/**
+ * Modbus/UDP receive callback (one MBAP frame per datagram, unit ID selects the UART)
+ * The reply goes back to the source address of the request
+ * @param mgr: Pointer to NetMgr instance
+ * @param src: Source address of the datagram
+ * @param data: Datagram payload
+ * @param len: Payload length
+ * @param arg: Unused
+ */
+static void on_udp_rx(NetMgr* mgr, const struct sockaddr_in* src, const uint8_t* data, int len, void* arg)
+{
+    if (modbus_tcp_frame_len(data, len) != len) {
+        LOG_WARN("Malformed Modbus/UDP datagram (%d bytes) from %s:%d", len,
+                 inet_ntoa(src->sin_addr), ntohs(src->sin_port));
+        return;
+    }
+
+    ModbusOrigin origin;
+    memset(&origin, 0, sizeof(origin));
+    origin.client_idx = MODBUS_ORIGIN_UDP;
+    origin.peer = *src;
+    gw_rx_frame(&origin, -1, data, len);
 }
 
 /**
@@ -80,85 +177,108 @@ void sig_handler(int sig)
     if (sig == SIGINT) {
         LOG_INFO("Catch SIGINT, start exit program...");
         g_running = 0;
+        reactor_stop(g_reactor);
+    }
+}
+
+/**
+ * SIGHUP handler (signalfd on the main loop): reconfigure the ports from the config file
+ * @param handler: Pointer to g_sighup_handler
+ * @param events: Ready event mask
+ */
+static void on_sighup(ReactorHandler* handler, uint32_t events)
+{
+    struct signalfd_siginfo info;
+    while (read(handler->fd, &info, sizeof(info)) == (ssize_t)sizeof(info)) {
     }
+    LOG_INFO("Catch SIGHUP, reload %s", g_uart_mgr->config_path);
+    uart_mgr_reload(g_uart_mgr);
 }
 
 /**
- * Handle UART epoll events (read data & convert to TCP frame)
+ * Build header that tags raw UART data with its port (unit ID = UART index)
+ * @param uart: UART device the data was read from
+ * @param len: Length of raw data
+ * @param hdr: Output header (MODBUS_TCP_HEADER_LEN + 2 bytes)
+ * @return Header length
+ */
+static int build_raw_header(UartDev* uart, int len, uint8_t* hdr)
+{
+    // Modbus TCP data example：00 01 00 00 00 06 07 03 00 00 00 01
+    int offset = 0;
+    hdr[offset++] = 0;
+    hdr[offset++] = 1;
+    hdr[offset++] = 0;
+    hdr[offset++] = 0;
+    hdr[offset++] = ((len + 2) >> 8) & 0xFF;
+    hdr[offset++] = (len + 2) & 0xFF;
+    hdr[offset++] = uart->config.idx;
+    hdr[offset++] = 3;
+    return offset;
+}
+
+/**
+ * UART receive callback (convert UART data to TCP frame)
+ * @param uart: UART device the data was read from
+ * @param buf: Received data (Modbus ports: one CRC-checked RTU frame)
+ * @param len: Length of received data
+ * @param arg: Unused
  */
-void epoll_handle_uart_events() {
-    struct epoll_event events[EPOLL_MAX_EVENTS];
-    int nfds = epoll_wait(g_uart_mgr->epoll_fd, events, EPOLL_MAX_EVENTS, 100); 
-    if (nfds < 0) {
-        if (errno == EINTR) return; 
-        LOG_ERROR("epoll_wait failed");
+static void on_uart_rx(UartDev* uart, const uint8_t* buf, int len, void* arg)
+{
+    if (uart->config.modbus_enable) {
+        // Response goes only to the client that sent the request
+        modbus_gw_on_rtu_frame(g_modbus_gw, uart->config.idx, buf, len);
         return;
-    } else if (nfds == 0) {
-        return; 
     }
 
-    for (int i = 0; i < nfds; i++) {
-        int fd = events[i].data.fd;
-        int uart_idx = -1;
+    // Own port: pure byte stream to the clients of that port
+    if (g_port_listener[uart->config.idx] > 0) {
+        net_mgr_broadcast_tcp(g_net_mgr, g_port_listener[uart->config.idx], buf, len);
+        return;
+    }
 
-        for (int j = 0; j < MAX_UART_NUM; j++) {
-            if (g_uart_mgr->uarts[j].fd == fd) {
-                uart_idx = j;
-                break;
-            }
-        }
-        if (uart_idx == -1) {
-            LOG_ERROR("Unknown fd %d in epoll", fd);
-            continue;
-        }
+    // Shared port: transparent data is broadcast to every client, tagged with the port
+    static uint8_t send_buf[BUF_SIZE + MODBUS_TCP_HEADER_LEN + 2] = {0};
+    int offset = build_raw_header(uart, len, send_buf);
+    memcpy(&send_buf[offset], buf, len);
+    offset += len;
 
-        UartDev* uart = &g_uart_mgr->uarts[uart_idx];
-        uint8_t buf[BUF_SIZE] = {0};
-        ssize_t len = read(fd, buf, sizeof(buf) - 1);
-        if (len <= 0) {
-            if (len < 0 && errno != EAGAIN) {
-                uart->err_count++;
-                LOG_ERROR("UART read failed");
-            }
-            continue;
-        }
-        uart->rx_bytes += len;
-
-        if (uart->config.modbus_enable) {
-            static uint8_t send_buf[BUF_SIZE] = {0};
-            int total_send_len = 2 + 2 + 2 + len - 2;
-            int offset = 0;
-            send_buf[offset++] = MODBUS_TCP_TRANS_ID_H;
-            send_buf[offset++] = MODBUS_TCP_TRANS_ID_L;
-            send_buf[offset++] = (MODBUS_TCP_PROTOCOL_ID >> 8) & 0xFF;
-            send_buf[offset++] = MODBUS_TCP_PROTOCOL_ID & 0xFF;
-            send_buf[offset++] = ((len - 2) >> 8) & 0xFF;
-            send_buf[offset++] = (len - 2) & 0xFF;
-            send_buf[offset++] = uart->config.idx;
-            send_buf[offset++] = buf[1];  
-            memcpy(&send_buf[offset], buf + 2, len - 4);
-            offset += len;
-
-            net_mgr_broadcast_tcp(g_net_mgr, (char*)send_buf, offset);            
-        } else {
-            // Modbus TCP data example：00 01 00 00 00 06 07 03 00 00 00 01
-            static uint8_t send_buf[BUF_SIZE] = {0};
-            int total_send_len = 2 + 2 + 2 + 1 + 1 + len;
-            int offset = 0;
-            send_buf[offset++] = 0;
-            send_buf[offset++] = 1;
-            send_buf[offset++] = 0;
-            send_buf[offset++] = 0;
-            send_buf[offset++] = 0;
-            send_buf[offset++] = len;
-            send_buf[offset++] = uart->config.idx;
-            send_buf[offset++] = 3;
-            memcpy(&send_buf[offset], buf, len);
-            offset += len;
-
-            net_mgr_broadcast_tcp(g_net_mgr, (char*)send_buf, offset);
-        }
+    net_mgr_broadcast_tcp(g_net_mgr, 0, send_buf, offset);
+}
+
+/**
+ * UART splice callback (raw port data waiting in a pipe, sent without user-space copy)
+ * @param uart: UART device the data was read from
+ * @param pipe_fd: Pipe holding the data
+ * @param len: Length of data in the pipe
+ * @param arg: Unused
+ */
+static void on_uart_splice(UartDev* uart, int pipe_fd, int len, void* arg)
+{
+    if (g_port_listener[uart->config.idx] > 0) {
+        net_mgr_broadcast_splice(g_net_mgr, g_port_listener[uart->config.idx], NULL, 0, pipe_fd, len);
+        return;
     }
+
+    uint8_t hdr[MODBUS_TCP_HEADER_LEN + 2];
+    int hdr_len = build_raw_header(uart, len, hdr);
+
+    net_mgr_broadcast_splice(g_net_mgr, 0, hdr, hdr_len, pipe_fd, len);
+}
+
+/**
+ * Metrics endpoint callback (runs on the reactor thread for every scrape)
+ * @param buf: Output text buffer
+ * @param arg: Unused
+ */
+static void on_metrics_render(StatsBuf* buf, void* arg)
+{
+    ReactorStats rs;
+    reactor_get_stats(g_reactor, &rs);
+    stats_buf_printf(buf, "# HELP serial_uptime_seconds Time since the event loop started\n"
+                          "# TYPE serial_uptime_seconds gauge\nserial_uptime_seconds %.3f\n", rs.uptime_ns / 1e9);
+    modbus_gw_write_metrics(g_modbus_gw, buf);
 }
 
 /**
@@ -169,6 +289,13 @@ void epoll_handle_uart_events() {
  */
 int main(int argc, char *argv[])
 {
+    // SIGHUP is read from a signalfd: block it before any thread is created
+    sigset_t hup_mask;
+    sigemptyset(&hup_mask);
+    sigaddset(&hup_mask, SIGHUP);
+    pthread_sigmask(SIG_BLOCK, &hup_mask, NULL);
+    g_sighup_handler.fd = -1;
+
     if (log_init() != 0) {
         fprintf(stderr, "Log system init failed! Exit...\n");
         return -1;
@@ -181,76 +308,147 @@ int main(int argc, char *argv[])
     }
 
     signal(SIGINT, sig_handler);
+    // splice() to a closed socket raises SIGPIPE (no MSG_NOSIGNAL), errors are handled via EPIPE
+    signal(SIGPIPE, SIG_IGN);
+
+    g_reactor = reactor_create();
+    if (g_reactor == NULL) {
+        LOG_ERROR("Reactor init failed!");
+        return -1;
+    }
 
     LOG_INFO("Start init UART manager...");
-    g_uart_mgr = uart_mgr_init(argv[1]);
+    g_uart_mgr = uart_mgr_init(argv[1], g_reactor, on_uart_rx, NULL);
     if (g_uart_mgr == NULL) {
         LOG_ERROR("[ERROR] UART manager init failed!");
+        reactor_destroy(g_reactor);
         return -1;
     }
     LOG_INFO("UART manager init OK, enable UART count: %d", g_uart_mgr->uart_count);
 
-    LOG_INFO("Start init Network manager (TCP Server 192.168.1.232:8888)...");
-    g_net_mgr = net_mgr_init(NET_MODE_TCP_SERVER, NULL, 8888);
+    int server_port = g_uart_mgr->server_port > 0 ? g_uart_mgr->server_port : TCP_PORT;
+    LOG_INFO("Start init Network manager (TCP Server port %d)...", server_port);
+    g_net_mgr = net_mgr_init(NET_MODE_TCP_SERVER, NULL, server_port, g_reactor, on_tcp_rx, NULL);
     if(g_net_mgr == NULL)
     {
         LOG_ERROR("Network manager init failed!");
         uart_mgr_destroy(g_uart_mgr);
+        reactor_destroy(g_reactor);
         return -1;
     }
+    net_mgr_set_limits(g_net_mgr, g_uart_mgr->max_clients, g_uart_mgr->listen_backlog);
+    net_mgr_set_framer(g_net_mgr, modbus_tcp_frame_len);
+    for (int i = 0; i < MAX_UART_NUM; i++) {
+        UartDev* uart = &g_uart_mgr->uarts[i];
+        if (uart->fd < 0 || uart->config.tcp_port <= 0) continue;
+        int id = net_mgr_add_listener(g_net_mgr, uart->config.tcp_port,
+                                      uart->config.modbus_enable ? modbus_tcp_frame_len : NULL,
+                                      on_port_tcp_rx, uart);
+        if (id < 0) {
+            LOG_WARN("UART %d stays on the shared port", i);
+            continue;
+        }
+        g_port_listener[i] = id;
+        // Raw byte stream: socket -> pipe -> tty, the same zero-copy path as the RX side
+        if (!uart->config.modbus_enable && uart->config.splice_enable) {
+            net_mgr_set_splice_rx(g_net_mgr, id, on_port_tcp_splice, uart);
+        }
+    }
+    // Reverse connect: dial out to collectors, served like clients of the shared port
+    for (int i = 0; i < g_uart_mgr->upstream_count; i++) {
+        net_mgr_add_upstream(g_net_mgr, g_uart_mgr->upstreams[i].host, g_uart_mgr->upstreams[i].port);
+    }
+    if (g_uart_mgr->udp_port > 0 &&
+        net_mgr_open_udp(g_net_mgr, g_uart_mgr->udp_port, on_udp_rx, NULL) != 0) {
+        LOG_WARN("Modbus/UDP disabled");
+    }
+    uart_mgr_set_splice_handler(g_uart_mgr, on_uart_splice, NULL);
     LOG_INFO("Network manager init OK");
 
-    LOG_INFO("Start init CLI manager...");
-    int cli_ret = cli_mgr_init();
-    if (cli_ret!= 0) {
-        LOG_ERROR("CLI manager init failed!");
+    g_modbus_gw = modbus_gw_init(g_uart_mgr, g_net_mgr, g_reactor);
+    if (g_modbus_gw == NULL) {
+        LOG_ERROR("Modbus gateway init failed!");
         net_mgr_destroy(g_net_mgr);
         uart_mgr_destroy(g_uart_mgr);
+        reactor_destroy(g_reactor);
         return -1;
     }
-    LOG_INFO("CLI managert init CLI OK");
 
-    LOG_INFO("Start create Modbus process thread...");
-    int phread_ret = pthread_create(&g_modbus_thread, NULL, modbus_process_thread, NULL);
-    if (phread_ret != 0) {
-        LOG_ERROR("Create modbus thread failed:%s", strerror(phread_ret));
+    if (g_uart_mgr->metrics_port > 0) {
+        g_stats_srv = stats_srv_init(g_reactor, g_uart_mgr->metrics_port, on_metrics_render, NULL);
+        if (g_stats_srv == NULL) {
+            LOG_WARN("Metrics endpoint disabled");
+        }
+    }
+
+    LOG_INFO("Start init CLI manager...");
+    int cli_ret = cli_mgr_init();
+    if (cli_ret!= 0) {
+        LOG_ERROR("CLI manager init failed!");
+        stats_srv_destroy(g_stats_srv);
+        modbus_gw_destroy(g_modbus_gw);
         net_mgr_destroy(g_net_mgr);
         uart_mgr_destroy(g_uart_mgr);
-        cli_mgr_destroy();
+        reactor_destroy(g_reactor);
         return -1;
     }
-    LOG_INFO("Modbus process thread OK");
-
+    LOG_INFO("CLI managert init CLI OK");
 
     LOG_INFO("Start create CLI thread...");
     int cli_thread_ret = pthread_create(&g_cli_thread, NULL, cli_mgr_loop, NULL);
     if (cli_thread_ret != 0) {
         LOG_ERROR("Create CLI thread failed:%s", strerror(cli_thread_ret));
-        pthread_cancel(g_modbus_thread);
-        pthread_join(g_modbus_thread, NULL);
+        stats_srv_destroy(g_stats_srv);
+        modbus_gw_destroy(g_modbus_gw);
         net_mgr_destroy(g_net_mgr);
         uart_mgr_destroy(g_uart_mgr);
         cli_mgr_destroy();
+        reactor_destroy(g_reactor);
         return -1;
     }
     LOG_INFO("CLI thread OK");
 
+    // SIGHUP or a rewrite of the config file reconfigures the ports in place
+    int hup_fd = signalfd(-1, &hup_mask, SFD_NONBLOCK | SFD_CLOEXEC);
+    if (hup_fd < 0 || reactor_add(g_reactor, &g_sighup_handler, hup_fd, EPOLLIN, on_sighup, NULL) != 0) {
+        LOG_WARN("SIGHUP reload disabled");
+        if (hup_fd >= 0) close(hup_fd);
+        g_sighup_handler.fd = -1;
+    }
+    if (uart_mgr_watch_config(g_uart_mgr) != 0) {
+        LOG_WARN("Config file watch disabled, use SIGHUP to reload");
+    }
+
+    // Bus workers start last: every handler of their loops is registered by now
+    if (uart_mgr_start_workers(g_uart_mgr) < 0) {
+        LOG_ERROR("Start bus workers failed!");
+        g_running = 0;
+    }
+
     LOG_INFO("All module init complete! System running...");
     LOG_INFO("Press Ctrl+C to exit");
 
-    while (g_running) {
-        epoll_handle_uart_events();
-        usleep(1000); 
+    // Block in epoll until SIGINT or CLI 'exit' stops the reactor
+    if (g_running) {
+        reactor_run(g_reactor);
     }
 
     LOG_INFO("Start release resource...");
     pthread_cancel(g_cli_thread);
     pthread_join(g_cli_thread, NULL);
-    pthread_cancel(g_modbus_thread);
-    pthread_join(g_modbus_thread, NULL);
+    uart_mgr_stop_workers(g_uart_mgr);
+    if (g_sighup_handler.fd >= 0) {
+        int fd = g_sighup_handler.fd;
+        reactor_del(g_reactor, &g_sighup_handler);
+        close(fd);
+    }
+    stats_srv_destroy(g_stats_srv);
+    modbus_gw_destroy(g_modbus_gw);
     net_mgr_destroy(g_net_mgr);
     uart_mgr_destroy(g_uart_mgr);
     cli_mgr_destroy();
+    reactor_destroy(g_reactor);
+    trace_destroy();
     log_destroy();
     printf("[EXIT] All resource released, program exit success!\n");
 
@@ -0,0 +1,180 @@
+#define LOG_MODULE LOG_MOD_MODBUS
+#include "modbus_cache.h"
+#include "../log/log.h"
+
+/**
+ * Initialize read-response cache
+ * @param cache: Pointer to ModbusCache
+ * @param capacity: Number of register blocks to keep
+ * @param ttl_ms: Max age of a cached response (ms)
+ * @return 0 on success, -1 on failure
+ */
+int modbus_cache_init(ModbusCache* cache, int capacity, uint32_t ttl_ms)
+{
+    if (!cache || capacity <= 0 || ttl_ms == 0) return -1;
+
+    memset(cache, 0, sizeof(ModbusCache));
+    cache->entries = (ModbusCacheEntry*)calloc(capacity, sizeof(ModbusCacheEntry));
+    if (!cache->entries) {
+        LOG_ERROR("Malloc ModbusCache entries failed");
+        return -1;
+    }
+    cache->capacity = capacity;
+    cache->ttl_ms = ttl_ms;
+    return 0;
+}
+
+/**
+ * Release read-response cache
+ * @param cache: Pointer to ModbusCache
+ */
+void modbus_cache_destroy(ModbusCache* cache)
+{
+    if (!cache) return;
+    free(cache->entries);
+    cache->entries = NULL;
+    cache->capacity = 0;
+}
+
+/**
+ * Find entry of a register block
+ * @param cache: Pointer to ModbusCache
+ * @param unit: Slave address
+ * @param func_code: Function code
+ * @param start: Start register
+ * @param quantity: Number of registers
+ * @return Pointer to ModbusCacheEntry, NULL if not cached
+ */
+static ModbusCacheEntry* modbus_cache_find(ModbusCache* cache, uint8_t unit, uint8_t func_code,
+                                           uint16_t start, uint16_t quantity)
+{
+    for (int i = 0; i < cache->capacity; i++) {
+        ModbusCacheEntry* e = &cache->entries[i];
+        if (e->valid && e->unit == unit && e->func_code == func_code &&
+            e->start == start && e->quantity == quantity) {
+            return e;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Look up a cached FC03/FC04 response
+ * @param cache: Pointer to ModbusCache
+ * @param unit: Slave address
+ * @param func_code: Function code (0x03 / 0x04)
+ * @param start: Start register
+ * @param quantity: Number of registers
+ * @param now_ns: Monotonic time (ns)
+ * @param pdu_len: Output PDU length
+ * @return Cached response PDU (fc + byte count + data), NULL on miss
+ */
+const uint8_t* modbus_cache_lookup(ModbusCache* cache, uint8_t unit, uint8_t func_code,
+                                   uint16_t start, uint16_t quantity, uint64_t now_ns, int* pdu_len)
+{
+    if (!cache || !cache->entries || !pdu_len) return NULL;
+
+    ModbusCacheEntry* e = modbus_cache_find(cache, unit, func_code, start, quantity);
+    if (e && now_ns - e->stored_ns > (uint64_t)cache->ttl_ms * 1000000ULL) {
+        e->valid = 0;
+        stats_ctr_add(&cache->ctr, MODBUS_CACHE_CTR_EXPIRED, 1);
+        e = NULL;
+    }
+    if (!e) {
+        stats_ctr_add(&cache->ctr, MODBUS_CACHE_CTR_MISSES, 1);
+        return NULL;
+    }
+
+    e->used_ns = now_ns;
+    stats_ctr_add(&cache->ctr, MODBUS_CACHE_CTR_HITS, 1);
+    *pdu_len = e->pdu_len;
+    return e->pdu;
+}
+
+/**
+ * Store FC03/FC04 response (replaces the same block, else a free, expired or least recently used entry)
+ * @param cache: Pointer to ModbusCache
+ * @param unit: Slave address
+ * @param func_code: Function code (0x03 / 0x04)
+ * @param start: Start register
+ * @param quantity: Number of registers
+ * @param pdu: Response PDU (fc + byte count + data)
+ * @param pdu_len: PDU length
+ * @param now_ns: Monotonic time (ns)
+ */
+void modbus_cache_store(ModbusCache* cache, uint8_t unit, uint8_t func_code, uint16_t start, uint16_t quantity,
+                        const uint8_t* pdu, int pdu_len, uint64_t now_ns)
+{
+    if (!cache || !cache->entries || !pdu || pdu_len <= 0 || pdu_len > MODBUS_CACHE_PDU_MAX) return;
+
+    uint64_t ttl_ns = (uint64_t)cache->ttl_ms * 1000000ULL;
+    ModbusCacheEntry* e = modbus_cache_find(cache, unit, func_code, start, quantity);
+    if (!e) {
+        ModbusCacheEntry* lru = NULL;
+        for (int i = 0; i < cache->capacity; i++) {
+            ModbusCacheEntry* c = &cache->entries[i];
+            if (!c->valid || now_ns - c->stored_ns > ttl_ns) {
+                e = c;
+                break;
+            }
+            if (!lru || c->used_ns < lru->used_ns) {
+                lru = c;
+            }
+        }
+        if (!e) {
+            e = lru;
+            stats_ctr_add(&cache->ctr, MODBUS_CACHE_CTR_EVICTIONS, 1);
+        }
+    }
+
+    e->valid = 1;
+    e->unit = unit;
+    e->func_code = func_code;
+    e->start = start;
+    e->quantity = quantity;
+    e->stored_ns = now_ns;
+    e->used_ns = now_ns;
+    e->pdu_len = (uint8_t)pdu_len;
+    memcpy(e->pdu, pdu, pdu_len);
+    stats_ctr_add(&cache->ctr, MODBUS_CACHE_CTR_STORES, 1);
+}
+
+/**
+ * Drop cached holding-register blocks overlapping a written range
+ * @param cache: Pointer to ModbusCache
+ * @param unit: Slave address (MODBUS_BROADCAST_ADDR = every slave)
+ * @param start: First written register
+ * @param quantity: Number of written registers
+ */
+void modbus_cache_invalidate(ModbusCache* cache, uint8_t unit, uint16_t start, uint16_t quantity)
+{
+    if (!cache || !cache->entries || quantity == 0) return;
+
+    uint32_t end = (uint32_t)start + quantity;
+    for (int i = 0; i < cache->capacity; i++) {
+        ModbusCacheEntry* e = &cache->entries[i];
+        if (!e->valid || e->func_code != MODBUS_FC_READ_HOLDING_REGISTERS) continue;
+        if (unit != MODBUS_BROADCAST_ADDR && e->unit != unit) continue;
+        if (e->start < end && start < (uint32_t)e->start + e->quantity) {
+            e->valid = 0;
+            stats_ctr_add(&cache->ctr, MODBUS_CACHE_CTR_INVALIDATIONS, 1);
+        }
+    }
+}
+
+/**
+ * Get cache statistics (any thread)
+ * @param cache: Pointer to ModbusCache
+ * @param stats: Output ModbusCacheStats
+ */
+void modbus_cache_get_stats(const ModbusCache* cache, ModbusCacheStats* stats)
+{
+    uint64_t v[MODBUS_CACHE_CTR_NUM];
+    stats_ctr_snapshot(&cache->ctr, v, MODBUS_CACHE_CTR_NUM);
+    stats->hits = v[MODBUS_CACHE_CTR_HITS];
+    stats->misses = v[MODBUS_CACHE_CTR_MISSES];
+    stats->stores = v[MODBUS_CACHE_CTR_STORES];
+    stats->evictions = v[MODBUS_CACHE_CTR_EVICTIONS];
+    stats->expired = v[MODBUS_CACHE_CTR_EXPIRED];
+    stats->invalidations = v[MODBUS_CACHE_CTR_INVALIDATIONS];
+}
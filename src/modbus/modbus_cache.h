@@ -0,0 +1,68 @@
+#ifndef MODBUS_CACHE_H
+#define MODBUS_CACHE_H
+
+#include <stdint.h>
+#include "modbus_core.h"
+#include "../stats/stats.h"
+
+// Global constants for the read-response cache
+#define MODBUS_CACHE_ENTRIES 64          // Cached register blocks per bus
+#define MODBUS_CACHE_PDU_MAX 253         // fc + byte count + 250 data bytes
+
+// Cached FC03/FC04 response of one register block
+typedef struct {
+    int valid;
+    uint8_t unit;
+    uint8_t func_code;
+    uint16_t start;
+    uint16_t quantity;
+    uint64_t stored_ns;
+    uint64_t used_ns;            // Last hit (LRU eviction)
+    uint8_t pdu_len;
+    uint8_t pdu[MODBUS_CACHE_PDU_MAX];
+} ModbusCacheEntry;
+
+// Cache counters (index into ModbusCache.ctr)
+typedef enum {
+    MODBUS_CACHE_CTR_HITS,
+    MODBUS_CACHE_CTR_MISSES,
+    MODBUS_CACHE_CTR_STORES,
+    MODBUS_CACHE_CTR_EVICTIONS,
+    MODBUS_CACHE_CTR_EXPIRED,
+    MODBUS_CACHE_CTR_INVALIDATIONS,
+    MODBUS_CACHE_CTR_NUM
+} ModbusCacheCtr;
+
+// Cache statistics of a bus (snapshot of ModbusCache.ctr)
+typedef struct {
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t stores;
+    uint32_t evictions;          // Valid entries replaced because the cache was full
+    uint32_t expired;            // Lookups that found an entry older than the TTL
+    uint32_t invalidations;      // Entries dropped by overlapping writes
+} ModbusCacheStats;
+
+// Per-bus read-response cache (owned by the reactor thread)
+typedef struct {
+    ModbusCacheEntry* entries;
+    int capacity;
+    uint32_t ttl_ms;
+    StatsCounters ctr;           // ModbusCacheCtr
+} ModbusCache;
+
+int modbus_cache_init(ModbusCache* cache, int capacity, uint32_t ttl_ms);
+
+void modbus_cache_destroy(ModbusCache* cache);
+
+const uint8_t* modbus_cache_lookup(ModbusCache* cache, uint8_t unit, uint8_t func_code,
+                                   uint16_t start, uint16_t quantity, uint64_t now_ns, int* pdu_len);
+
+void modbus_cache_store(ModbusCache* cache, uint8_t unit, uint8_t func_code, uint16_t start, uint16_t quantity,
+                        const uint8_t* pdu, int pdu_len, uint64_t now_ns);
+
+void modbus_cache_invalidate(ModbusCache* cache, uint8_t unit, uint16_t start, uint16_t quantity);
+
+void modbus_cache_get_stats(const ModbusCache* cache, ModbusCacheStats* stats);
+
+#endif // !MODBUS_CACHE_H
@@ -1,3 +1,4 @@
+#define LOG_MODULE LOG_MOD_MODBUS
 #include "modbus_core.h"
 #include "../log/log.h"
 
@@ -9,25 +10,37 @@
  */
 uint16_t modbus_crc16(const uint8_t* data, uint16_t len)
 {
-    uint16_t crc = 0xFFFF;
+    uint16_t crc = MODBUS_CRC16_INIT;
     if (data == NULL || len == 0) {
         LOG_WARN("Modbus CRC16 input data is null or len is 0");
         return crc;
     }
 
-    for (int i = 0; i < len; i++) {
-        crc ^= data[i];
-        for (int j = 0; j < 8; j++) {
-            if (crc & 0x0001) {
-                crc >>= 1;
-                crc ^= 0xA001;
-            } else {
-                crc >>= 1;
-            }
-        }
+    return modbus_crc16_final(modbus_crc16_update(crc, data, len));
+}
+
+/**
+ * Get length of the first complete MBAP frame in a TCP byte stream
+ * @param buf: Buffered stream data (starts at a frame boundary)
+ * @param len: Number of buffered bytes
+ * @return Frame length if complete, 0 if more data is needed, -1 on invalid MBAP header
+ */
+int modbus_tcp_frame_len(const uint8_t* buf, int len)
+{
+    if (buf == NULL || len < MODBUS_TCP_HEADER_LEN) {
+        return 0;
     }
 
-    return (crc >> 8) | (crc << 8);
+    uint16_t protocol_id = (buf[2] << 8) | buf[3];
+    uint16_t length = (buf[4] << 8) | buf[5];
+    if (protocol_id != MODBUS_TCP_PROTOCOL_ID || length < 2 || length > MODBUS_TCP_MAX_LENGTH) {
+        return -1;
+    }
+
+    if (len < MODBUS_TCP_HEADER_LEN + length) {
+        return 0;
+    }
+    return MODBUS_TCP_HEADER_LEN + length;
 }
 
 /**
@@ -56,7 +69,8 @@ int modbus_parse_tcp_data(const uint8_t* tcp_data, uint16_t data_len, ModbusTCPF
         return -2;
     }
 
-    if (tcp_frame->length + MODBUS_TCP_HEADER_LEN != data_len) {
+    if (tcp_frame->length + MODBUS_TCP_HEADER_LEN != data_len ||
+        tcp_frame->length < 2 || tcp_frame->length > MODBUS_TCP_MAX_LENGTH) {
         LOG_ERROR("Modbus TCP frame length mismatch");
         return -3;
     }
@@ -156,11 +170,54 @@ int modbus_tcp_to_rtu(const ModbusTCPFrame* tcp_frame, ModbusRTUFrame* rtu_frame
     rtu_frame->data_len = tcp_frame->data_len;
     memcpy(rtu_frame->data, tcp_frame->data, tcp_frame->data_len);
 
-    uint8_t crc_data[MODBUS_MAX_FRAME_LEN];
-    crc_data[0] = rtu_frame->slave_addr;
-    crc_data[1] = rtu_frame->func_code;
-    memcpy(crc_data + 2, rtu_frame->data, rtu_frame->data_len);
-    rtu_frame->crc = modbus_crc16(crc_data, 2 + rtu_frame->data_len);
+    uint8_t head[2] = { rtu_frame->slave_addr, rtu_frame->func_code };
+    uint16_t crc = modbus_crc16_update(MODBUS_CRC16_INIT, head, sizeof(head));
+    crc = modbus_crc16_update(crc, rtu_frame->data, rtu_frame->data_len);
+    rtu_frame->crc = modbus_crc16_final(crc);
 
     return 0;
+}
+
+/**
+ * Build Modbus TCP ADU (MBAP header + PDU)
+ * @param transaction_id: MBAP transaction ID
+ * @param unit_id: MBAP unit ID
+ * @param pdu: PDU (function code + data)
+ * @param pdu_len: PDU length (1 ~ 253)
+ * @param out: Output buffer (at least MODBUS_TCP_MAX_ADU_LEN bytes)
+ * @return ADU length on success, -1 on failure
+ */
+int modbus_build_tcp_adu(uint16_t transaction_id, uint8_t unit_id, const uint8_t* pdu, int pdu_len, uint8_t* out)
+{
+    if (pdu == NULL || out == NULL || pdu_len <= 0 || pdu_len + 1 > MODBUS_TCP_MAX_LENGTH) {
+        return -1;
+    }
+
+    int offset = 0;
+    out[offset++] = (transaction_id >> 8) & 0xFF;
+    out[offset++] = transaction_id & 0xFF;
+    out[offset++] = (MODBUS_TCP_PROTOCOL_ID >> 8) & 0xFF;
+    out[offset++] = MODBUS_TCP_PROTOCOL_ID & 0xFF;
+    out[offset++] = ((pdu_len + 1) >> 8) & 0xFF;
+    out[offset++] = (pdu_len + 1) & 0xFF;
+    out[offset++] = unit_id;
+    memcpy(out + offset, pdu, pdu_len);
+    offset += pdu_len;
+
+    return offset;
+}
+
+/**
+ * Build Modbus TCP exception response
+ * @param transaction_id: MBAP transaction ID of the request
+ * @param unit_id: MBAP unit ID of the request
+ * @param func_code: Function code of the request
+ * @param ex_code: Exception code (MODBUS_EX_xxx)
+ * @param out: Output buffer (at least 9 bytes)
+ * @return ADU length on success, -1 on failure
+ */
+int modbus_build_tcp_exception(uint16_t transaction_id, uint8_t unit_id, uint8_t func_code, uint8_t ex_code, uint8_t* out)
+{
+    uint8_t pdu[2] = { (uint8_t)(func_code | 0x80), ex_code };
+    return modbus_build_tcp_adu(transaction_id, unit_id, pdu, sizeof(pdu), out);
 }
\ No newline at end of file
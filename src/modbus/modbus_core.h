@@ -5,16 +5,32 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdint.h>
+#include "modbus_crc.h"
 
 // Global constants for Modbus protocol
 #define MODBUS_MAX_FRAME_LEN 256
 #define MODBUS_TCP_HEADER_LEN 6
 #define MODBUS_CRC_LEN 2
+#define MODBUS_TCP_MAX_LENGTH 254    // Max MBAP length field (unit + PDU of 253 bytes)
+#define MODBUS_TCP_MAX_ADU_LEN (MODBUS_TCP_HEADER_LEN + MODBUS_TCP_MAX_LENGTH)
+#define MODBUS_MAX_READ_REGS 125     // FC03/FC04 register limit of one request
 
 // Modbus function codes (common types)
+#define MODBUS_FC_READ_COILS 0x01
+#define MODBUS_FC_READ_DISCRETE_INPUTS 0x02
 #define MODBUS_FC_READ_HOLDING_REGISTERS 0x03
+#define MODBUS_FC_READ_INPUT_REGISTERS 0x04
 #define MODBUS_FC_WRITE_SINGLE_REGISTER 0x06
 #define MODBUS_FC_WRITE_MULTIPLE_REGISTERS 0x10
+#define MODBUS_FC_MASK_WRITE_REGISTER 0x16
+#define MODBUS_FC_READ_WRITE_REGISTERS 0x17
+
+// Modbus exception codes
+#define MODBUS_EX_SLAVE_BUSY 0x06
+#define MODBUS_EX_GATEWAY_PATH 0x0A
+#define MODBUS_EX_GATEWAY_TARGET 0x0B
+
+#define MODBUS_BROADCAST_ADDR 0x00
 
 // Modbus TCP fixed parameters
 #define MODBUS_TCP_TRANS_ID_H 0x00
@@ -37,15 +53,18 @@ typedef struct {
     uint16_t length;             // 剩余帧长度(从站+功能码+数据)
     uint8_t slave_addr;          // 从站地址
     uint8_t func_code;           // 功能码
-    uint8_t data[MODBUS_MAX_FRAME_LEN - MODBUS_TCP_HEADER_LEN - 1]; // 数据域
+    uint8_t data[MODBUS_MAX_FRAME_LEN - 3]; // 数据域(与RTU数据域等长)
     uint16_t data_len;           // 数据域长度
 } ModbusTCPFrame;
 
 // 核心函数声明
 uint16_t modbus_crc16(const uint8_t* data, uint16_t len);
+int modbus_tcp_frame_len(const uint8_t* buf, int len);
 int modbus_parse_tcp_data(const uint8_t* tcp_data, uint16_t data_len, ModbusTCPFrame* tcp_frame);
 int modbus_parse_rtu_data(const uint8_t* rtu_data, uint16_t data_len, ModbusRTUFrame* rtu_frame);
 int modbus_rtu_to_tcp(const ModbusRTUFrame* rtu_frame, uint16_t transaction_id, ModbusTCPFrame* tcp_frame);
 int modbus_tcp_to_rtu(const ModbusTCPFrame* tcp_frame, ModbusRTUFrame* rtu_frame);
+int modbus_build_tcp_adu(uint16_t transaction_id, uint8_t unit_id, const uint8_t* pdu, int pdu_len, uint8_t* out);
+int modbus_build_tcp_exception(uint16_t transaction_id, uint8_t unit_id, uint8_t func_code, uint8_t ex_code, uint8_t* out);
 
 #endif // !MODBUS_CORE_H
\ No newline at end of file
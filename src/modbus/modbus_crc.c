@@ -0,0 +1,288 @@
+#include <string.h>
+
+#include "modbus_crc.h"
+
+#if !defined(MODBUS_CRC_NO_FOLD) && defined(__aarch64__)
+#include <arm_neon.h>
+#include <sys/auxv.h>
+#ifndef HWCAP_PMULL
+#define HWCAP_PMULL (1 << 4)
+#endif
+#define MODBUS_CRC_HAVE_FOLD 1
+#elif !defined(MODBUS_CRC_NO_FOLD) && defined(__x86_64__)
+#include <immintrin.h>
+#define MODBUS_CRC_HAVE_FOLD 1
+#endif
+
+// Folding constants: bit-reflected (x^n mod P) for P = x^16 + x^15 + x^2 + 1,
+// one degree below the folding distance so the reflected product needs no shift
+#define MODBUS_CRC_FOLD_K1 0xCCD0000000000000ULL    // x^(128+64-1) mod P
+#define MODBUS_CRC_FOLD_K2 0xC100000000000000ULL    // x^(128-1) mod P
+
+// crc_table[k][b]: CRC of byte b followed by k zero bytes (crc_table[0] is the classic table)
+static uint16_t crc_table[8][256];
+
+static uint16_t modbus_crc16_update_slice8(uint16_t crc, const uint8_t* data, size_t len);
+static ModbusCrc16Fn g_crc16_update = modbus_crc16_update_slice8;
+static ModbusCrcImpl g_crc16_impl = MODBUS_CRC_IMPL_SLICE8;
+
+/**
+ * Bit-by-bit CRC update (reference implementation)
+ * @param crc: Raw CRC register
+ * @param data: Data buffer
+ * @param len: Length of data buffer
+ * @return Updated CRC register
+ */
+static uint16_t modbus_crc16_update_bitwise(uint16_t crc, const uint8_t* data, size_t len)
+{
+    for (size_t i = 0; i < len; i++) {
+        crc ^= data[i];
+        for (int j = 0; j < 8; j++) {
+            if (crc & 0x0001) {
+                crc = (crc >> 1) ^ MODBUS_CRC16_POLY;
+            } else {
+                crc >>= 1;
+            }
+        }
+    }
+    return crc;
+}
+
+/**
+ * Table-driven CRC update (one lookup per byte)
+ * @param crc: Raw CRC register
+ * @param data: Data buffer
+ * @param len: Length of data buffer
+ * @return Updated CRC register
+ */
+static uint16_t modbus_crc16_update_table(uint16_t crc, const uint8_t* data, size_t len)
+{
+    for (size_t i = 0; i < len; i++) {
+        crc = (crc >> 8) ^ crc_table[0][(crc ^ data[i]) & 0xFF];
+    }
+    return crc;
+}
+
+/**
+ * Slice-by-8 CRC update (8 independent lookups per 8 bytes)
+ * @param crc: Raw CRC register
+ * @param data: Data buffer
+ * @param len: Length of data buffer
+ * @return Updated CRC register
+ */
+static uint16_t modbus_crc16_update_slice8(uint16_t crc, const uint8_t* data, size_t len)
+{
+    while (len >= 8) {
+        crc = crc_table[7][(data[0] ^ crc) & 0xFF] ^
+              crc_table[6][data[1] ^ (crc >> 8)] ^
+              crc_table[5][data[2]] ^
+              crc_table[4][data[3]] ^
+              crc_table[3][data[4]] ^
+              crc_table[2][data[5]] ^
+              crc_table[1][data[6]] ^
+              crc_table[0][data[7]];
+        data += 8;
+        len -= 8;
+    }
+    return modbus_crc16_update_table(crc, data, len);
+}
+
+#ifdef MODBUS_CRC_HAVE_FOLD
+#ifdef __aarch64__
+/**
+ * Fold 16-byte blocks with PMULL until one block is left
+ * @param crc: Raw CRC register
+ * @param data: Data buffer (len >= MODBUS_CRC_FOLD_MIN_LEN)
+ * @param len: Length of data buffer
+ * @param out: Output remaining block (CRC-equivalent to the folded bytes, init 0)
+ * @return Number of bytes consumed (multiple of 16)
+ */
+__attribute__((target("+crypto")))
+static size_t modbus_crc16_fold_blocks(uint16_t crc, const uint8_t* data, size_t len, uint8_t out[16])
+{
+    uint8_t first[16];
+    memcpy(first, data, sizeof(first));
+    first[0] ^= crc & 0xFF;
+    first[1] ^= crc >> 8;
+
+    uint64x2_t acc = vreinterpretq_u64_u8(vld1q_u8(first));
+    size_t off = 16;
+    for (; len - off >= 16; off += 16) {
+        poly128_t lo = vmull_p64((poly64_t)vgetq_lane_u64(acc, 0), (poly64_t)MODBUS_CRC_FOLD_K1);
+        poly128_t hi = vmull_p64((poly64_t)vgetq_lane_u64(acc, 1), (poly64_t)MODBUS_CRC_FOLD_K2);
+        acc = veorq_u64(vreinterpretq_u64_p128(lo), vreinterpretq_u64_p128(hi));
+        acc = veorq_u64(acc, vreinterpretq_u64_u8(vld1q_u8(data + off)));
+    }
+    vst1q_u8(out, vreinterpretq_u8_u64(acc));
+    return off;
+}
+
+/**
+ * Check whether the CPU implements PMULL
+ * @return 1 if supported, 0 otherwise
+ */
+static int modbus_crc16_fold_supported(void)
+{
+    return (getauxval(AT_HWCAP) & HWCAP_PMULL) != 0;
+}
+#else
+/**
+ * Fold 16-byte blocks with PCLMULQDQ until one block is left
+ * @param crc: Raw CRC register
+ * @param data: Data buffer (len >= MODBUS_CRC_FOLD_MIN_LEN)
+ * @param len: Length of data buffer
+ * @param out: Output remaining block (CRC-equivalent to the folded bytes, init 0)
+ * @return Number of bytes consumed (multiple of 16)
+ */
+__attribute__((target("pclmul,sse2")))
+static size_t modbus_crc16_fold_blocks(uint16_t crc, const uint8_t* data, size_t len, uint8_t out[16])
+{
+    const __m128i k = _mm_set_epi64x((long long)MODBUS_CRC_FOLD_K2, (long long)MODBUS_CRC_FOLD_K1);
+    __m128i acc = _mm_loadu_si128((const __m128i*)data);
+    acc = _mm_xor_si128(acc, _mm_cvtsi32_si128(crc));
+
+    size_t off = 16;
+    for (; len - off >= 16; off += 16) {
+        __m128i lo = _mm_clmulepi64_si128(acc, k, 0x00);
+        __m128i hi = _mm_clmulepi64_si128(acc, k, 0x11);
+        acc = _mm_xor_si128(_mm_xor_si128(lo, hi), _mm_loadu_si128((const __m128i*)(data + off)));
+    }
+    _mm_storeu_si128((__m128i*)out, acc);
+    return off;
+}
+
+/**
+ * Check whether the CPU implements PCLMULQDQ
+ * @return 1 if supported, 0 otherwise
+ */
+static int modbus_crc16_fold_supported(void)
+{
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("pclmul");
+}
+#endif
+
+/**
+ * Folding CRC update: reduce the buffer to one 16-byte block with carry-less
+ * multiplies, then finish the block and the tail with slice-by-8
+ * @param crc: Raw CRC register
+ * @param data: Data buffer
+ * @param len: Length of data buffer
+ * @return Updated CRC register
+ */
+static uint16_t modbus_crc16_update_fold(uint16_t crc, const uint8_t* data, size_t len)
+{
+    if (len < MODBUS_CRC_FOLD_MIN_LEN) {
+        return modbus_crc16_update_slice8(crc, data, len);
+    }
+
+    uint8_t block[16];
+    size_t off = modbus_crc16_fold_blocks(crc, data, len, block);
+    crc = modbus_crc16_update_slice8(0, block, sizeof(block));
+    return modbus_crc16_update_slice8(crc, data + off, len - off);
+}
+#endif
+
+/**
+ * Build lookup tables and select the fastest implementation (runs before main)
+ */
+__attribute__((constructor))
+static void modbus_crc16_init(void)
+{
+    for (int b = 0; b < 256; b++) {
+        uint8_t byte = (uint8_t)b;
+        crc_table[0][b] = modbus_crc16_update_bitwise(0, &byte, 1);
+    }
+    for (int k = 1; k < 8; k++) {
+        for (int b = 0; b < 256; b++) {
+            uint16_t prev = crc_table[k - 1][b];
+            crc_table[k][b] = (prev >> 8) ^ crc_table[0][prev & 0xFF];
+        }
+    }
+
+    if (modbus_crc16_select(MODBUS_CRC_IMPL_FOLD) != 0) {
+        modbus_crc16_select(MODBUS_CRC_IMPL_SLICE8);
+    }
+}
+
+/**
+ * Update CRC register with the active implementation
+ * @param crc: Raw CRC register (MODBUS_CRC16_INIT for a new frame)
+ * @param data: Data buffer
+ * @param len: Length of data buffer
+ * @return Updated CRC register (see modbus_crc16_final)
+ */
+uint16_t modbus_crc16_update(uint16_t crc, const uint8_t* data, size_t len)
+{
+    return g_crc16_update(crc, data, len);
+}
+
+/**
+ * Get a specific CRC implementation
+ * @param impl: Implementation ID
+ * @return Update function, NULL if not supported by this build or CPU
+ */
+ModbusCrc16Fn modbus_crc16_get_impl(ModbusCrcImpl impl)
+{
+    switch (impl) {
+        case MODBUS_CRC_IMPL_BITWISE:
+            return modbus_crc16_update_bitwise;
+        case MODBUS_CRC_IMPL_TABLE:
+            return modbus_crc16_update_table;
+        case MODBUS_CRC_IMPL_SLICE8:
+            return modbus_crc16_update_slice8;
+        case MODBUS_CRC_IMPL_FOLD:
+#ifdef MODBUS_CRC_HAVE_FOLD
+            if (modbus_crc16_fold_supported()) {
+                return modbus_crc16_update_fold;
+            }
+#endif
+            return NULL;
+        default:
+            return NULL;
+    }
+}
+
+/**
+ * Select implementation used by modbus_crc16_update / modbus_crc16
+ * @param impl: Implementation ID
+ * @return 0 on success, -1 if not supported
+ */
+int modbus_crc16_select(ModbusCrcImpl impl)
+{
+    ModbusCrc16Fn fn = modbus_crc16_get_impl(impl);
+    if (!fn) return -1;
+
+    g_crc16_update = fn;
+    g_crc16_impl = impl;
+    return 0;
+}
+
+/**
+ * Get active implementation
+ * @return Implementation ID
+ */
+ModbusCrcImpl modbus_crc16_active(void)
+{
+    return g_crc16_impl;
+}
+
+/**
+ * Get implementation name
+ * @param impl: Implementation ID
+ * @return Name string
+ */
+const char* modbus_crc16_impl_name(ModbusCrcImpl impl)
+{
+    switch (impl) {
+        case MODBUS_CRC_IMPL_BITWISE: return "bitwise";
+        case MODBUS_CRC_IMPL_TABLE:   return "table";
+        case MODBUS_CRC_IMPL_SLICE8:  return "slice8";
+#ifdef __aarch64__
+        case MODBUS_CRC_IMPL_FOLD:    return "fold-pmull";
+#else
+        case MODBUS_CRC_IMPL_FOLD:    return "fold-pclmul";
+#endif
+        default:                      return "unknown";
+    }
+}
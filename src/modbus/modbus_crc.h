@@ -0,0 +1,45 @@
+#ifndef MODBUS_CRC_H
+#define MODBUS_CRC_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// CRC-16/MODBUS (reflected poly 0xA001, init 0xFFFF, no final xor)
+#define MODBUS_CRC16_INIT 0xFFFF
+#define MODBUS_CRC16_POLY 0xA001
+#define MODBUS_CRC_FOLD_MIN_LEN 32       // Shorter buffers are faster with slice-by-8
+
+// CRC16 implementations (the fastest supported one is selected at startup)
+typedef enum {
+    MODBUS_CRC_IMPL_BITWISE,     // 8 shifts per byte (reference)
+    MODBUS_CRC_IMPL_TABLE,       // 256-entry table, 1 byte per step
+    MODBUS_CRC_IMPL_SLICE8,      // 8 x 256-entry tables, 8 bytes per step
+    MODBUS_CRC_IMPL_FOLD,        // Carry-less multiply folding (aarch64 PMULL / x86-64 PCLMUL)
+    MODBUS_CRC_IMPL_NUM
+} ModbusCrcImpl;
+
+// Update raw CRC register with len bytes (streaming: chain calls, start with MODBUS_CRC16_INIT)
+typedef uint16_t (*ModbusCrc16Fn)(uint16_t crc, const uint8_t* data, size_t len);
+
+uint16_t modbus_crc16_update(uint16_t crc, const uint8_t* data, size_t len);
+
+/**
+ * Convert raw CRC register to the value returned by modbus_crc16
+ * (high byte = first CRC byte on the wire)
+ * @param crc: Raw CRC register
+ * @return CRC16 checksum value
+ */
+static inline uint16_t modbus_crc16_final(uint16_t crc)
+{
+    return (uint16_t)((crc >> 8) | (crc << 8));
+}
+
+ModbusCrc16Fn modbus_crc16_get_impl(ModbusCrcImpl impl);
+
+int modbus_crc16_select(ModbusCrcImpl impl);
+
+ModbusCrcImpl modbus_crc16_active(void);
+
+const char* modbus_crc16_impl_name(ModbusCrcImpl impl);
+
+#endif // !MODBUS_CRC_H
@@ -0,0 +1,1224 @@
+#define LOG_MODULE LOG_MOD_MODBUS
+#include "modbus_gw.h"
+#include "../log/log.h"
+#include "../trace/trace.h"
+
+static void bus_req_queue_handler(void* item, void* arg);
+
+/**
+ * Get register block read by a FC03/FC04 request
+ * @param func_code: Function code
+ * @param data: Request data (after function code)
+ * @param data_len: Request data length
+ * @param start: Output start register
+ * @param quantity: Output number of registers
+ * @return 1 if the request is a cacheable read, 0 otherwise
+ */
+static int gw_read_block(uint8_t func_code, const uint8_t* data, int data_len, uint16_t* start, uint16_t* quantity)
+{
+    if ((func_code != MODBUS_FC_READ_HOLDING_REGISTERS && func_code != MODBUS_FC_READ_INPUT_REGISTERS) ||
+        data_len != 4) {
+        return 0;
+    }
+    *start = (data[0] << 8) | data[1];
+    *quantity = (data[2] << 8) | data[3];
+    return 1;
+}
+
+/**
+ * Check whether a function code only reads slave data (safe to share one response)
+ * @param func_code: Function code
+ * @return 1 if read-only, 0 otherwise
+ */
+static int gw_is_read(uint8_t func_code)
+{
+    return func_code == MODBUS_FC_READ_COILS || func_code == MODBUS_FC_READ_DISCRETE_INPUTS ||
+           func_code == MODBUS_FC_READ_HOLDING_REGISTERS || func_code == MODBUS_FC_READ_INPUT_REGISTERS;
+}
+
+/**
+ * Get holding-register block written by a request
+ * @param func_code: Function code
+ * @param data: Request data (after function code)
+ * @param data_len: Request data length
+ * @param start: Output first written register
+ * @param quantity: Output number of written registers
+ * @return 1 if the request writes holding registers, 0 otherwise
+ */
+static int gw_write_block(uint8_t func_code, const uint8_t* data, int data_len, uint16_t* start, uint16_t* quantity)
+{
+    switch (func_code) {
+        case MODBUS_FC_WRITE_SINGLE_REGISTER:
+        case MODBUS_FC_MASK_WRITE_REGISTER:
+            if (data_len < 2) return 0;
+            *start = (data[0] << 8) | data[1];
+            *quantity = 1;
+            return 1;
+        case MODBUS_FC_WRITE_MULTIPLE_REGISTERS:
+            if (data_len < 4) return 0;
+            *start = (data[0] << 8) | data[1];
+            *quantity = (data[2] << 8) | data[3];
+            return 1;
+        case MODBUS_FC_READ_WRITE_REGISTERS:
+            if (data_len < 8) return 0;
+            *start = (data[4] << 8) | data[5];
+            *quantity = (data[6] << 8) | data[7];
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+/**
+ * Drop cached blocks a request writes to
+ * @param bus: Pointer to ModbusBus
+ * @param rtu: Request
+ */
+static void bus_cache_invalidate(ModbusBus* bus, const ModbusRTUFrame* rtu)
+{
+    uint16_t start, quantity;
+    if (bus->cache.entries && gw_write_block(rtu->func_code, rtu->data, rtu->data_len, &start, &quantity)) {
+        modbus_cache_invalidate(&bus->cache, rtu->slave_addr, start, quantity);
+    }
+}
+
+/**
+ * Take a transaction from the bus pool
+ * @param bus: Pointer to ModbusBus
+ * @return Pointer to ModbusTxn, NULL if the table is full
+ */
+static ModbusTxn* bus_txn_alloc(ModbusBus* bus)
+{
+    ModbusTxn* txn = bus->free_list;
+    if (txn) {
+        bus->free_list = txn->next;
+        memset(txn, 0, sizeof(ModbusTxn));
+    }
+    return txn;
+}
+
+/**
+ * Return a transaction to the bus pool
+ * @param bus: Pointer to ModbusBus
+ * @param txn: Transaction to release
+ */
+static void bus_txn_free(ModbusBus* bus, ModbusTxn* txn)
+{
+    // Reads answered while a write was queued may have cached pre-write values
+    bus_cache_invalidate(bus, &txn->rtu);
+
+    while (txn->waiters) {
+        ModbusWaiter* w = txn->waiters;
+        txn->waiters = w->next;
+        w->next = bus->free_waiters;
+        bus->free_waiters = w;
+    }
+
+    txn->next = bus->free_list;
+    bus->free_list = txn;
+    bus->depth--;
+}
+
+/**
+ * Check whether the requester of a transaction still waits for the response
+ * (worker buses read the connection ID of another thread: a stale value only
+ * postpones the drop until the response is delivered)
+ * @param gw: Pointer to ModbusGw
+ * @param origin: Requester of the transaction
+ * @return 1 if connected (or the gateway poller / a UDP peer), 0 otherwise
+ */
+static int gw_origin_alive(ModbusGw* gw, const ModbusOrigin* origin)
+{
+    return origin->client_idx == MODBUS_ORIGIN_POLL || origin->client_idx == MODBUS_ORIGIN_UDP ||
+           net_mgr_get_conn_id(gw->net_mgr, origin->client_idx) == origin->conn_id;
+}
+
+/**
+ * Drop the register image a completed client write touched (network loop)
+ * Writes already drop it when queued, this catches polls the scheduler ran before the write
+ * @param gw: Pointer to ModbusGw
+ * @param origin: Requester of the transaction
+ * @param adu: Response ADU
+ * @param len: ADU length
+ */
+static void gw_image_invalidate(ModbusGw* gw, const ModbusOrigin* origin, const uint8_t* adu, int len)
+{
+    if (!gw->poller || len < MODBUS_TCP_HEADER_LEN + 2) return;
+
+    // FC06/FC16/FC22 responses echo the written address (and quantity) like the request
+    uint8_t func_code = adu[MODBUS_TCP_HEADER_LEN + 1];
+    const uint8_t* data = adu + MODBUS_TCP_HEADER_LEN + 2;
+    int data_len = len - MODBUS_TCP_HEADER_LEN - 2;
+    uint16_t start, quantity;
+    if (func_code == MODBUS_FC_READ_WRITE_REGISTERS) {
+        // FC23 responses carry the read data only
+        modbus_poll_invalidate(gw->poller, origin->uart_idx, origin->unit_id, 0, UINT16_MAX);
+    } else if (gw_write_block(func_code, data, data_len, &start, &quantity)) {
+        modbus_poll_invalidate(gw->poller, origin->uart_idx, origin->unit_id, start, quantity);
+    }
+}
+
+/**
+ * Deliver a Modbus TCP ADU to the requester on the network loop (dropped if it disconnected)
+ * @param gw: Pointer to ModbusGw
+ * @param origin: Requester of the transaction
+ * @param adu: ADU to send
+ * @param len: ADU length
+ * @return Number of bytes sent, -1 if the requester is gone
+ */
+static int gw_deliver(ModbusGw* gw, const ModbusOrigin* origin, const uint8_t* adu, int len)
+{
+    if (origin->client_idx == MODBUS_ORIGIN_POLL) {
+        modbus_poll_on_response(gw->poller, origin->trans_id, adu + MODBUS_TCP_HEADER_LEN + 1,
+                                len - MODBUS_TCP_HEADER_LEN - 1);
+        return len;
+    }
+    gw_image_invalidate(gw, origin, adu, len);
+    if (origin->client_idx == MODBUS_ORIGIN_UDP) {
+        TRACE_FRAME(origin->uart_idx, TRACE_TCP_TX, 0, origin->client_idx, origin->conn_id, adu, len);
+        return net_mgr_send_udp_to(gw->net_mgr, &origin->peer, adu, len);
+    }
+    if (!gw_origin_alive(gw, origin)) {
+        return -1;
+    }
+    TRACE_FRAME(origin->uart_idx, TRACE_TCP_TX, 0, origin->client_idx, origin->conn_id, adu, len);
+    return net_mgr_send_tcp(gw->net_mgr, origin->client_idx, adu, len);
+}
+
+/**
+ * Send a Modbus TCP ADU from the bus loop to the requester
+ * @param bus: Pointer to ModbusBus
+ * @param origin: Requester of the transaction
+ * @param adu: ADU to send
+ * @param len: ADU length
+ * @return ADU length if sent / queued to the network loop, -1 otherwise
+ */
+static int bus_send_to_origin(ModbusBus* bus, const ModbusOrigin* origin, const uint8_t* adu, int len)
+{
+    if (!bus->threaded) {
+        return gw_deliver(bus->gw, origin, adu, len);
+    }
+
+    ModbusGwResponse resp;
+    resp.origin = *origin;
+    resp.len = len;
+    memcpy(resp.adu, adu, len);
+    if (reactor_queue_push(&bus->resp_queue, &resp) != 0) {
+        LOG_WARN("UART %d response queue full, response dropped", bus->uart_idx);
+        return -1;
+    }
+    return len;
+}
+
+/**
+ * Deliver a response queued by a bus worker (runs on the network loop)
+ * @param item: Pointer to ModbusGwResponse
+ * @param arg: Pointer to ModbusBus
+ */
+static void gw_resp_queue_handler(void* item, void* arg)
+{
+    ModbusBus* bus = (ModbusBus*)arg;
+    ModbusGwResponse* resp = (ModbusGwResponse*)item;
+    gw_deliver(bus->gw, &resp->origin, resp->adu, resp->len);
+}
+
+/**
+ * Send Modbus exception response to the requester (network loop)
+ * @param gw: Pointer to ModbusGw
+ * @param origin: Requester of the transaction
+ * @param func_code: Function code of the request
+ * @param ex_code: Exception code (MODBUS_EX_xxx)
+ */
+void modbus_gw_send_exception(ModbusGw* gw, const ModbusOrigin* origin, uint8_t func_code, uint8_t ex_code)
+{
+    uint8_t adu[MODBUS_TCP_HEADER_LEN + 3];
+    int len = modbus_build_tcp_exception(origin->trans_id, origin->unit_id, func_code, ex_code, adu);
+    if (len > 0) {
+        gw_deliver(gw, origin, adu, len);
+    }
+}
+
+/**
+ * Send Modbus exception response to the requester from the bus loop
+ * @param bus: Pointer to ModbusBus
+ * @param origin: Requester of the transaction
+ * @param func_code: Function code of the request
+ * @param ex_code: Exception code (MODBUS_EX_xxx)
+ */
+static void bus_send_exception(ModbusBus* bus, const ModbusOrigin* origin, uint8_t func_code, uint8_t ex_code)
+{
+    uint8_t adu[MODBUS_TCP_HEADER_LEN + 3];
+    int len = modbus_build_tcp_exception(origin->trans_id, origin->unit_id, func_code, ex_code, adu);
+    if (len > 0) {
+        bus_send_to_origin(bus, origin, adu, len);
+    }
+}
+
+/**
+ * Send exception response to every requester of a transaction
+ * @param bus: Pointer to ModbusBus
+ * @param txn: Transaction
+ * @param ex_code: Exception code (MODBUS_EX_xxx)
+ */
+static void bus_txn_exception(ModbusBus* bus, const ModbusTxn* txn, uint8_t ex_code)
+{
+    bus_send_exception(bus, &txn->origin, txn->rtu.func_code, ex_code);
+    for (const ModbusWaiter* w = txn->waiters; w; w = w->next) {
+        bus_send_exception(bus, &w->origin, txn->rtu.func_code, ex_code);
+    }
+}
+
+/**
+ * Replace a disconnected requester with the first attached waiter
+ * @param bus: Pointer to ModbusBus
+ * @param txn: Transaction whose origin is gone
+ * @return 1 if a waiter took over, 0 if nobody is waiting
+ */
+static int bus_txn_promote_waiter(ModbusBus* bus, ModbusTxn* txn)
+{
+    ModbusWaiter* w = txn->waiters;
+    if (!w) return 0;
+
+    txn->origin = w->origin;
+    txn->waiters = w->next;
+    w->next = bus->free_waiters;
+    bus->free_waiters = w;
+    return 1;
+}
+
+/**
+ * Check whether a transaction carries the same request PDU for the same slave
+ * @param txn: Queued or in-flight transaction
+ * @param tcp_frame: Parsed Modbus TCP request
+ * @return 1 if identical, 0 otherwise
+ */
+static int bus_txn_same_request(const ModbusTxn* txn, const ModbusTCPFrame* tcp_frame)
+{
+    const ModbusRTUFrame* rtu = &txn->rtu;
+    return rtu->slave_addr == tcp_frame->slave_addr && rtu->func_code == tcp_frame->func_code &&
+           rtu->data_len == tcp_frame->data_len && memcmp(rtu->data, tcp_frame->data, rtu->data_len) == 0;
+}
+
+/**
+ * Attach a read to an identical read that is queued or in flight
+ * (only if the requester has nothing queued, so its own requests keep their order)
+ * @param bus: Pointer to ModbusBus
+ * @param origin: Requester of the new read
+ * @param tcp_frame: Parsed Modbus TCP request
+ * @return 1 if attached, 0 if the request needs its own transaction
+ */
+static int bus_txn_coalesce(ModbusBus* bus, const ModbusOrigin* origin, const ModbusTCPFrame* tcp_frame)
+{
+    if (!bus->free_waiters || !gw_is_read(tcp_frame->func_code) ||
+        tcp_frame->slave_addr == MODBUS_BROADCAST_ADDR || modbus_sched_flow_count(&bus->sched, origin) > 0) {
+        return 0;
+    }
+
+    ModbusTxn* match = NULL;
+    for (ModbusTxn* m = bus->inflight; m && !match; m = m->merged) {
+        if (bus_txn_same_request(m, tcp_frame)) {
+            match = m;
+        }
+    }
+    for (int i = 0; i < MODBUS_SCHED_FLOWS && !match; i++) {
+        for (ModbusTxn* txn = bus->sched.flows[i].head; txn; txn = txn->next) {
+            if (bus_txn_same_request(txn, tcp_frame)) {
+                match = txn;
+                break;
+            }
+        }
+    }
+    if (!match) return 0;
+
+    ModbusWaiter* w = bus->free_waiters;
+    bus->free_waiters = w->next;
+    w->origin = *origin;
+    w->next = match->waiters;
+    match->waiters = w;
+    stats_ctr_add(&bus->ctr, MODBUS_BUS_CTR_COALESCED, 1);
+    return 1;
+}
+
+/**
+ * Get latency histograms of a slave, allocated on its first transaction (bus loop)
+ * @param bus: Pointer to ModbusBus
+ * @param slave_addr: RTU slave address
+ * @return Pointer to ModbusLatency, NULL if out of memory
+ */
+static ModbusLatency* bus_slave_latency(ModbusBus* bus, uint8_t slave_addr)
+{
+    ModbusLatency* lat = bus->slave_lat[slave_addr];
+    if (!lat) {
+        lat = (ModbusLatency*)malloc(sizeof(ModbusLatency));
+        if (!lat) return NULL;
+        memset(lat, 0, sizeof(ModbusLatency));
+        // Readers on other threads only follow published pointers
+        __atomic_store_n(&bus->slave_lat[slave_addr], lat, __ATOMIC_RELEASE);
+    }
+    return lat;
+}
+
+/**
+ * Get round-trip histogram of a client slot, allocated on first use
+ * Buses on different workers may race for a new slot: the first pointer published wins.
+ * @param gw: Pointer to ModbusGw instance
+ * @param client_idx: Client slot
+ * @return Pointer to StatsHist, NULL on allocation failure
+ */
+static StatsHist* gw_client_rtt(ModbusGw* gw, int client_idx)
+{
+    StatsHist* h = __atomic_load_n(&gw->client_rtt[client_idx], __ATOMIC_ACQUIRE);
+    if (!h) {
+        StatsHist* fresh = (StatsHist*)malloc(sizeof(StatsHist));
+        if (!fresh) return NULL;
+        memset(fresh, 0, sizeof(StatsHist));
+        if (__atomic_compare_exchange_n(&gw->client_rtt[client_idx], &h, fresh, 0,
+                                        __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+            h = fresh;
+        } else {
+            free(fresh);
+        }
+    }
+    return h;
+}
+
+/**
+ * Record time since a TCP client request was received (gateway poller requests are skipped)
+ * @param bus: Pointer to ModbusBus
+ * @param slave: Histograms of the slave (may be NULL)
+ * @param kind: MODBUS_LAT_QUEUE or MODBUS_LAT_RTT
+ * @param origin: Requester
+ * @param now_ns: Current time (ns)
+ */
+static void bus_origin_latency(ModbusBus* bus, ModbusLatency* slave, ModbusLatKind kind,
+                               const ModbusOrigin* origin, uint64_t now_ns)
+{
+    if (origin->client_idx == MODBUS_ORIGIN_POLL || origin->rx_ns == 0 || now_ns < origin->rx_ns) return;
+
+    uint64_t us = (now_ns - origin->rx_ns) / 1000;
+    stats_hist_record(&bus->lat.hist[kind], us);
+    if (slave) {
+        stats_hist_record(&slave->hist[kind], us);
+    }
+    StatsHist* h;
+    if (kind == MODBUS_LAT_RTT && origin->client_idx >= 0 && origin->client_idx < NET_MAX_CLIENTS_LIMIT &&
+        (h = gw_client_rtt(bus->gw, origin->client_idx)) != NULL) {
+        // A new connection in the slot starts a fresh histogram
+        if (__atomic_load_n(&h->owner, __ATOMIC_RELAXED) != origin->conn_id) {
+            stats_hist_reset(h, origin->conn_id);
+        }
+        stats_hist_record(h, us);
+    }
+}
+
+/**
+ * Record latency of every requester of a transaction
+ * @param bus: Pointer to ModbusBus
+ * @param kind: MODBUS_LAT_QUEUE or MODBUS_LAT_RTT
+ * @param txn: Transaction
+ * @param now_ns: Current time (ns)
+ */
+static void bus_txn_latency(ModbusBus* bus, ModbusLatKind kind, const ModbusTxn* txn, uint64_t now_ns)
+{
+    ModbusLatency* slave = bus_slave_latency(bus, txn->rtu.slave_addr);
+    bus_origin_latency(bus, slave, kind, &txn->origin, now_ns);
+    for (const ModbusWaiter* w = txn->waiters; w; w = w->next) {
+        bus_origin_latency(bus, slave, kind, &w->origin, now_ns);
+    }
+}
+
+/**
+ * Send response PDU to every requester of a transaction
+ * @param bus: Pointer to ModbusBus
+ * @param txn: Transaction
+ * @param pdu: Response PDU (function code + data)
+ * @param pdu_len: PDU length
+ */
+static void bus_txn_reply(ModbusBus* bus, const ModbusTxn* txn, const uint8_t* pdu, int pdu_len)
+{
+    uint8_t adu[MODBUS_TCP_MAX_ADU_LEN];
+    int adu_len = modbus_build_tcp_adu(txn->origin.trans_id, txn->origin.unit_id, pdu, pdu_len, adu);
+    if (adu_len <= 0) return;
+
+    bus_txn_latency(bus, MODBUS_LAT_RTT, txn, reactor_now_ns());
+    bus_send_to_origin(bus, &txn->origin, adu, adu_len);
+    // Same PDU for every waiter, only the MBAP transaction / unit ID differ
+    for (const ModbusWaiter* w = txn->waiters; w; w = w->next) {
+        adu[0] = w->origin.trans_id >> 8;
+        adu[1] = w->origin.trans_id & 0xFF;
+        adu[6] = w->origin.unit_id;
+        bus_send_to_origin(bus, &w->origin, adu, adu_len);
+    }
+}
+
+/**
+ * Fail a transaction and the reads merged into it (exception to every requester)
+ * @param bus: Pointer to ModbusBus
+ * @param txn: Transaction
+ * @param ex_code: Exception code (MODBUS_EX_xxx)
+ */
+static void bus_txn_fail(ModbusBus* bus, ModbusTxn* txn, uint8_t ex_code)
+{
+    while (txn) {
+        ModbusTxn* next = txn->merged;
+        bus_txn_exception(bus, txn, ex_code);
+        bus_txn_free(bus, txn);
+        txn = next;
+    }
+}
+
+/**
+ * Cache a FC03/FC04 response of a transaction
+ * @param bus: Pointer to ModbusBus
+ * @param txn: Transaction
+ * @param pdu: Response PDU (function code + byte count + data)
+ * @param pdu_len: PDU length
+ */
+static void bus_cache_store(ModbusBus* bus, const ModbusTxn* txn, const uint8_t* pdu, int pdu_len)
+{
+    uint16_t start, quantity;
+    if (bus->cache.entries && !(pdu[0] & 0x80) && pdu_len >= 2 &&
+        gw_read_block(txn->rtu.func_code, txn->rtu.data, txn->rtu.data_len, &start, &quantity) &&
+        pdu[1] == quantity * 2) {
+        modbus_cache_store(&bus->cache, txn->rtu.slave_addr, txn->rtu.func_code, start, quantity,
+                           pdu, pdu_len, reactor_now_ns());
+    }
+}
+
+/**
+ * Fold queued reads of the same slave and register type that lie within the
+ * gap tolerance into one request (per requester, scan stops at the first queued non-read)
+ * @param bus: Pointer to ModbusBus
+ * @param uart: Pointer to UartDev (merge limits)
+ * @param txn: Transaction about to be written
+ * @return 1 if bus->merge_rtu holds the merged request, 0 if txn is written as is
+ */
+static int bus_txn_merge(ModbusBus* bus, UartDev* uart, ModbusTxn* txn)
+{
+    int max_regs = uart->config.merge_max_regs;
+    int gap = uart->config.merge_gap > 0 ? uart->config.merge_gap : 0;
+    uint16_t start, quantity;
+
+    if (max_regs > MODBUS_MAX_READ_REGS) max_regs = MODBUS_MAX_READ_REGS;
+    if (max_regs <= 0 || txn->no_merge || txn->rtu.slave_addr == MODBUS_BROADCAST_ADDR ||
+        !gw_read_block(txn->rtu.func_code, txn->rtu.data, txn->rtu.data_len, &start, &quantity) ||
+        quantity == 0 || quantity >= max_regs) {
+        return 0;
+    }
+
+    uint32_t lo = start;
+    uint32_t hi = (uint32_t)start + quantity;
+    ModbusTxn* last = txn;
+    for (int i = 0; i < MODBUS_SCHED_FLOWS; i++) {
+        // Only the leading reads of a requester: never move a read ahead of its own write
+        ModbusTxn* cur = bus->sched.flows[i].head;
+        while (cur && gw_is_read(cur->rtu.func_code)) {
+            ModbusTxn* next = cur->next;
+            uint16_t s, q;
+            if (!cur->no_merge && cur->rtu.slave_addr == txn->rtu.slave_addr &&
+                cur->rtu.func_code == txn->rtu.func_code &&
+                gw_read_block(cur->rtu.func_code, cur->rtu.data, cur->rtu.data_len, &s, &q) && q > 0 &&
+                s <= hi + gap && lo <= (uint32_t)s + q + gap) {
+                uint32_t new_lo = s < lo ? s : lo;
+                uint32_t new_hi = (uint32_t)s + q > hi ? (uint32_t)s + q : hi;
+                if (new_hi - new_lo <= (uint32_t)max_regs) {
+                    // Unlink from the scheduler and chain behind the leader
+                    modbus_sched_remove(&bus->sched, cur);
+                    last->merged = cur;
+                    last = cur;
+                    lo = new_lo;
+                    hi = new_hi;
+                    stats_ctr_add(&bus->ctr, MODBUS_BUS_CTR_MERGED, 1);
+                }
+            }
+            cur = next;
+        }
+    }
+    if (!txn->merged) return 0;
+
+    ModbusTCPFrame req;
+    memset(&req, 0, sizeof(req));
+    req.slave_addr = txn->rtu.slave_addr;
+    req.func_code = txn->rtu.func_code;
+    req.data[0] = lo >> 8;
+    req.data[1] = lo & 0xFF;
+    req.data[2] = (hi - lo) >> 8;
+    req.data[3] = (hi - lo) & 0xFF;
+    req.data_len = 4;
+    modbus_tcp_to_rtu(&req, &bus->merge_rtu);
+    bus->merge_start = (uint16_t)lo;
+    bus->merge_quantity = (uint16_t)(hi - lo);
+    stats_ctr_add(&bus->ctr, MODBUS_BUS_CTR_MERGE_TXNS, 1);
+    return 1;
+}
+
+/**
+ * Split the response of a merged request into the answers of its reads
+ * @param bus: Pointer to ModbusBus
+ * @param txn: Leader of the merged reads
+ * @param frame: RTU response incl. CRC
+ * @param len: Frame length
+ * @return 0 on success (all reads answered and released), -1 if the response does not cover the block
+ */
+static int bus_merge_reply(ModbusBus* bus, ModbusTxn* txn, const uint8_t* frame, int len)
+{
+    if ((frame[1] & 0x80) || len < 3 + MODBUS_CRC_LEN || frame[2] != bus->merge_quantity * 2 ||
+        len - 3 - MODBUS_CRC_LEN != frame[2]) {
+        return -1;
+    }
+
+    while (txn) {
+        ModbusTxn* next = txn->merged;
+        uint16_t start = bus->merge_start, quantity = 0;
+        uint8_t pdu[2 + MODBUS_MAX_READ_REGS * 2];
+        gw_read_block(txn->rtu.func_code, txn->rtu.data, txn->rtu.data_len, &start, &quantity);
+        pdu[0] = txn->rtu.func_code;
+        pdu[1] = quantity * 2;
+        memcpy(pdu + 2, frame + 3 + (start - bus->merge_start) * 2, quantity * 2);
+
+        bus_txn_reply(bus, txn, pdu, 2 + quantity * 2);
+        bus_cache_store(bus, txn, pdu, 2 + quantity * 2);
+        bus_txn_free(bus, txn);
+        txn = next;
+    }
+    return 0;
+}
+
+/**
+ * Put the reads of a failed merged request back at the head of their queues, to be sent one by one
+ * @param bus: Pointer to ModbusBus
+ * @param txn: Leader of the merged reads
+ */
+static void bus_merge_split(ModbusBus* bus, ModbusTxn* txn)
+{
+    ModbusTxn* reads[MODBUS_GW_MAX_PENDING];
+    int count = 0;
+    while (txn && count < MODBUS_GW_MAX_PENDING) {
+        reads[count++] = txn;
+        txn = txn->merged;
+    }
+
+    // Reverse order keeps the original order of reads taken from the same queue
+    while (count > 0) {
+        ModbusTxn* m = reads[--count];
+        m->merged = NULL;
+        m->no_merge = 1;
+        modbus_sched_push_front(&bus->sched, m);
+    }
+}
+
+/**
+ * Get time a frame occupies the wire at the UART baudrate
+ * @param uart: Pointer to UartDev
+ * @param len: Frame length (bytes)
+ * @return Transmission time (us)
+ */
+static uint64_t bus_frame_time_us(UartDev* uart, int len)
+{
+    int baud = uart->config.baudrate > 0 ? uart->config.baudrate : 9600;
+    return (uint64_t)len * MODBUS_RTU_CHAR_BITS * 1000000ULL / baud;
+}
+
+/**
+ * Write next pending request to the bus if it is idle
+ * @param bus: Pointer to ModbusBus
+ */
+static void bus_dispatch(ModbusBus* bus)
+{
+    ModbusGw* gw = bus->gw;
+    UartDev* uart = uart_mgr_get_uart_by_idx(gw->uart_mgr, bus->uart_idx);
+
+    ModbusTxn* txn;
+    while (bus->state == MODBUS_BUS_IDLE && !bus->hold && (txn = modbus_sched_pop(&bus->sched)) != NULL) {
+
+        if (!gw_origin_alive(gw, &txn->origin) && !bus_txn_promote_waiter(bus, txn)) {
+            stats_ctr_add(&bus->ctr, MODBUS_BUS_CTR_DROPPED, 1);
+            bus_txn_free(bus, txn);
+            continue;
+        }
+
+        const ModbusRTUFrame* wire = bus_txn_merge(bus, uart, txn) ? &bus->merge_rtu : &txn->rtu;
+        if (modbus_rtu_frame_write(gw->uart_mgr, bus->uart_idx, wire) <= 0) {
+            LOG_ERROR("UART %d write failed", bus->uart_idx);
+            bus_txn_fail(bus, txn, MODBUS_EX_GATEWAY_TARGET);
+            continue;
+        }
+        txn->write_ns = reactor_now_ns();
+        for (const ModbusTxn* m = txn; m; m = m->merged) {
+            modbus_sched_account(&bus->sched, m, txn->write_ns);
+            bus_txn_latency(bus, MODBUS_LAT_QUEUE, m, txn->write_ns);
+        }
+        uint64_t tx_us = bus_frame_time_us(uart, 4 + wire->data_len);
+
+        if (txn->rtu.slave_addr == MODBUS_BROADCAST_ADDR) {
+            // No response to broadcast: keep the bus silent until the frame is out
+            bus_txn_free(bus, txn);
+            bus->state = MODBUS_BUS_TURNAROUND;
+            reactor_timer_start(&bus->timer, tx_us + uart->rtu.t35_us, 0);
+            break;
+        }
+
+        int timeout_ms = uart->config.resp_timeout_ms > 0 ? uart->config.resp_timeout_ms : MODBUS_GW_RESP_TIMEOUT_MS;
+        bus->inflight = txn;
+        bus->state = MODBUS_BUS_WAIT_RESP;
+        reactor_timer_start(&bus->timer, tx_us + (uint64_t)timeout_ms * 1000, 0);
+    }
+}
+
+/**
+ * Bus timer callback (response timeout or end of turnaround)
+ * @param arg: Pointer to ModbusBus
+ */
+static void bus_timer_handler(void* arg)
+{
+    ModbusBus* bus = (ModbusBus*)arg;
+
+    if (bus->state == MODBUS_BUS_WAIT_RESP && bus->inflight) {
+        ModbusTxn* txn = bus->inflight;
+        bus->inflight = NULL;
+        stats_ctr_add(&bus->ctr, MODBUS_BUS_CTR_TIMEOUTS, 1);
+        LOG_WARN("UART %d slave %d response timeout (fc 0x%02X)",
+                 bus->uart_idx, txn->rtu.slave_addr, txn->rtu.func_code);
+        bus_txn_fail(bus, txn, MODBUS_EX_GATEWAY_TARGET);
+    }
+
+    bus->state = MODBUS_BUS_IDLE;
+    bus_dispatch(bus);
+}
+
+/**
+ * Hold / release a bus around a live reconfiguration of its UART (called on the bus loop)
+ * Requests keep queueing while the bus is held; the one in flight is answered or times out
+ * @param uart: Reconfigured UART
+ * @param phase: UART_RECONFIG_HOLD or UART_RECONFIG_RELEASE
+ * @param arg: Pointer to ModbusGw
+ * @return 1 once no request is on the wire, 0 while waiting for it
+ */
+static int gw_on_reconfig(UartDev* uart, UartReconfigPhase phase, void* arg)
+{
+    ModbusGw* gw = (ModbusGw*)arg;
+    ModbusBus* bus = &gw->buses[uart->config.idx];
+    if (!bus->enabled) return 1;
+
+    if (phase == UART_RECONFIG_HOLD) {
+        bus->hold = 1;
+        return bus->state == MODBUS_BUS_IDLE;
+    }
+    bus->hold = 0;
+    bus_dispatch(bus);
+    return 1;
+}
+
+/**
+ * Initialize Modbus gateway engine
+ * @param uart_mgr: Pointer to UartMgr instance
+ * @param net_mgr: Pointer to NetMgr instance
+ * @param reactor: Event loop for bus timers
+ * @return Pointer to ModbusGw instance on success, NULL on failure
+ */
+ModbusGw* modbus_gw_init(UartMgr* uart_mgr, NetMgr* net_mgr, Reactor* reactor)
+{
+    ModbusGw* gw = (ModbusGw*)malloc(sizeof(ModbusGw));
+    if (!gw) {
+        LOG_ERROR("Malloc ModbusGw failed");
+        return NULL;
+    }
+    memset(gw, 0, sizeof(ModbusGw));
+    gw->uart_mgr = uart_mgr;
+    gw->net_mgr = net_mgr;
+    gw->reactor = reactor;
+
+    for (int i = 0; i < MAX_UART_NUM; i++) {
+        ModbusBus* bus = &gw->buses[i];
+        bus->uart_idx = i;
+        bus->gw = gw;
+        bus->timer.handler.fd = -1;
+        for (int j = MODBUS_GW_MAX_PENDING - 1; j >= 0; j--) {
+            bus->pool[j].next = bus->free_list;
+            bus->free_list = &bus->pool[j];
+        }
+        for (int j = MODBUS_GW_MAX_WAITERS - 1; j >= 0; j--) {
+            bus->waiter_pool[j].next = bus->free_waiters;
+            bus->free_waiters = &bus->waiter_pool[j];
+        }
+
+        bus->req_queue.handler.fd = -1;
+        bus->resp_queue.handler.fd = -1;
+        modbus_sched_init(&bus->sched);
+
+        UartDev* uart = uart_mgr_get_uart_by_idx(uart_mgr, i);
+        if (uart->fd < 0 || !uart->config.modbus_enable) continue;
+
+        // The bus lives on the loop that reads its UART
+        bus->reactor = uart->reactor;
+        bus->threaded = bus->reactor != reactor;
+        bus->max_depth = uart->config.queue_depth;
+        if (bus->max_depth <= 0 || bus->max_depth > MODBUS_GW_MAX_PENDING) {
+            bus->max_depth = MODBUS_GW_MAX_PENDING;
+        }
+        if (reactor_timer_init(bus->reactor, &bus->timer, bus_timer_handler, bus) != 0) {
+            LOG_ERROR("Create bus %d timer failed", i);
+            modbus_gw_destroy(gw);
+            return NULL;
+        }
+        if (bus->threaded &&
+            (reactor_queue_init(&bus->req_queue, bus->reactor, sizeof(ModbusGwRequest), MODBUS_GW_QUEUE_LEN,
+                                bus_req_queue_handler, bus) != 0 ||
+             reactor_queue_init(&bus->resp_queue, reactor, sizeof(ModbusGwResponse), MODBUS_GW_QUEUE_LEN,
+                                gw_resp_queue_handler, bus) != 0)) {
+            LOG_ERROR("Create bus %d worker queues failed", i);
+            modbus_gw_destroy(gw);
+            return NULL;
+        }
+        if (uart->config.cache_ttl_ms > 0 &&
+            modbus_cache_init(&bus->cache, MODBUS_CACHE_ENTRIES, uart->config.cache_ttl_ms) != 0) {
+            LOG_WARN("Bus %d response cache disabled", i);
+        }
+        bus->enabled = 1;
+    }
+
+    if (uart_mgr->poll_count > 0) {
+        gw->poller = modbus_poll_init(gw, uart_mgr, reactor);
+    }
+    uart_mgr_set_reconfig_handler(uart_mgr, gw_on_reconfig, gw);
+
+    return gw;
+}
+
+/**
+ * Destroy Modbus gateway engine
+ * @param gw: Pointer to ModbusGw instance
+ */
+void modbus_gw_destroy(ModbusGw* gw)
+{
+    if (!gw) return;
+    uart_mgr_set_reconfig_handler(gw->uart_mgr, NULL, NULL);
+    modbus_poll_destroy(gw->poller);
+    for (int i = 0; i < MAX_UART_NUM; i++) {
+        reactor_timer_destroy(&gw->buses[i].timer);
+        reactor_queue_destroy(&gw->buses[i].req_queue);
+        reactor_queue_destroy(&gw->buses[i].resp_queue);
+        modbus_cache_destroy(&gw->buses[i].cache);
+        for (int j = 0; j < MODBUS_GW_MAX_SLAVES; j++) {
+            free(gw->buses[i].slave_lat[j]);
+        }
+    }
+    for (int i = 0; i < NET_MAX_CLIENTS_LIMIT; i++) {
+        free(gw->client_rtt[i]);
+    }
+    free(gw);
+}
+
+/**
+ * Queue a Modbus request on the bus loop (cache, coalescing, scheduler)
+ * @param bus: Pointer to ModbusBus
+ * @param origin: Requester (response is routed back to it)
+ * @param tcp_frame: Parsed Modbus TCP request
+ * @return 0 on success, -1 on failure (exception response already sent)
+ */
+static int bus_submit(ModbusBus* bus, const ModbusOrigin* origin, const ModbusTCPFrame* tcp_frame)
+{
+    uint16_t start, quantity;
+    if (origin->client_idx != MODBUS_ORIGIN_POLL && bus->cache.entries &&
+        gw_read_block(tcp_frame->func_code, tcp_frame->data, tcp_frame->data_len, &start, &quantity)) {
+        int pdu_len = 0;
+        const uint8_t* pdu = modbus_cache_lookup(&bus->cache, tcp_frame->slave_addr, tcp_frame->func_code,
+                                                 start, quantity, reactor_now_ns(), &pdu_len);
+        if (pdu) {
+            uint8_t adu[MODBUS_TCP_MAX_ADU_LEN];
+            int adu_len = modbus_build_tcp_adu(origin->trans_id, origin->unit_id, pdu, pdu_len, adu);
+            if (adu_len > 0) {
+                bus_send_to_origin(bus, origin, adu, adu_len);
+            }
+            return 0;
+        }
+    }
+
+    if (bus_txn_coalesce(bus, origin, tcp_frame)) {
+        return 0;
+    }
+
+    ModbusClass cls = !gw_is_read(tcp_frame->func_code) ? MODBUS_CLASS_WRITE :
+                      origin->client_idx == MODBUS_ORIGIN_POLL ? MODBUS_CLASS_POLL : MODBUS_CLASS_READ;
+    // The last slots stay free for writes, so a flood of reads cannot lock operators out
+    int limit = bus->max_depth;
+    if (cls != MODBUS_CLASS_WRITE && limit > MODBUS_SCHED_WRITE_RESERVE * 2) {
+        limit -= MODBUS_SCHED_WRITE_RESERVE;
+    }
+
+    // One TCP client may hold at most half of the read slots, the rest is left for the others
+    int flow_limit = cls == MODBUS_CLASS_READ ? (limit + 1) / 2 : limit;
+
+    ModbusTxn* txn = NULL;
+    if (bus->depth < limit && modbus_sched_flow_count(&bus->sched, origin) < flow_limit) {
+        txn = bus_txn_alloc(bus);
+    }
+    if (!txn) {
+        stats_ctr_add(&bus->ctr, MODBUS_BUS_CTR_QUEUE_FULL, 1);
+        stats_ctr_add(&bus->sched.ctr, MODBUS_SCHED_CTR(cls, MODBUS_SCHED_CTR_REJECTED), 1);
+        bus_send_exception(bus, origin, tcp_frame->func_code, MODBUS_EX_SLAVE_BUSY);
+        return -1;
+    }
+    bus->depth++;
+    if (bus->depth > (int)bus->depth_peak) {
+        __atomic_store_n(&bus->depth_peak, bus->depth, __ATOMIC_RELAXED);
+    }
+
+    txn->origin = *origin;
+    txn->cls = cls;
+    txn->enqueue_ns = reactor_now_ns();
+    if (modbus_tcp_to_rtu(tcp_frame, &txn->rtu) != 0) {
+        bus_txn_free(bus, txn);
+        return -1;
+    }
+
+    stats_ctr_add(&bus->ctr, MODBUS_BUS_CTR_REQUESTS, 1);
+    bus_cache_invalidate(bus, &txn->rtu);
+    modbus_sched_push(&bus->sched, txn);
+    bus_dispatch(bus);
+    return 0;
+}
+
+/**
+ * Run a request handed over by the network loop (runs on the bus worker)
+ * @param item: Pointer to ModbusGwRequest
+ * @param arg: Pointer to ModbusBus
+ */
+static void bus_req_queue_handler(void* item, void* arg)
+{
+    ModbusGwRequest* req = (ModbusGwRequest*)item;
+    bus_submit((ModbusBus*)arg, &req->origin, &req->frame);
+}
+
+/**
+ * Queue a Modbus request for a serial bus (network loop)
+ * @param gw: Pointer to ModbusGw instance
+ * @param uart_idx: Target UART index
+ * @param origin: Requester (response is routed back to it)
+ * @param tcp_frame: Parsed Modbus TCP request
+ * @return 0 on success, -1 on failure (exception response already sent)
+ */
+int modbus_gw_submit(ModbusGw* gw, int uart_idx, const ModbusOrigin* origin, const ModbusTCPFrame* tcp_frame)
+{
+    if (!gw || !origin || !tcp_frame || uart_idx < 0 || uart_idx >= MAX_UART_NUM) {
+        return -1;
+    }
+
+    ModbusBus* bus = &gw->buses[uart_idx];
+    if (!bus->enabled) {
+        modbus_gw_send_exception(gw, origin, tcp_frame->func_code, MODBUS_EX_GATEWAY_PATH);
+        return -1;
+    }
+
+    // The register image belongs to the network loop, answer before handing over to the bus
+    uint16_t start, quantity;
+    if (origin->client_idx != MODBUS_ORIGIN_POLL && gw->poller &&
+        gw_read_block(tcp_frame->func_code, tcp_frame->data, tcp_frame->data_len, &start, &quantity)) {
+        uint8_t pdu[2 + MODBUS_MAX_READ_REGS * 2];
+        int pdu_len = modbus_poll_read(gw->poller, uart_idx, tcp_frame->slave_addr, tcp_frame->func_code,
+                                       start, quantity, reactor_now_ns(), pdu);
+        if (pdu_len > 0) {
+            uint8_t adu[MODBUS_TCP_MAX_ADU_LEN];
+            int adu_len = modbus_build_tcp_adu(origin->trans_id, origin->unit_id, pdu, pdu_len, adu);
+            if (adu_len > 0) {
+                gw_deliver(gw, origin, adu, adu_len);
+            }
+            return 0;
+        }
+    }
+    // Reads after a client write must not see the image polled before it
+    if (origin->client_idx != MODBUS_ORIGIN_POLL && gw->poller &&
+        gw_write_block(tcp_frame->func_code, tcp_frame->data, tcp_frame->data_len, &start, &quantity)) {
+        modbus_poll_invalidate(gw->poller, uart_idx, tcp_frame->slave_addr, start, quantity);
+    }
+
+    if (!bus->threaded) {
+        return bus_submit(bus, origin, tcp_frame);
+    }
+
+    ModbusGwRequest req;
+    req.origin = *origin;
+    req.frame = *tcp_frame;
+    if (reactor_queue_push(&bus->req_queue, &req) != 0) {
+        modbus_gw_send_exception(gw, origin, tcp_frame->func_code, MODBUS_EX_SLAVE_BUSY);
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * Handle validated RTU frame received on a bus (route response to its requester)
+ * @param gw: Pointer to ModbusGw instance
+ * @param uart_idx: UART index the frame was received on
+ * @param frame: RTU frame incl. CRC
+ * @param len: Frame length
+ */
+void modbus_gw_on_rtu_frame(ModbusGw* gw, int uart_idx, const uint8_t* frame, int len)
+{
+    if (!gw || !frame || len < MODBUS_RTU_MIN_FRAME_LEN || uart_idx < 0 || uart_idx >= MAX_UART_NUM) {
+        return;
+    }
+
+    ModbusBus* bus = &gw->buses[uart_idx];
+    ModbusTxn* txn = bus->inflight;
+    if (bus->state != MODBUS_BUS_WAIT_RESP || !txn ||
+        frame[0] != txn->rtu.slave_addr || (frame[1] & 0x7F) != txn->rtu.func_code) {
+        stats_ctr_add(&bus->ctr, MODBUS_BUS_CTR_UNMATCHED, 1);
+        LOG_WARN("UART %d unmatched RTU response (slave %d, fc 0x%02X)", uart_idx, frame[0], frame[1]);
+        return;
+    }
+
+    stats_ctr_add(&bus->ctr, MODBUS_BUS_CTR_RESPONSES, 1);
+    bus->inflight = NULL;
+
+    // First byte of this frame (the deframer has not reset it yet) measures the slave turnaround
+    UartDev* uart = uart_mgr_get_uart_by_idx(gw->uart_mgr, uart_idx);
+    if (uart->rtu.first_rx_ns > txn->write_ns) {
+        uint64_t us = (uart->rtu.first_rx_ns - txn->write_ns) / 1000;
+        ModbusLatency* slave = bus_slave_latency(bus, frame[0]);
+        stats_hist_record(&bus->lat.hist[MODBUS_LAT_RESPONSE], us);
+        if (slave) {
+            stats_hist_record(&slave->hist[MODBUS_LAT_RESPONSE], us);
+        }
+    }
+    if (!txn->merged) {
+        bus_txn_reply(bus, txn, frame + 1, len - 1 - MODBUS_CRC_LEN);
+        bus_cache_store(bus, txn, frame + 1, len - 1 - MODBUS_CRC_LEN);
+        bus_txn_free(bus, txn);
+    } else if (bus_merge_reply(bus, txn, frame, len) != 0) {
+        stats_ctr_add(&bus->ctr, MODBUS_BUS_CTR_MERGE_FALLBACKS, 1);
+        LOG_WARN("UART %d slave %d merged read %u+%u rejected, retrying reads separately",
+                 uart_idx, frame[0], bus->merge_start, bus->merge_quantity);
+        bus_merge_split(bus, txn);
+    }
+
+    // Keep t3.5 of silence before the next request
+    bus->state = MODBUS_BUS_TURNAROUND;
+    reactor_timer_start(&bus->timer, uart->rtu.t35_us, 0);
+}
+
+/**
+ * Get transaction statistics of a bus
+ * @param gw: Pointer to ModbusGw instance
+ * @param uart_idx: UART index
+ * @param stats: Output ModbusBusStats
+ * @param depth: Output number of outstanding transactions (may be NULL)
+ */
+void modbus_gw_get_bus_stats(ModbusGw* gw, int uart_idx, ModbusBusStats* stats, int* depth)
+{
+    if (!gw || !stats || uart_idx < 0 || uart_idx >= MAX_UART_NUM) return;
+    ModbusBus* bus = &gw->buses[uart_idx];
+    uint64_t v[MODBUS_BUS_CTR_NUM];
+    stats_ctr_snapshot(&bus->ctr, v, MODBUS_BUS_CTR_NUM);
+    stats->requests = v[MODBUS_BUS_CTR_REQUESTS];
+    stats->responses = v[MODBUS_BUS_CTR_RESPONSES];
+    stats->timeouts = (uint32_t)v[MODBUS_BUS_CTR_TIMEOUTS];
+    stats->queue_full = (uint32_t)v[MODBUS_BUS_CTR_QUEUE_FULL];
+    stats->unmatched = (uint32_t)v[MODBUS_BUS_CTR_UNMATCHED];
+    stats->dropped = (uint32_t)v[MODBUS_BUS_CTR_DROPPED];
+    stats->coalesced = v[MODBUS_BUS_CTR_COALESCED];
+    stats->merged = v[MODBUS_BUS_CTR_MERGED];
+    stats->merge_txns = v[MODBUS_BUS_CTR_MERGE_TXNS];
+    stats->merge_fallbacks = (uint32_t)v[MODBUS_BUS_CTR_MERGE_FALLBACKS];
+    stats->max_depth = __atomic_load_n(&bus->depth_peak, __ATOMIC_RELAXED);
+    if (depth) *depth = __atomic_load_n(&bus->depth, __ATOMIC_RELAXED);
+}
+
+/**
+ * Get per-class scheduler statistics of a bus
+ * @param gw: Pointer to ModbusGw instance
+ * @param uart_idx: UART index
+ * @param stats: Output array of MODBUS_CLASS_NUM ModbusSchedStats
+ * @param max_depth: Output outstanding transaction limit (may be NULL)
+ * @return 0 on success, -1 if the bus is not enabled
+ */
+int modbus_gw_get_sched_stats(ModbusGw* gw, int uart_idx, ModbusSchedStats* stats, int* max_depth)
+{
+    if (!gw || !stats || uart_idx < 0 || uart_idx >= MAX_UART_NUM) return -1;
+    ModbusBus* bus = &gw->buses[uart_idx];
+    if (!bus->enabled) return -1;
+    modbus_sched_get_stats(&bus->sched, stats);
+    if (max_depth) *max_depth = bus->max_depth;
+    return 0;
+}
+
+/**
+ * Get worker queue overflow counters of a bus
+ * @param gw: Pointer to ModbusGw instance
+ * @param uart_idx: UART index
+ * @param req_full: Output requests rejected because the worker queue was full
+ * @param resp_full: Output responses dropped because the network queue was full
+ * @return 0 on success, -1 if the bus does not run on a worker
+ */
+int modbus_gw_get_queue_stats(ModbusGw* gw, int uart_idx, uint32_t* req_full, uint32_t* resp_full)
+{
+    if (!gw || !req_full || !resp_full || uart_idx < 0 || uart_idx >= MAX_UART_NUM) return -1;
+    ModbusBus* bus = &gw->buses[uart_idx];
+    if (!bus->threaded) return -1;
+    *req_full = bus->req_queue.full;
+    *resp_full = bus->resp_queue.full;
+    return 0;
+}
+
+/**
+ * Get response cache statistics of a bus
+ * @param gw: Pointer to ModbusGw instance
+ * @param uart_idx: UART index
+ * @param stats: Output ModbusCacheStats
+ * @param ttl_ms: Output cache TTL (may be NULL)
+ * @return 0 on success, -1 if the bus has no cache
+ */
+int modbus_gw_get_cache_stats(ModbusGw* gw, int uart_idx, ModbusCacheStats* stats, uint32_t* ttl_ms)
+{
+    if (!gw || !stats || uart_idx < 0 || uart_idx >= MAX_UART_NUM) return -1;
+    ModbusCache* cache = &gw->buses[uart_idx].cache;
+    if (!cache->entries) return -1;
+    modbus_cache_get_stats(cache, stats);
+    if (ttl_ms) *ttl_ms = cache->ttl_ms;
+    return 0;
+}
+
+/**
+ * Get latency histograms of a bus or of one slave on it (snapshot, any thread)
+ * @param gw: Pointer to ModbusGw instance
+ * @param uart_idx: UART index
+ * @param slave_addr: RTU slave address, -1 = whole bus
+ * @param lat: Output ModbusLatency
+ * @return 0 on success, -1 if the bus is not enabled or the slave has no samples
+ */
+int modbus_gw_get_latency(ModbusGw* gw, int uart_idx, int slave_addr, ModbusLatency* lat)
+{
+    if (!gw || !lat || uart_idx < 0 || uart_idx >= MAX_UART_NUM || slave_addr >= MODBUS_GW_MAX_SLAVES) return -1;
+    ModbusBus* bus = &gw->buses[uart_idx];
+    if (!bus->enabled) return -1;
+
+    const ModbusLatency* src = &bus->lat;
+    if (slave_addr >= 0) {
+        src = __atomic_load_n(&bus->slave_lat[slave_addr], __ATOMIC_ACQUIRE);
+        if (!src) return -1;
+    }
+    for (int k = 0; k < MODBUS_LAT_NUM; k++) {
+        stats_hist_snapshot(&src->hist[k], &lat->hist[k]);
+    }
+    return 0;
+}
+
+/**
+ * Get round-trip histogram of a connected client (snapshot, any thread)
+ * @param gw: Pointer to ModbusGw instance
+ * @param client_idx: Client slot
+ * @param hist: Output StatsHist
+ * @return 0 on success, -1 if the slot holds no samples of its current connection
+ */
+int modbus_gw_get_client_rtt(ModbusGw* gw, int client_idx, StatsHist* hist)
+{
+    if (!gw || !hist || client_idx < 0 || client_idx >= NET_MAX_CLIENTS_LIMIT) return -1;
+    uint32_t conn_id = net_mgr_get_conn_id(gw->net_mgr, client_idx);
+    StatsHist* h = __atomic_load_n(&gw->client_rtt[client_idx], __ATOMIC_ACQUIRE);
+    if (!h) return -1;
+    stats_hist_snapshot(h, hist);
+    return conn_id != 0 && hist->owner == conn_id ? 0 : -1;
+}
+
+/**
+ * Clear every latency histogram (samples recorded meanwhile may survive)
+ * @param gw: Pointer to ModbusGw instance
+ */
+void modbus_gw_reset_latency(ModbusGw* gw)
+{
+    if (!gw) return;
+    for (int i = 0; i < MAX_UART_NUM; i++) {
+        ModbusBus* bus = &gw->buses[i];
+        for (int k = 0; k < MODBUS_LAT_NUM; k++) {
+            stats_hist_reset(&bus->lat.hist[k], 0);
+        }
+        for (int j = 0; j < MODBUS_GW_MAX_SLAVES; j++) {
+            ModbusLatency* lat = __atomic_load_n(&bus->slave_lat[j], __ATOMIC_ACQUIRE);
+            for (int k = 0; lat && k < MODBUS_LAT_NUM; k++) {
+                stats_hist_reset(&lat->hist[k], 0);
+            }
+        }
+    }
+    for (int i = 0; i < NET_MAX_CLIENTS_LIMIT; i++) {
+        StatsHist* h = __atomic_load_n(&gw->client_rtt[i], __ATOMIC_ACQUIRE);
+        if (h) {
+            stats_hist_reset(h, __atomic_load_n(&h->owner, __ATOMIC_RELAXED));
+        }
+    }
+}
+
+/**
+ * Write bus counters and latency histograms in Prometheus text format
+ * @param gw: Pointer to ModbusGw instance
+ * @param buf: Output StatsBuf
+ */
+void modbus_gw_write_metrics(ModbusGw* gw, StatsBuf* buf)
+{
+    static const char* lat_names[MODBUS_LAT_NUM] = {"queue", "response", "rtt"};
+    static const char* lat_help[MODBUS_LAT_NUM] = {
+        "TCP receive to request written to the UART",
+        "Request written to first response byte",
+        "TCP receive to response sent"
+    };
+    if (!gw || !buf) return;
+
+    ModbusBusStats bus_stats[MAX_UART_NUM];
+    for (int i = 0; i < MAX_UART_NUM; i++) {
+        modbus_gw_get_bus_stats(gw, i, &bus_stats[i], NULL);
+    }
+    stats_buf_printf(buf, "# HELP serial_modbus_requests_total Requests queued on the bus\n"
+                          "# TYPE serial_modbus_requests_total counter\n");
+    for (int i = 0; i < MAX_UART_NUM; i++) {
+        if (gw->buses[i].enabled) {
+            stats_buf_printf(buf, "serial_modbus_requests_total{uart=\"%d\"} %lu\n", i, bus_stats[i].requests);
+        }
+    }
+    stats_buf_printf(buf, "# HELP serial_modbus_timeouts_total Requests without response\n"
+                          "# TYPE serial_modbus_timeouts_total counter\n");
+    for (int i = 0; i < MAX_UART_NUM; i++) {
+        if (gw->buses[i].enabled) {
+            stats_buf_printf(buf, "serial_modbus_timeouts_total{uart=\"%d\"} %u\n", i, bus_stats[i].timeouts);
+        }
+    }
+
+    StatsHist* snap = (StatsHist*)malloc(sizeof(StatsHist));
+    if (!snap) return;
+    char labels[64];
+    for (int k = 0; k < MODBUS_LAT_NUM; k++) {
+        stats_buf_printf(buf, "# HELP serial_modbus_%s_seconds %s\n# TYPE serial_modbus_%s_seconds summary\n",
+                         lat_names[k], lat_help[k], lat_names[k]);
+        char name[64];
+        snprintf(name, sizeof(name), "serial_modbus_%s_seconds", lat_names[k]);
+        for (int i = 0; i < MAX_UART_NUM; i++) {
+            if (!gw->buses[i].enabled) continue;
+            stats_hist_snapshot(&gw->buses[i].lat.hist[k], snap);
+            snprintf(labels, sizeof(labels), "uart=\"%d\"", i);
+            stats_write_summary(buf, name, labels, snap);
+        }
+
+        stats_buf_printf(buf, "# HELP serial_modbus_slave_%s_seconds %s per slave\n"
+                              "# TYPE serial_modbus_slave_%s_seconds summary\n",
+                         lat_names[k], lat_help[k], lat_names[k]);
+        snprintf(name, sizeof(name), "serial_modbus_slave_%s_seconds", lat_names[k]);
+        for (int i = 0; i < MAX_UART_NUM; i++) {
+            if (!gw->buses[i].enabled) continue;
+            for (int j = 0; j < MODBUS_GW_MAX_SLAVES; j++) {
+                ModbusLatency* lat = __atomic_load_n(&gw->buses[i].slave_lat[j], __ATOMIC_ACQUIRE);
+                if (!lat) continue;
+                stats_hist_snapshot(&lat->hist[k], snap);
+                snprintf(labels, sizeof(labels), "uart=\"%d\",slave=\"%d\"", i, j);
+                stats_write_summary(buf, name, labels, snap);
+            }
+        }
+    }
+
+    stats_buf_printf(buf, "# HELP serial_modbus_client_rtt_seconds TCP receive to response sent per client slot\n"
+                          "# TYPE serial_modbus_client_rtt_seconds summary\n");
+    int slots = net_mgr_get_slot_count(gw->net_mgr);
+    for (int i = 0; i < slots; i++) {
+        if (modbus_gw_get_client_rtt(gw, i, snap) != 0) continue;
+        snprintf(labels, sizeof(labels), "client=\"%d\"", i);
+        stats_write_summary(buf, "serial_modbus_client_rtt_seconds", labels, snap);
+    }
+    free(snap);
+}
@@ -0,0 +1,155 @@
+#ifndef MODBUS_GW_H
+#define MODBUS_GW_H
+
+#include <stdint.h>
+#include "modbus_core.h"
+#include "modbus_cache.h"
+#include "modbus_sched.h"
+#include "modbus_poll.h"
+#include "../uart/uart_mgr.h"
+#include "../net/net_mgr.h"
+#include "../reactor/reactor.h"
+#include "../stats/stats.h"
+
+// Global constants for the Modbus TCP -> RTU gateway engine
+#define MODBUS_GW_MAX_PENDING 32         // Outstanding transactions per bus (queued + in flight)
+#define MODBUS_GW_RESP_TIMEOUT_MS 1000   // Default RTU response timeout
+#define MODBUS_GW_MAX_WAITERS 32         // Requesters attached to identical reads per bus
+#define MODBUS_GW_QUEUE_LEN 256          // Slots of the request / response queues of a worker bus
+#define MODBUS_GW_MAX_SLAVES 256         // Slave addresses with latency histograms per bus
+
+#if MODBUS_SCHED_FLOWS <= MODBUS_GW_MAX_PENDING
+#error "Every outstanding transaction needs a scheduler flow to queue on"
+#endif
+
+// Request handed from the network loop to a bus worker
+typedef struct {
+    ModbusOrigin origin;
+    ModbusTCPFrame frame;
+} ModbusGwRequest;
+
+// Response handed from a bus worker to the network loop
+typedef struct {
+    ModbusOrigin origin;
+    int len;
+    uint8_t adu[MODBUS_TCP_MAX_ADU_LEN];
+} ModbusGwResponse;
+
+// Bus state machine
+typedef enum {
+    MODBUS_BUS_IDLE,             // Nothing on the wire
+    MODBUS_BUS_WAIT_RESP,        // Request written, waiting for response or timeout
+    MODBUS_BUS_TURNAROUND        // Silence before the next request (t3.5 / broadcast delay)
+} ModbusBusState;
+
+// Transaction counters of a bus (index into ModbusBus.ctr)
+typedef enum {
+    MODBUS_BUS_CTR_REQUESTS,
+    MODBUS_BUS_CTR_RESPONSES,
+    MODBUS_BUS_CTR_TIMEOUTS,
+    MODBUS_BUS_CTR_QUEUE_FULL,
+    MODBUS_BUS_CTR_UNMATCHED,
+    MODBUS_BUS_CTR_DROPPED,
+    MODBUS_BUS_CTR_COALESCED,
+    MODBUS_BUS_CTR_MERGED,
+    MODBUS_BUS_CTR_MERGE_TXNS,
+    MODBUS_BUS_CTR_MERGE_FALLBACKS,
+    MODBUS_BUS_CTR_NUM
+} ModbusBusCtr;
+
+// Transaction statistics of a bus (snapshot of ModbusBus.ctr)
+typedef struct {
+    uint64_t requests;
+    uint64_t responses;
+    uint32_t timeouts;
+    uint32_t queue_full;
+    uint32_t unmatched;          // Responses without a matching request
+    uint32_t dropped;            // Requests whose client disconnected before dispatch
+    uint64_t coalesced;          // Reads attached to an identical queued / in-flight read
+    uint64_t merged;             // Reads folded into an adjacent read
+    uint64_t merge_txns;         // Merged requests written to the bus
+    uint32_t merge_fallbacks;    // Merged requests answered with an exception (reads retried alone)
+    uint32_t max_depth;
+} ModbusBusStats;
+
+// Measured latency of a transaction
+typedef enum {
+    MODBUS_LAT_QUEUE,            // TCP receive -> request written to the UART (TCP clients)
+    MODBUS_LAT_RESPONSE,         // Request written -> first response byte (all requests)
+    MODBUS_LAT_RTT,              // TCP receive -> response handed to the network loop (TCP clients)
+    MODBUS_LAT_NUM
+} ModbusLatKind;
+
+// Latency histograms of a bus or of one slave on it
+typedef struct {
+    StatsHist hist[MODBUS_LAT_NUM];
+} ModbusLatency;
+
+// Per-UART outstanding-transaction table
+// Everything below runs on the bus event loop (main loop, or the worker thread of the UART)
+typedef struct {
+    int uart_idx;
+    int enabled;                 // Modbus port opened successfully
+    int threaded;                // Bus runs on a worker: requests / responses cross req_queue / resp_queue
+    Reactor* reactor;            // Event loop owning the bus
+    ModbusBusState state;
+    int hold;                    // Port is being reconfigured: queue requests, write nothing
+    ModbusTxn pool[MODBUS_GW_MAX_PENDING];
+    ModbusTxn* free_list;
+    ModbusWaiter waiter_pool[MODBUS_GW_MAX_WAITERS];
+    ModbusWaiter* free_waiters;
+    ModbusSched sched;           // Pending transactions (priority classes, per-requester queues)
+    int depth;
+    int max_depth;               // Outstanding transaction limit (queue_depth)
+    ModbusTxn* inflight;
+    ModbusRTUFrame merge_rtu;    // Wire request of a merged in-flight read
+    uint16_t merge_start;
+    uint16_t merge_quantity;
+    ReactorTimer timer;          // Response timeout / turnaround timer
+    StatsCounters ctr;           // ModbusBusCtr
+    uint32_t depth_peak;         // High watermark of depth
+    ModbusLatency lat;
+    ModbusLatency* slave_lat[MODBUS_GW_MAX_SLAVES];  // Allocated by the bus on first use
+    ModbusCache cache;           // FC03/FC04 responses (entries == NULL: disabled)
+    ReactorQueue req_queue;      // Network loop -> worker (ModbusGwRequest)
+    ReactorQueue resp_queue;     // Worker -> network loop (ModbusGwResponse)
+    struct ModbusGw* gw;
+} ModbusBus;
+
+// Gateway engine (owned by the reactor thread)
+typedef struct ModbusGw {
+    UartMgr* uart_mgr;
+    NetMgr* net_mgr;
+    Reactor* reactor;
+    ModbusBus buses[MAX_UART_NUM];
+    ModbusPoller* poller;        // Cyclic poller and register image (NULL: no poll_list)
+    StatsHist* client_rtt[NET_MAX_CLIENTS_LIMIT];  // Round trip per client slot (owner = connection ID), allocated on first use
+} ModbusGw;
+
+ModbusGw* modbus_gw_init(UartMgr* uart_mgr, NetMgr* net_mgr, Reactor* reactor);
+
+void modbus_gw_destroy(ModbusGw* gw);
+
+int modbus_gw_submit(ModbusGw* gw, int uart_idx, const ModbusOrigin* origin, const ModbusTCPFrame* tcp_frame);
+
+void modbus_gw_on_rtu_frame(ModbusGw* gw, int uart_idx, const uint8_t* frame, int len);
+
+void modbus_gw_send_exception(ModbusGw* gw, const ModbusOrigin* origin, uint8_t func_code, uint8_t ex_code);
+
+void modbus_gw_get_bus_stats(ModbusGw* gw, int uart_idx, ModbusBusStats* stats, int* depth);
+
+int modbus_gw_get_cache_stats(ModbusGw* gw, int uart_idx, ModbusCacheStats* stats, uint32_t* ttl_ms);
+
+int modbus_gw_get_sched_stats(ModbusGw* gw, int uart_idx, ModbusSchedStats* stats, int* max_depth);
+
+int modbus_gw_get_latency(ModbusGw* gw, int uart_idx, int slave_addr, ModbusLatency* lat);
+
+int modbus_gw_get_client_rtt(ModbusGw* gw, int client_idx, StatsHist* hist);
+
+void modbus_gw_reset_latency(ModbusGw* gw);
+
+void modbus_gw_write_metrics(ModbusGw* gw, StatsBuf* buf);
+
+int modbus_gw_get_queue_stats(ModbusGw* gw, int uart_idx, uint32_t* req_full, uint32_t* resp_full);
+
+#endif // !MODBUS_GW_H
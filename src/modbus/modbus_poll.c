@@ -0,0 +1,307 @@
+#define LOG_MODULE LOG_MOD_MODBUS
+#include "modbus_poll.h"
+#include "modbus_gw.h"
+#include "../log/log.h"
+
+/**
+ * Queue poll request of a block on its bus
+ * @param poller: Pointer to ModbusPoller
+ * @param idx: Block index
+ * @param now_ns: Monotonic time (ns)
+ */
+static void poll_block_submit(ModbusPoller* poller, int idx, uint64_t now_ns)
+{
+    ModbusPollBlock* b = &poller->blocks[idx];
+
+    ModbusTCPFrame req;
+    memset(&req, 0, sizeof(req));
+    req.transaction_id = (uint16_t)idx;
+    req.slave_addr = (uint8_t)b->config.slave_addr;
+    req.func_code = (uint8_t)b->config.func_code;
+    req.data[0] = (b->config.start >> 8) & 0xFF;
+    req.data[1] = b->config.start & 0xFF;
+    req.data[2] = (b->config.quantity >> 8) & 0xFF;
+    req.data[3] = b->config.quantity & 0xFF;
+    req.data_len = 4;
+
+    ModbusOrigin origin;
+    origin.client_idx = MODBUS_ORIGIN_POLL;
+    origin.conn_id = 0;
+    origin.trans_id = (uint16_t)idx;
+    origin.unit_id = req.slave_addr;
+    origin.uart_idx = (uint8_t)b->config.uart_idx;
+    origin.rx_ns = now_ns;
+
+    // Failures come back synchronously through modbus_poll_on_response
+    b->pending = 1;
+    b->sent_ns = now_ns;
+    modbus_gw_submit(poller->gw, b->config.uart_idx, &origin, &req);
+}
+
+/**
+ * Give up a poll whose response never arrived (e.g. dropped on a full worker response queue),
+ * so the block is polled again instead of counting overruns forever
+ * @param poller: Pointer to ModbusPoller
+ * @param idx: Block index
+ * @param now_ns: Monotonic time (ns)
+ */
+static void poll_block_expire(ModbusPoller* poller, int idx, uint64_t now_ns)
+{
+    ModbusPollBlock* b = &poller->blocks[idx];
+
+    UartConfig config;
+    uart_mgr_get_config(poller->gw->uart_mgr, b->config.uart_idx, &config);
+    int timeout_ms = config.resp_timeout_ms > 0 ? config.resp_timeout_ms : MODBUS_GW_RESP_TIMEOUT_MS;
+    uint64_t expire_ns = (uint64_t)(timeout_ms + b->config.cycle_ms) * 1000000ULL;
+    if (now_ns - b->sent_ns <= expire_ns) return;
+
+    b->pending = 0;
+    b->errors++;
+    b->last_ex = 0;
+    LOG_WARN("Poll block %d (uart %d slave %d, %d+%d) got no response in %d ms, polling again", idx,
+             b->config.uart_idx, b->config.slave_addr, b->config.start, b->config.quantity,
+             (int)((now_ns - b->sent_ns) / 1000000));
+}
+
+/**
+ * Poll timer callback: queue due blocks in priority order, re-arm for the next due block
+ * @param arg: Pointer to ModbusPoller
+ */
+static void poll_timer_handler(void* arg)
+{
+    ModbusPoller* poller = (ModbusPoller*)arg;
+    uint64_t now = reactor_now_ns();
+    uint64_t next = UINT64_MAX;
+
+    for (int i = 0; i < poller->count; i++) {
+        ModbusPollBlock* b = &poller->blocks[i];
+        uint64_t cycle_ns = (uint64_t)b->config.cycle_ms * 1000000ULL;
+
+        if (now >= b->next_due_ns) {
+            if (b->pending) {
+                poll_block_expire(poller, i, now);
+            }
+            if (b->pending) {
+                b->overruns++;
+                LOG_DEBUG("Poll block %d (uart %d, %d+%d) overrun", i, b->config.uart_idx,
+                          b->config.start, b->config.quantity);
+            } else {
+                poll_block_submit(poller, i, now);
+            }
+            b->next_due_ns += cycle_ns;
+            if (b->next_due_ns <= now) {
+                // Timer ran late by whole cycles: count them and keep the original phase
+                uint64_t missed = (now - b->next_due_ns) / cycle_ns + 1;
+                b->overruns += (uint32_t)missed;
+                b->next_due_ns += missed * cycle_ns;
+            }
+        }
+        if (b->next_due_ns < next) {
+            next = b->next_due_ns;
+        }
+    }
+
+    if (next != UINT64_MAX) {
+        reactor_timer_start(&poller->timer, (next - now) / 1000, 0);
+    }
+}
+
+/**
+ * Initialize gateway poller with the poll_list blocks of enabled Modbus buses
+ * @param gw: Pointer to ModbusGw instance (requests are queued through it)
+ * @param uart_mgr: Pointer to UartMgr instance (parsed poll_list)
+ * @param reactor: Event loop for the cycle timer
+ * @return Pointer to ModbusPoller on success, NULL on failure or if nothing is polled
+ */
+ModbusPoller* modbus_poll_init(struct ModbusGw* gw, UartMgr* uart_mgr, Reactor* reactor)
+{
+    ModbusPoller* poller = (ModbusPoller*)malloc(sizeof(ModbusPoller));
+    if (!poller) {
+        LOG_ERROR("Malloc ModbusPoller failed");
+        return NULL;
+    }
+    memset(poller, 0, sizeof(ModbusPoller));
+    poller->gw = gw;
+    poller->timer.handler.fd = -1;
+
+    for (int i = 0; i < uart_mgr->poll_count; i++) {
+        const UartPollConfig* cfg = &uart_mgr->polls[i];
+        if (!gw->buses[cfg->uart_idx].enabled) {
+            LOG_WARN("Poll block on uart %d skipped: no Modbus bus", cfg->uart_idx);
+            continue;
+        }
+
+        // Insertion sort keeps config order within a priority
+        int pos = poller->count;
+        while (pos > 0 && poller->blocks[pos - 1].config.priority > cfg->priority) {
+            poller->blocks[pos] = poller->blocks[pos - 1];
+            pos--;
+        }
+        memset(&poller->blocks[pos], 0, sizeof(ModbusPollBlock));
+        poller->blocks[pos].config = *cfg;
+        poller->count++;
+    }
+
+    if (poller->count == 0) {
+        free(poller);
+        return NULL;
+    }
+
+    if (reactor_timer_init(reactor, &poller->timer, poll_timer_handler, poller) != 0) {
+        LOG_ERROR("Create poll timer failed");
+        free(poller);
+        return NULL;
+    }
+
+    uint64_t now = reactor_now_ns();
+    for (int i = 0; i < poller->count; i++) {
+        poller->blocks[i].next_due_ns = now;
+    }
+    reactor_timer_start(&poller->timer, 0, 0);
+    LOG_INFO("Gateway poller started: %d blocks", poller->count);
+    return poller;
+}
+
+/**
+ * Destroy gateway poller
+ * @param poller: Pointer to ModbusPoller
+ */
+void modbus_poll_destroy(ModbusPoller* poller)
+{
+    if (!poller) return;
+    reactor_timer_destroy(&poller->timer);
+    free(poller);
+}
+
+/**
+ * Answer a FC03/FC04 read from the register image
+ * @param poller: Pointer to ModbusPoller
+ * @param uart_idx: UART index
+ * @param slave_addr: Slave address
+ * @param func_code: Function code
+ * @param start: Start register
+ * @param quantity: Number of registers
+ * @param now_ns: Monotonic time (ns)
+ * @param pdu: Output response PDU (at least 2 + 2 * MODBUS_MAX_READ_REGS bytes)
+ * @return PDU length, -1 if no block with fresh data covers the range
+ */
+int modbus_poll_read(ModbusPoller* poller, int uart_idx, uint8_t slave_addr, uint8_t func_code,
+                     uint16_t start, uint16_t quantity, uint64_t now_ns, uint8_t* pdu)
+{
+    if (!poller || !pdu || quantity == 0 || quantity > MODBUS_MAX_READ_REGS) return -1;
+
+    for (int i = 0; i < poller->count; i++) {
+        ModbusPollBlock* b = &poller->blocks[i];
+        const UartPollConfig* cfg = &b->config;
+        if (cfg->uart_idx != uart_idx || cfg->slave_addr != slave_addr || cfg->func_code != func_code ||
+            start < cfg->start || start + quantity > cfg->start + cfg->quantity || b->updated_ns == 0 ||
+            now_ns - b->updated_ns > (uint64_t)cfg->cycle_ms * MODBUS_POLL_MAX_AGE_CYCLES * 1000000ULL) {
+            continue;
+        }
+
+        const uint16_t* regs = &b->regs[start - cfg->start];
+        pdu[0] = func_code;
+        pdu[1] = quantity * 2;
+        for (int r = 0; r < quantity; r++) {
+            pdu[2 + r * 2] = regs[r] >> 8;
+            pdu[3 + r * 2] = regs[r] & 0xFF;
+        }
+        b->image_hits++;
+        return 2 + quantity * 2;
+    }
+    return -1;
+}
+
+/**
+ * Handle response to a poll request (update register image)
+ * @param poller: Pointer to ModbusPoller
+ * @param block_idx: Block index (MBAP transaction ID of the poll request)
+ * @param pdu: Response PDU
+ * @param pdu_len: PDU length
+ */
+void modbus_poll_on_response(ModbusPoller* poller, int block_idx, const uint8_t* pdu, int pdu_len)
+{
+    if (!poller || !pdu || block_idx < 0 || block_idx >= poller->count || pdu_len < 2) return;
+
+    ModbusPollBlock* b = &poller->blocks[block_idx];
+    uint64_t now = reactor_now_ns();
+    int quantity = b->config.quantity;
+
+    b->pending = 0;
+    b->polls++;
+    b->last_rtt_us = (uint32_t)((now - b->sent_ns) / 1000);
+
+    if ((pdu[0] & 0x80) || pdu[1] != quantity * 2 || pdu_len != 2 + quantity * 2) {
+        b->errors++;
+        b->last_ex = (pdu[0] & 0x80) ? pdu[1] : 0;
+        LOG_WARN("Poll block %d (uart %d slave %d, %d+%d) failed (ex 0x%02X)", block_idx,
+                 b->config.uart_idx, b->config.slave_addr, b->config.start, quantity, b->last_ex);
+        return;
+    }
+    // A client wrote to the block meanwhile: the poll may have been read before the write
+    if (b->sent_ns <= b->invalidated_ns) {
+        return;
+    }
+
+    // Seqlock write: readers on other threads retry while the version is odd or changed
+    __atomic_store_n(&b->version, b->version + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    for (int r = 0; r < quantity; r++) {
+        b->regs[r] = (pdu[2 + r * 2] << 8) | pdu[3 + r * 2];
+    }
+    b->updated_ns = now;
+    __atomic_store_n(&b->version, b->version + 1, __ATOMIC_RELEASE);
+}
+
+/**
+ * Drop the image of holding-register blocks a client writes to (network loop),
+ * reads go to the bus until the next poll sent after the write
+ * @param poller: Pointer to ModbusPoller
+ * @param uart_idx: UART index
+ * @param slave_addr: Slave address (MODBUS_BROADCAST_ADDR = every slave)
+ * @param start: First written register
+ * @param quantity: Number of written registers
+ */
+void modbus_poll_invalidate(ModbusPoller* poller, int uart_idx, uint8_t slave_addr, uint16_t start,
+                            uint16_t quantity)
+{
+    if (!poller || quantity == 0) return;
+
+    uint64_t now = reactor_now_ns();
+    uint32_t end = (uint32_t)start + quantity;
+    for (int i = 0; i < poller->count; i++) {
+        ModbusPollBlock* b = &poller->blocks[i];
+        const UartPollConfig* cfg = &b->config;
+        if (cfg->uart_idx != uart_idx || cfg->func_code != MODBUS_FC_READ_HOLDING_REGISTERS) continue;
+        if (slave_addr != MODBUS_BROADCAST_ADDR && cfg->slave_addr != slave_addr) continue;
+        if (cfg->start >= end || start >= (uint32_t)cfg->start + cfg->quantity) continue;
+
+        __atomic_store_n(&b->version, b->version + 1, __ATOMIC_RELAXED);
+        __atomic_thread_fence(__ATOMIC_RELEASE);
+        b->updated_ns = 0;
+        __atomic_store_n(&b->version, b->version + 1, __ATOMIC_RELEASE);
+        b->invalidated_ns = now;
+    }
+}
+
+/**
+ * Get consistent copy of a block (safe from other threads)
+ * @param poller: Pointer to ModbusPoller
+ * @param block_idx: Block index
+ * @param block: Output ModbusPollBlock
+ * @return 0 on success, -1 if the index is invalid
+ */
+int modbus_poll_get_block(ModbusPoller* poller, int block_idx, ModbusPollBlock* block)
+{
+    if (!poller || !block || block_idx < 0 || block_idx >= poller->count) return -1;
+
+    ModbusPollBlock* b = &poller->blocks[block_idx];
+    uint32_t v1, v2;
+    do {
+        v1 = __atomic_load_n(&b->version, __ATOMIC_ACQUIRE);
+        memcpy(block, b, sizeof(ModbusPollBlock));
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        v2 = __atomic_load_n(&b->version, __ATOMIC_RELAXED);
+    } while ((v1 & 1) || v1 != v2);
+    return 0;
+}
@@ -0,0 +1,54 @@
+#ifndef MODBUS_POLL_H
+#define MODBUS_POLL_H
+
+#include <stdint.h>
+#include "modbus_core.h"
+#include "../uart/uart_mgr.h"
+#include "../reactor/reactor.h"
+
+// Global constants for the gateway poller
+#define MODBUS_POLL_MAX_AGE_CYCLES 2     // Image answers reads while the data is younger than this many cycles
+
+struct ModbusGw;
+
+// Runtime state and register image of a polled block
+typedef struct {
+    UartPollConfig config;
+    uint32_t version;            // Incremented around every image update (odd = update in progress)
+    uint64_t updated_ns;         // Time of last successful poll (0 = no data yet / written by a client)
+    uint64_t invalidated_ns;     // Last client write to the block (polls sent before it are discarded)
+    uint64_t next_due_ns;        // Start of the next cycle (fixed period, not drifting with response time)
+    uint64_t sent_ns;
+    int pending;                 // Request queued or in flight
+    uint64_t polls;
+    uint64_t image_hits;         // TCP reads answered from the image
+    uint32_t errors;             // Exception / timeout responses
+    uint32_t overruns;           // Cycles skipped because the previous poll had not finished
+    uint32_t last_rtt_us;        // Queue + bus time of the last poll
+    uint8_t last_ex;             // Exception code of the last failed poll
+    uint16_t regs[MODBUS_MAX_READ_REGS];
+} ModbusPollBlock;
+
+// Gateway poller (owned by the reactor thread, blocks sorted by priority)
+typedef struct ModbusPoller {
+    struct ModbusGw* gw;
+    ModbusPollBlock blocks[MAX_POLL_BLOCKS];
+    int count;
+    ReactorTimer timer;
+} ModbusPoller;
+
+ModbusPoller* modbus_poll_init(struct ModbusGw* gw, UartMgr* uart_mgr, Reactor* reactor);
+
+void modbus_poll_destroy(ModbusPoller* poller);
+
+int modbus_poll_read(ModbusPoller* poller, int uart_idx, uint8_t slave_addr, uint8_t func_code,
+                     uint16_t start, uint16_t quantity, uint64_t now_ns, uint8_t* pdu);
+
+void modbus_poll_on_response(ModbusPoller* poller, int block_idx, const uint8_t* pdu, int pdu_len);
+
+void modbus_poll_invalidate(ModbusPoller* poller, int uart_idx, uint8_t slave_addr, uint16_t start,
+                            uint16_t quantity);
+
+int modbus_poll_get_block(ModbusPoller* poller, int block_idx, ModbusPollBlock* block);
+
+#endif // !MODBUS_POLL_H
@@ -0,0 +1,189 @@
+#define LOG_MODULE LOG_MOD_MODBUS
+#include "modbus_rtu.h"
+#include "../log/log.h"
+
+/**
+ * Initialize RTU deframer and derive t1.5/t3.5 from baudrate
+ * @param d: Pointer to ModbusRtuDeframer
+ * @param baudrate: UART baudrate
+ */
+void modbus_rtu_deframer_init(ModbusRtuDeframer* d, int baudrate)
+{
+    if (d == NULL) return;
+    memset(d, 0, sizeof(ModbusRtuDeframer));
+    modbus_rtu_deframer_set_baud(d, baudrate);
+}
+
+/**
+ * Change the line rate of a deframer (drops the partial frame, keeps the counters)
+ * @param d: Pointer to ModbusRtuDeframer
+ * @param baudrate: New UART baudrate (determines t1.5 / t3.5)
+ */
+void modbus_rtu_deframer_set_baud(ModbusRtuDeframer* d, int baudrate)
+{
+    if (d == NULL) return;
+    d->len = 0;
+    d->expect_len = 0;
+    d->overrun = 0;
+    d->last_rx_ns = 0;
+    d->first_rx_ns = 0;
+
+    uint32_t t15_us = MODBUS_RTU_FIXED_T15_US;
+    uint32_t t35_us = MODBUS_RTU_FIXED_T35_US;
+    if (baudrate > 0 && baudrate <= MODBUS_RTU_FIXED_BAUD) {
+        uint32_t char_us = (MODBUS_RTU_CHAR_BITS * 1000000U + baudrate - 1) / baudrate;
+        t15_us = char_us * 3 / 2;
+        t35_us = char_us * 7 / 2;
+    }
+    // Shown by the CLI thread (uart_mgr_get_status)
+    __atomic_store_n(&d->t15_us, t15_us, __ATOMIC_RELAXED);
+    __atomic_store_n(&d->t35_us, t35_us, __ATOMIC_RELAXED);
+}
+
+/**
+ * Get expected length of a Modbus RTU response from its header
+ * @param buf: Received bytes of the response (starting at slave address)
+ * @param len: Number of received bytes
+ * @return Expected frame length incl. CRC, 0 if not yet known or variable
+ */
+int modbus_rtu_response_len(const uint8_t* buf, int len)
+{
+    if (buf == NULL || len < 2) return 0;
+
+    uint8_t fc = buf[1];
+    if (fc & 0x80) {
+        return 5;
+    }
+
+    switch (fc) {
+        case 0x01: case 0x02: case 0x03: case 0x04:
+        case 0x0C: case 0x11: case 0x14: case 0x15: case 0x17:
+            return len >= 3 ? 5 + buf[2] : 0;
+        case 0x05: case 0x06: case 0x08: case 0x0B:
+        case 0x0F: case 0x10:
+            return 8;
+        case 0x07:
+            return 5;
+        case 0x16:
+            return 10;
+        case 0x18:
+            return len >= 4 ? 6 + ((buf[2] << 8) | buf[3]) : 0;
+        default:
+            return 0;
+    }
+}
+
+/**
+ * Check CRC of the buffered frame (the running CRC over data + CRC bytes is 0 when valid)
+ * @param d: Pointer to ModbusRtuDeframer
+ * @return 1 if CRC matches, 0 otherwise
+ */
+static int modbus_rtu_crc_ok(const ModbusRtuDeframer* d)
+{
+    return d->len >= MODBUS_RTU_MIN_FRAME_LEN && d->crc == 0;
+}
+
+/**
+ * Close current frame: validate, emit and reset buffer
+ * @param d: Pointer to ModbusRtuDeframer
+ * @param cb: Frame callback
+ * @param arg: Callback argument
+ */
+static void modbus_rtu_deframer_end(ModbusRtuDeframer* d, ModbusRtuFrameCb cb, void* arg)
+{
+    if (d->overrun) {
+        stats_ctr_add(&d->ctr, MODBUS_RTU_CTR_OVERRUN_ERR, 1);
+        LOG_WARN("Modbus RTU frame overrun, dropped");
+    } else if (d->len < MODBUS_RTU_MIN_FRAME_LEN || (d->expect_len && d->len != d->expect_len)) {
+        stats_ctr_add(&d->ctr, MODBUS_RTU_CTR_FRAME_ERR, 1);
+        LOG_WARN("Modbus RTU framing error (len: %d, expect: %d)", d->len, d->expect_len);
+    } else if (!modbus_rtu_crc_ok(d)) {
+        stats_ctr_add(&d->ctr, MODBUS_RTU_CTR_CRC_ERR, 1);
+        LOG_WARN("Modbus RTU CRC check failed (len: %d)", d->len);
+    } else {
+        stats_ctr_add(&d->ctr, MODBUS_RTU_CTR_FRAMES, 1);
+        if (cb) cb(d->buf, d->len, arg);
+    }
+
+    d->len = 0;
+    d->expect_len = 0;
+    d->overrun = 0;
+}
+
+/**
+ * Feed bytes read from the UART into the deframer
+ * A frame ends when its function-code length is reached, when a gap above
+ * t1.5 follows a CRC-valid frame, or on t3.5 silence (see flush)
+ * @param d: Pointer to ModbusRtuDeframer
+ * @param data: Bytes read from UART
+ * @param len: Number of bytes
+ * @param now_ns: Monotonic arrival time (ns)
+ * @param cb: Frame callback
+ * @param arg: Callback argument
+ */
+void modbus_rtu_deframer_feed(ModbusRtuDeframer* d, const uint8_t* data, int len, uint64_t now_ns,
+                              ModbusRtuFrameCb cb, void* arg)
+{
+    if (d == NULL || data == NULL || len <= 0) return;
+
+    if (d->len > 0 || d->overrun) {
+        uint64_t gap_us = (now_ns - d->last_rx_ns) / 1000;
+        if (gap_us >= d->t35_us) {
+            modbus_rtu_deframer_end(d, cb, arg);
+        } else if (gap_us >= d->t15_us && !d->overrun && modbus_rtu_crc_ok(d)) {
+            modbus_rtu_deframer_end(d, cb, arg);
+        }
+    }
+
+    int i = 0;
+    while (i < len) {
+        if (d->len == 0 && !d->overrun) {
+            d->first_rx_ns = now_ns;
+            d->crc = MODBUS_CRC16_INIT;
+        }
+        if (d->overrun) break;
+        if (d->len >= MODBUS_MAX_FRAME_LEN) {
+            d->overrun = 1;
+            break;
+        }
+
+        // Header bytes one at a time until the length is known, then the rest of the frame at once
+        int take = 1;
+        if (d->expect_len) {
+            take = d->expect_len - d->len;
+        } else if (d->len >= MODBUS_RTU_MIN_FRAME_LEN) {
+            take = MODBUS_MAX_FRAME_LEN - d->len;
+        }
+        if (take > len - i) take = len - i;
+
+        memcpy(d->buf + d->len, data + i, take);
+        d->crc = modbus_crc16_update(d->crc, data + i, take);
+        d->len += take;
+        i += take;
+
+        if (d->expect_len == 0) {
+            int expect = modbus_rtu_response_len(d->buf, d->len);
+            if (expect > MODBUS_MAX_FRAME_LEN) {
+                d->overrun = 1;
+                break;
+            }
+            d->expect_len = (uint16_t)expect;
+        }
+        if (d->expect_len && d->len == d->expect_len) {
+            modbus_rtu_deframer_end(d, cb, arg);
+        }
+    }
+    d->last_rx_ns = now_ns;
+}
+
+/**
+ * End pending frame after t3.5 silence (called from the t3.5 timer)
+ * @param d: Pointer to ModbusRtuDeframer
+ * @param cb: Frame callback
+ * @param arg: Callback argument
+ */
+void modbus_rtu_deframer_flush(ModbusRtuDeframer* d, ModbusRtuFrameCb cb, void* arg)
+{
+    if (d == NULL || (d->len == 0 && !d->overrun)) return;
+    modbus_rtu_deframer_end(d, cb, arg);
+}
@@ -0,0 +1,52 @@
+#ifndef MODBUS_RTU_H
+#define MODBUS_RTU_H
+
+#include <stdint.h>
+#include "modbus_core.h"
+#include "../stats/stats.h"
+
+// Modbus RTU timing (spec: fixed values above 19200 baud)
+#define MODBUS_RTU_CHAR_BITS 11          // start + 8 data + parity/stop + stop
+#define MODBUS_RTU_FIXED_BAUD 19200
+#define MODBUS_RTU_FIXED_T15_US 750
+#define MODBUS_RTU_FIXED_T35_US 1750
+#define MODBUS_RTU_MIN_FRAME_LEN 4       // addr + fc + crc
+
+// Deframer counters (index into ModbusRtuDeframer.ctr)
+typedef enum {
+    MODBUS_RTU_CTR_FRAMES,       // Valid frames emitted
+    MODBUS_RTU_CTR_FRAME_ERR,    // Short frames / trailing bytes
+    MODBUS_RTU_CTR_CRC_ERR,      // CRC mismatch
+    MODBUS_RTU_CTR_OVERRUN_ERR,  // Frames longer than MODBUS_MAX_FRAME_LEN
+    MODBUS_RTU_CTR_NUM
+} ModbusRtuCtr;
+
+// Called for each complete frame that passed the length and CRC checks (includes CRC bytes)
+typedef void (*ModbusRtuFrameCb)(const uint8_t* frame, int len, void* arg);
+
+// Per-UART RTU response deframer (byte stream -> validated frames)
+typedef struct {
+    uint8_t buf[MODBUS_MAX_FRAME_LEN];
+    uint16_t len;
+    uint16_t expect_len;         // Length derived from function code, 0 = unknown
+    uint16_t crc;                // Running CRC register over buf (0 once a valid CRC is appended)
+    int overrun;                 // Frame exceeded buffer, drop until silence
+    uint64_t last_rx_ns;
+    uint64_t first_rx_ns;        // Arrival time of the first byte of the current frame
+    uint32_t t15_us;
+    uint32_t t35_us;
+    StatsCounters ctr;           // ModbusRtuCtr
+} ModbusRtuDeframer;
+
+void modbus_rtu_deframer_init(ModbusRtuDeframer* d, int baudrate);
+
+void modbus_rtu_deframer_set_baud(ModbusRtuDeframer* d, int baudrate);
+
+void modbus_rtu_deframer_feed(ModbusRtuDeframer* d, const uint8_t* data, int len, uint64_t now_ns,
+                              ModbusRtuFrameCb cb, void* arg);
+
+void modbus_rtu_deframer_flush(ModbusRtuDeframer* d, ModbusRtuFrameCb cb, void* arg);
+
+int modbus_rtu_response_len(const uint8_t* buf, int len);
+
+#endif // !MODBUS_RTU_H
@@ -0,0 +1,314 @@
+#include "modbus_sched.h"
+
+/**
+ * Estimate bus time of a request as request + expected response bytes
+ * @param rtu: Request
+ * @return Estimated wire bytes (CRC included)
+ */
+static int sched_txn_cost(const ModbusRTUFrame* rtu)
+{
+    int req = 4 + rtu->data_len;
+    int quantity = rtu->data_len >= 4 ? (rtu->data[2] << 8) | rtu->data[3] : 0;
+
+    switch (rtu->func_code) {
+        case MODBUS_FC_READ_COILS:
+        case MODBUS_FC_READ_DISCRETE_INPUTS:
+            return req + 5 + (quantity + 7) / 8;
+        case MODBUS_FC_READ_HOLDING_REGISTERS:
+        case MODBUS_FC_READ_INPUT_REGISTERS:
+            return req + 5 + quantity * 2;
+        default:
+            return req + 8;
+    }
+}
+
+/**
+ * Append flow to the ring of a class
+ * @param sched: Pointer to ModbusSched
+ * @param flow: Backlogged flow
+ * @param cls: Class of the flow head
+ */
+static void sched_ring_append(ModbusSched* sched, ModbusFlow* flow, int cls)
+{
+    flow->cls = cls;
+    flow->next = NULL;
+    if (sched->ring_tail[cls]) {
+        sched->ring_tail[cls]->next = flow;
+    } else {
+        sched->ring_head[cls] = flow;
+    }
+    sched->ring_tail[cls] = flow;
+}
+
+/**
+ * Unlink flow from its class ring
+ * @param sched: Pointer to ModbusSched
+ * @param flow: Flow on a ring
+ */
+static void sched_ring_remove(ModbusSched* sched, ModbusFlow* flow)
+{
+    int cls = flow->cls;
+    ModbusFlow* prev = NULL;
+    for (ModbusFlow* f = sched->ring_head[cls]; f; prev = f, f = f->next) {
+        if (f != flow) continue;
+        if (prev) prev->next = f->next; else sched->ring_head[cls] = f->next;
+        if (sched->ring_tail[cls] == f) sched->ring_tail[cls] = prev;
+        break;
+    }
+    flow->cls = -1;
+    flow->next = NULL;
+}
+
+/**
+ * Put flow on the ring matching the class of its head (after the head changed)
+ * A flow that changes class starts a new round with an empty deficit
+ * @param sched: Pointer to ModbusSched
+ * @param flow: Flow
+ */
+static void sched_flow_update(ModbusSched* sched, ModbusFlow* flow)
+{
+    int cls = flow->head ? (int)flow->head->cls : -1;
+    if (cls == flow->cls) return;
+
+    if (flow->cls >= 0) {
+        sched_ring_remove(sched, flow);
+    }
+    flow->deficit = 0;
+    if (cls >= 0) {
+        sched_ring_append(sched, flow, cls);
+    }
+}
+
+/**
+ * Initialize bus scheduler (all flows idle)
+ * @param sched: Pointer to ModbusSched
+ */
+void modbus_sched_init(ModbusSched* sched)
+{
+    if (!sched) return;
+    memset(sched, 0, sizeof(ModbusSched));
+    for (int i = 0; i < MODBUS_SCHED_FLOWS; i++) {
+        sched->flows[i].cls = -1;
+    }
+}
+
+/**
+ * Check whether a flow belongs to a requester
+ * @param flow: Flow with queued transactions
+ * @param origin: Requester
+ * @return 1 if it does, 0 otherwise
+ */
+static int sched_flow_match(const ModbusFlow* flow, const ModbusOrigin* origin)
+{
+    if (flow->client_idx != origin->client_idx) return 0;
+    if (origin->client_idx == MODBUS_ORIGIN_UDP) {
+        return flow->peer.sin_addr.s_addr == origin->peer.sin_addr.s_addr &&
+               flow->peer.sin_port == origin->peer.sin_port;
+    }
+    // A reconnect reusing the slot is a new requester
+    return origin->client_idx < 0 || flow->conn_id == origin->conn_id;
+}
+
+/**
+ * Find the queue of a requester
+ * @param sched: Pointer to ModbusSched
+ * @param origin: Requester
+ * @return Pointer to ModbusFlow, NULL if the requester has nothing queued
+ */
+static ModbusFlow* sched_flow_find(ModbusSched* sched, const ModbusOrigin* origin)
+{
+    for (int i = 0; i < MODBUS_SCHED_FLOWS; i++) {
+        ModbusFlow* flow = &sched->flows[i];
+        if (flow->count > 0 && sched_flow_match(flow, origin)) return flow;
+    }
+    return NULL;
+}
+
+/**
+ * Get the queue of a requester, taking an idle flow of the pool if it has none
+ * (every busy flow holds a transaction, so with more flows than transactions one is always idle)
+ * @param sched: Pointer to ModbusSched
+ * @param origin: Requester
+ * @return Pointer to ModbusFlow
+ */
+static ModbusFlow* sched_flow_get(ModbusSched* sched, const ModbusOrigin* origin)
+{
+    ModbusFlow* idle = NULL;
+    for (int i = 0; i < MODBUS_SCHED_FLOWS; i++) {
+        ModbusFlow* flow = &sched->flows[i];
+        if (flow->count == 0) {
+            if (!idle) idle = flow;
+        } else if (sched_flow_match(flow, origin)) {
+            return flow;
+        }
+    }
+    idle->client_idx = origin->client_idx;
+    idle->conn_id = origin->conn_id;
+    idle->peer = origin->peer;
+    return idle;
+}
+
+/**
+ * Get number of queued transactions of a requester
+ * @param sched: Pointer to ModbusSched
+ * @param origin: Requester
+ * @return Transactions waiting in its flow
+ */
+int modbus_sched_flow_count(const ModbusSched* sched, const ModbusOrigin* origin)
+{
+    const ModbusFlow* flow = sched_flow_find((ModbusSched*)sched, origin);
+    return flow ? flow->count : 0;
+}
+
+/**
+ * Append transaction to the queue of its requester
+ * @param sched: Pointer to ModbusSched
+ * @param txn: Transaction (cls set by the caller)
+ */
+void modbus_sched_push(ModbusSched* sched, ModbusTxn* txn)
+{
+    ModbusFlow* flow = sched_flow_get(sched, &txn->origin);
+
+    txn->cost = sched_txn_cost(&txn->rtu);
+    txn->next = NULL;
+    if (flow->tail) {
+        flow->tail->next = txn;
+    } else {
+        flow->head = txn;
+    }
+    flow->tail = txn;
+    flow->count++;
+
+    stats_ctr_add(&sched->ctr, MODBUS_SCHED_CTR(txn->cls, MODBUS_SCHED_CTR_ENQUEUED), 1);
+    sched->queued[txn->cls]++;
+    sched_flow_update(sched, flow);
+}
+
+/**
+ * Put transaction back at the head of the queue of its requester (retry)
+ * @param sched: Pointer to ModbusSched
+ * @param txn: Transaction taken with modbus_sched_pop / modbus_sched_remove
+ */
+void modbus_sched_push_front(ModbusSched* sched, ModbusTxn* txn)
+{
+    ModbusFlow* flow = sched_flow_get(sched, &txn->origin);
+
+    txn->next = flow->head;
+    flow->head = txn;
+    if (!flow->tail) flow->tail = txn;
+    flow->count++;
+
+    sched->queued[txn->cls]++;
+    sched_flow_update(sched, flow);
+}
+
+/**
+ * Take first transaction of a flow
+ * @param sched: Pointer to ModbusSched
+ * @param flow: Backlogged flow
+ * @return Pointer to ModbusTxn
+ */
+static ModbusTxn* sched_flow_pop(ModbusSched* sched, ModbusFlow* flow)
+{
+    ModbusTxn* txn = flow->head;
+    flow->head = txn->next;
+    if (!flow->head) flow->tail = NULL;
+    flow->count--;
+    txn->next = NULL;
+
+    sched->queued[txn->cls]--;
+    sched_flow_update(sched, flow);
+    return txn;
+}
+
+/**
+ * Pick next transaction to write: highest backlogged class, deficit round-robin between its flows
+ * @param sched: Pointer to ModbusSched
+ * @return Pointer to ModbusTxn, NULL if nothing is queued
+ */
+ModbusTxn* modbus_sched_pop(ModbusSched* sched)
+{
+    for (int cls = 0; cls < MODBUS_CLASS_NUM; cls++) {
+        // Every pass adds a quantum, so some flow affords its head within a few rounds
+        while (sched->ring_head[cls]) {
+            ModbusFlow* flow = sched->ring_head[cls];
+            if (flow->deficit >= flow->head->cost) {
+                flow->deficit -= flow->head->cost;
+                return sched_flow_pop(sched, flow);
+            }
+
+            flow->deficit += MODBUS_SCHED_QUANTUM;
+            if (flow->next) {
+                sched->ring_head[cls] = flow->next;
+                flow->next = NULL;
+                sched->ring_tail[cls]->next = flow;
+                sched->ring_tail[cls] = flow;
+            }
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Unlink a queued transaction (taken by a merged read)
+ * @param sched: Pointer to ModbusSched
+ * @param txn: Queued transaction
+ */
+void modbus_sched_remove(ModbusSched* sched, ModbusTxn* txn)
+{
+    ModbusFlow* flow = sched_flow_find(sched, &txn->origin);
+    if (!flow) return;
+
+    if (flow->head == txn) {
+        sched_flow_pop(sched, flow);
+        return;
+    }
+    for (ModbusTxn* prev = flow->head; prev; prev = prev->next) {
+        if (prev->next != txn) continue;
+        prev->next = txn->next;
+        if (flow->tail == txn) flow->tail = prev;
+        flow->count--;
+        txn->next = NULL;
+        sched->queued[txn->cls]--;
+        return;
+    }
+}
+
+/**
+ * Record queueing delay of a transaction written to the bus
+ * @param sched: Pointer to ModbusSched
+ * @param txn: Transaction
+ * @param write_ns: Time the request was written (ns)
+ */
+void modbus_sched_account(ModbusSched* sched, const ModbusTxn* txn, uint64_t write_ns)
+{
+    uint64_t wait_ns = write_ns > txn->enqueue_ns ? write_ns - txn->enqueue_ns : 0;
+
+    StatsCtrSlot* ctr = stats_ctr_begin(&sched->ctr);
+    stats_ctr_put(ctr, MODBUS_SCHED_CTR(txn->cls, MODBUS_SCHED_CTR_DISPATCHED), 1);
+    stats_ctr_put(ctr, MODBUS_SCHED_CTR(txn->cls, MODBUS_SCHED_CTR_WAIT_NS), wait_ns);
+    stats_ctr_end(ctr);
+    if (wait_ns > sched->wait_ns_max[txn->cls]) {
+        __atomic_store_n(&sched->wait_ns_max[txn->cls], wait_ns, __ATOMIC_RELAXED);
+    }
+}
+
+/**
+ * Get per-class scheduler statistics (any thread)
+ * @param sched: Pointer to ModbusSched
+ * @param stats: Output array of MODBUS_CLASS_NUM ModbusSchedStats
+ */
+void modbus_sched_get_stats(const ModbusSched* sched, ModbusSchedStats* stats)
+{
+    uint64_t v[MODBUS_CLASS_NUM * MODBUS_SCHED_CTR_PER_CLASS];
+    stats_ctr_snapshot(&sched->ctr, v, MODBUS_CLASS_NUM * MODBUS_SCHED_CTR_PER_CLASS);
+    for (int cls = 0; cls < MODBUS_CLASS_NUM; cls++) {
+        ModbusSchedStats* st = &stats[cls];
+        st->enqueued = v[MODBUS_SCHED_CTR(cls, MODBUS_SCHED_CTR_ENQUEUED)];
+        st->dispatched = v[MODBUS_SCHED_CTR(cls, MODBUS_SCHED_CTR_DISPATCHED)];
+        st->rejected = (uint32_t)v[MODBUS_SCHED_CTR(cls, MODBUS_SCHED_CTR_REJECTED)];
+        st->wait_ns_total = v[MODBUS_SCHED_CTR(cls, MODBUS_SCHED_CTR_WAIT_NS)];
+        st->queued = __atomic_load_n(&sched->queued[cls], __ATOMIC_RELAXED);
+        st->wait_ns_max = __atomic_load_n(&sched->wait_ns_max[cls], __ATOMIC_RELAXED);
+    }
+}
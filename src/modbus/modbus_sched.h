@@ -0,0 +1,116 @@
+#ifndef MODBUS_SCHED_H
+#define MODBUS_SCHED_H
+
+#include <stdint.h>
+#include <netinet/in.h>
+#include "modbus_core.h"
+#include "../stats/stats.h"
+
+// Global constants for the serial bus scheduler
+#define MODBUS_SCHED_FLOWS 33            // Requester queues per bus (one per outstanding transaction + spare)
+#define MODBUS_SCHED_QUANTUM 32          // Deficit round-robin quantum (estimated wire bytes per round)
+#define MODBUS_SCHED_WRITE_RESERVE 4     // Queue slots only writes may use
+
+#define MODBUS_ORIGIN_POLL -1            // client_idx of requests issued by the gateway poller
+#define MODBUS_ORIGIN_UDP -2             // client_idx of Modbus/UDP requests (reply to peer)
+
+// Requester of a transaction (the response is routed back to it)
+typedef struct {
+    int client_idx;              // TCP client slot (MODBUS_ORIGIN_POLL: gateway poller, MODBUS_ORIGIN_UDP: peer)
+    uint32_t conn_id;            // Connection generation of the slot
+    uint16_t trans_id;           // MBAP transaction ID of the request
+    uint8_t unit_id;             // MBAP unit ID of the request
+    uint8_t uart_idx;            // Bus the request was routed to
+    uint64_t rx_ns;              // Time the request was received / issued (latency histograms)
+    struct sockaddr_in peer;     // MODBUS_ORIGIN_UDP: source address of the request
+} ModbusOrigin;
+
+// Additional requester of a coalesced read
+typedef struct ModbusWaiter {
+    ModbusOrigin origin;
+    struct ModbusWaiter* next;
+} ModbusWaiter;
+
+// Priority class of a transaction (lower value is served first)
+typedef enum {
+    MODBUS_CLASS_WRITE,          // Requests that change slave data
+    MODBUS_CLASS_READ,           // Interactive reads of TCP clients
+    MODBUS_CLASS_POLL,           // Background reads of the gateway poller
+    MODBUS_CLASS_NUM
+} ModbusClass;
+
+// Outstanding transaction on a serial bus
+typedef struct ModbusTxn {
+    ModbusOrigin origin;
+    ModbusWaiter* waiters;       // Requesters of identical reads sharing this transaction
+    struct ModbusTxn* merged;    // Next read served by the same merged request
+    int no_merge;                // Merged request failed: retry this read on its own
+    ModbusClass cls;
+    int cost;                    // Estimated request + response bytes on the wire
+    ModbusRTUFrame rtu;
+    uint64_t enqueue_ns;
+    uint64_t write_ns;
+    struct ModbusTxn* next;
+} ModbusTxn;
+
+// Pending transactions of one requester (served in FIFO order), taken from the pool while it has any
+typedef struct ModbusFlow {
+    int client_idx;              // Requester owning the flow (ModbusOrigin key, valid while count > 0)
+    uint32_t conn_id;
+    struct sockaddr_in peer;
+    ModbusTxn* head;
+    ModbusTxn* tail;
+    int count;
+    int deficit;                 // Bytes the flow may still send in the current round
+    int cls;                     // Class ring the flow is on (class of its head, -1 = idle)
+    struct ModbusFlow* next;     // Next backlogged flow of the class ring
+} ModbusFlow;
+
+// Per-class scheduler counters (index MODBUS_SCHED_CTR(cls, k) into ModbusSched.ctr)
+typedef enum {
+    MODBUS_SCHED_CTR_ENQUEUED,
+    MODBUS_SCHED_CTR_DISPATCHED,
+    MODBUS_SCHED_CTR_REJECTED,
+    MODBUS_SCHED_CTR_WAIT_NS,
+    MODBUS_SCHED_CTR_PER_CLASS
+} ModbusSchedCtr;
+
+#define MODBUS_SCHED_CTR(cls, k) ((cls) * MODBUS_SCHED_CTR_PER_CLASS + (k))
+
+// Per-class scheduler statistics (snapshot)
+typedef struct {
+    uint64_t enqueued;
+    uint64_t dispatched;
+    uint32_t rejected;           // Requests refused because the queue was full
+    uint32_t queued;             // Currently waiting
+    uint64_t wait_ns_total;      // Enqueue -> write time of dispatched requests
+    uint64_t wait_ns_max;
+} ModbusSchedStats;
+
+// Per-bus scheduler: strict priority between classes, deficit round-robin between requesters of a class
+typedef struct {
+    ModbusFlow flows[MODBUS_SCHED_FLOWS];
+    ModbusFlow* ring_head[MODBUS_CLASS_NUM];
+    ModbusFlow* ring_tail[MODBUS_CLASS_NUM];
+    uint32_t queued[MODBUS_CLASS_NUM];       // Currently waiting per class
+    uint64_t wait_ns_max[MODBUS_CLASS_NUM];
+    StatsCounters ctr;           // ModbusSchedCtr per class
+} ModbusSched;
+
+void modbus_sched_init(ModbusSched* sched);
+
+int modbus_sched_flow_count(const ModbusSched* sched, const ModbusOrigin* origin);
+
+void modbus_sched_push(ModbusSched* sched, ModbusTxn* txn);
+
+void modbus_sched_push_front(ModbusSched* sched, ModbusTxn* txn);
+
+ModbusTxn* modbus_sched_pop(ModbusSched* sched);
+
+void modbus_sched_remove(ModbusSched* sched, ModbusTxn* txn);
+
+void modbus_sched_account(ModbusSched* sched, const ModbusTxn* txn, uint64_t write_ns);
+
+void modbus_sched_get_stats(const ModbusSched* sched, ModbusSchedStats* stats);
+
+#endif // !MODBUS_SCHED_H
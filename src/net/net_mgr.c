@@ -1,6 +1,21 @@
+#define _GNU_SOURCE
+#define LOG_MODULE LOG_MOD_NET
 #include "net_mgr.h"
+#include <sys/resource.h>
+#include <netdb.h>
+#include <netinet/tcp.h>
 #include "../log/log.h"
 
+#define TCP_CLIENT_EVENTS (EPOLLIN | EPOLLRDHUP | EPOLLET)
+
+// Datagrams received or waiting to be sent by one recvmmsg / sendmmsg call
+typedef struct NetUdpBatch {
+    struct mmsghdr msgs[NET_UDP_BATCH];
+    struct iovec iov[NET_UDP_BATCH];
+    struct sockaddr_in addrs[NET_UDP_BATCH];
+    uint8_t bufs[NET_UDP_BATCH][NET_UDP_MSG_MAX];
+    int count;
+} NetUdpBatch;
 
 /**
  * Initialize TCP client structure
@@ -10,6 +25,7 @@ static void tcp_client_init(TcpClient* client) {
     if (!client) return;
     memset(client, 0, sizeof(TcpClient));
     client->fd = -1;
+    client->handler.fd = -1;
     client->connected = 0;
     client->last_active = time(NULL);
     pthread_mutex_init(&client->mutex, NULL);
@@ -27,6 +43,93 @@ static void tcp_client_destroy(TcpClient* client) {
     pthread_mutex_destroy(&client->mutex);
 }
 
+/**
+ * Take a free client slot, allocating a new one when every allocated slot is in use
+ * @param mgr: Pointer to NetMgr instance
+ * @return Pointer to unconnected TcpClient, NULL at max_clients or on failure
+ */
+static TcpClient* tcp_client_alloc(NetMgr* mgr)
+{
+    if (mgr->client_count >= mgr->max_clients) return NULL;
+
+    TcpClient* client = NULL;
+    if (mgr->free_count > 0) {
+        client = mgr->clients[mgr->free_slots[--mgr->free_count]];
+    } else if (mgr->slot_count < NET_MAX_CLIENTS_LIMIT) {
+        // Cache-line aligned for the per-thread counter slots
+        client = (TcpClient*)aligned_alloc(64, sizeof(TcpClient));
+        if (!client) {
+            LOG_ERROR("Malloc TcpClient failed");
+            return NULL;
+        }
+        tcp_client_init(client);
+        client->idx = mgr->slot_count;
+        client->mgr = mgr;
+        mgr->clients[client->idx] = client;
+        // Readers on other threads only look at slots below slot_count
+        __atomic_store_n(&mgr->slot_count, mgr->slot_count + 1, __ATOMIC_RELEASE);
+    } else {
+        return NULL;
+    }
+    mgr->client_count++;
+    return client;
+}
+
+/**
+ * Return a client slot to the free stack
+ * @param mgr: Pointer to NetMgr instance
+ * @param client: Pointer to TcpClient (no longer connected)
+ */
+static void tcp_client_release(NetMgr* mgr, TcpClient* client)
+{
+    NetListener* listener = client->listener;
+    if (client->prev) {
+        client->prev->next = client->next;
+    } else {
+        listener->clients = client->next;
+    }
+    if (client->next) {
+        client->next->prev = client->prev;
+    }
+    client->prev = NULL;
+    client->next = NULL;
+    listener->client_count--;
+
+    mgr->free_slots[mgr->free_count++] = client->idx;
+    mgr->client_count--;
+}
+
+/**
+ * Add a client to the connected list of the listener that accepted it
+ * @param listener: Pointer to NetListener
+ * @param client: Pointer to TcpClient
+ */
+static void tcp_client_link(NetListener* listener, TcpClient* client)
+{
+    client->listener = listener;
+    client->prev = NULL;
+    client->next = listener->clients;
+    if (listener->clients) {
+        listener->clients->prev = client;
+    }
+    listener->clients = client;
+    listener->client_count++;
+}
+
+/**
+ * Look up an allocated client slot
+ * @param mgr: Pointer to NetMgr instance
+ * @param client_idx: Client slot
+ * @return Pointer to TcpClient, NULL if the slot was never allocated
+ */
+static TcpClient* tcp_client_at(NetMgr* mgr, int client_idx)
+{
+    if (client_idx < 0 || client_idx >= __atomic_load_n(&mgr->slot_count, __ATOMIC_ACQUIRE)) {
+        return NULL;
+    }
+    return mgr->clients[client_idx];
+}
+
 /**
  * Update TCP client active time
  * @param mgr: Pointer to NetMgr instance
@@ -34,11 +137,229 @@ static void tcp_client_destroy(TcpClient* client) {
  */
 static void update_client_active(NetMgr* mgr, int client_idx)
 {
-    if (!mgr || client_idx < 0 || client_idx >= MAX_CLIENT_NUM) return;
-    TcpClient* client = &mgr->clients[client_idx];
+    if (!mgr) return;
+    TcpClient* client = tcp_client_at(mgr, client_idx);
+    if (!client) return;
     client->last_active = time(NULL);
 }
 
+/**
+ * Allocate transmit buffer holding a copy of data
+ * @param data: Data to copy (NULL = leave uninitialized)
+ * @param len: Data length
+ * @return Pointer to NetBuf (refcnt 1), NULL on failure
+ */
+static NetBuf* net_buf_alloc(const uint8_t* data, int len)
+{
+    NetBuf* buf = (NetBuf*)malloc(sizeof(NetBuf) + len);
+    if (!buf) {
+        LOG_ERROR("Malloc NetBuf failed");
+        return NULL;
+    }
+    buf->refcnt = 1;
+    buf->len = len;
+    if (data) {
+        memcpy(buf->data, data, len);
+    }
+    return buf;
+}
+
+/**
+ * Release a reference to a transmit buffer (freed with the last one)
+ * @param buf: Pointer to NetBuf (may be NULL)
+ */
+static void net_buf_unref(NetBuf* buf)
+{
+    if (buf && __atomic_sub_fetch(&buf->refcnt, 1, __ATOMIC_ACQ_REL) == 0) {
+        free(buf);
+    }
+}
+
+/**
+ * Watch EPOLLOUT only while the client has queued data
+ * @param mgr: Pointer to NetMgr instance
+ * @param client: Pointer to TcpClient
+ */
+static void tcp_client_update_events(NetMgr* mgr, TcpClient* client)
+{
+    uint32_t events = TCP_CLIENT_EVENTS;
+    if (client->tx_count > 0) {
+        events |= EPOLLOUT;
+    }
+    reactor_mod(mgr->reactor, &client->handler, events);
+}
+
+/**
+ * Release every queued transmit buffer of a client
+ * @param client: Pointer to TcpClient
+ */
+static void tcp_client_tx_clear(TcpClient* client)
+{
+    while (client->tx_count > 0) {
+        NetTxItem* item = &client->tx_queue[client->tx_head];
+        net_buf_unref(item->buf);
+        item->buf = NULL;
+        client->tx_head = (client->tx_head + 1) % NET_TX_QUEUE_LEN;
+        client->tx_count--;
+    }
+    client->tx_head = 0;
+    client->tx_queued_bytes = 0;
+}
+
+/**
+ * Queue the unsent part of a buffer on a client
+ * @param mgr: Pointer to NetMgr instance
+ * @param client: Pointer to TcpClient
+ * @param buf: Buffer to queue (a reference is taken)
+ * @param off: Bytes of buf already sent
+ */
+static void tcp_client_enqueue(NetMgr* mgr, TcpClient* client, NetBuf* buf, int off)
+{
+    NetTxItem* item = &client->tx_queue[(client->tx_head + client->tx_count) % NET_TX_QUEUE_LEN];
+    __atomic_add_fetch(&buf->refcnt, 1, __ATOMIC_RELAXED);
+    item->buf = buf;
+    item->off = off;
+    client->tx_count++;
+    client->tx_queued_bytes += buf->len - off;
+    if (client->tx_queued_bytes > client->tx_max_queued) {
+        client->tx_max_queued = client->tx_queued_bytes;
+    }
+    if (client->tx_count == 1) {
+        tcp_client_update_events(mgr, client);
+    }
+}
+
+/**
+ * Check whether a message of len bytes still fits in the client queue
+ * @param mgr: Pointer to NetMgr instance
+ * @param client: Pointer to TcpClient
+ * @param len: Message length
+ * @return 1 if the queue is full, 0 otherwise
+ */
+static int tcp_client_tx_full(NetMgr* mgr, TcpClient* client, int len)
+{
+    return client->tx_count >= NET_TX_QUEUE_LEN || client->tx_queued_bytes + len > mgr->tx_max_bytes;
+}
+
+static void close_tcp_client(NetMgr* mgr, int client_idx);
+static void net_pipe_discard(int pipe_fd);
+static void upstream_lost(NetUpstream* up);
+
+/**
+ * Apply slow-consumer policy to a client whose queue is full
+ * @param mgr: Pointer to NetMgr instance
+ * @param client: Pointer to TcpClient
+ * @return 0 if the message was dropped, -1 if the client was closed
+ */
+static int tcp_client_tx_overflow(NetMgr* mgr, TcpClient* client)
+{
+    if (mgr->tx_policy == NET_TX_POLICY_DISCONNECT) {
+        LOG_WARN("Client %d too slow (%d bytes queued), close conn", client->idx, client->tx_queued_bytes);
+        close_tcp_client(mgr, client->idx);
+        return -1;
+    }
+    stats_ctr_add(&client->ctr, NET_CTR_TX_DROPS, 1);
+    return 0;
+}
+
+/**
+ * Send a message to a client without blocking: sent directly when nothing is
+ * queued, otherwise (or for the unsent remainder) queued until EPOLLOUT
+ * @param mgr: Pointer to NetMgr instance
+ * @param client: Pointer to TcpClient
+ * @param data: Message
+ * @param len: Message length
+ * @param shared: Buffer holding a copy of data, allocated on first use and shared between clients
+ * @return len if sent or queued, 0 if dropped, -1 if the client was closed
+ */
+static int tcp_client_submit(NetMgr* mgr, TcpClient* client, const uint8_t* data, int len, NetBuf** shared)
+{
+    int sent = 0;
+
+    if (client->tx_count == 0) {
+        ssize_t ret = send(client->fd, data, len, MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (ret < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                LOG_ERROR("Send to client %d failed, close conn", client->idx);
+                close_tcp_client(mgr, client->idx);
+                return -1;
+            }
+            ret = 0;
+        }
+        stats_ctr_add(&client->ctr, NET_CTR_TX_BYTES, ret);
+        sent = (int)ret;
+        if (sent == len) return len;
+    } else if (tcp_client_tx_full(mgr, client, len)) {
+        return tcp_client_tx_overflow(mgr, client);
+    }
+
+    if (!*shared) {
+        *shared = net_buf_alloc(data, len);
+    }
+    if (!*shared) {
+        // Part of the message is already on the wire: the stream can't be resumed
+        if (sent > 0) {
+            close_tcp_client(mgr, client->idx);
+            return -1;
+        }
+        stats_ctr_add(&client->ctr, NET_CTR_TX_DROPS, 1);
+        return 0;
+    }
+    tcp_client_enqueue(mgr, client, *shared, sent);
+    return len;
+}
+
+/**
+ * Flush queued data until the queue is empty or the socket is full
+ * @param mgr: Pointer to NetMgr instance
+ * @param client: Pointer to TcpClient
+ * @return 0 on success, -1 if the client was closed
+ */
+static int tcp_client_flush(NetMgr* mgr, TcpClient* client)
+{
+    while (client->connected && client->tx_count > 0) {
+        struct iovec iov[NET_TX_IOV_MAX];
+        int n = 0;
+        for (; n < client->tx_count && n < NET_TX_IOV_MAX; n++) {
+            NetTxItem* item = &client->tx_queue[(client->tx_head + n) % NET_TX_QUEUE_LEN];
+            iov[n].iov_base = item->buf->data + item->off;
+            iov[n].iov_len = item->buf->len - item->off;
+        }
+
+        struct msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = iov;
+        msg.msg_iovlen = n;
+        ssize_t ret = sendmsg(client->fd, &msg, MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (ret < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) return 0;
+            LOG_ERROR("Send to client %d failed, close conn", client->idx);
+            close_tcp_client(mgr, client->idx);
+            return -1;
+        }
+
+        stats_ctr_add(&client->ctr, NET_CTR_TX_BYTES, ret);
+        client->tx_queued_bytes -= ret;
+        while (ret > 0) {
+            NetTxItem* item = &client->tx_queue[client->tx_head];
+            int left = item->buf->len - item->off;
+            if (ret < left) {
+                item->off += ret;
+                break;
+            }
+            ret -= left;
+            net_buf_unref(item->buf);
+            item->buf = NULL;
+            client->tx_head = (client->tx_head + 1) % NET_TX_QUEUE_LEN;
+            client->tx_count--;
+        }
+    }
+
+    tcp_client_update_events(mgr, client);
+    return 0;
+}
+
 /**
  * Close TCP client
  * @param mgr: Pointer to NetMgr instance
@@ -46,11 +367,16 @@ static void update_client_active(NetMgr* mgr, int client_idx)
  */
 static void close_tcp_client(NetMgr* mgr, int client_idx)
 {
-    if (!mgr || client_idx < 0 || client_idx >= MAX_CLIENT_NUM) return;
-    TcpClient* client = &mgr->clients[client_idx];
+    if (!mgr) return;
+    TcpClient* client = tcp_client_at(mgr, client_idx);
+    if (!client) return;
 
     // pthread_mutex_lock(&client->mutex);
+    if (client->connected) {
+        tcp_client_release(mgr, client);
+    }
     if (client->connected && client->fd > 0) {
+        reactor_del(mgr->reactor, &client->handler);
         shutdown(client->fd, SHUT_RDWR);
         close(client->fd);
         LOG_INFO("%d (%s:%d) closed (timeout/invalid)", 
@@ -58,156 +384,589 @@ static void close_tcp_client(NetMgr* mgr, int client_idx)
     }
     client->fd = -1;
     client->connected = 0;
-    client->rx_bytes = 0;
-    client->tx_bytes = 0;
+    client->conn_id = 0;
+    stats_ctr_reset(&client->ctr, NET_CTR_NUM);
+    client->rx_len = 0;
     client->last_active = 0;
+    tcp_client_tx_clear(client);
     // pthread_mutex_unlock(&client->mutex);
+
+    if (client->upstream) {
+        NetUpstream* up = client->upstream;
+        client->upstream = NULL;
+        upstream_lost(up);
+    }
 }
 
 /**
- * TCP client connect clean thread function
+ * TCP client connect clean timer callback (close idle connections)
  * @param arg: Pointer to NetMgr instance
- * @return NULL on exit
  */
-static void* tcp_conn_clean_thread(void* arg)
+static void tcp_conn_clean_timer(void* arg)
 {
     NetMgr* mgr = (NetMgr*)arg;
-    time_t now;
+    time_t now = time(NULL);
+
+    pthread_mutex_lock(&mgr->mutex);
+    for (int i = 0; i < mgr->slot_count; i++) {
+        TcpClient* client = mgr->clients[i];
+        // Upstreams stay open while idle (dead peers are found by TCP keepalive)
+        if (!client->connected || client->fd < 0 || client->upstream) continue;
+
+        if (difftime(now, client->last_active) > CONN_TIMEOUT) {
+            close_tcp_client(mgr, i);
+        }
+    }
+    pthread_mutex_unlock(&mgr->mutex);
+}
+
+/**
+ * Deliver every complete frame in the client reassembly buffer
+ * Partial frames are kept at the buffer start until more data arrives
+ * @param mgr: Pointer to NetMgr instance
+ * @param client: Pointer to TcpClient
+ * @return 0 on success, -1 on stream protocol error
+ */
+static int tcp_client_dispatch_frames(NetMgr* mgr, TcpClient* client)
+{
+    NetListener* listener = client->listener;
+    int offset = 0;
+
+    while (offset < client->rx_len) {
+        const uint8_t* frame = client->rx_buf + offset;
+        int avail = client->rx_len - offset;
+        int frame_len = listener->frame_len ? listener->frame_len(frame, avail) : avail;
+        if (frame_len < 0) {
+            LOG_ERROR("Client %d stream framing error, close conn", client->idx);
+            return -1;
+        }
+        if (frame_len == 0) break;
+
+        offset += frame_len;
+        stats_ctr_add(&client->ctr, NET_CTR_RX_FRAMES, 1);
+        if (listener->on_rx) {
+            listener->on_rx(mgr, client->idx, frame, frame_len, listener->rx_arg);
+        }
+        // Callback may have closed the connection
+        if (!client->connected) return 0;
+    }
+
+    if (offset > 0) {
+        client->rx_len -= offset;
+        if (client->rx_len > 0) {
+            memmove(client->rx_buf, client->rx_buf + offset, client->rx_len);
+        }
+    }
+    return 0;
+}
+
+/**
+ * Move data of a raw-listener client into the receive pipe and hand it to the consumer (drain socket until EAGAIN)
+ * @param mgr: Pointer to NetMgr instance
+ * @param client: Pointer to TcpClient
+ * @return 0 if the socket was drained, -1 if splice is not supported (listener falls back to the copy path)
+ */
+static int tcp_client_splice_rx(NetMgr* mgr, TcpClient* client)
+{
+    NetListener* listener = client->listener;
+
+    while (client->connected && client->fd >= 0) {
+        ssize_t ret = splice(client->fd, NULL, mgr->rx_pipe[1], NULL, BUF_SIZE, SPLICE_F_NONBLOCK);
+        if (ret > 0) {
+            StatsCtrSlot* ctr = stats_ctr_begin(&client->ctr);
+            stats_ctr_put(ctr, NET_CTR_RX_BYTES, ret);
+            stats_ctr_put(ctr, NET_CTR_RX_FRAMES, 1);
+            stats_ctr_end(ctr);
+            update_client_active(mgr, client->idx);
+            listener->on_splice(mgr, client->idx, mgr->rx_pipe[0], (int)ret, listener->splice_arg);
+            net_pipe_discard(mgr->rx_pipe[0]);
+            continue;
+        }
+        if (ret < 0 && errno == EINTR) continue;
+        if (ret < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+        if (ret < 0 && (errno == EINVAL || errno == ENOSYS)) {
+            LOG_WARN("TCP port %d does not support splice, use copy path", listener->port);
+            listener->on_splice = NULL;
+            return -1;
+        }
 
-    while (1) {
-        now = time(NULL);
         pthread_mutex_lock(&mgr->mutex);
+        close_tcp_client(mgr, client->idx);
+        pthread_mutex_unlock(&mgr->mutex);
+        break;
+    }
+    return 0;
+}
 
-        for (int i = 0; i < MAX_CLIENT_NUM; i++) {
-            TcpClient* client = &mgr->clients[i];
-            if (!client->connected || client->fd < 0) continue;
+/**
+ * TCP client read handler (reactor callback, drain socket until EAGAIN)
+ * @param handler: Pointer to client reactor handler
+ * @param events: Ready event mask
+ */
+static void tcp_client_read_handler(ReactorHandler* handler, uint32_t events)
+{
+    TcpClient* client = (TcpClient*)handler->ctx;
+    NetMgr* mgr = client->mgr;
+
+    if (client->listener->on_splice && client->rx_len == 0 && tcp_client_splice_rx(mgr, client) == 0) {
+        return;
+    }
 
-            if (difftime(now, client->last_active) > CONN_TIMEOUT) {
-                close_tcp_client(mgr, i);
+    while (client->connected && client->fd >= 0) {
+        ssize_t ret = recv(client->fd, client->rx_buf + client->rx_len,
+                           sizeof(client->rx_buf) - client->rx_len, 0);
+        if (ret > 0) {
+            stats_ctr_add(&client->ctr, NET_CTR_RX_BYTES, ret);
+            client->rx_len += ret;
+            update_client_active(mgr, client->idx);
+            if (tcp_client_dispatch_frames(mgr, client) == 0) {
+                continue;
             }
+        } else {
+            if (ret < 0 && errno == EINTR) continue;
+            if (ret < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
         }
 
+        pthread_mutex_lock(&mgr->mutex);
+        close_tcp_client(mgr, client->idx);
         pthread_mutex_unlock(&mgr->mutex);
-        sleep(5);
+        break;
     }
-    return NULL;
 }
 
 /**
- * TCP server thread function (handle client connections)
- * @param arg: Pointer to NetMgr instance
- * @return NULL on exit
+ * TCP client event handler (reactor callback: flush queue on EPOLLOUT, then read)
+ * @param handler: Pointer to client reactor handler
+ * @param events: Ready event mask
  */
-static void* tcp_server_thread(void* arg) 
+static void tcp_client_event_handler(ReactorHandler* handler, uint32_t events)
 {
-    NetMgr* mgr = (NetMgr*)arg;
-    struct sockaddr_in client_addr;
-    socklen_t client_len = sizeof(client_addr);
+    TcpClient* client = (TcpClient*)handler->ctx;
+    NetMgr* mgr = client->mgr;
+
+    if (events & EPOLLOUT) {
+        pthread_mutex_lock(&mgr->mutex);
+        pthread_mutex_lock(&client->mutex);
+        tcp_client_flush(mgr, client);
+        pthread_mutex_unlock(&client->mutex);
+        pthread_mutex_unlock(&mgr->mutex);
+    }
+    if (events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR)) {
+        tcp_client_read_handler(handler, events);
+    }
+}
+
+/**
+ * Refuse one pending connection while the process is out of file descriptors
+ * The listen socket is edge-triggered: a connection left in the backlog would
+ * never be reported again, so a reserved fd is freed to accept and close it.
+ * @param mgr: Pointer to NetMgr instance
+ * @param listener: Listener with the pending connection
+ * @return 1 if a connection was refused, 0 otherwise
+ */
+static int tcp_refuse_pending(NetMgr* mgr, NetListener* listener)
+{
+    if (mgr->spare_fd < 0) return 0;
+
+    close(mgr->spare_fd);
+    int fd = accept(listener->fd, NULL, NULL);
+    if (fd >= 0) {
+        close(fd);
+        mgr->rejected++;
+    }
+    mgr->spare_fd = open("/dev/null", O_RDONLY | O_CLOEXEC);
+    LOG_WARN("Out of file descriptors (%d clients), reject new connection", mgr->client_count);
+    return fd >= 0;
+}
+
+/**
+ * Serve a connected socket in a client slot taken with tcp_client_alloc (mgr->mutex held)
+ * @param mgr: Pointer to NetMgr instance
+ * @param listener: Listener whose callbacks handle the connection
+ * @param client: Pointer to unconnected TcpClient
+ * @param fd: Connected non-blocking socket
+ * @param addr: Peer address
+ * @return 0 on success, -1 on failure (slot released, fd left open)
+ */
+static int tcp_client_start(NetMgr* mgr, NetListener* listener, TcpClient* client, int fd,
+                            const struct sockaddr_in* addr)
+{
+    tcp_client_link(listener, client);
+    pthread_mutex_lock(&client->mutex);
+    if (client->fd > 0) {
+        close(client->fd);
+    }
+    client->fd = fd;
+    client->addr = *addr;
+    client->connected = 1;
+    client->upstream = NULL;
+    if (++mgr->next_conn_id == 0) mgr->next_conn_id = 1;
+    client->conn_id = mgr->next_conn_id;
+    stats_ctr_reset(&client->ctr, NET_CTR_NUM);
+    client->rx_len = 0;
+    client->tx_max_queued = 0;
+    client->last_active = time(NULL);
+    if (reactor_add(mgr->reactor, &client->handler, fd, TCP_CLIENT_EVENTS,
+                    tcp_client_event_handler, client) != 0) {
+        client->fd = -1;
+        client->connected = 0;
+        tcp_client_release(mgr, client);
+        pthread_mutex_unlock(&client->mutex);
+        return -1;
+    }
+    pthread_mutex_unlock(&client->mutex);
+    return 0;
+}
 
-    LOG_INFO("TCP server thread start, listen port: %d", TCP_PORT);
+/**
+ * TCP listen socket handler (reactor callback, accept until EAGAIN)
+ * @param handler: Pointer to listen reactor handler
+ * @param events: Ready event mask
+ */
+static void tcp_accept_handler(ReactorHandler* handler, uint32_t events)
+{
+    NetListener* listener = (NetListener*)handler->ctx;
+    NetMgr* mgr = listener->mgr;
+    struct sockaddr_in client_addr;
+    socklen_t client_len;
 
     while (1) {
-        int client_fd = accept(mgr->server_fd, (struct sockaddr*)&client_addr, &client_len);
+        client_len = sizeof(client_addr);
+        int client_fd = accept4(listener->fd, (struct sockaddr*)&client_addr, &client_len,
+                                SOCK_NONBLOCK | SOCK_CLOEXEC);
         if (client_fd < 0) {
-            if (errno == EINTR) continue;
-            LOG_ERROR("TCP accept failed");
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            if ((errno == EMFILE || errno == ENFILE) && tcp_refuse_pending(mgr, listener)) continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                LOG_ERROR("TCP accept failed: %s", strerror(errno));
+            }
             break;
         }
 
-        int flags = fcntl(client_fd, F_GETFL, 0);
-        fcntl(client_fd, F_SETFL, flags | O_NONBLOCK);
-
-        int client_idx = -1;
         pthread_mutex_lock(&mgr->mutex);
-        for (int i = 0; i < MAX_CLIENT_NUM; i++) {
-            if (!mgr->clients[i].connected) {
-                client_idx = i;
-                break;
-            }
+        TcpClient* client = tcp_client_alloc(mgr);
+        if (!client) {
+            mgr->rejected++;
+            pthread_mutex_unlock(&mgr->mutex);
+            close(client_fd);
+            LOG_WARN("TCP client limit %d reached, reject new connection", mgr->max_clients);
+            continue;
         }
-        pthread_mutex_unlock(&mgr->mutex);
 
-        if (client_idx == -1) {
+        int client_idx = client->idx;
+        if (tcp_client_start(mgr, listener, client, client_fd, &client_addr) != 0) {
+            pthread_mutex_unlock(&mgr->mutex);
             close(client_fd);
-            LOG_WARN("TCP client max num reacher, reject new connection");
             continue;
         }
+        pthread_mutex_unlock(&mgr->mutex);
 
-        TcpClient* client = &mgr->clients[client_idx];
-        pthread_mutex_lock(&client->mutex);
-        if (client->fd > 0) {
-            close(client->fd);
-        }
-        client->fd = client_fd;
-        client->addr = client_addr;
-        client->connected = 1;
-        client->rx_bytes = 0;
-        client->tx_bytes = 0;
-        client->last_active = time(NULL);
-        pthread_mutex_unlock(&client->mutex);
+        LOG_INFO("TCP client connected: %s:%d (idx: %d, port %d)", 
+                inet_ntoa(client_addr.sin_addr), ntohs(client_addr.sin_port), client_idx, listener->port);
 
-        LOG_INFO("TCP client connected: %s:%d (idx: %d)", 
-                inet_ntoa(client_addr.sin_addr), ntohs(client_addr.sin_port), client_idx);
+        // Data may already be queued (EPOLLET only reports new arrivals)
+        tcp_client_read_handler(&client->handler, EPOLLIN);
     }
-    return NULL;
 }
 
 /**
- * TCP client thread function (connect to server)
- * @param arg: Pointer to NetMgr instance
- * @return NULL on exit
+ * Open a listen socket and register it with the reactor
+ * @param mgr: Pointer to NetMgr instance
+ * @param listener: Listener to open (id, callbacks set by the caller)
+ * @param port: TCP port
+ * @return 0 on success, -1 on failure
  */
-static void* tcp_client_thread(void* arg)
+static int tcp_listener_open(NetMgr* mgr, NetListener* listener, int port)
 {
-    NetMgr* mgr = (NetMgr*)arg;
+    int opt = 1;
+    listener->mgr = mgr;
+    listener->port = port;
+    listener->handler.fd = -1;
+    listener->fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listener->fd < 0) {
+        LOG_ERROR("TCP server socket create failed");
+        return -1;
+    }
+    setsockopt(listener->fd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+
     struct sockaddr_in server_addr;
     memset(&server_addr, 0, sizeof(server_addr));
     server_addr.sin_family = AF_INET;
-    server_addr.sin_port = htons(TCP_PORT);
+    server_addr.sin_addr.s_addr = INADDR_ANY;
+    server_addr.sin_port = htons(port);
 
-    if (inet_pton(AF_INET, (char*)arg + sizeof(NetMgr*), &server_addr.sin_addr) <= 0) {
-        LOG_ERROR("Invalid server IP");
-        return NULL;
+    if (bind(listener->fd, (struct sockaddr*)&server_addr, sizeof(server_addr)) < 0) {
+        LOG_ERROR("TCP server bind port %d failed: %s", port, strerror(errno));
+        close(listener->fd);
+        listener->fd = -1;
+        return -1;
     }
 
-    while (1) {
-        pthread_mutex_lock(&mgr->mutex);
-        if (mgr->client_fd < 0 || !mgr->client_fd) {
-            mgr->client_fd = socket(AF_INET, SOCK_STREAM, 0);
-            if (mgr->client_fd < 0) {
-                LOG_ERROR("TCP client socket create failed");
-                pthread_mutex_unlock(&mgr->mutex);
-                sleep(1);
-                continue;
+    if (listen(listener->fd, mgr->backlog) < 0) {
+        LOG_ERROR("TCP server listen failed");
+        close(listener->fd);
+        listener->fd = -1;
+        return -1;
+    }
+
+    if (reactor_add(mgr->reactor, &listener->handler, listener->fd, EPOLLIN | EPOLLET,
+                    tcp_accept_handler, listener) != 0) {
+        LOG_ERROR("Add TCP server socket to reactor failed");
+        close(listener->fd);
+        listener->fd = -1;
+        return -1;
+    }
+    LOG_INFO("TCP server listen port: %d", port);
+    return 0;
+}
+
+/**
+ * Arm the retry timer of an upstream (exponential backoff with jitter)
+ * @param up: Pointer to NetUpstream
+ */
+static void upstream_schedule(NetUpstream* up)
+{
+    // Equal jitter: half the backoff fixed, half random, so gateways restarted together spread out
+    uint32_t half = up->backoff_ms / 2;
+    uint32_t delay_ms = half + rand_r(&up->mgr->upstream_seed) % (half + 1);
+    up->backoff_ms = up->backoff_ms * 2 > NET_UPSTREAM_BACKOFF_MAX_MS ?
+                     NET_UPSTREAM_BACKOFF_MAX_MS : up->backoff_ms * 2;
+    up->state = NET_UPSTREAM_IDLE;
+    reactor_timer_start(&up->timer, (uint64_t)delay_ms * 1000 + 1, 0);
+}
+
+/**
+ * Count a failed connect attempt and schedule the next one
+ * @param up: Pointer to NetUpstream
+ * @param reason: Failure description
+ */
+static void upstream_failed(NetUpstream* up, const char* reason)
+{
+    up->failures++;
+    LOG_WARN("Upstream %s:%d connect failed: %s", up->host, up->port, reason);
+    upstream_schedule(up);
+}
+
+/**
+ * Reconnect an upstream whose connection was closed (called by close_tcp_client)
+ * @param up: Pointer to NetUpstream
+ */
+static void upstream_lost(NetUpstream* up)
+{
+    LOG_WARN("Upstream %s:%d disconnected", up->host, up->port);
+    // A connection that lasted restarts the backoff, one dropped right away keeps growing it
+    if (difftime(time(NULL), up->connected_at) >= NET_UPSTREAM_STABLE_S) {
+        up->backoff_ms = NET_UPSTREAM_BACKOFF_MIN_MS;
+    }
+    up->client_idx = -1;
+    upstream_schedule(up);
+}
+
+/**
+ * Serve a connected upstream socket as a client of the shared port
+ * @param up: Pointer to NetUpstream
+ * @param fd: Connected non-blocking socket
+ */
+static void upstream_attach(NetUpstream* up, int fd)
+{
+    NetMgr* mgr = up->mgr;
+
+    pthread_mutex_lock(&mgr->mutex);
+    TcpClient* client = tcp_client_alloc(mgr);
+    if (!client || tcp_client_start(mgr, &mgr->listeners[0], client, fd, &up->addr) != 0) {
+        pthread_mutex_unlock(&mgr->mutex);
+        close(fd);
+        upstream_failed(up, "no free client slot");
+        return;
+    }
+    client->upstream = up;
+    up->client_idx = client->idx;
+    up->state = NET_UPSTREAM_CONNECTED;
+    up->connected_at = time(NULL);
+    up->connects++;
+    pthread_mutex_unlock(&mgr->mutex);
+
+    LOG_INFO("Upstream %s:%d connected (idx: %d)", up->host, up->port, client->idx);
+    // The collector may have sent its first request together with the handshake
+    tcp_client_read_handler(&client->handler, EPOLLIN);
+}
+
+/**
+ * Upstream connect completion handler (reactor callback, socket writable or failed)
+ * @param handler: Pointer to the upstream connect handler
+ * @param events: Ready event mask
+ */
+static void upstream_connect_handler(ReactorHandler* handler, uint32_t events)
+{
+    NetUpstream* up = (NetUpstream*)handler->ctx;
+    int fd = up->fd;
+    int err = 0;
+    socklen_t len = sizeof(err);
+
+    reactor_del(up->mgr->reactor, &up->handler);
+    reactor_timer_stop(&up->timer);
+    up->fd = -1;
+    if (getsockopt(fd, SOL_SOCKET, SO_ERROR, &err, &len) < 0) {
+        err = errno;
+    }
+    if (err != 0) {
+        close(fd);
+        upstream_failed(up, strerror(err));
+        return;
+    }
+    upstream_attach(up, fd);
+}
+
+/**
+ * Start a non-blocking connect to an upstream (completion is reported by the reactor)
+ * @param up: Pointer to NetUpstream
+ */
+static void upstream_connect(NetUpstream* up)
+{
+    NetMgr* mgr = up->mgr;
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        upstream_failed(up, strerror(errno));
+        return;
+    }
+    int opt = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &opt, sizeof(opt));
+    setsockopt(fd, SOL_SOCKET, SO_KEEPALIVE, &opt, sizeof(opt));
+
+    if (connect(fd, (struct sockaddr*)&up->addr, sizeof(up->addr)) == 0) {
+        upstream_attach(up, fd);
+        return;
+    }
+    if (errno != EINPROGRESS) {
+        int err = errno;
+        close(fd);
+        upstream_failed(up, strerror(err));
+        return;
+    }
+    if (reactor_add(mgr->reactor, &up->handler, fd, EPOLLOUT, upstream_connect_handler, up) != 0) {
+        close(fd);
+        upstream_failed(up, "reactor add failed");
+        return;
+    }
+    up->fd = fd;
+    up->state = NET_UPSTREAM_CONNECTING;
+    reactor_timer_start(&up->timer, NET_UPSTREAM_CONNECT_TIMEOUT_MS * 1000ULL, 0);
+}
+
+/**
+ * Upstream timer callback: retry after the backoff or abort a connect that takes too long
+ * @param arg: Pointer to NetUpstream
+ */
+static void upstream_timer(void* arg)
+{
+    NetUpstream* up = (NetUpstream*)arg;
+
+    if (up->state == NET_UPSTREAM_CONNECTING) {
+        reactor_del(up->mgr->reactor, &up->handler);
+        close(up->fd);
+        up->fd = -1;
+        upstream_failed(up, "timeout");
+    } else if (up->state == NET_UPSTREAM_IDLE) {
+        upstream_connect(up);
+    }
+}
+
+/**
+ * Create and bind a non-blocking UDP socket
+ * @param port: UDP port
+ * @return Socket fd on success, -1 on failure
+ */
+static int udp_socket_open(int port)
+{
+    int opt = 1;
+    // Blocking socket: the reactor path uses MSG_DONTWAIT, net_mgr_recv_udp may block
+    int fd = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        LOG_ERROR("UDP socket create failed");
+        return -1;
+    }
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+
+    struct sockaddr_in udp_addr;
+    memset(&udp_addr, 0, sizeof(udp_addr));
+    udp_addr.sin_family = AF_INET;
+    udp_addr.sin_addr.s_addr = INADDR_ANY;
+    udp_addr.sin_port = htons(port);
+
+    if (bind(fd, (struct sockaddr*)&udp_addr, sizeof(udp_addr)) < 0) {
+        LOG_ERROR("UDP bind port %d failed: %s", port, strerror(errno));
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/**
+ * Point every message of a batch at its own buffer and address
+ * @param batch: Pointer to NetUdpBatch
+ */
+static void udp_batch_init(NetUdpBatch* batch)
+{
+    memset(batch->msgs, 0, sizeof(batch->msgs));
+    for (int i = 0; i < NET_UDP_BATCH; i++) {
+        batch->iov[i].iov_base = batch->bufs[i];
+        batch->iov[i].iov_len = NET_UDP_MSG_MAX;
+        batch->msgs[i].msg_hdr.msg_iov = &batch->iov[i];
+        batch->msgs[i].msg_hdr.msg_iovlen = 1;
+        batch->msgs[i].msg_hdr.msg_name = &batch->addrs[i];
+        batch->msgs[i].msg_hdr.msg_namelen = sizeof(struct sockaddr_in);
+    }
+    batch->count = 0;
+}
+
+/**
+ * UDP socket read handler (reactor callback, datagrams are read NET_UDP_BATCH at a time)
+ * @param handler: Pointer to UDP reactor handler
+ * @param events: Ready event mask
+ */
+static void udp_read_handler(ReactorHandler* handler, uint32_t events)
+{
+    NetMgr* mgr = (NetMgr*)handler->ctx;
+    NetUdpBatch* batch = mgr->udp_rx;
+
+    // Level-triggered: datagrams left after a few rounds are read on the next wake-up
+    for (int round = 0; round < NET_UDP_RX_ROUNDS; round++) {
+        for (int i = 0; i < NET_UDP_BATCH; i++) {
+            batch->msgs[i].msg_hdr.msg_namelen = sizeof(struct sockaddr_in);
+        }
+        int n = recvmmsg(mgr->udp_fd, batch->msgs, NET_UDP_BATCH, MSG_DONTWAIT, NULL);
+        if (n <= 0) {
+            if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                LOG_ERROR("UDP recvmmsg failed: %s", strerror(errno));
             }
+            break;
+        }
 
-            LOG_INFO("TCP client connecting to %s:%d...", 
-                    inet_ntoa(server_addr.sin_addr), ntohs(server_addr.sin_port));
+        StatsCtrSlot* ctr = stats_ctr_begin(&mgr->udp_ctr);
+        stats_ctr_put(ctr, NET_UDP_CTR_RX_DATAGRAMS, n);
+        stats_ctr_put(ctr, NET_UDP_CTR_RX_BATCHES, 1);
+        stats_ctr_end(ctr);
 
-            if (connect(mgr->client_fd, (struct sockaddr*)&server_addr, sizeof(server_addr)) < 0) {
-                LOG_ERROR("TCP client connerc failed");
-                close(mgr->client_fd);
-                mgr->client_fd = -1;
-                pthread_mutex_unlock(&mgr->mutex);
-                sleep(3);
+        for (int i = 0; i < n; i++) {
+            if (batch->msgs[i].msg_hdr.msg_flags & MSG_TRUNC) {
+                stats_ctr_add(&mgr->udp_ctr, NET_UDP_CTR_RX_ERRORS, 1);
                 continue;
             }
-            LOG_INFO("TCP client connected to server");
+            if (mgr->udp_on_rx) {
+                mgr->udp_on_rx(mgr, &batch->addrs[i], batch->bufs[i], (int)batch->msgs[i].msg_len, mgr->udp_rx_arg);
+            }
         }
-        pthread_mutex_unlock(&mgr->mutex);
-        sleep(1);
+        if (n < NET_UDP_BATCH) break;
     }
-    return NULL;
 }
 
 /**
- * UDP thread function (reserved for extension)
+ * Reactor flush hook: send the responses queued during the event batch
  * @param arg: Pointer to NetMgr instance
- * @return NULL on exit
  */
-static void* udp_thread(void* arg) {
-    // temple NULL
-    return NULL;
+static void udp_flush_hook(void* arg)
+{
+    net_mgr_flush_udp((NetMgr*)arg);
 }
 
 /**
@@ -215,9 +974,12 @@ static void* udp_thread(void* arg) {
  * @param mode: Network mode (TCP_SERVER/TCP_CLIENT/UDP)
  * @param server_ip: Server IP (only for TCP_CLIENT mode)
  * @param port: Network port (0 for default port)
+ * @param reactor: Event loop that owns the sockets
+ * @param on_rx: Callback for data received from TCP clients
+ * @param arg: Callback argument
  * @return Pointer to NetMgr instance on success, NULL on failure
  */
-NetMgr* net_mgr_init(NetMode mode, const char* server_ip, int port) {
+NetMgr* net_mgr_init(NetMode mode, const char* server_ip, int port, Reactor* reactor, NetRxCallback on_rx, void* arg) {
     NetMgr* mgr = (NetMgr*)malloc(sizeof(NetMgr));
     if (!mgr) {
         LOG_ERROR("Malloc NetMgr failed");
@@ -225,95 +987,69 @@ NetMgr* net_mgr_init(NetMode mode, const char* server_ip, int port) {
     }
     memset(mgr, 0, sizeof(NetMgr));
     mgr->mode = mode;
-    pthread_mutex_init(&mgr->mutex, NULL);
-
-    for (int i = 0; i < MAX_CLIENT_NUM; i++) {
-        tcp_client_init(&mgr->clients[i]);
+    mgr->reactor = reactor;
+    for (int i = 0; i < NET_MAX_LISTENERS; i++) {
+        mgr->listeners[i].id = i;
+        mgr->listeners[i].fd = -1;
+        mgr->listeners[i].handler.fd = -1;
     }
+    mgr->listeners[0].on_rx = on_rx;
+    mgr->listeners[0].rx_arg = arg;
+    mgr->clean_timer.handler.fd = -1;
+    mgr->splice_pipe[0] = -1;
+    mgr->splice_pipe[1] = -1;
+    mgr->rx_pipe[0] = -1;
+    mgr->rx_pipe[1] = -1;
+    mgr->tx_policy = NET_TX_POLICY_DROP;
+    mgr->tx_max_bytes = NET_TX_MAX_BYTES;
+    mgr->max_clients = NET_MAX_CLIENTS;
+    mgr->backlog = LISTEN_BACKLOG;
+    mgr->spare_fd = -1;
+    mgr->udp_fd = -1;
+    mgr->udp_handler.fd = -1;
+    mgr->upstream_seed = (unsigned int)time(NULL) ^ (unsigned int)getpid();
+    pthread_mutex_init(&mgr->mutex, NULL);
 
-    int opt = 1;
     switch (mode) {
         case NET_MODE_TCP_SERVER:
-            mgr->server_fd = socket(AF_INET, SOCK_STREAM, 0);
-            if (mgr->server_fd < 0) {
-                LOG_ERROR("TCP server socket create failed");
-                free(mgr);
-                return NULL;
-            }
-            setsockopt(mgr->server_fd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
-
-            struct sockaddr_in server_addr;
-            memset(&server_addr, 0, sizeof(server_addr));
-            server_addr.sin_family = AF_INET;
-            server_addr.sin_addr.s_addr = INADDR_ANY;
-            server_addr.sin_port = htons(port > 0 ? port : TCP_PORT);
-
-            if (bind(mgr->server_fd, (struct sockaddr*)&server_addr, sizeof(server_addr)) < 0) {
-                LOG_ERROR("TCP server bind failed");
-                close(mgr->server_fd);
-                free(mgr);
-                return NULL;
-            }
-
-            if (listen(mgr->server_fd, LISTEN_BACKLOG) < 0) {
-                LOG_ERROR("TCP server listen failed");
-                close(mgr->server_fd);
-                free(mgr);
-                return NULL;
-            }
-
-            if (pthread_create(&mgr->net_thread, NULL, tcp_server_thread, mgr) != 0) {
-                LOG_ERROR("Create TCP server thread failed");
-                close(mgr->server_fd);
+            if (tcp_listener_open(mgr, &mgr->listeners[0], port > 0 ? port : TCP_PORT) != 0) {
                 free(mgr);
                 return NULL;
             }
-
-             if (pthread_create(&mgr->clean_thread, NULL, tcp_conn_clean_thread, mgr) != 0) {
-                LOG_ERROR("Create TCP clean thread failed");
+            mgr->listener_count = 1;
+            mgr->server_fd = mgr->listeners[0].fd;
+
+            if (reactor_timer_init(reactor, &mgr->clean_timer, tcp_conn_clean_timer, mgr) != 0 ||
+                reactor_timer_start(&mgr->clean_timer, CONN_CHECK_INTERVAL * 1000000ULL,
+                                    CONN_CHECK_INTERVAL * 1000000ULL) != 0) {
+                LOG_ERROR("Create TCP clean timer failed");
+                reactor_timer_destroy(&mgr->clean_timer);
+                reactor_del(reactor, &mgr->listeners[0].handler);
                 close(mgr->server_fd);
                 free(mgr);
                 return NULL;
             }
-            pthread_detach(mgr->clean_thread);
+            mgr->spare_fd = open("/dev/null", O_RDONLY | O_CLOEXEC);
             break;
 
         case NET_MODE_TCP_CLIENT: 
-            if (pthread_create(&mgr->net_thread, NULL, tcp_client_thread, mgr) != 0) {
-                LOG_ERROR("Create TCP client thread failed");
+            // Dial out instead of listening: the server is served like a client of the shared port
+            mgr->server_fd = -1;
+            if (!server_ip || net_mgr_add_upstream(mgr, server_ip, port > 0 ? port : TCP_PORT) < 0) {
                 free(mgr);
                 return NULL;
             }
             break;
 
         case NET_MODE_UDP: 
-            mgr->server_fd = socket(AF_INET, SOCK_DGRAM, 0);
+            // Served by the reactor once net_mgr_open_udp sets the receive callback
+            mgr->udp_port = port > 0 ? port : UDP_PORT;
+            mgr->server_fd = udp_socket_open(mgr->udp_port);
             if (mgr->server_fd < 0) {
-                LOG_ERROR("UDP socket create failed");
-                free(mgr);
-                return NULL;
-            }
-            setsockopt(mgr->server_fd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
-
-            struct sockaddr_in udp_addr;
-            memset(&udp_addr, 0, sizeof(udp_addr));
-            udp_addr.sin_family = AF_INET;
-            udp_addr.sin_addr.s_addr = INADDR_ANY;
-            udp_addr.sin_port = htons(port > 0 ? port : UDP_PORT);
-
-            if (bind(mgr->server_fd, (struct sockaddr*)&udp_addr, sizeof(udp_addr)) < 0) {
-                LOG_ERROR("UDP bind failed");
-                close(mgr->server_fd);
-                free(mgr);
-                return NULL;
-            }
-
-            if (pthread_create(&mgr->net_thread, NULL, udp_thread, mgr) != 0) {
-                LOG_ERROR("Create UDP thread failed");
-                close(mgr->server_fd);
                 free(mgr);
                 return NULL;
             }
+            mgr->udp_fd = mgr->server_fd;
             break;
         
         default: 
@@ -332,25 +1068,51 @@ void net_mgr_destroy(NetMgr* mgr)
 {
     if (!mgr) return;
 
+    reactor_timer_destroy(&mgr->clean_timer);
+    for (int i = 0; i < mgr->upstream_count; i++) {
+        NetUpstream* up = &mgr->upstreams[i];
+        reactor_timer_destroy(&up->timer);
+        if (up->fd >= 0) {
+            reactor_del(mgr->reactor, &up->handler);
+            close(up->fd);
+        }
+    }
+    if (mgr->udp_fd >= 0) {
+        reactor_set_flush_hook(mgr->reactor, NULL, NULL);
+        reactor_del(mgr->reactor, &mgr->udp_handler);
+        if (mgr->udp_fd != mgr->server_fd) {
+            close(mgr->udp_fd);
+        }
+    }
+    free(mgr->udp_rx);
+    free(mgr->udp_tx);
+    for (int i = 0; i < mgr->listener_count; i++) {
+        reactor_del(mgr->reactor, &mgr->listeners[i].handler);
+        if (i > 0) {
+            close(mgr->listeners[i].fd);
+        }
+    }
     if (mgr->server_fd > 0) {
         close(mgr->server_fd);
     }
-    if (mgr->client_fd > 0) {
-        close(mgr->client_fd);
-    }
-
-    for (int i = 0; i < MAX_CLIENT_NUM; i++) {
-        tcp_client_destroy(&mgr->clients[i]);
+    for (int i = 0; i < 2; i++) {
+        if (mgr->splice_pipe[i] >= 0) {
+            close(mgr->splice_pipe[i]);
+        }
+        if (mgr->rx_pipe[i] >= 0) {
+            close(mgr->rx_pipe[i]);
+        }
     }
 
-    if (mgr->net_thread) {
-        pthread_cancel(mgr->net_thread);
-        pthread_join(mgr->net_thread, NULL);
+    if (mgr->spare_fd >= 0) {
+        close(mgr->spare_fd);
     }
 
-    if (mgr->clean_thread) {
-        pthread_cancel(mgr->clean_thread);
-        pthread_join(mgr->clean_thread, NULL);
+    for (int i = 0; i < mgr->slot_count; i++) {
+        reactor_del(mgr->reactor, &mgr->clients[i]->handler);
+        tcp_client_tx_clear(mgr->clients[i]);
+        tcp_client_destroy(mgr->clients[i]);
+        free(mgr->clients[i]);
     }
 
     LOG_INFO("Net manager destroyed");
@@ -360,37 +1122,380 @@ void net_mgr_destroy(NetMgr* mgr)
 }
 
 /**
- * Broadcast TCP data to all connected clients
+ * Set stream framer used to split client byte streams into frames
+ * @param mgr: Pointer to NetMgr instance
+ * @param frame_len: Framer (NULL = deliver data as received)
+ */
+void net_mgr_set_framer(NetMgr* mgr, NetFrameLenFn frame_len)
+{
+    if (!mgr) return;
+    mgr->listeners[0].frame_len = frame_len;
+}
+
+/**
+ * Set slow-consumer policy of client transmit queues
+ * @param mgr: Pointer to NetMgr instance
+ * @param policy: Action when a client queue is full
+ * @param max_bytes: Max queued bytes per client (<= 0 = NET_TX_MAX_BYTES)
+ */
+void net_mgr_set_tx_policy(NetMgr* mgr, NetTxPolicy policy, int max_bytes)
+{
+    if (!mgr) return;
+    pthread_mutex_lock(&mgr->mutex);
+    mgr->tx_policy = policy;
+    mgr->tx_max_bytes = max_bytes > 0 ? max_bytes : NET_TX_MAX_BYTES;
+    pthread_mutex_unlock(&mgr->mutex);
+}
+
+/**
+ * Set connection limits (connections above a lowered limit stay open)
+ * @param mgr: Pointer to NetMgr instance
+ * @param max_clients: Max connected clients (<= 0 = NET_MAX_CLIENTS, capped at NET_MAX_CLIENTS_LIMIT)
+ * @param backlog: Listen backlog (<= 0 = unchanged)
+ * @return 0 on success, -1 on failure
+ */
+int net_mgr_set_limits(NetMgr* mgr, int max_clients, int backlog)
+{
+    if (!mgr) return -1;
+
+    int ret = 0;
+    pthread_mutex_lock(&mgr->mutex);
+    if (max_clients <= 0) {
+        max_clients = NET_MAX_CLIENTS;
+    } else if (max_clients > NET_MAX_CLIENTS_LIMIT) {
+        LOG_WARN("max_clients %d above limit, use %d", max_clients, NET_MAX_CLIENTS_LIMIT);
+        max_clients = NET_MAX_CLIENTS_LIMIT;
+    }
+    mgr->max_clients = max_clients;
+
+    // Every client needs an fd: raise the soft limit as far as the hard limit allows
+    struct rlimit rl;
+    rlim_t want = (rlim_t)max_clients + NET_FD_RESERVE;
+    if (getrlimit(RLIMIT_NOFILE, &rl) == 0 && rl.rlim_cur < want) {
+        rl.rlim_cur = rl.rlim_max < want ? rl.rlim_max : want;
+        if (setrlimit(RLIMIT_NOFILE, &rl) != 0 || rl.rlim_cur < want) {
+            LOG_WARN("Open file limit %lu below %lu needed for %d clients",
+                     (unsigned long)rl.rlim_cur, (unsigned long)want, max_clients);
+        }
+    }
+
+    // listen() again on a listening socket only updates its backlog
+    if (backlog > 0 && backlog != mgr->backlog && mgr->mode == NET_MODE_TCP_SERVER) {
+        for (int i = 0; i < mgr->listener_count; i++) {
+            if (listen(mgr->listeners[i].fd, backlog) < 0) {
+                LOG_ERROR("Set listen backlog %d failed: %s", backlog, strerror(errno));
+                ret = -1;
+            }
+        }
+        mgr->backlog = backlog;
+    }
+    pthread_mutex_unlock(&mgr->mutex);
+    return ret;
+}
+
+/**
+ * Add a TCP listener with its own clients (e.g. one port per serial line)
+ * @param mgr: Pointer to NetMgr instance (NET_MODE_TCP_SERVER)
+ * @param port: TCP port
+ * @param frame_len: Stream framer of its clients (NULL = deliver data as received)
+ * @param on_rx: Callback for data received from its clients
+ * @param arg: Callback argument
+ * @return Listener id (> 0) on success, -1 on failure
+ */
+int net_mgr_add_listener(NetMgr* mgr, int port, NetFrameLenFn frame_len, NetRxCallback on_rx, void* arg)
+{
+    if (!mgr || mgr->mode != NET_MODE_TCP_SERVER || port <= 0 || port > 65535) return -1;
+
+    pthread_mutex_lock(&mgr->mutex);
+    if (mgr->listener_count >= NET_MAX_LISTENERS) {
+        pthread_mutex_unlock(&mgr->mutex);
+        LOG_ERROR("TCP listener num reach max: %d", NET_MAX_LISTENERS);
+        return -1;
+    }
+
+    NetListener* listener = &mgr->listeners[mgr->listener_count];
+    listener->frame_len = frame_len;
+    listener->on_rx = on_rx;
+    listener->rx_arg = arg;
+    if (tcp_listener_open(mgr, listener, port) != 0) {
+        pthread_mutex_unlock(&mgr->mutex);
+        return -1;
+    }
+    mgr->listener_count++;
+    pthread_mutex_unlock(&mgr->mutex);
+    return listener->id;
+}
+
+/**
+ * Hand data of a raw listener's clients over in a pipe instead of a buffer (socket -> pipe with splice())
+ * @param mgr: Pointer to NetMgr instance
+ * @param listener: Listener id of a raw listener (added without a framer)
+ * @param on_splice: Callback for data waiting in the pipe
+ * @param arg: Callback argument
+ * @return 0 on success, -1 on failure (its clients stay on on_rx)
+ */
+int net_mgr_set_splice_rx(NetMgr* mgr, int listener, NetSpliceRxCallback on_splice, void* arg)
+{
+    if (!mgr || !on_splice || listener <= 0 || listener >= mgr->listener_count ||
+        mgr->listeners[listener].frame_len) {
+        return -1;
+    }
+
+    if (mgr->rx_pipe[0] < 0 && pipe2(mgr->rx_pipe, O_NONBLOCK | O_CLOEXEC) < 0) {
+        LOG_WARN("Create receive splice pipe failed: %s, use copy path", strerror(errno));
+        mgr->rx_pipe[0] = -1;
+        mgr->rx_pipe[1] = -1;
+        return -1;
+    }
+    mgr->listeners[listener].splice_arg = arg;
+    mgr->listeners[listener].on_splice = on_splice;
+    return 0;
+}
+
+/**
+ * Dial out to a collector and keep the connection up (reverse connect)
+ * The connection is served like a client of the shared port: same framer, callback and broadcasts.
+ * The host name is resolved once here; connects are non-blocking and retried with backoff.
+ * @param mgr: Pointer to NetMgr instance
+ * @param host: Collector host name or IPv4 address
+ * @param port: Collector TCP port
+ * @return Upstream index on success, -1 on failure
+ */
+int net_mgr_add_upstream(NetMgr* mgr, const char* host, int port)
+{
+    if (!mgr || !host || port <= 0 || port > 65535) return -1;
+    if (mgr->upstream_count >= NET_MAX_UPSTREAMS) {
+        LOG_ERROR("Upstream num reach max: %d", NET_MAX_UPSTREAMS);
+        return -1;
+    }
+
+    struct addrinfo hints;
+    struct addrinfo* res = NULL;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    int rc = getaddrinfo(host, NULL, &hints, &res);
+    if (rc != 0 || !res) {
+        LOG_ERROR("Resolve upstream %s failed: %s", host, gai_strerror(rc));
+        return -1;
+    }
+
+    NetUpstream* up = &mgr->upstreams[mgr->upstream_count];
+    memset(up, 0, sizeof(NetUpstream));
+    up->addr = *(struct sockaddr_in*)res->ai_addr;
+    up->addr.sin_port = htons(port);
+    freeaddrinfo(res);
+    strncpy(up->host, host, sizeof(up->host) - 1);
+    up->port = port;
+    up->fd = -1;
+    up->handler.fd = -1;
+    up->client_idx = -1;
+    up->backoff_ms = NET_UPSTREAM_BACKOFF_MIN_MS;
+    up->mgr = mgr;
+    if (reactor_timer_init(mgr->reactor, &up->timer, upstream_timer, up) != 0) {
+        LOG_ERROR("Create upstream timer failed");
+        return -1;
+    }
+    mgr->upstream_count++;
+
+    LOG_INFO("Upstream %s:%d (%s) added", host, port, inet_ntoa(up->addr.sin_addr));
+    upstream_connect(up);
+    return mgr->upstream_count - 1;
+}
+
+/**
+ * Broadcast TCP data to the clients of one listener (never blocks, slow clients get it queued)
  * @param mgr: Pointer to NetMgr instance
+ * @param listener: Listener id (0 = port of net_mgr_init)
  * @param data: Data buffer to send
  * @param len: Length of data buffer
- * @return Number of clients successfully sent to
+ * @return Number of clients the data was sent to or queued for
  */
-int net_mgr_broadcast_tcp(NetMgr* mgr, const uint8_t* data, int len)
+int net_mgr_broadcast_tcp(NetMgr* mgr, int listener, const uint8_t* data, int len)
 {
-    if (!mgr || !data || len <= 0) return -1;
+    if (!mgr || !data || len <= 0 || listener < 0 || listener >= NET_MAX_LISTENERS) return -1;
 
+    NetBuf* shared = NULL;
     int send_count = 0;
     pthread_mutex_lock(&mgr->mutex);
-    for (int i = 0; i < MAX_CLIENT_NUM; i++) {
-        TcpClient* client = &mgr->clients[i];
-        if (!client->connected || client->fd < 0) continue;
-
+    TcpClient* next;
+    for (TcpClient* client = mgr->listeners[listener].clients; client; client = next) {
+        // Submit may close the client (and unlink it)
+        next = client->next;
         pthread_mutex_lock(&client->mutex);
-        ssize_t ret = send(client->fd, (const void*)data, len, MSG_NOSIGNAL);
-        if (ret > 0) {
-            client->tx_bytes += ret;
-            update_client_active(mgr, i);
+        if (tcp_client_submit(mgr, client, data, len, &shared) > 0) {
+            update_client_active(mgr, client->idx);
             send_count++;
-        } else if (ret < 0) {
-            if (errno != EAGAIN && errno != EWOULDBLOCK) {
-                LOG_ERROR("Send to client %d failed, close conn", i);
-                close_tcp_client(mgr, i);
+        }
+        pthread_mutex_unlock(&client->mutex);
+    }
+    pthread_mutex_unlock(&mgr->mutex);
+    net_buf_unref(shared);
+
+    return send_count;
+}
+
+/**
+ * Drop bytes left in a pipe
+ * @param pipe_fd: Read end of a non-blocking pipe
+ */
+static void net_pipe_discard(int pipe_fd)
+{
+    uint8_t buf[BUF_SIZE];
+    while (read(pipe_fd, buf, sizeof(buf)) > 0) {
+    }
+}
+
+/**
+ * Copy header + payload waiting in a pipe into a transmit buffer (pipe is not consumed)
+ * @param mgr: Pointer to NetMgr instance
+ * @param hdr: Header bytes
+ * @param hdr_len: Header length
+ * @param pipe_fd: Pipe holding the payload
+ * @param len: Payload length
+ * @return Pointer to NetBuf, NULL on failure
+ */
+static NetBuf* net_buf_from_pipe(NetMgr* mgr, const uint8_t* hdr, int hdr_len, int pipe_fd, int len)
+{
+    NetBuf* buf = net_buf_alloc(NULL, hdr_len + len);
+    if (!buf) return NULL;
+    if (hdr_len > 0) {
+        memcpy(buf->data, hdr, hdr_len);
+    }
+
+    int got = 0;
+    if (tee(pipe_fd, mgr->splice_pipe[1], len, SPLICE_F_NONBLOCK) == len) {
+        while (got < len) {
+            ssize_t ret = read(mgr->splice_pipe[0], buf->data + hdr_len + got, len - got);
+            if (ret <= 0) break;
+            got += ret;
+        }
+    }
+    net_pipe_discard(mgr->splice_pipe[0]);
+    if (got != len) {
+        LOG_ERROR("Copy spliced data failed: %s", strerror(errno));
+        net_buf_unref(buf);
+        return NULL;
+    }
+    return buf;
+}
+
+/**
+ * Send header + payload waiting in a pipe to a client without blocking
+ * The header is sent with MSG_MORE so it shares a segment with the payload, which is
+ * tee()d and spliced to the socket. Whatever the socket can't take (or everything, if
+ * data is already queued) is copied into a transmit buffer and queued.
+ * @param mgr: Pointer to NetMgr instance
+ * @param client: Pointer to TcpClient
+ * @param hdr: Header bytes (may be NULL)
+ * @param hdr_len: Header length
+ * @param pipe_fd: Pipe holding the payload (not consumed)
+ * @param len: Payload length
+ * @param copy: Buffer holding header + payload, made on first use and shared between clients
+ * @return Message length if sent or queued, 0 if dropped, -1 if the client was closed
+ */
+static int tcp_client_submit_spliced(NetMgr* mgr, TcpClient* client, const uint8_t* hdr, int hdr_len,
+                                     int pipe_fd, int len, NetBuf** copy)
+{
+    int total = hdr_len + len;
+    int sent = 0;
+
+    if (client->tx_count > 0) {
+        if (tcp_client_tx_full(mgr, client, total)) {
+            return tcp_client_tx_overflow(mgr, client);
+        }
+    } else {
+        if (hdr_len > 0) {
+            ssize_t ret = send(client->fd, hdr, hdr_len, MSG_NOSIGNAL | MSG_DONTWAIT | MSG_MORE);
+            if (ret < 0) {
+                if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                    LOG_ERROR("Send to client %d failed, close conn", client->idx);
+                    close_tcp_client(mgr, client->idx);
+                    return -1;
+                }
+                ret = 0;
+            }
+            sent = (int)ret;
+        }
+
+        if (sent == hdr_len && tee(pipe_fd, mgr->splice_pipe[1], len, SPLICE_F_NONBLOCK) == len) {
+            while (sent < total) {
+                ssize_t ret = splice(mgr->splice_pipe[0], NULL, client->fd, NULL, total - sent, SPLICE_F_NONBLOCK);
+                if (ret > 0) {
+                    sent += ret;
+                    continue;
+                }
+                if (ret < 0 && errno == EINTR) continue;
+                if (ret < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+
+                net_pipe_discard(mgr->splice_pipe[0]);
+                stats_ctr_add(&client->ctr, NET_CTR_TX_BYTES, sent);
+                LOG_ERROR("Splice to client %d failed, close conn", client->idx);
+                close_tcp_client(mgr, client->idx);
+                return -1;
             }
+            net_pipe_discard(mgr->splice_pipe[0]);
+        }
+
+        stats_ctr_add(&client->ctr, NET_CTR_TX_BYTES, sent);
+        if (sent == total) return total;
+    }
+
+    if (!*copy) {
+        *copy = net_buf_from_pipe(mgr, hdr, hdr_len, pipe_fd, len);
+    }
+    if (!*copy) {
+        if (sent > 0) {
+            close_tcp_client(mgr, client->idx);
+            return -1;
+        }
+        stats_ctr_add(&client->ctr, NET_CTR_TX_DROPS, 1);
+        return 0;
+    }
+    tcp_client_enqueue(mgr, client, *copy, sent);
+    return total;
+}
+
+/**
+ * Broadcast header + payload waiting in a pipe to the clients of one listener without
+ * copying the payload through user space (clients with queued data get a copy)
+ * @param mgr: Pointer to NetMgr instance
+ * @param listener: Listener id (0 = port of net_mgr_init)
+ * @param hdr: Header sent before the payload (may be NULL)
+ * @param hdr_len: Header length
+ * @param pipe_fd: Read end of the pipe holding the payload (left for the caller to drain)
+ * @param len: Payload length
+ * @return Number of clients successfully sent to, -1 on failure
+ */
+int net_mgr_broadcast_splice(NetMgr* mgr, int listener, const uint8_t* hdr, int hdr_len, int pipe_fd, int len)
+{
+    if (!mgr || pipe_fd < 0 || len <= 0 || listener < 0 || listener >= NET_MAX_LISTENERS) return -1;
+    if (!hdr) hdr_len = 0;
+
+    NetBuf* copy = NULL;
+    int send_count = 0;
+
+    pthread_mutex_lock(&mgr->mutex);
+    if (mgr->splice_pipe[0] < 0 && pipe2(mgr->splice_pipe, O_NONBLOCK | O_CLOEXEC) < 0) {
+        LOG_ERROR("Create splice pipe failed: %s", strerror(errno));
+        mgr->splice_pipe[0] = -1;
+        mgr->splice_pipe[1] = -1;
+        pthread_mutex_unlock(&mgr->mutex);
+        return -1;
+    }
+
+    TcpClient* next;
+    for (TcpClient* client = mgr->listeners[listener].clients; client; client = next) {
+        next = client->next;
+        pthread_mutex_lock(&client->mutex);
+        if (tcp_client_submit_spliced(mgr, client, hdr, hdr_len, pipe_fd, len, &copy) > 0) {
+            update_client_active(mgr, client->idx);
+            send_count++;
         }
         pthread_mutex_unlock(&client->mutex);
     }
     pthread_mutex_unlock(&mgr->mutex);
+    net_buf_unref(copy);
 
     return send_count;
 }
@@ -398,19 +1503,23 @@ int net_mgr_broadcast_tcp(NetMgr* mgr, const uint8_t* data, int len)
 /**
  * Send TCP data to specified client
  * @param mgr: Pointer to NetMgr instance
- * @param client_idx: Client index (0 ~ MAX_CLIENT_NUM-1)
+ * @param client_idx: Client slot
  * @param data: Data buffer to send
  * @param len: Length of data buffer
- * @return Number of bytes sent on success, -1 on failure
+ * @return len if sent or queued, 0 if dropped (queue full), -1 on failure
  */
 int net_mgr_send_tcp(NetMgr* mgr, int client_idx, const uint8_t* data, int len) {
-    if (!mgr || client_idx < 0 || client_idx >= MAX_CLIENT_NUM || !data || len <= 0) {
+    if (!mgr || !data || len <= 0) {
         return -1;
     }
 
     pthread_mutex_lock(&mgr->mutex);
 
-    TcpClient* client = &mgr->clients[client_idx];
+    TcpClient* client = tcp_client_at(mgr, client_idx);
+    if (!client) {
+        pthread_mutex_unlock(&mgr->mutex);
+        return -1;
+    }
     pthread_mutex_lock(&client->mutex);
     if (!client->connected || client->fd < 0) {
         pthread_mutex_unlock(&client->mutex);
@@ -418,14 +1527,9 @@ int net_mgr_send_tcp(NetMgr* mgr, int client_idx, const uint8_t* data, int len)
         return -1;
     }
 
-    ssize_t ret = send(client->fd, (const void*)data, len, MSG_NOSIGNAL);
-    if (ret > 0) {
-        client->tx_bytes += ret;
-    } else {
-        close(client->fd);
-        client->fd = -1;
-        client->connected = 0;
-    }
+    NetBuf* buf = NULL;
+    int ret = tcp_client_submit(mgr, client, data, len, &buf);
+    net_buf_unref(buf);
     pthread_mutex_unlock(&client->mutex);
     pthread_mutex_unlock(&mgr->mutex);
 
@@ -433,47 +1537,175 @@ int net_mgr_send_tcp(NetMgr* mgr, int client_idx, const uint8_t* data, int len)
 }
 
 /**
- * Receive TCP data from specified client
+ * Get a client slot (any thread, slots stay allocated until net_mgr_destroy)
  * @param mgr: Pointer to NetMgr instance
- * @param client_idx: Client index (0 ~ MAX_CLIENT_NUM-1)
- * @param buf: Output data buffer
- * @param len: Length of output buffer
- * @return Number of bytes received on success, 0 on timeout, -1 on failure
+ * @param client_idx: Client slot (0 ~ net_mgr_get_slot_count()-1)
+ * @return Pointer to TcpClient, NULL if the slot was never used
+ */
+TcpClient* net_mgr_get_client(NetMgr* mgr, int client_idx)
+{
+    if (!mgr) return NULL;
+    return tcp_client_at(mgr, client_idx);
+}
+
+/**
+ * Get number of client slots allocated so far (upper bound of client indexes)
+ * @param mgr: Pointer to NetMgr instance
+ * @return Slot count
+ */
+int net_mgr_get_slot_count(NetMgr* mgr)
+{
+    if (!mgr) return 0;
+    return __atomic_load_n(&mgr->slot_count, __ATOMIC_ACQUIRE);
+}
+
+/**
+ * Get connection id of a client slot
+ * @param mgr: Pointer to NetMgr instance
+ * @param client_idx: Client slot
+ * @return Connection id, 0 if the slot is not connected
+ */
+uint32_t net_mgr_get_conn_id(NetMgr* mgr, int client_idx)
+{
+    if (!mgr) return 0;
+    TcpClient* client = tcp_client_at(mgr, client_idx);
+    return client && client->connected ? client->conn_id : 0;
+}
+
+/**
+ * Get traffic counters of the current connection of a client slot (no lock on the data path)
+ * @param mgr: Pointer to NetMgr instance
+ * @param client_idx: Client slot
+ * @param counters: Output NetClientCounters
+ * @return 0 on success, -1 on invalid slot
+ */
+int net_mgr_get_client_counters(NetMgr* mgr, int client_idx, NetClientCounters* counters)
+{
+    if (!mgr || !counters) return -1;
+    TcpClient* client = tcp_client_at(mgr, client_idx);
+    if (!client) return -1;
+
+    uint64_t v[NET_CTR_NUM];
+    stats_ctr_snapshot(&client->ctr, v, NET_CTR_NUM);
+    counters->rx_bytes = v[NET_CTR_RX_BYTES];
+    counters->tx_bytes = v[NET_CTR_TX_BYTES];
+    counters->rx_frames = v[NET_CTR_RX_FRAMES];
+    counters->tx_drops = v[NET_CTR_TX_DROPS];
+    return 0;
+}
+
+/**
+ * Serve Modbus/UDP requests from the reactor (datagrams are read and answered in batches)
+ * @param mgr: Pointer to NetMgr instance
+ * @param port: UDP port (<= 0 = socket bound by net_mgr_init in NET_MODE_UDP)
+ * @param on_rx: Callback for every received datagram
+ * @param arg: Callback argument
+ * @return 0 on success, -1 on failure
  */
-int net_mgr_recv_tcp(NetMgr* mgr, int client_idx, uint8_t* buf, int len)
+int net_mgr_open_udp(NetMgr* mgr, int port, NetUdpRxCallback on_rx, void* arg)
 {
-    if (!mgr || client_idx < 0 || client_idx >= MAX_CLIENT_NUM || !buf || len <= 0) {
+    if (!mgr || !on_rx || mgr->udp_handler.fd >= 0) return -1;
+
+    if (mgr->udp_fd < 0) {
+        if (port <= 0) return -1;
+        mgr->udp_fd = udp_socket_open(port);
+        if (mgr->udp_fd < 0) return -1;
+        mgr->udp_port = port;
+    }
+
+    mgr->udp_rx = (NetUdpBatch*)malloc(sizeof(NetUdpBatch));
+    mgr->udp_tx = (NetUdpBatch*)malloc(sizeof(NetUdpBatch));
+    if (mgr->udp_rx) udp_batch_init(mgr->udp_rx);
+    if (mgr->udp_tx) udp_batch_init(mgr->udp_tx);
+
+    mgr->udp_on_rx = on_rx;
+    mgr->udp_rx_arg = arg;
+    if (!mgr->udp_rx || !mgr->udp_tx ||
+        reactor_add(mgr->reactor, &mgr->udp_handler, mgr->udp_fd, EPOLLIN, udp_read_handler, mgr) != 0) {
+        LOG_ERROR("Add UDP socket to reactor failed");
+        free(mgr->udp_rx);
+        free(mgr->udp_tx);
+        mgr->udp_rx = NULL;
+        mgr->udp_tx = NULL;
+        if (mgr->udp_fd != mgr->server_fd) {
+            close(mgr->udp_fd);
+            mgr->udp_fd = -1;
+        }
         return -1;
     }
+    reactor_set_flush_hook(mgr->reactor, udp_flush_hook, mgr);
+    LOG_INFO("Modbus/UDP listen port: %d", mgr->udp_port);
+    return 0;
+}
 
-    TcpClient* client = &mgr->clients[client_idx];
-    pthread_mutex_lock(&client->mutex);
-    if (!client->connected || client->fd < 0) {
-        pthread_mutex_unlock(&client->mutex);
+/**
+ * Queue a datagram for the next sendmmsg batch (network loop only)
+ * Queued datagrams go out when the batch is full or the current reactor event batch ends.
+ * @param mgr: Pointer to NetMgr instance
+ * @param dst: Destination address
+ * @param data: Datagram
+ * @param len: Datagram length (<= NET_UDP_MSG_MAX)
+ * @return len on success, -1 on failure
+ */
+int net_mgr_send_udp_to(NetMgr* mgr, const struct sockaddr_in* dst, const uint8_t* data, int len)
+{
+    if (!mgr || !mgr->udp_tx || !dst || !data || len <= 0 || len > NET_UDP_MSG_MAX) {
         return -1;
     }
 
-    struct timeval tv = {1, 0};
-    setsockopt(client->fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    NetUdpBatch* batch = mgr->udp_tx;
+    if (batch->count == NET_UDP_BATCH) {
+        net_mgr_flush_udp(mgr);
+    }
+    int i = batch->count++;
+    memcpy(batch->bufs[i], data, len);
+    batch->iov[i].iov_len = len;
+    batch->addrs[i] = *dst;
+    return len;
+}
 
-    ssize_t ret = recv(client->fd, (void*)buf, len - 1, MSG_NOSIGNAL);
-    if (ret > 0) {
-        client->rx_bytes += ret;
-        update_client_active(mgr, client_idx);
-        buf[ret] = '\0';
-    } else if (ret == 0) {
-        close_tcp_client(mgr, client_idx);
-        ret = -1; 
-    } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
-        ret = 0; 
-    } else {
-        close_tcp_client(mgr, client_idx);
-        ret = -1;
+/**
+ * Send every queued datagram with as few sendmmsg calls as possible (network loop only)
+ * @param mgr: Pointer to NetMgr instance
+ */
+void net_mgr_flush_udp(NetMgr* mgr)
+{
+    if (!mgr || !mgr->udp_tx || mgr->udp_tx->count == 0) return;
+
+    NetUdpBatch* batch = mgr->udp_tx;
+    int sent = 0;
+    int drops = 0;
+    int calls = 0;
+    while (sent < batch->count) {
+        int ret = sendmmsg(mgr->udp_fd, batch->msgs + sent, batch->count - sent, MSG_DONTWAIT);
+        calls++;
+        if (ret > 0) {
+            sent += ret;
+            continue;
+        }
+        if (ret < 0 && errno == EINTR) continue;
+        if (ret < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            // Socket buffer full: the rest of the batch is lost like any UDP datagram
+            drops += batch->count - sent;
+            break;
+        }
+        // The first datagram failed (e.g. unreachable peer): skip it, send the others
+        LOG_WARN("UDP send to %s:%d failed: %s", inet_ntoa(batch->addrs[sent].sin_addr),
+                 ntohs(batch->addrs[sent].sin_port), strerror(errno));
+        drops++;
+        sent++;
     }
 
-    pthread_mutex_unlock(&client->mutex);
+    StatsCtrSlot* ctr = stats_ctr_begin(&mgr->udp_ctr);
+    stats_ctr_put(ctr, NET_UDP_CTR_TX_DATAGRAMS, batch->count - drops);
+    stats_ctr_put(ctr, NET_UDP_CTR_TX_BATCHES, calls);
+    stats_ctr_put(ctr, NET_UDP_CTR_TX_DROPS, drops);
+    stats_ctr_end(ctr);
 
-    return ret;
+    for (int i = 0; i < batch->count; i++) {
+        batch->iov[i].iov_len = NET_UDP_MSG_MAX;
+    }
+    batch->count = 0;
 }
 
 /**
@@ -486,7 +1718,7 @@ int net_mgr_recv_tcp(NetMgr* mgr, int client_idx, uint8_t* buf, int len)
  * @return Number of bytes sent on success, -1 on failure
  */
 int net_mgr_send_udp(NetMgr* mgr, const char* ip, int port, const char* data, int len) {
-    if (!mgr || mgr->mode != NET_MODE_UDP || !ip || port <= 0 || !data || len <= 0) {
+    if (!mgr || mgr->udp_fd < 0 || !ip || port <= 0 || !data || len <= 0) {
         return -1;
     }
 
@@ -498,7 +1730,7 @@ int net_mgr_send_udp(NetMgr* mgr, const char* ip, int port, const char* data, in
         return -1;
     }
 
-    ssize_t ret = sendto(mgr->server_fd, data, len, 0, (struct sockaddr*)&dest_addr, sizeof(dest_addr));
+    ssize_t ret = sendto(mgr->udp_fd, data, len, 0, (struct sockaddr*)&dest_addr, sizeof(dest_addr));
     return ret;
 }
 
@@ -512,13 +1744,13 @@ int net_mgr_send_udp(NetMgr* mgr, const char* ip, int port, const char* data, in
  * @return Number of bytes received on success, -1 on failure
  */
 int net_mgr_recv_udp(NetMgr* mgr, char* buf, int len, char* src_ip, int* src_port) {
-    if (!mgr || mgr->mode != NET_MODE_UDP || !buf || len <= 0 || !src_ip || !src_port) {
+    if (!mgr || mgr->udp_fd < 0 || !buf || len <= 0 || !src_ip || !src_port) {
         return -1;
     }
 
     struct sockaddr_in src_addr;
     socklen_t src_len = sizeof(src_addr);
-    ssize_t ret = recvfrom(mgr->server_fd, buf, len - 1, 0, (struct sockaddr*)&src_addr, &src_len);
+    ssize_t ret = recvfrom(mgr->udp_fd, buf, len - 1, 0, (struct sockaddr*)&src_addr, &src_len);
     if (ret > 0) {
         buf[ret] = '\0';
         strcpy(src_ip, inet_ntoa(src_addr.sin_addr));
@@ -14,14 +14,32 @@
 #include <time.h>
 #include <errno.h>
 #include <fcntl.h>
+#include "../reactor/reactor.h"
+#include "../stats/stats.h"
 
 // Global constants for network management
 #define TCP_PORT 8888
 #define UDP_PORT 8889
-#define MAX_CLIENT_NUM 4
-#define LISTEN_BACKLOG 5
+#define NET_MAX_CLIENTS 64               // Default connected client limit (root key max_clients)
+#define NET_MAX_CLIENTS_LIMIT 4096       // Client slots the table can address
+#define LISTEN_BACKLOG 128               // Default listen backlog (root key listen_backlog)
+#define NET_MAX_LISTENERS 18             // Shared port + one per serial port
+#define NET_UDP_BATCH 32                 // Datagrams per recvmmsg / sendmmsg call
+#define NET_UDP_RX_ROUNDS 4              // recvmmsg calls per wake-up before other sockets get a turn
+#define NET_UDP_MSG_MAX 260              // Largest Modbus/UDP datagram (MBAP header + 253-byte PDU)
+#define NET_MAX_UPSTREAMS 8              // Collectors the gateway dials out to
+#define NET_UPSTREAM_CONNECT_TIMEOUT_MS 5000  // Abort a connect attempt after this long
+#define NET_UPSTREAM_BACKOFF_MIN_MS 100  // First retry delay (doubled per failure, +/- jitter)
+#define NET_UPSTREAM_BACKOFF_MAX_MS 30000  // Retry delay cap
+#define NET_UPSTREAM_STABLE_S 10         // Connection age after which a drop restarts the backoff
+#define NET_FD_RESERVE 64                // fds kept for UARTs, pipes, timers ... on top of one per client
 #define BUF_SIZE 1024
+#define NET_RX_BUF_SIZE 2048     // Per-client stream reassembly buffer
 #define CONN_TIMEOUT 30
+#define CONN_CHECK_INTERVAL 5
+#define NET_TX_QUEUE_LEN 64              // Max queued messages per client
+#define NET_TX_MAX_BYTES (64 * 1024)     // Default max queued bytes per client
+#define NET_TX_IOV_MAX 16                // Queued messages flushed per sendmsg()
 
 // Network working mode enumeration
 typedef enum {
@@ -30,37 +48,206 @@ typedef enum {
     NET_MODE_UDP
 } NetMode;
 
-// Runtime status structure for a single TCP client
+// Policy for clients whose transmit queue is full
+typedef enum {
+    NET_TX_POLICY_DROP,          // Drop the new message (counted in tx_drops)
+    NET_TX_POLICY_DISCONNECT     // Close the connection
+} NetTxPolicy;
+
+struct NetMgr;
+struct NetListener;
+struct NetUpstream;
+
+// Reference-counted transmit buffer (shared by every client it is queued on)
+typedef struct {
+    int refcnt;
+    int len;
+    uint8_t data[];
+} NetBuf;
+
+// Queued message: buffer + bytes already sent
 typedef struct {
+    NetBuf* buf;
+    int off;
+} NetTxItem;
+
+// Traffic counters of a TCP client (index into TcpClient.ctr)
+typedef enum {
+    NET_CTR_RX_BYTES,
+    NET_CTR_TX_BYTES,
+    NET_CTR_RX_FRAMES,
+    NET_CTR_TX_DROPS,            // Messages dropped by NET_TX_POLICY_DROP
+    NET_CTR_NUM
+} NetCtr;
+
+// Consistent snapshot of the counters of a TCP client
+typedef struct {
+    uint64_t rx_bytes;
+    uint64_t tx_bytes;
+    uint64_t rx_frames;
+    uint64_t tx_drops;
+} NetClientCounters;
+
+// Runtime status structure for a single TCP client
+typedef struct TcpClient {
     int fd;
+    int idx;
+    uint32_t conn_id;            // Connection generation (detects slot reuse), 0 = none
     struct sockaddr_in addr;
     int connected;
-    uint64_t rx_bytes;
-    uint64_t tx_bytes;
+    StatsCounters ctr;           // NetCtr, restarted for every connection
     pthread_mutex_t mutex;
     time_t last_active;
+    uint8_t rx_buf[NET_RX_BUF_SIZE]; // Received bytes not yet consumed as a complete frame
+    int rx_len;
+    NetTxItem tx_queue[NET_TX_QUEUE_LEN]; // Unsent data, flushed on EPOLLOUT
+    int tx_head;
+    int tx_count;
+    int tx_queued_bytes;
+    int tx_max_queued;           // High watermark of tx_queued_bytes
+    ReactorHandler handler;      // Event source in the reactor (data.ptr)
+    struct NetListener* listener; // Port the connection was accepted on
+    struct NetUpstream* upstream; // Upstream that dialed the connection (NULL = accepted)
+    struct TcpClient* prev;      // Connected clients of the same listener
+    struct TcpClient* next;
+    struct NetMgr* mgr;
 } TcpClient;
 
+// Callback for data received from a TCP client (called on the reactor thread)
+typedef void (*NetRxCallback)(struct NetMgr* mgr, int client_idx, const uint8_t* data, int len, void* arg);
+
+// Callback for raw-listener data spliced into a pipe (called on the reactor thread)
+// len bytes are waiting in pipe_fd; bytes still in the pipe when it returns are dropped
+typedef void (*NetSpliceRxCallback)(struct NetMgr* mgr, int client_idx, int pipe_fd, int len, void* arg);
+
+// Stream framer: length of the first complete frame, 0 = need more data, -1 = protocol error
+typedef int (*NetFrameLenFn)(const uint8_t* buf, int len);
+
+// Callback for a datagram received on the UDP endpoint (called on the reactor thread, src = reply address)
+typedef void (*NetUdpRxCallback)(struct NetMgr* mgr, const struct sockaddr_in* src, const uint8_t* data, int len, void* arg);
+
+// Counters of the UDP endpoint (index into NetMgr.udp_ctr)
+typedef enum {
+    NET_UDP_CTR_RX_DATAGRAMS,
+    NET_UDP_CTR_RX_BATCHES,      // recvmmsg calls that returned data
+    NET_UDP_CTR_RX_ERRORS,       // Truncated datagrams
+    NET_UDP_CTR_TX_DATAGRAMS,
+    NET_UDP_CTR_TX_BATCHES,      // sendmmsg calls
+    NET_UDP_CTR_TX_DROPS,        // Datagrams the socket refused
+    NET_UDP_CTR_NUM
+} NetUdpCtr;
+
+// TCP listen socket and the clients accepted on it
+typedef struct NetListener {
+    int id;                      // Index in NetMgr.listeners (0 = port of net_mgr_init)
+    int fd;
+    int port;
+    ReactorHandler handler;
+    NetFrameLenFn frame_len;     // NULL = deliver data as received (raw byte stream)
+    NetRxCallback on_rx;
+    void* rx_arg;
+    NetSpliceRxCallback on_splice; // Raw listeners: received data handed over in a pipe (NULL = on_rx)
+    void* splice_arg;
+    TcpClient* clients;          // Connected clients (broadcasts only walk this list)
+    int client_count;
+    struct NetMgr* mgr;
+} NetListener;
+
+// State of an upstream connection
+typedef enum {
+    NET_UPSTREAM_IDLE,           // Waiting for the retry timer
+    NET_UPSTREAM_CONNECTING,     // Non-blocking connect in progress
+    NET_UPSTREAM_CONNECTED       // Served as a client of the shared port
+} NetUpstreamState;
+
+// Collector the gateway dials out to (reverse connect, e.g. from behind NAT)
+typedef struct NetUpstream {
+    char host[64];
+    int port;
+    struct sockaddr_in addr;     // Resolved once when added
+    NetUpstreamState state;
+    int fd;                      // Socket while connecting, -1 otherwise
+    ReactorHandler handler;      // Connect completion (EPOLLOUT)
+    ReactorTimer timer;          // Retry backoff / connect timeout
+    uint32_t backoff_ms;         // Base of the next retry delay
+    int client_idx;              // Client slot while connected, -1 otherwise
+    time_t connected_at;
+    uint32_t connects;           // Successful connects
+    uint32_t failures;           // Failed connect attempts
+    struct NetMgr* mgr;
+} NetUpstream;
+
 // Manager structure for global network resource management
-typedef struct {
+typedef struct NetMgr {
     NetMode mode;
     int server_fd;
-    int client_fd;
-    TcpClient clients[MAX_CLIENT_NUM];
-    pthread_t net_thread;
-    pthread_t clean_thread;
+    TcpClient* clients[NET_MAX_CLIENTS_LIMIT];  // Allocated on first use of a slot, kept until destroy
+    int slot_count;              // Slots allocated so far (client loops stop here)
+    int free_slots[NET_MAX_CLIENTS_LIMIT];      // Stack of allocated, unused slots
+    int free_count;
+    int client_count;            // Connected clients
+    int max_clients;
+    int backlog;
+    uint32_t rejected;           // Connections refused at max_clients
+    int spare_fd;                // Reserved fd, released to refuse connections when out of fds
     pthread_mutex_t mutex;
+    Reactor* reactor;
+    NetListener listeners[NET_MAX_LISTENERS];
+    int listener_count;
+    ReactorTimer clean_timer;
+    uint32_t next_conn_id;
+    NetUpstream upstreams[NET_MAX_UPSTREAMS];
+    int upstream_count;
+    unsigned int upstream_seed;  // Retry jitter (rand_r)
+    int udp_fd;                  // Modbus/UDP endpoint (-1 = none)
+    int udp_port;
+    ReactorHandler udp_handler;
+    NetUdpRxCallback udp_on_rx;
+    void* udp_rx_arg;
+    struct NetUdpBatch* udp_rx;  // Allocated by net_mgr_open_udp
+    struct NetUdpBatch* udp_tx;  // Responses queued until the reactor batch ends (network loop only)
+    StatsCounters udp_ctr;       // NetUdpCtr
+    int splice_pipe[2];          // tee() target for spliced data
+    int rx_pipe[2];              // splice() target for data received on raw listeners (network loop only)
+    NetTxPolicy tx_policy;
+    int tx_max_bytes;
 } NetMgr;
 
-NetMgr* net_mgr_init(NetMode mode, const char* server_ip, int port);
+NetMgr* net_mgr_init(NetMode mode, const char* server_ip, int port, Reactor* reactor, NetRxCallback on_rx, void* arg);
 
 void net_mgr_destroy(NetMgr* mgr);
 
-int net_mgr_broadcast_tcp(NetMgr* mgr, const uint8_t* data, int len);
+void net_mgr_set_framer(NetMgr* mgr, NetFrameLenFn frame_len);
+
+void net_mgr_set_tx_policy(NetMgr* mgr, NetTxPolicy policy, int max_bytes);
+
+int net_mgr_set_limits(NetMgr* mgr, int max_clients, int backlog);
+
+int net_mgr_add_listener(NetMgr* mgr, int port, NetFrameLenFn frame_len, NetRxCallback on_rx, void* arg);
+
+int net_mgr_set_splice_rx(NetMgr* mgr, int listener, NetSpliceRxCallback on_splice, void* arg);
+
+int net_mgr_add_upstream(NetMgr* mgr, const char* host, int port);
+
+TcpClient* net_mgr_get_client(NetMgr* mgr, int client_idx);
+
+int net_mgr_get_slot_count(NetMgr* mgr);
+
+int net_mgr_broadcast_tcp(NetMgr* mgr, int listener, const uint8_t* data, int len);
+
+int net_mgr_broadcast_splice(NetMgr* mgr, int listener, const uint8_t* hdr, int hdr_len, int pipe_fd, int len);
 
 int net_mgr_send_tcp(NetMgr* mgr, int client_idx, const uint8_t* data, int len);
 
-int net_mgr_recv_tcp(NetMgr* mgr, int client_idx, uint8_t* buf, int len);
+uint32_t net_mgr_get_conn_id(NetMgr* mgr, int client_idx);
+
+int net_mgr_get_client_counters(NetMgr* mgr, int client_idx, NetClientCounters* counters);
+
+int net_mgr_open_udp(NetMgr* mgr, int port, NetUdpRxCallback on_rx, void* arg);
+
+int net_mgr_send_udp_to(NetMgr* mgr, const struct sockaddr_in* dst, const uint8_t* data, int len);
+
+void net_mgr_flush_udp(NetMgr* mgr);
 
 int net_mgr_send_udp(NetMgr* mgr, const char* ip, int port, const char* data, int len);
 
@@ -0,0 +1,550 @@
+#define _GNU_SOURCE
+#define LOG_MODULE LOG_MOD_CORE
+#include <stdlib.h>
+#include <sched.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+
+#include "reactor.h"
+#include "../log/log.h"
+
+/**
+ * Get monotonic time in nanoseconds
+ * @return Current CLOCK_MONOTONIC time (ns)
+ */
+uint64_t reactor_now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/**
+ * Wake-up eventfd handler (drain counter, used by reactor_stop)
+ * @param handler: Pointer to wake handler
+ * @param events: Ready event mask
+ */
+static void reactor_wake_handler(ReactorHandler* handler, uint32_t events)
+{
+    uint64_t val;
+    while (read(handler->fd, &val, sizeof(val)) > 0) {
+    }
+}
+
+/**
+ * Create reactor instance (epoll set + wake-up eventfd)
+ * @return Pointer to Reactor instance on success, NULL on failure
+ */
+Reactor* reactor_create(void)
+{
+    Reactor* r = (Reactor*)malloc(sizeof(Reactor));
+    if (!r) {
+        LOG_ERROR("Malloc Reactor failed");
+        return NULL;
+    }
+    memset(r, 0, sizeof(Reactor));
+    r->wake_fd = -1;
+    r->cpu = -1;
+
+    r->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (r->epoll_fd < 0) {
+        LOG_ERROR("Failed to create epoll: %s", strerror(errno));
+        free(r);
+        return NULL;
+    }
+
+    r->wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (r->wake_fd < 0) {
+        LOG_ERROR("Failed to create eventfd: %s", strerror(errno));
+        close(r->epoll_fd);
+        free(r);
+        return NULL;
+    }
+
+    if (reactor_add(r, &r->wake_handler, r->wake_fd, EPOLLIN | EPOLLET, reactor_wake_handler, r) != 0) {
+        close(r->wake_fd);
+        close(r->epoll_fd);
+        free(r);
+        return NULL;
+    }
+
+    r->running = 1;
+    return r;
+}
+
+/**
+ * Destroy reactor and release resources
+ * Registered handlers are owned by their modules and must be removed first
+ * @param r: Pointer to Reactor instance
+ */
+void reactor_destroy(Reactor* r)
+{
+    if (!r) return;
+    if (r->wake_fd >= 0) {
+        close(r->wake_fd);
+    }
+    if (r->epoll_fd >= 0) {
+        close(r->epoll_fd);
+    }
+    free(r);
+}
+
+/**
+ * Register fd in the reactor
+ * @param r: Pointer to Reactor instance
+ * @param h: Handler storage (must stay valid until reactor_del)
+ * @param fd: File descriptor to watch
+ * @param events: epoll event mask (EPOLLIN/EPOLLOUT/EPOLLET...)
+ * @param cb: Callback invoked when fd is ready
+ * @param ctx: User context stored in handler
+ * @return 0 on success, -1 on failure
+ */
+int reactor_add(Reactor* r, ReactorHandler* h, int fd, uint32_t events, ReactorCallback cb, void* ctx)
+{
+    if (!r || !h || fd < 0 || !cb) return -1;
+
+    h->fd = fd;
+    h->events = events;
+    h->cb = cb;
+    h->ctx = ctx;
+
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = events;
+    ev.data.ptr = h;
+    if (epoll_ctl(r->epoll_fd, EPOLL_CTL_ADD, fd, &ev) < 0) {
+        LOG_ERROR("epoll_ctl add fd %d failed: %s", fd, strerror(errno));
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * Change event mask of a registered handler
+ * @param r: Pointer to Reactor instance
+ * @param h: Registered handler
+ * @param events: New epoll event mask
+ * @return 0 on success, -1 on failure
+ */
+int reactor_mod(Reactor* r, ReactorHandler* h, uint32_t events)
+{
+    if (!r || !h || h->fd < 0) return -1;
+    if (h->events == events) return 0;
+
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = events;
+    ev.data.ptr = h;
+    if (epoll_ctl(r->epoll_fd, EPOLL_CTL_MOD, h->fd, &ev) < 0) {
+        LOG_ERROR("epoll_ctl mod fd %d failed: %s", h->fd, strerror(errno));
+        return -1;
+    }
+    h->events = events;
+    return 0;
+}
+
+/**
+ * Remove handler from the reactor (fd is not closed)
+ * @param r: Pointer to Reactor instance
+ * @param h: Registered handler
+ * @return 0 on success, -1 on failure
+ */
+int reactor_del(Reactor* r, ReactorHandler* h)
+{
+    if (!r || !h || h->fd < 0) return -1;
+    if (epoll_ctl(r->epoll_fd, EPOLL_CTL_DEL, h->fd, NULL) < 0) {
+        return -1;
+    }
+    h->fd = -1;
+    return 0;
+}
+
+/**
+ * Wait for events once and dispatch them
+ * @param r: Pointer to Reactor instance
+ * @param timeout_ms: epoll_wait timeout (-1 = infinite)
+ * @return Number of dispatched events, -1 on failure
+ */
+int reactor_run_once(Reactor* r, int timeout_ms)
+{
+    struct epoll_event events[REACTOR_MAX_EVENTS];
+
+    uint64_t t0 = reactor_now_ns();
+    int nfds = epoll_wait(r->epoll_fd, events, REACTOR_MAX_EVENTS, timeout_ms);
+    uint64_t t1 = reactor_now_ns();
+    r->stats.idle_ns += t1 - t0;
+
+    if (nfds < 0) {
+        if (errno == EINTR) return 0;
+        LOG_ERROR("epoll_wait failed: %s", strerror(errno));
+        return -1;
+    }
+    if (nfds == 0) return 0;
+
+    r->stats.wakeups++;
+    r->stats.events += nfds;
+    for (int i = 0; i < nfds; i++) {
+        ReactorHandler* h = (ReactorHandler*)events[i].data.ptr;
+        // Handler may have been removed by a previous callback in this batch
+        if (h && h->fd >= 0 && h->cb) {
+            h->cb(h, events[i].events);
+        }
+    }
+    if (r->flush_cb) {
+        r->flush_cb(r->flush_arg);
+    }
+    r->stats.busy_ns += reactor_now_ns() - t1;
+
+    return nfds;
+}
+
+/**
+ * Run event loop until reactor_stop is called
+ * @param r: Pointer to Reactor instance
+ */
+void reactor_run(Reactor* r)
+{
+    if (!r) return;
+
+    r->thread = pthread_self();
+    r->has_thread = 1;
+    r->start_ns = reactor_now_ns();
+
+    while (r->running) {
+        if (reactor_run_once(r, -1) < 0) {
+            break;
+        }
+    }
+}
+
+/**
+ * Stop event loop (async-signal-safe, callable from any thread)
+ * @param r: Pointer to Reactor instance
+ */
+void reactor_stop(Reactor* r)
+{
+    if (!r) return;
+    r->running = 0;
+
+    uint64_t val = 1;
+    ssize_t ret = write(r->wake_fd, &val, sizeof(val));
+    (void)ret;
+}
+
+/**
+ * Get event loop statistics
+ * @param r: Pointer to Reactor instance
+ * @param stats: Output ReactorStats structure
+ */
+void reactor_get_stats(Reactor* r, ReactorStats* stats)
+{
+    if (!r || !stats) return;
+
+    memcpy(stats, &r->stats, sizeof(ReactorStats));
+    stats->cpu_ns = 0;
+    stats->uptime_ns = 0;
+    if (!r->has_thread) return;
+
+    stats->uptime_ns = reactor_now_ns() - r->start_ns;
+
+    clockid_t cpu_clock;
+    struct timespec ts;
+    if (pthread_getcpuclockid(r->thread, &cpu_clock) == 0 && clock_gettime(cpu_clock, &ts) == 0) {
+        stats->cpu_ns = (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+    }
+}
+
+/**
+ * Set callback run after every batch of dispatched events (flushes output batched by the callbacks)
+ * @param r: Pointer to Reactor instance
+ * @param cb: Callback (NULL = none), runs on the loop thread
+ * @param arg: Callback argument
+ */
+void reactor_set_flush_hook(Reactor* r, void (*cb)(void* arg), void* arg)
+{
+    if (!r) return;
+    r->flush_arg = arg;
+    r->flush_cb = cb;
+}
+
+/**
+ * Entry of a reactor-owned loop thread
+ * @param arg: Pointer to Reactor instance
+ * @return NULL
+ */
+static void* reactor_thread_main(void* arg)
+{
+    reactor_run((Reactor*)arg);
+    return NULL;
+}
+
+/**
+ * Run event loop in a new thread
+ * @param r: Pointer to Reactor instance (handlers may be added before the call)
+ * @param name: Thread name (max 15 chars, may be NULL)
+ * @param cpu: CPU to pin the thread to (-1 = no affinity)
+ * @return 0 on success, -1 on failure
+ */
+int reactor_start_thread(Reactor* r, const char* name, int cpu)
+{
+    if (!r || r->own_thread) return -1;
+
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    if (cpu >= 0) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        if (pthread_attr_setaffinity_np(&attr, sizeof(set), &set) != 0) {
+            LOG_WARN("Invalid CPU %d for %s, thread is not pinned", cpu, name ? name : "reactor");
+            cpu = -1;
+        }
+    }
+
+    int ret = pthread_create(&r->thread, &attr, reactor_thread_main, r);
+    if (ret != 0 && cpu >= 0) {
+        // CPU not in the allowed set: run unpinned rather than not at all
+        LOG_WARN("Pin %s to CPU %d failed: %s", name ? name : "reactor", cpu, strerror(ret));
+        pthread_attr_destroy(&attr);
+        pthread_attr_init(&attr);
+        cpu = -1;
+        ret = pthread_create(&r->thread, &attr, reactor_thread_main, r);
+    }
+    pthread_attr_destroy(&attr);
+    if (ret != 0) {
+        LOG_ERROR("Create %s thread failed: %s", name ? name : "reactor", strerror(ret));
+        return -1;
+    }
+
+    if (name) {
+        pthread_setname_np(r->thread, name);
+    }
+    r->cpu = cpu;
+    r->own_thread = 1;
+    return 0;
+}
+
+/**
+ * Stop a loop started by reactor_start_thread and wait for its thread
+ * @param r: Pointer to Reactor instance
+ */
+void reactor_join_thread(Reactor* r)
+{
+    if (!r || !r->own_thread) return;
+    reactor_stop(r);
+    pthread_join(r->thread, NULL);
+    r->own_thread = 0;
+    r->has_thread = 0;
+}
+
+/**
+ * Queue eventfd handler: drain all items published by the producer
+ * @param handler: Pointer to queue handler
+ * @param events: Ready event mask
+ */
+static void reactor_queue_handler(ReactorHandler* handler, uint32_t events)
+{
+    ReactorQueue* q = (ReactorQueue*)handler->ctx;
+    uint64_t val;
+    while (read(handler->fd, &val, sizeof(val)) > 0) {
+    }
+
+    // Clear before draining: an item pushed after this point signals again
+    __atomic_store_n(&q->wake_pending, 0, __ATOMIC_SEQ_CST);
+
+    uint32_t head = q->head;
+    uint32_t tail;
+    while (head != (tail = __atomic_load_n(&q->tail, __ATOMIC_SEQ_CST))) {
+        while (head != tail) {
+            q->on_item(q->slots + (size_t)(head & q->mask) * q->item_size, q->arg);
+            head++;
+            __atomic_store_n(&q->head, head, __ATOMIC_RELEASE);
+        }
+    }
+}
+
+/**
+ * Create SPSC queue consumed by a reactor
+ * @param q: Queue storage (must stay valid until reactor_queue_destroy)
+ * @param consumer: Reactor whose thread runs on_item
+ * @param item_size: Size of one item (bytes)
+ * @param capacity: Number of slots (power of two)
+ * @param on_item: Callback for each item (item is only valid during the call)
+ * @param arg: Callback argument
+ * @return 0 on success, -1 on failure
+ */
+int reactor_queue_init(ReactorQueue* q, Reactor* consumer, size_t item_size, uint32_t capacity,
+                       void (*on_item)(void* item, void* arg), void* arg)
+{
+    if (!q || !consumer || !on_item || item_size == 0 || capacity == 0 || (capacity & (capacity - 1))) {
+        return -1;
+    }
+
+    memset(q, 0, sizeof(ReactorQueue));
+    q->handler.fd = -1;
+    q->slots = (uint8_t*)malloc(item_size * capacity);
+    if (!q->slots) {
+        LOG_ERROR("Malloc ReactorQueue slots failed");
+        return -1;
+    }
+    q->reactor = consumer;
+    q->item_size = item_size;
+    q->mask = capacity - 1;
+    q->on_item = on_item;
+    q->arg = arg;
+
+    int fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (fd < 0) {
+        LOG_ERROR("Failed to create eventfd: %s", strerror(errno));
+        free(q->slots);
+        q->slots = NULL;
+        return -1;
+    }
+    if (reactor_add(consumer, &q->handler, fd, EPOLLIN | EPOLLET, reactor_queue_handler, q) != 0) {
+        close(fd);
+        free(q->slots);
+        q->slots = NULL;
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * Publish item to the consumer (producer thread only)
+ * @param q: Pointer to ReactorQueue
+ * @param item: Item to copy into the queue
+ * @return 0 on success, -1 if the queue is full
+ */
+int reactor_queue_push(ReactorQueue* q, const void* item)
+{
+    uint32_t tail = q->tail;
+    if (tail - __atomic_load_n(&q->head, __ATOMIC_ACQUIRE) > q->mask) {
+        q->full++;
+        return -1;
+    }
+
+    memcpy(q->slots + (size_t)(tail & q->mask) * q->item_size, item, q->item_size);
+    __atomic_store_n(&q->tail, tail + 1, __ATOMIC_SEQ_CST);
+    q->pushed++;
+
+    if (!__atomic_exchange_n(&q->wake_pending, 1, __ATOMIC_SEQ_CST)) {
+        uint64_t val = 1;
+        ssize_t ret = write(q->handler.fd, &val, sizeof(val));
+        (void)ret;
+    }
+    return 0;
+}
+
+/**
+ * Unregister and release queue (items still queued are dropped)
+ * @param q: Pointer to ReactorQueue
+ */
+void reactor_queue_destroy(ReactorQueue* q)
+{
+    if (!q || q->handler.fd < 0) return;
+
+    int fd = q->handler.fd;
+    reactor_del(q->reactor, &q->handler);
+    close(fd);
+    q->handler.fd = -1;
+    free(q->slots);
+    q->slots = NULL;
+}
+
+/**
+ * timerfd handler (read expirations, then invoke timer callback)
+ * @param handler: Pointer to timer handler
+ * @param events: Ready event mask
+ */
+static void reactor_timer_handler(ReactorHandler* handler, uint32_t events)
+{
+    ReactorTimer* timer = (ReactorTimer*)handler->ctx;
+    uint64_t expirations = 0;
+
+    if (read(handler->fd, &expirations, sizeof(expirations)) != sizeof(expirations)) {
+        return;
+    }
+    if (timer->cb) {
+        timer->cb(timer->arg);
+    }
+}
+
+/**
+ * Create timerfd and register it in the reactor (timer is disarmed)
+ * @param r: Pointer to Reactor instance
+ * @param timer: Timer storage (must stay valid until reactor_timer_destroy)
+ * @param cb: Callback invoked on expiration
+ * @param arg: Callback argument
+ * @return 0 on success, -1 on failure
+ */
+int reactor_timer_init(Reactor* r, ReactorTimer* timer, void (*cb)(void* arg), void* arg)
+{
+    if (!r || !timer) return -1;
+
+    memset(timer, 0, sizeof(ReactorTimer));
+    timer->handler.fd = -1;
+    timer->reactor = r;
+    timer->cb = cb;
+    timer->arg = arg;
+
+    int fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (fd < 0) {
+        LOG_ERROR("Failed to create timerfd: %s", strerror(errno));
+        return -1;
+    }
+
+    if (reactor_add(r, &timer->handler, fd, EPOLLIN, reactor_timer_handler, timer) != 0) {
+        close(fd);
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * Arm timer
+ * @param timer: Pointer to ReactorTimer
+ * @param delay_us: First expiration delay (us, 0 is rounded up to 1)
+ * @param interval_us: Period after first expiration (us, 0 = one-shot)
+ * @return 0 on success, -1 on failure
+ */
+int reactor_timer_start(ReactorTimer* timer, uint64_t delay_us, uint64_t interval_us)
+{
+    if (!timer || timer->handler.fd < 0) return -1;
+    if (delay_us == 0) delay_us = 1;
+
+    struct itimerspec its;
+    its.it_value.tv_sec = delay_us / 1000000;
+    its.it_value.tv_nsec = (delay_us % 1000000) * 1000;
+    its.it_interval.tv_sec = interval_us / 1000000;
+    its.it_interval.tv_nsec = (interval_us % 1000000) * 1000;
+
+    return timerfd_settime(timer->handler.fd, 0, &its, NULL);
+}
+
+/**
+ * Disarm timer
+ * @param timer: Pointer to ReactorTimer
+ * @return 0 on success, -1 on failure
+ */
+int reactor_timer_stop(ReactorTimer* timer)
+{
+    if (!timer || timer->handler.fd < 0) return -1;
+
+    struct itimerspec its;
+    memset(&its, 0, sizeof(its));
+    return timerfd_settime(timer->handler.fd, 0, &its, NULL);
+}
+
+/**
+ * Unregister and close timer
+ * @param timer: Pointer to ReactorTimer
+ */
+void reactor_timer_destroy(ReactorTimer* timer)
+{
+    if (!timer || timer->handler.fd < 0) return;
+
+    int fd = timer->handler.fd;
+    reactor_del(timer->reactor, &timer->handler);
+    close(fd);
+    timer->handler.fd = -1;
+}
@@ -0,0 +1,121 @@
+#ifndef REACTOR_H
+#define REACTOR_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sys/epoll.h>
+
+// Global constants for the event loop
+#define REACTOR_MAX_EVENTS 64    // Max events fetched by one epoll_wait call
+
+typedef struct ReactorHandler ReactorHandler;
+
+// Event callback, invoked with the handler registered in epoll and the ready event mask
+typedef void (*ReactorCallback)(ReactorHandler* handler, uint32_t events);
+
+// Event source registered in the reactor (epoll_event.data.ptr points to it)
+struct ReactorHandler {
+    int fd;
+    uint32_t events;
+    ReactorCallback cb;
+    void* ctx;
+};
+
+// Runtime statistics of an event loop (idle CPU / wake-up rate)
+typedef struct {
+    uint64_t wakeups;            // epoll_wait returns with at least one event
+    uint64_t events;             // dispatched events
+    uint64_t idle_ns;            // time blocked in epoll_wait
+    uint64_t busy_ns;            // time spent in callbacks
+    uint64_t cpu_ns;             // CPU time consumed by the loop thread
+    uint64_t uptime_ns;          // time since reactor_run started
+} ReactorStats;
+
+// Single-threaded epoll reactor
+typedef struct {
+    int epoll_fd;
+    int wake_fd;
+    ReactorHandler wake_handler;
+    volatile int running;
+    int has_thread;
+    int own_thread;              // Loop thread created by reactor_start_thread
+    int cpu;                     // CPU the loop thread is pinned to (-1 = any)
+    pthread_t thread;
+    uint64_t start_ns;
+    ReactorStats stats;
+    void (*flush_cb)(void* arg);  // Called after every batch of dispatched events
+    void* flush_arg;
+} Reactor;
+
+// One-shot or periodic timer backed by a timerfd
+typedef struct {
+    ReactorHandler handler;
+    Reactor* reactor;
+    void (*cb)(void* arg);
+    void* arg;
+} ReactorTimer;
+
+// Lock-free single-producer / single-consumer queue drained by the consumer's reactor
+// (the producer wakes the consumer through an eventfd only if it is not already draining)
+typedef struct {
+    ReactorHandler handler;      // eventfd in the consumer reactor
+    Reactor* reactor;
+    uint8_t* slots;
+    size_t item_size;
+    uint32_t mask;               // Capacity - 1 (capacity is a power of two)
+    void (*on_item)(void* item, void* arg);
+    void* arg;
+    uint32_t head __attribute__((aligned(64)));   // Next slot to read (consumer)
+    uint32_t tail __attribute__((aligned(64)));   // Next slot to write (producer)
+    int wake_pending;            // Consumer was already signalled
+    uint64_t pushed;             // Producer-side counters
+    uint32_t full;
+} ReactorQueue;
+
+Reactor* reactor_create(void);
+
+void reactor_destroy(Reactor* r);
+
+int reactor_add(Reactor* r, ReactorHandler* h, int fd, uint32_t events, ReactorCallback cb, void* ctx);
+
+int reactor_mod(Reactor* r, ReactorHandler* h, uint32_t events);
+
+int reactor_del(Reactor* r, ReactorHandler* h);
+
+int reactor_run_once(Reactor* r, int timeout_ms);
+
+void reactor_run(Reactor* r);
+
+void reactor_stop(Reactor* r);
+
+void reactor_get_stats(Reactor* r, ReactorStats* stats);
+
+void reactor_set_flush_hook(Reactor* r, void (*cb)(void* arg), void* arg);
+
+int reactor_start_thread(Reactor* r, const char* name, int cpu);
+
+void reactor_join_thread(Reactor* r);
+
+int reactor_timer_init(Reactor* r, ReactorTimer* timer, void (*cb)(void* arg), void* arg);
+
+int reactor_timer_start(ReactorTimer* timer, uint64_t delay_us, uint64_t interval_us);
+
+int reactor_timer_stop(ReactorTimer* timer);
+
+void reactor_timer_destroy(ReactorTimer* timer);
+
+int reactor_queue_init(ReactorQueue* q, Reactor* consumer, size_t item_size, uint32_t capacity,
+                       void (*on_item)(void* item, void* arg), void* arg);
+
+int reactor_queue_push(ReactorQueue* q, const void* item);
+
+void reactor_queue_destroy(ReactorQueue* q);
+
+uint64_t reactor_now_ns(void);
+
+#endif // !REACTOR_H
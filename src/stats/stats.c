@@ -0,0 +1,505 @@
+#define _GNU_SOURCE
+#define LOG_MODULE LOG_MOD_CORE
+#include <stdlib.h>
+#include <stdarg.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include "stats.h"
+#include "../log/log.h"
+
+#define STATS_HIST_SUB_COUNT (1u << STATS_HIST_SUB_BITS)
+#define STATS_BUF_MIN 4096               // First allocation of a text buffer
+#define STATS_CONN_EVENTS (EPOLLIN | EPOLLRDHUP)
+
+__thread int t_stats_slot = -1;
+static int g_stats_threads = 0;          // Private counter slots handed out
+
+/**
+ * Get bucket of a value: exact below STATS_HIST_SUB_COUNT, then
+ * STATS_HIST_SUB_COUNT linear sub-buckets per power of two
+ * @param us: Value (us)
+ * @return Bucket index
+ */
+static int stats_hist_index(uint64_t us)
+{
+    if (us < STATS_HIST_SUB_COUNT) {
+        return (int)us;
+    }
+    int exp = 63 - __builtin_clzll(us);
+    if (exp >= STATS_HIST_MAX_EXP) {
+        return STATS_HIST_BUCKETS - 1;
+    }
+    return ((exp - STATS_HIST_SUB_BITS + 1) << STATS_HIST_SUB_BITS) +
+           (int)((us >> (exp - STATS_HIST_SUB_BITS)) & (STATS_HIST_SUB_COUNT - 1));
+}
+
+/**
+ * Get highest value counted in a bucket
+ * @param idx: Bucket index
+ * @return Upper bound of the bucket (us)
+ */
+static uint64_t stats_hist_upper(int idx)
+{
+    int group = idx >> STATS_HIST_SUB_BITS;
+    uint64_t sub = idx & (STATS_HIST_SUB_COUNT - 1);
+    if (group == 0) {
+        return sub;
+    }
+    int shift = group - 1;
+    return ((STATS_HIST_SUB_COUNT + sub) << shift) + (1ULL << shift) - 1;
+}
+
+/**
+ * Record one latency sample (safe from any thread)
+ * @param h: Pointer to StatsHist
+ * @param us: Latency (us)
+ */
+void stats_hist_record(StatsHist* h, uint64_t us)
+{
+    __atomic_fetch_add(&h->buckets[stats_hist_index(us)], 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&h->count, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&h->sum_us, us, __ATOMIC_RELAXED);
+
+    uint64_t max = __atomic_load_n(&h->max_us, __ATOMIC_RELAXED);
+    while (us > max &&
+           !__atomic_compare_exchange_n(&h->max_us, &max, us, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+}
+
+/**
+ * Clear a histogram (samples recorded concurrently may survive or get lost)
+ * @param h: Pointer to StatsHist
+ * @param owner: New sample generation
+ */
+void stats_hist_reset(StatsHist* h, uint32_t owner)
+{
+    for (int i = 0; i < STATS_HIST_BUCKETS; i++) {
+        __atomic_store_n(&h->buckets[i], 0, __ATOMIC_RELAXED);
+    }
+    __atomic_store_n(&h->count, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&h->sum_us, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&h->max_us, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&h->owner, owner, __ATOMIC_RELAXED);
+}
+
+/**
+ * Copy a histogram that may be recorded concurrently (count is recomputed from the buckets)
+ * @param h: Pointer to StatsHist
+ * @param out: Output snapshot
+ */
+void stats_hist_snapshot(const StatsHist* h, StatsHist* out)
+{
+    uint64_t count = 0;
+    for (int i = 0; i < STATS_HIST_BUCKETS; i++) {
+        out->buckets[i] = __atomic_load_n(&h->buckets[i], __ATOMIC_RELAXED);
+        count += out->buckets[i];
+    }
+    out->count = count;
+    out->sum_us = __atomic_load_n(&h->sum_us, __ATOMIC_RELAXED);
+    out->max_us = __atomic_load_n(&h->max_us, __ATOMIC_RELAXED);
+    out->owner = __atomic_load_n(&h->owner, __ATOMIC_RELAXED);
+}
+
+/**
+ * Get percentile of a snapshot
+ * @param snap: Snapshot taken with stats_hist_snapshot
+ * @param pct: Percentile (0~100)
+ * @return Upper bound of the bucket holding the percentile (us, at most the maximum), 0 if empty
+ */
+uint64_t stats_hist_percentile(const StatsHist* snap, double pct)
+{
+    if (snap->count == 0) return 0;
+
+    uint64_t rank = (uint64_t)(pct / 100.0 * snap->count + 0.5);
+    if (rank < 1) rank = 1;
+    if (rank > snap->count) rank = snap->count;
+
+    uint64_t seen = 0;
+    for (int i = 0; i < STATS_HIST_BUCKETS; i++) {
+        seen += snap->buckets[i];
+        if (seen >= rank) {
+            uint64_t v = stats_hist_upper(i);
+            return v < snap->max_us ? v : snap->max_us;
+        }
+    }
+    return snap->max_us;
+}
+
+/**
+ * Append formatted text to a buffer (grows as needed)
+ * @param buf: Pointer to StatsBuf
+ * @param fmt: printf format
+ * @return 0 on success, -1 on allocation failure
+ */
+int stats_buf_printf(StatsBuf* buf, const char* fmt, ...)
+{
+    while (1) {
+        int room = buf->cap - buf->len;
+        if (room > 0) {
+            va_list ap;
+            va_start(ap, fmt);
+            int n = vsnprintf(buf->data + buf->len, room, fmt, ap);
+            va_end(ap);
+            if (n < 0) return -1;
+            if (n < room) {
+                buf->len += n;
+                return 0;
+            }
+        }
+
+        int cap = buf->cap ? buf->cap * 2 : STATS_BUF_MIN;
+        char* data = (char*)realloc(buf->data, cap);
+        if (!data) {
+            LOG_ERROR("Realloc stats buffer (%d bytes) failed", cap);
+            return -1;
+        }
+        buf->data = data;
+        buf->cap = cap;
+    }
+}
+
+/**
+ * Release a text buffer
+ * @param buf: Pointer to StatsBuf
+ */
+void stats_buf_free(StatsBuf* buf)
+{
+    free(buf->data);
+    memset(buf, 0, sizeof(StatsBuf));
+}
+
+/**
+ * Write a histogram as a Prometheus summary in seconds (HELP / TYPE lines are up to the caller)
+ * @param buf: Pointer to StatsBuf
+ * @param name: Metric name
+ * @param labels: Label pairs without braces (e.g. uart="1")
+ * @param snap: Snapshot taken with stats_hist_snapshot
+ */
+void stats_write_summary(StatsBuf* buf, const char* name, const char* labels, const StatsHist* snap)
+{
+    static const double quantiles[] = {0.5, 0.9, 0.99, 0.999};
+
+    for (size_t i = 0; i < sizeof(quantiles) / sizeof(quantiles[0]); i++) {
+        stats_buf_printf(buf, "%s{%s,quantile=\"%g\"} %.6f\n", name, labels, quantiles[i],
+                         stats_hist_percentile(snap, quantiles[i] * 100.0) / 1e6);
+    }
+    stats_buf_printf(buf, "%s_sum{%s} %.6f\n", name, labels, snap->sum_us / 1e6);
+    stats_buf_printf(buf, "%s_count{%s} %lu\n", name, labels, snap->count);
+}
+
+/**
+ * Assign the calling thread its counter slot (first update of the thread)
+ * @return Slot index (STATS_CTR_SHARED once the private slots are used up)
+ */
+int stats_ctr_thread_slot(void)
+{
+    int idx = __atomic_fetch_add(&g_stats_threads, 1, __ATOMIC_RELAXED);
+    if (idx >= STATS_CTR_SHARED) {
+        idx = STATS_CTR_SHARED;
+        LOG_WARN("Counter slots exhausted, thread falls back to the shared slot");
+    }
+    t_stats_slot = idx;
+    return idx;
+}
+
+/**
+ * Initialize a counter block (all counters 0)
+ * @param c: Pointer to StatsCounters
+ */
+void stats_ctr_init(StatsCounters* c)
+{
+    memset(c, 0, sizeof(StatsCounters));
+}
+
+/**
+ * Read a slot whose owner may be updating it
+ * @param s: Pointer to StatsCtrSlot
+ * @param out: Output values
+ * @param n: Number of counters
+ */
+static void stats_ctr_read_slot(const StatsCtrSlot* s, uint64_t* out, int n)
+{
+    uint32_t seq;
+    do {
+        while ((seq = __atomic_load_n(&s->seq, __ATOMIC_ACQUIRE)) & 1) {
+        }
+        for (int i = 0; i < n; i++) {
+            out[i] = __atomic_load_n(&s->v[i], __ATOMIC_RELAXED);
+        }
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    } while (__atomic_load_n(&s->seq, __ATOMIC_RELAXED) != seq);
+}
+
+/**
+ * Sum the slots of every thread
+ * @param c: Pointer to StatsCounters
+ * @param out: Output totals
+ * @param n: Number of counters
+ */
+static void stats_ctr_total(const StatsCounters* c, uint64_t* out, int n)
+{
+    uint64_t v[STATS_CTR_MAX];
+    memset(out, 0, n * sizeof(uint64_t));
+    for (int t = 0; t < STATS_CTR_THREADS; t++) {
+        stats_ctr_read_slot(&c->slots[t], v, n);
+        for (int i = 0; i < n; i++) {
+            out[i] += v[i];
+        }
+    }
+}
+
+/**
+ * Get counter values since the last reset (each thread's updates are seen whole)
+ * @param c: Pointer to StatsCounters
+ * @param out: Output values
+ * @param n: Number of counters (<= STATS_CTR_MAX)
+ */
+void stats_ctr_snapshot(const StatsCounters* c, uint64_t* out, int n)
+{
+    uint64_t base[STATS_CTR_MAX];
+    stats_ctr_total(c, out, n);
+    stats_ctr_read_slot(&c->base, base, n);
+    for (int i = 0; i < n; i++) {
+        out[i] -= base[i];
+    }
+}
+
+/**
+ * Restart counters from 0 without touching the writers' slots (one resetting thread at a time)
+ * @param c: Pointer to StatsCounters
+ * @param n: Number of counters (<= STATS_CTR_MAX)
+ */
+void stats_ctr_reset(StatsCounters* c, int n)
+{
+    uint64_t total[STATS_CTR_MAX];
+    stats_ctr_total(c, total, n);
+
+    StatsCtrSlot* b = &c->base;
+    __atomic_store_n(&b->seq, b->seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    for (int i = 0; i < n; i++) {
+        __atomic_store_n(&b->v[i], total[i], __ATOMIC_RELAXED);
+    }
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    __atomic_store_n(&b->seq, b->seq + 1, __ATOMIC_RELAXED);
+}
+
+/**
+ * Close a scrape connection and free its slot
+ * @param conn: Pointer to StatsConn
+ */
+static void stats_conn_close(StatsConn* conn)
+{
+    int fd = conn->handler.fd;
+    if (fd < 0) return;
+    reactor_del(conn->srv->reactor, &conn->handler);
+    close(fd);
+    conn->handler.fd = -1;
+    conn->req_len = 0;
+    conn->sent = 0;
+    stats_buf_free(&conn->resp);
+}
+
+/**
+ * Send as much of the response as the socket takes (closes the connection when done)
+ * @param conn: Pointer to StatsConn
+ */
+static void stats_conn_flush(StatsConn* conn)
+{
+    while (conn->sent < conn->resp.len) {
+        ssize_t n = send(conn->handler.fd, conn->resp.data + conn->sent, conn->resp.len - conn->sent,
+                         MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                // Not EPOLLRDHUP: it stays set after SHUT_RD and would wake the loop on every pass
+                reactor_mod(conn->srv->reactor, &conn->handler, EPOLLOUT);
+                return;
+            }
+            break;
+        }
+        conn->sent += (int)n;
+    }
+    stats_conn_close(conn);
+}
+
+/**
+ * Build the HTTP response for a complete request header
+ * @param conn: Pointer to StatsConn
+ */
+static void stats_conn_respond(StatsConn* conn)
+{
+    StatsSrv* srv = conn->srv;
+    StatsBuf body;
+    memset(&body, 0, sizeof(body));
+
+    const char* status = "200 OK";
+    if (strncmp(conn->req, "GET / ", 6) == 0 || strncmp(conn->req, "GET /metrics ", 13) == 0) {
+        srv->render(&body, srv->arg);
+        srv->scrapes++;
+    } else {
+        status = "404 Not Found";
+        stats_buf_printf(&body, "Try GET /metrics\n");
+    }
+
+    stats_buf_printf(&conn->resp, "HTTP/1.0 %s\r\nContent-Type: text/plain; version=0.0.4\r\n"
+                     "Content-Length: %d\r\nConnection: close\r\n\r\n", status, body.len);
+    if (body.len > 0) {
+        stats_buf_printf(&conn->resp, "%.*s", body.len, body.data);
+    }
+    stats_buf_free(&body);
+
+    // Only the response is of interest from now on
+    shutdown(conn->handler.fd, SHUT_RD);
+    stats_conn_flush(conn);
+}
+
+/**
+ * Scrape connection handler (reactor callback: read request, then write response)
+ * @param handler: Pointer to connection reactor handler
+ * @param events: Ready event mask
+ */
+static void stats_conn_handler(ReactorHandler* handler, uint32_t events)
+{
+    StatsConn* conn = (StatsConn*)handler->ctx;
+
+    if (conn->resp.len > 0) {
+        if (events & (EPOLLERR | EPOLLHUP)) {
+            stats_conn_close(conn);
+        } else {
+            stats_conn_flush(conn);
+        }
+        return;
+    }
+
+    while (conn->req_len < STATS_SRV_REQ_MAX - 1) {
+        ssize_t n = recv(handler->fd, conn->req + conn->req_len, STATS_SRV_REQ_MAX - 1 - conn->req_len,
+                         MSG_DONTWAIT);
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+        if (n <= 0) {
+            stats_conn_close(conn);
+            return;
+        }
+        conn->req_len += (int)n;
+    }
+    conn->req[conn->req_len] = '\0';
+
+    if (strstr(conn->req, "\r\n\r\n") || strstr(conn->req, "\n\n") || conn->req_len >= STATS_SRV_REQ_MAX - 1) {
+        stats_conn_respond(conn);
+    }
+}
+
+/**
+ * Listen socket handler (reactor callback, accept until EAGAIN)
+ * @param handler: Pointer to listen reactor handler
+ * @param events: Ready event mask
+ */
+static void stats_accept_handler(ReactorHandler* handler, uint32_t events)
+{
+    StatsSrv* srv = (StatsSrv*)handler->ctx;
+
+    while (1) {
+        int fd = accept4(handler->fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                LOG_ERROR("Metrics accept failed: %s", strerror(errno));
+            }
+            break;
+        }
+
+        StatsConn* conn = NULL;
+        for (int i = 0; i < STATS_SRV_MAX_CONNS; i++) {
+            if (srv->conns[i].handler.fd < 0) {
+                conn = &srv->conns[i];
+                break;
+            }
+        }
+        if (!conn || reactor_add(srv->reactor, &conn->handler, fd, STATS_CONN_EVENTS,
+                                 stats_conn_handler, conn) != 0) {
+            srv->rejected++;
+            if (conn) conn->handler.fd = -1;
+            close(fd);
+            continue;
+        }
+    }
+}
+
+/**
+ * Start metrics endpoint on 127.0.0.1:port
+ * @param reactor: Event loop serving the endpoint
+ * @param port: TCP port
+ * @param render: Callback writing the metrics text
+ * @param arg: Callback argument
+ * @return Pointer to StatsSrv instance on success, NULL on failure
+ */
+StatsSrv* stats_srv_init(Reactor* reactor, int port, StatsRenderCb render, void* arg)
+{
+    if (!reactor || !render || port <= 0 || port > 65535) return NULL;
+
+    StatsSrv* srv = (StatsSrv*)malloc(sizeof(StatsSrv));
+    if (!srv) {
+        LOG_ERROR("Malloc StatsSrv failed");
+        return NULL;
+    }
+    memset(srv, 0, sizeof(StatsSrv));
+    srv->reactor = reactor;
+    srv->port = port;
+    srv->render = render;
+    srv->arg = arg;
+    srv->listen_handler.fd = -1;
+    for (int i = 0; i < STATS_SRV_MAX_CONNS; i++) {
+        srv->conns[i].handler.fd = -1;
+        srv->conns[i].srv = srv;
+    }
+
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        LOG_ERROR("Metrics socket create failed: %s", strerror(errno));
+        free(srv);
+        return NULL;
+    }
+    int opt = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(port);
+    if (bind(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0 || listen(fd, STATS_SRV_MAX_CONNS) < 0) {
+        LOG_ERROR("Metrics endpoint on port %d failed: %s", port, strerror(errno));
+        close(fd);
+        free(srv);
+        return NULL;
+    }
+    if (reactor_add(reactor, &srv->listen_handler, fd, EPOLLIN | EPOLLET, stats_accept_handler, srv) != 0) {
+        close(fd);
+        free(srv);
+        return NULL;
+    }
+
+    LOG_INFO("Metrics endpoint: http://127.0.0.1:%d/metrics", port);
+    return srv;
+}
+
+/**
+ * Stop metrics endpoint and close open scrapes
+ * @param srv: Pointer to StatsSrv instance
+ */
+void stats_srv_destroy(StatsSrv* srv)
+{
+    if (!srv) return;
+    for (int i = 0; i < STATS_SRV_MAX_CONNS; i++) {
+        stats_conn_close(&srv->conns[i]);
+    }
+    int fd = srv->listen_handler.fd;
+    if (fd >= 0) {
+        reactor_del(srv->reactor, &srv->listen_handler);
+        close(fd);
+    }
+    free(srv);
+}
@@ -0,0 +1,157 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include <stdint.h>
+#include "../reactor/reactor.h"
+
+// Global constants for latency histograms and the metrics endpoint
+#define STATS_HIST_SUB_BITS 5            // 32 linear sub-buckets per power of two (<= 3.2% error)
+#define STATS_HIST_MAX_EXP 27            // Values up to 2^27 us (~134 s), larger ones fall in the last bucket
+#define STATS_HIST_BUCKETS ((STATS_HIST_MAX_EXP - STATS_HIST_SUB_BITS + 1) << STATS_HIST_SUB_BITS)
+#define STATS_SRV_MAX_CONNS 4            // Concurrent metrics scrapes
+#define STATS_SRV_REQ_MAX 2048           // Request header bytes accepted per scrape
+#define STATS_CTR_MAX 15                 // Counters per block (one slot = two cache lines)
+#define STATS_CTR_THREADS 20             // Counter slots per block (main loop, workers, CLI ...)
+#define STATS_CTR_SHARED (STATS_CTR_THREADS - 1)  // Slot shared by threads beyond the others (atomic adds)
+
+// Log-linear latency histogram (HDR style, microseconds)
+// Any thread may record (relaxed atomics), readers work on a snapshot
+typedef struct {
+    uint64_t count;
+    uint64_t sum_us;
+    uint64_t max_us;
+    uint32_t owner;              // Generation the samples belong to (e.g. connection ID), 0 = none
+    uint32_t buckets[STATS_HIST_BUCKETS];
+} StatsHist;
+
+// Counters updated by one thread (seq is odd while the owner updates them)
+typedef struct {
+    uint32_t seq;
+    uint64_t v[STATS_CTR_MAX];
+} __attribute__((aligned(64))) StatsCtrSlot;
+
+// Block of related counters with a private slot per writer thread:
+// updates take no lock and share no cache line, readers sum seqlock-consistent slots
+typedef struct {
+    StatsCtrSlot slots[STATS_CTR_THREADS];
+    StatsCtrSlot base;           // Totals at the last reset (subtracted from snapshots)
+} StatsCounters;
+
+// Counter slot of the calling thread (-1 until its first update)
+extern __thread int t_stats_slot;
+
+// Growable text buffer (metrics rendering)
+typedef struct {
+    char* data;
+    int len;
+    int cap;
+} StatsBuf;
+
+// Append the metrics text exposition to buf (called on the reactor thread for every scrape)
+typedef void (*StatsRenderCb)(StatsBuf* buf, void* arg);
+
+// One scrape connection of the metrics endpoint
+typedef struct {
+    ReactorHandler handler;      // fd -1 = free slot
+    char req[STATS_SRV_REQ_MAX];
+    int req_len;
+    StatsBuf resp;
+    int sent;
+    struct StatsSrv* srv;
+} StatsConn;
+
+// Prometheus text endpoint on the loopback interface (served by the reactor, never blocks it)
+typedef struct StatsSrv {
+    Reactor* reactor;
+    ReactorHandler listen_handler;
+    int port;
+    StatsRenderCb render;
+    void* arg;
+    StatsConn conns[STATS_SRV_MAX_CONNS];
+    uint64_t scrapes;
+    uint32_t rejected;           // Connections refused because every slot was busy
+} StatsSrv;
+
+void stats_hist_record(StatsHist* h, uint64_t us);
+
+void stats_hist_reset(StatsHist* h, uint32_t owner);
+
+void stats_hist_snapshot(const StatsHist* h, StatsHist* out);
+
+uint64_t stats_hist_percentile(const StatsHist* snap, double pct);
+
+int stats_buf_printf(StatsBuf* buf, const char* fmt, ...) __attribute__((format(printf, 2, 3)));
+
+void stats_buf_free(StatsBuf* buf);
+
+void stats_write_summary(StatsBuf* buf, const char* name, const char* labels, const StatsHist* snap);
+
+int stats_ctr_thread_slot(void);
+
+/**
+ * Open an update of the calling thread's counters in a block
+ * @param c: Pointer to StatsCounters
+ * @return Slot to pass to stats_ctr_put / stats_ctr_end
+ */
+static inline StatsCtrSlot* stats_ctr_begin(StatsCounters* c)
+{
+    int idx = t_stats_slot >= 0 ? t_stats_slot : stats_ctr_thread_slot();
+    StatsCtrSlot* s = &c->slots[idx];
+    if (idx != STATS_CTR_SHARED) {
+        __atomic_store_n(&s->seq, s->seq + 1, __ATOMIC_RELAXED);
+        __atomic_thread_fence(__ATOMIC_RELEASE);
+    }
+    return s;
+}
+
+/**
+ * Add to one counter of an open update
+ * @param s: Slot returned by stats_ctr_begin
+ * @param idx: Counter index
+ * @param delta: Amount to add
+ */
+static inline void stats_ctr_put(StatsCtrSlot* s, int idx, uint64_t delta)
+{
+    if (t_stats_slot != STATS_CTR_SHARED) {
+        __atomic_store_n(&s->v[idx], s->v[idx] + delta, __ATOMIC_RELAXED);
+    } else {
+        __atomic_fetch_add(&s->v[idx], delta, __ATOMIC_RELAXED);
+    }
+}
+
+/**
+ * Publish an update opened with stats_ctr_begin
+ * @param s: Slot returned by stats_ctr_begin
+ */
+static inline void stats_ctr_end(StatsCtrSlot* s)
+{
+    if (t_stats_slot != STATS_CTR_SHARED) {
+        __atomic_thread_fence(__ATOMIC_RELEASE);
+        __atomic_store_n(&s->seq, s->seq + 1, __ATOMIC_RELAXED);
+    }
+}
+
+/**
+ * Add to a single counter
+ * @param c: Pointer to StatsCounters
+ * @param idx: Counter index
+ * @param delta: Amount to add
+ */
+static inline void stats_ctr_add(StatsCounters* c, int idx, uint64_t delta)
+{
+    StatsCtrSlot* s = stats_ctr_begin(c);
+    stats_ctr_put(s, idx, delta);
+    stats_ctr_end(s);
+}
+
+void stats_ctr_init(StatsCounters* c);
+
+void stats_ctr_snapshot(const StatsCounters* c, uint64_t* out, int n);
+
+void stats_ctr_reset(StatsCounters* c, int n);
+
+StatsSrv* stats_srv_init(Reactor* reactor, int port, StatsRenderCb render, void* arg);
+
+void stats_srv_destroy(StatsSrv* srv);
+
+#endif // !STATS_H
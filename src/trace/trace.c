@@ -0,0 +1,500 @@
+#define _GNU_SOURCE
+#define LOG_MODULE LOG_MOD_CORE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <arpa/inet.h>
+#include "trace.h"
+#include "../log/log.h"
+#include "../net/net_mgr.h"
+
+#define TRACE_PCAP_MAGIC 0xA1B2C3D4      // Microsecond timestamps
+#define TRACE_LINKTYPE_RAW 101           // Raw IPv4 (Modbus/TCP encapsulation)
+#define TRACE_LINKTYPE_USER0 147         // DLT_USER0 (pseudo-header + captured bytes)
+#define TRACE_MBTCP_PORT 502
+#define TRACE_STREAMS (TRACE_MAX_PORTS + NET_MAX_CLIENTS_LIMIT + 1) // Synthetic TCP streams: per UART, per client slot, UDP
+
+// One captured frame (slot of the ring)
+typedef struct {
+    uint32_t seq;                // 2n+1 while record n is written, 2n+2 once complete
+    uint8_t dir;
+    uint8_t flags;
+    uint8_t port;
+    int16_t client;              // TCP client slot (-1 = none)
+    uint32_t conn;               // TCP connection ID (0 = none)
+    uint16_t len;                // Captured bytes
+    uint16_t orig_len;
+    uint64_t ts_us;              // Wall clock (pcap timestamp)
+    uint8_t data[TRACE_FRAME_MAX];
+} TraceRecord;
+
+uint32_t g_trace_mask = 0;
+
+static TraceRecord* g_trace_ring = NULL;   /**< mmap'ed on first start, kept until trace_destroy */
+static uint64_t g_trace_head = 0;          /**< Records claimed since the last start */
+static uint64_t g_trace_bytes = 0;
+static uint64_t g_trace_truncated = 0;
+static uint64_t g_trace_cost_ns = 0;
+static uint64_t g_trace_cost_samples = 0;
+
+static FILE* g_trace_file = NULL;          /**< Replay trace being recorded (NULL = none) */
+static pthread_t g_trace_writer;
+static int g_trace_writer_stop = 0;
+static uint64_t g_trace_next = 0;          /**< Next record the recorder writes */
+static uint64_t g_trace_prev_us = 0;       /**< Timestamp of the last written record */
+static uint64_t g_trace_written = 0;
+static uint64_t g_trace_lost = 0;
+
+/**
+ * Get time from a clock in microseconds
+ * @param clock: Clock ID
+ * @return Time (us)
+ */
+static uint64_t trace_now_us(clockid_t clock)
+{
+    struct timespec ts;
+    clock_gettime(clock, &ts);
+    return (uint64_t)ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+}
+
+/**
+ * Copy a frame into the capture ring (any thread, lock-free)
+ * @param port: UART index
+ * @param dir: Direction / side (TraceDir)
+ * @param flags: TRACE_FLAG_xxx
+ * @param client: TCP client slot (-1 = none)
+ * @param conn: TCP connection ID (0 = none)
+ * @param data: Frame bytes
+ * @param len: Frame length
+ */
+void trace_record(int port, TraceDir dir, int flags, int client, uint32_t conn, const uint8_t* data, int len)
+{
+    if (!g_trace_ring || !data || len <= 0) return;
+
+    uint64_t n = __atomic_fetch_add(&g_trace_head, 1, __ATOMIC_RELAXED);
+    int sample = (n % TRACE_COST_SAMPLE) == 0;
+    struct timespec t0;
+    if (sample) clock_gettime(CLOCK_MONOTONIC, &t0);
+
+    TraceRecord* rec = &g_trace_ring[n % TRACE_RING_SLOTS];
+    __atomic_store_n(&rec->seq, (uint32_t)(2 * n + 1), __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    int copy = len > TRACE_FRAME_MAX ? TRACE_FRAME_MAX : len;
+    rec->dir = (uint8_t)dir;
+    rec->flags = (uint8_t)flags;
+    rec->port = (uint8_t)port;
+    rec->client = (int16_t)client;
+    rec->conn = conn;
+    rec->len = (uint16_t)copy;
+    rec->orig_len = (uint16_t)len;
+    rec->ts_us = trace_now_us(CLOCK_REALTIME);
+    memcpy(rec->data, data, copy);
+    __atomic_store_n(&rec->seq, (uint32_t)(2 * n + 2), __ATOMIC_RELEASE);
+
+    __atomic_fetch_add(&g_trace_bytes, len, __ATOMIC_RELAXED);
+    if (copy < len) {
+        __atomic_fetch_add(&g_trace_truncated, 1, __ATOMIC_RELAXED);
+    }
+    if (sample) {
+        struct timespec t1;
+        clock_gettime(CLOCK_MONOTONIC, &t1);
+        __atomic_fetch_add(&g_trace_cost_ns, (uint64_t)(t1.tv_sec - t0.tv_sec) * 1000000000ULL +
+                           t1.tv_nsec - t0.tv_nsec, __ATOMIC_RELAXED);
+        __atomic_fetch_add(&g_trace_cost_samples, 1, __ATOMIC_RELAXED);
+    }
+}
+
+/**
+ * Start capturing (drops frames of the previous capture)
+ * @param mask: Ports to capture (bit = UART index)
+ * @return 0 on success, -1 if the ring cannot be mapped
+ */
+int trace_start(uint32_t mask)
+{
+    if (__atomic_load_n(&g_trace_file, __ATOMIC_ACQUIRE)) {
+        LOG_WARN("Trace is being recorded to a file, stop it first");
+        return -1;
+    }
+    if (!g_trace_ring) {
+        // Populated up front: capturing never takes a page fault
+        void* ring = mmap(NULL, sizeof(TraceRecord) * TRACE_RING_SLOTS, PROT_READ | PROT_WRITE,
+                          MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1, 0);
+        if (ring == MAP_FAILED) {
+            LOG_ERROR("Map trace ring failed");
+            return -1;
+        }
+        g_trace_ring = (TraceRecord*)ring;
+    }
+
+    __atomic_store_n(&g_trace_mask, 0, __ATOMIC_RELAXED);
+    for (int i = 0; i < TRACE_RING_SLOTS; i++) {
+        __atomic_store_n(&g_trace_ring[i].seq, 0, __ATOMIC_RELAXED);
+    }
+    __atomic_store_n(&g_trace_head, 0, __ATOMIC_RELAXED);
+    g_trace_bytes = 0;
+    g_trace_truncated = 0;
+    g_trace_cost_ns = 0;
+    g_trace_cost_samples = 0;
+    __atomic_store_n(&g_trace_mask, mask, __ATOMIC_RELEASE);
+    LOG_INFO("Trace started (port mask 0x%X, %d frames)", mask, TRACE_RING_SLOTS);
+    return 0;
+}
+
+/**
+ * Stop capturing (captured frames stay available for trace_dump), finish a recording
+ */
+void trace_stop(void)
+{
+    __atomic_store_n(&g_trace_mask, 0, __ATOMIC_RELEASE);
+
+    FILE* fp = __atomic_load_n(&g_trace_file, __ATOMIC_ACQUIRE);
+    if (fp) {
+        __atomic_store_n(&g_trace_writer_stop, 1, __ATOMIC_RELEASE);
+        pthread_join(g_trace_writer, NULL);
+        fclose(fp);
+        __atomic_store_n(&g_trace_file, NULL, __ATOMIC_RELEASE);
+        LOG_INFO("Trace recording done: %lu frames written, %lu lost", g_trace_written, g_trace_lost);
+    }
+}
+
+/**
+ * Get capture statistics
+ * @param stats: Output TraceStats
+ */
+void trace_get_stats(TraceStats* stats)
+{
+    if (!stats) return;
+    uint64_t head = __atomic_load_n(&g_trace_head, __ATOMIC_RELAXED);
+    stats->mask = __atomic_load_n(&g_trace_mask, __ATOMIC_RELAXED);
+    stats->records = head;
+    stats->overwritten = head > TRACE_RING_SLOTS ? head - TRACE_RING_SLOTS : 0;
+    stats->bytes = __atomic_load_n(&g_trace_bytes, __ATOMIC_RELAXED);
+    stats->truncated = __atomic_load_n(&g_trace_truncated, __ATOMIC_RELAXED);
+    stats->cost_ns = __atomic_load_n(&g_trace_cost_ns, __ATOMIC_RELAXED);
+    stats->cost_samples = __atomic_load_n(&g_trace_cost_samples, __ATOMIC_RELAXED);
+    stats->recording = __atomic_load_n(&g_trace_file, __ATOMIC_RELAXED) != NULL;
+    stats->written = __atomic_load_n(&g_trace_written, __ATOMIC_RELAXED);
+    stats->lost = __atomic_load_n(&g_trace_lost, __ATOMIC_RELAXED);
+}
+
+/**
+ * Copy a complete record out of the ring
+ * @param n: Record number
+ * @param out: Output TraceRecord
+ * @return 0 on success, -1 if the slot holds another record or is being written
+ */
+static int trace_read(uint64_t n, TraceRecord* out)
+{
+    TraceRecord* rec = &g_trace_ring[n % TRACE_RING_SLOTS];
+    uint32_t seq = (uint32_t)(2 * n + 2);
+    if (__atomic_load_n(&rec->seq, __ATOMIC_ACQUIRE) != seq) return -1;
+    memcpy(out, rec, sizeof(TraceRecord));
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    if (__atomic_load_n(&rec->seq, __ATOMIC_RELAXED) != seq) return -1;
+    return out->len <= TRACE_FRAME_MAX ? 0 : -1;
+}
+
+/**
+ * Append the records captured since the last call to the replay trace file (recorder thread)
+ * @return Number of records written
+ */
+static int trace_file_drain(void)
+{
+    uint64_t head = __atomic_load_n(&g_trace_head, __ATOMIC_ACQUIRE);
+    uint64_t lost = 0;
+    if (head - g_trace_next > TRACE_RING_SLOTS) {
+        lost = head - TRACE_RING_SLOTS - g_trace_next;
+        g_trace_next = head - TRACE_RING_SLOTS;
+    }
+
+    int count = 0;
+    while (g_trace_next < head) {
+        uint64_t n = g_trace_next;
+        uint32_t seq = __atomic_load_n(&g_trace_ring[n % TRACE_RING_SLOTS].seq, __ATOMIC_ACQUIRE);
+        int32_t ahead = (int32_t)(seq - (uint32_t)(2 * n + 2));
+        if (ahead < 0) break;    // Claimed, still being written: next round
+
+        TraceRecord rec;
+        g_trace_next++;
+        if (ahead > 0 || trace_read(n, &rec) != 0) {
+            lost++;
+            continue;
+        }
+        TraceFileRecord hdr;
+        hdr.delta_us = rec.ts_us > g_trace_prev_us ? (uint32_t)(rec.ts_us - g_trace_prev_us) : 0;
+        hdr.len = rec.len;
+        hdr.client = rec.client;
+        hdr.port = rec.port;
+        hdr.dir = rec.dir;
+        hdr.flags = rec.flags;
+        hdr.reserved = 0;
+        hdr.conn = rec.conn;
+        fwrite(&hdr, sizeof(hdr), 1, g_trace_file);
+        fwrite(rec.data, 1, rec.len, g_trace_file);
+        g_trace_prev_us = rec.ts_us > g_trace_prev_us ? rec.ts_us : g_trace_prev_us;
+        count++;
+    }
+
+    if (count > 0) {
+        fflush(g_trace_file);
+        __atomic_store_n(&g_trace_written, g_trace_written + count, __ATOMIC_RELAXED);
+    }
+    if (lost > 0) {
+        __atomic_store_n(&g_trace_lost, g_trace_lost + lost, __ATOMIC_RELAXED);
+    }
+    return count;
+}
+
+/**
+ * Recorder thread: stream captured frames to the replay trace file
+ * @param arg: Unused
+ * @return NULL
+ */
+static void* trace_writer_loop(void* arg)
+{
+    (void)arg;
+    struct timespec idle = { 0, TRACE_WRITER_IDLE_MS * 1000000L };
+
+    for (;;) {
+        int stop = __atomic_load_n(&g_trace_writer_stop, __ATOMIC_ACQUIRE);
+        if (trace_file_drain() == 0) {
+            if (stop) break;
+            nanosleep(&idle, NULL);
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Start capturing and stream every frame to a replay trace file until trace_stop
+ * (the ring only has to hold what arrives between two TRACE_WRITER_IDLE_MS drains)
+ * @param mask: Ports to capture (bit = UART index)
+ * @param path: Output file (TraceFileHeader + TraceFileRecord stream)
+ * @return 0 on success, -1 on failure
+ */
+int trace_record_file(uint32_t mask, const char* path)
+{
+    if (!path) return -1;
+    if (__atomic_load_n(&g_trace_file, __ATOMIC_ACQUIRE)) {
+        LOG_WARN("Trace is being recorded to a file, stop it first");
+        return -1;
+    }
+
+    FILE* fp = fopen(path, "wb");
+    if (!fp) {
+        LOG_ERROR("Open trace file %s failed", path);
+        return -1;
+    }
+    TraceFileHeader hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    hdr.magic = TRACE_FILE_MAGIC;
+    hdr.version = TRACE_FILE_VERSION;
+    hdr.start_us = trace_now_us(CLOCK_REALTIME);
+    if (fwrite(&hdr, sizeof(hdr), 1, fp) != 1 || trace_start(mask) != 0) {
+        fclose(fp);
+        return -1;
+    }
+
+    g_trace_next = 0;
+    g_trace_prev_us = hdr.start_us;
+    g_trace_written = 0;
+    g_trace_lost = 0;
+    g_trace_writer_stop = 0;
+    __atomic_store_n(&g_trace_file, fp, __ATOMIC_RELEASE);
+    if (pthread_create(&g_trace_writer, NULL, trace_writer_loop, NULL) != 0) {
+        LOG_ERROR("Create trace recorder thread failed");
+        __atomic_store_n(&g_trace_mask, 0, __ATOMIC_RELEASE);
+        __atomic_store_n(&g_trace_file, NULL, __ATOMIC_RELEASE);
+        fclose(fp);
+        return -1;
+    }
+    pthread_setname_np(g_trace_writer, "trace-writer");
+    LOG_INFO("Recording trace to %s", path);
+    return 0;
+}
+
+/**
+ * Compute IPv4 header checksum
+ * @param hdr: IPv4 header (20 bytes, checksum field zero)
+ * @return Checksum (host order)
+ */
+static uint16_t trace_ip_checksum(const uint8_t* hdr)
+{
+    uint32_t sum = 0;
+    for (int i = 0; i < 20; i += 2) {
+        sum += (hdr[i] << 8) | hdr[i + 1];
+    }
+    while (sum >> 16) {
+        sum = (sum & 0xFFFF) + (sum >> 16);
+    }
+    return (uint16_t)~sum;
+}
+
+/**
+ * Build a synthetic IPv4/TCP packet carrying a captured frame as Modbus/TCP
+ * UART side: gateway 10.1.<port>.1 (master) <-> bus 10.1.<port>.2:502, RTU frames become MBAP ADUs
+ * TCP side: client 10.0.<slot / 250>.<slot % 250 + 1> <-> gateway 10.0.255.254:502 (UDP peers: one slot past the last)
+ * @param rec: Captured frame
+ * @param seqs: TCP sequence numbers per stream and direction (updated)
+ * @param tids: Last MBAP transaction ID per UART (updated)
+ * @param pkt: Output packet (40 + 7 + TRACE_FRAME_MAX bytes)
+ * @return Packet length, -1 if the frame cannot be converted
+ */
+static int trace_build_mbtcp(const TraceRecord* rec, uint32_t seqs[][2], uint16_t* tids, uint8_t* pkt)
+{
+    uint8_t* payload = pkt + 40;
+    int payload_len;
+    uint32_t gw_ip, peer_ip;
+    uint16_t gw_port, peer_port;
+    int stream, to_gw;
+
+    if (rec->dir == TRACE_UART_RX || rec->dir == TRACE_UART_TX) {
+        to_gw = rec->dir == TRACE_UART_RX;
+        stream = rec->port;
+        gw_ip = (10u << 24) | (1u << 16) | ((uint32_t)rec->port << 8) | 1;
+        peer_ip = gw_ip + 1;
+        gw_port = (uint16_t)(20000 + rec->port);
+        peer_port = TRACE_MBTCP_PORT;
+        if (rec->flags & TRACE_FLAG_RTU) {
+            // Request and response share the transaction ID, so Wireshark pairs them
+            if (rec->len < 4) return -1;
+            if (!to_gw) tids[rec->port]++;
+            int pdu_len = rec->len - 3;
+            payload[0] = tids[rec->port] >> 8;
+            payload[1] = tids[rec->port] & 0xFF;
+            payload[2] = 0;
+            payload[3] = 0;
+            payload[4] = (pdu_len + 1) >> 8;
+            payload[5] = (pdu_len + 1) & 0xFF;
+            memcpy(payload + 6, rec->data, pdu_len + 1);
+            payload_len = 7 + pdu_len;
+        } else {
+            memcpy(payload, rec->data, rec->len);
+            payload_len = rec->len;
+            peer_port = 4000 + rec->port;
+        }
+    } else {
+        int slot = rec->client >= 0 && rec->client < NET_MAX_CLIENTS_LIMIT ? rec->client : NET_MAX_CLIENTS_LIMIT;
+        to_gw = rec->dir == TRACE_TCP_RX;
+        stream = TRACE_MAX_PORTS + slot;
+        gw_ip = (10u << 24) | (0xFFu << 8) | 0xFE;
+        peer_ip = (10u << 24) | ((uint32_t)(slot / 250) << 8) | (slot % 250 + 1);
+        gw_port = TRACE_MBTCP_PORT;
+        peer_port = (uint16_t)(30000 + slot);
+        memcpy(payload, rec->data, rec->len);
+        payload_len = rec->len;
+    }
+
+    // UART side: the gateway is the Modbus client, TCP side: the server
+    int from_gw = !to_gw;
+    uint32_t src_ip = from_gw ? gw_ip : peer_ip;
+    uint32_t dst_ip = from_gw ? peer_ip : gw_ip;
+    uint16_t src_port = from_gw ? gw_port : peer_port;
+    uint16_t dst_port = from_gw ? peer_port : gw_port;
+    uint32_t* seq = &seqs[stream][from_gw];
+    uint32_t ack = seqs[stream][!from_gw];
+
+    int total = 40 + payload_len;
+    memset(pkt, 0, 40);
+    pkt[0] = 0x45;
+    pkt[2] = total >> 8;
+    pkt[3] = total & 0xFF;
+    pkt[8] = 64;
+    pkt[9] = 6;
+    *(uint32_t*)(pkt + 12) = htonl(src_ip);
+    *(uint32_t*)(pkt + 16) = htonl(dst_ip);
+    uint16_t csum = trace_ip_checksum(pkt);
+    pkt[10] = csum >> 8;
+    pkt[11] = csum & 0xFF;
+
+    uint8_t* tcp = pkt + 20;
+    *(uint16_t*)(tcp + 0) = htons(src_port);
+    *(uint16_t*)(tcp + 2) = htons(dst_port);
+    *(uint32_t*)(tcp + 4) = htonl(*seq);
+    *(uint32_t*)(tcp + 8) = htonl(ack);
+    tcp[12] = 5 << 4;
+    tcp[13] = 0x18;              // PSH | ACK
+    tcp[14] = 0xFF;
+    tcp[15] = 0xFF;
+    *seq += payload_len;
+    return total;
+}
+
+/**
+ * Write captured frames of some ports to a pcap file
+ * @param mask: Ports to write (bit = UART index)
+ * @param path: Output file
+ * @param fmt: Encapsulation (TraceFormat)
+ * @return Number of frames written, -1 on failure
+ */
+int trace_dump(uint32_t mask, const char* path, TraceFormat fmt)
+{
+    if (!g_trace_ring || !path) return -1;
+
+    FILE* fp = fopen(path, "wb");
+    if (!fp) {
+        LOG_ERROR("Open trace file %s failed", path);
+        return -1;
+    }
+
+    uint32_t ghdr[6] = { TRACE_PCAP_MAGIC, 0x00040002, 0, 0, 65535,
+                         fmt == TRACE_FMT_USER ? TRACE_LINKTYPE_USER0 : TRACE_LINKTYPE_RAW };
+    fwrite(ghdr, sizeof(ghdr), 1, fp);
+
+    static uint32_t seqs[TRACE_STREAMS][2];
+    static uint16_t tids[TRACE_MAX_PORTS];
+    memset(seqs, 0, sizeof(seqs));
+    memset(tids, 0, sizeof(tids));
+
+    uint64_t head = __atomic_load_n(&g_trace_head, __ATOMIC_ACQUIRE);
+    uint64_t first = head > TRACE_RING_SLOTS ? head - TRACE_RING_SLOTS : 0;
+    int count = 0;
+    for (uint64_t n = first; n < head; n++) {
+        TraceRecord rec;
+        if (trace_read(n, &rec) != 0 || !(mask & (1u << rec.port))) continue;
+
+        uint8_t pkt[40 + 7 + TRACE_FRAME_MAX];
+        int pkt_len, orig_len;
+        if (fmt == TRACE_FMT_USER) {
+            pkt[0] = rec.dir;
+            pkt[1] = rec.port;
+            pkt[2] = (uint16_t)rec.client >> 8;
+            pkt[3] = (uint16_t)rec.client & 0xFF;
+            memcpy(pkt + 4, rec.data, rec.len);
+            pkt_len = 4 + rec.len;
+            orig_len = 4 + rec.orig_len;
+        } else {
+            pkt_len = trace_build_mbtcp(&rec, seqs, tids, pkt);
+            if (pkt_len < 0) continue;
+            orig_len = pkt_len + (rec.orig_len - rec.len);
+        }
+
+        uint32_t phdr[4] = { (uint32_t)(rec.ts_us / 1000000), (uint32_t)(rec.ts_us % 1000000),
+                             (uint32_t)pkt_len, (uint32_t)orig_len };
+        fwrite(phdr, sizeof(phdr), 1, fp);
+        fwrite(pkt, 1, pkt_len, fp);
+        count++;
+    }
+
+    if (fclose(fp) != 0) {
+        LOG_ERROR("Write trace file %s failed", path);
+        return -1;
+    }
+    return count;
+}
+
+/**
+ * Stop capturing and unmap the ring (no hook may run any more)
+ */
+void trace_destroy(void)
+{
+    trace_stop();
+    if (g_trace_ring) {
+        munmap(g_trace_ring, sizeof(TraceRecord) * TRACE_RING_SLOTS);
+        g_trace_ring = NULL;
+    }
+}
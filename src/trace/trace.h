@@ -0,0 +1,88 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdint.h>
+
+// Global constants for the traffic capture ring
+#define TRACE_RING_SLOTS 8192            // Captured frames kept (oldest overwritten first)
+#define TRACE_FRAME_MAX 260              // Bytes kept per frame (Modbus TCP ADU max, longer raw chunks truncated)
+#define TRACE_MAX_PORTS 32               // Ports selectable in the capture mask
+#define TRACE_COST_SAMPLE 64             // Time one record in this many (capture overhead)
+#define TRACE_FILE_MAGIC 0x52545353      // "SSTR": replay trace written by trace_record_file
+#define TRACE_FILE_VERSION 2           // 2: records carry the TCP connection ID
+#define TRACE_WRITER_IDLE_MS 20          // Recorder drains the ring this often
+
+// Direction and side of a captured frame
+typedef enum {
+    TRACE_UART_RX,               // Slave -> gateway
+    TRACE_UART_TX,               // Gateway -> slave
+    TRACE_TCP_RX,                // Client -> gateway
+    TRACE_TCP_TX                 // Gateway -> client
+} TraceDir;
+
+#define TRACE_FLAG_RTU 0x01      // Payload is a Modbus RTU frame incl. CRC (else raw bytes / TCP ADU)
+
+// pcap encapsulation written by trace_dump
+typedef enum {
+    TRACE_FMT_MBTCP,             // IPv4/TCP with Modbus/TCP payload (RTU frames converted to MBAP)
+    TRACE_FMT_USER               // DLT_USER0: 4-byte pseudo-header + captured bytes
+} TraceFormat;
+
+// Replay trace file: TraceFileHeader, then a TraceFileRecord + len bytes per frame (host byte order)
+typedef struct __attribute__((packed)) {
+    uint32_t magic;              // TRACE_FILE_MAGIC
+    uint16_t version;            // TRACE_FILE_VERSION
+    uint16_t reserved;
+    uint64_t start_us;           // Wall clock when recording started
+} TraceFileHeader;
+
+typedef struct __attribute__((packed)) {
+    uint32_t delta_us;           // Time since the previous frame (the first: since start_us)
+    uint16_t len;                // Captured bytes that follow
+    int16_t client;              // TCP client slot (-1 = none)
+    uint8_t port;                // UART index
+    uint8_t dir;                 // TraceDir
+    uint8_t flags;               // TRACE_FLAG_xxx
+    uint8_t reserved;
+    uint32_t conn;               // TCP connection ID (tells apart connections reusing a slot), 0 = none
+} TraceFileRecord;
+
+// Capture statistics
+typedef struct {
+    uint32_t mask;               // Ports being captured (bit = UART index)
+    int recording;               // Frames are streamed to a replay trace file
+    uint64_t written;            // Frames written to the file
+    uint64_t lost;               // Frames overwritten before the recorder got to them
+    uint64_t records;
+    uint64_t bytes;
+    uint64_t overwritten;        // Records lost to ring wrap-around
+    uint64_t truncated;          // Frames longer than TRACE_FRAME_MAX
+    uint64_t cost_ns;            // Sampled time spent in trace_record
+    uint64_t cost_samples;
+} TraceStats;
+
+// Ports captured (0 = capture off, the only cost at every hook)
+extern uint32_t g_trace_mask;
+
+#define TRACE_FRAME(port, dir, flags, client, conn, data, len) do { \
+    if (__builtin_expect(g_trace_mask != 0, 0) && (unsigned)(port) < TRACE_MAX_PORTS && \
+        (__atomic_load_n(&g_trace_mask, __ATOMIC_RELAXED) & (1u << (port)))) { \
+        trace_record((port), (dir), (flags), (client), (conn), (data), (len)); \
+    } \
+} while (0)
+
+void trace_record(int port, TraceDir dir, int flags, int client, uint32_t conn, const uint8_t* data, int len);
+
+int trace_start(uint32_t mask);
+
+int trace_record_file(uint32_t mask, const char* path);
+
+void trace_stop(void);
+
+int trace_dump(uint32_t mask, const char* path, TraceFormat fmt);
+
+void trace_get_stats(TraceStats* stats);
+
+void trace_destroy(void);
+
+#endif // !TRACE_H
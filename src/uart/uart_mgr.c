@@ -1,5 +1,8 @@
+#define _GNU_SOURCE
+#define LOG_MODULE LOG_MOD_UART
 #include "uart_mgr.h"
 #include "../log/log.h"
+#include "../trace/trace.h"
 
 /**
  * Convert baudrate value to corresponding speed_t constant
@@ -129,9 +132,10 @@ static int uart_open_device(UartConfig *config)
  * @param config_path: Path to YAML config file
  * @param uart_configs: Output array of UartConfig
  * @param max_num: Max number of UART configs to parse
+ * @param mgr: Output gateway-wide settings (root keys server_port, metrics_port, max_clients, listen_backlog, udp_port, upstreams, poll_list; unchanged if absent), NULL to ignore them
  * @return Number of parsed configs on success, -1 on failure
  */
-static int parse_uart_config(const char* config_path, UartConfig* uart_configs, int max_num)
+static int parse_uart_config(const char* config_path, UartConfig* uart_configs, int max_num, UartMgr* mgr)
 {
     FILE* fp = fopen(config_path, "r");
     if (!fp) {
@@ -150,6 +154,10 @@ static int parse_uart_config(const char* config_path, UartConfig* uart_configs,
     int in_root_mapping = 0;   
     int in_uart_list_seq = 0; 
     int in_uart_item_map = 0;  
+    int in_upstream_seq = 0;    // Inside the upstreams section (list of "host:port")
+    int in_poll_list_seq = 0;   // Inside the poll_list section (mgr->polls, validated by the caller)
+    int in_poll_item_map = 0;
+    int skip_depth = 0;         // Nesting level inside unknown root sections
 
     if (!yaml_parser_initialize(&parser)) {
         LOG_ERROR("Failed yaml parser init");
@@ -160,6 +168,16 @@ static int parse_uart_config(const char* config_path, UartConfig* uart_configs,
 
     while (yaml_parser_parse(&parser, &event))
     {
+        if (skip_depth > 0) {
+            if (event.type == YAML_MAPPING_START_EVENT || event.type == YAML_SEQUENCE_START_EVENT) {
+                skip_depth++;
+            } else if (event.type == YAML_MAPPING_END_EVENT || event.type == YAML_SEQUENCE_END_EVENT) {
+                skip_depth--;
+            }
+            yaml_event_delete(&event);
+            continue;
+        }
+
         switch (event.type)
         {
             case YAML_STREAM_END_EVENT:
@@ -168,10 +186,23 @@ static int parse_uart_config(const char* config_path, UartConfig* uart_configs,
             case YAML_MAPPING_START_EVENT:
                 if (in_root_mapping == 0) {
                     in_root_mapping = 1;
+                } else if (in_poll_list_seq == 1) {
+                    in_poll_item_map = 1;
+                    if (mgr->poll_count < MAX_POLL_BLOCKS) {
+                        UartPollConfig* poll = &mgr->polls[mgr->poll_count];
+                        memset(poll, 0x00, sizeof(UartPollConfig));
+                        poll->slave_addr = -1;
+                        poll->func_code = MODBUS_FC_READ_HOLDING_REGISTERS;
+                        poll->cycle_ms = POLL_DEFAULT_CYCLE_MS;
+                    }
+                } else if (in_uart_list_seq == 0) {
+                    skip_depth = 1;
+                    memset(current_key, 0, sizeof(current_key));
                 } else if (in_uart_list_seq == 1) {
                     in_uart_item_map = 1;
                     if (uart_idx < max_num) {
                         memset(&uart_configs[uart_idx], 0x00, sizeof(UartConfig));
+                        uart_configs[uart_idx].worker_cpu = -1;
                     }
                 }
                 break;
@@ -183,6 +214,13 @@ static int parse_uart_config(const char* config_path, UartConfig* uart_configs,
                     if (uart_idx > max_num) {
                         LOG_WARN("Uart config num reach max: %d", max_num);
                     }
+                } else if (in_poll_item_map == 1) {
+                    in_poll_item_map = 0;
+                    if (mgr->poll_count < MAX_POLL_BLOCKS) {
+                        mgr->poll_count++;
+                    } else {
+                        LOG_WARN("Poll block num reach max: %d", MAX_POLL_BLOCKS);
+                    }
                 } else if (in_root_mapping == 1) {
                     in_root_mapping = 0;
                 }
@@ -191,13 +229,23 @@ static int parse_uart_config(const char* config_path, UartConfig* uart_configs,
             case YAML_SEQUENCE_START_EVENT:
                 if (strcmp(current_key, "uart_list") == 0) {
                     in_uart_list_seq = 1;
-                    memset(current_key, 0, sizeof(current_key));
+                } else if (strcmp(current_key, "upstreams") == 0 && in_uart_list_seq == 0) {
+                    in_upstream_seq = 1;
+                } else if (strcmp(current_key, "poll_list") == 0 && in_uart_list_seq == 0 && mgr != NULL) {
+                    in_poll_list_seq = 1;
+                } else if (in_uart_list_seq == 0) {
+                    skip_depth = 1;
                 }
+                memset(current_key, 0, sizeof(current_key));
                 break;
 
             case YAML_SEQUENCE_END_EVENT:
                 if (in_uart_list_seq == 1) {
                     in_uart_list_seq = 0;
+                } else if (in_upstream_seq == 1) {
+                    in_upstream_seq = 0;
+                } else if (in_poll_list_seq == 1) {
+                    in_poll_list_seq = 0;
                 }
                 break;
 
@@ -206,9 +254,76 @@ static int parse_uart_config(const char* config_path, UartConfig* uart_configs,
                 char *val = (char *)event.data.scalar.value;
                 if (!val || strlen(val) == 0) break;
 
-                if (in_root_mapping == 1 && in_uart_list_seq == 0) {
+                if (in_upstream_seq == 1 && mgr == NULL) {
+                    // Reload: gateway-wide settings keep their startup values
+                }
+                else if (in_upstream_seq == 1) {
+                    char* colon = strrchr(val, ':');
+                    if (!colon || colon == val || atoi(colon + 1) <= 0 || atoi(colon + 1) > 65535 ||
+                        colon - val >= (int)sizeof(mgr->upstreams[0].host)) {
+                        LOG_WARN("Invalid upstream \"%s\" (host:port), skip", val);
+                    } else if (mgr->upstream_count >= MAX_UPSTREAMS) {
+                        LOG_WARN("Upstream num reach max: %d", MAX_UPSTREAMS);
+                    } else {
+                        UartUpstreamConfig* up = &mgr->upstreams[mgr->upstream_count++];
+                        memset(up, 0, sizeof(UartUpstreamConfig));
+                        memcpy(up->host, val, colon - val);
+                        up->port = atoi(colon + 1);
+                    }
+                }
+                else if (in_poll_list_seq == 1 && in_poll_item_map == 1 && strlen(current_key) == 0) {
                     strncpy(current_key, val, sizeof(current_key)-1);
                 }
+                else if (in_poll_list_seq == 1 && in_poll_item_map == 1 && strlen(current_key) > 0) {
+                    if (mgr->poll_count >= MAX_POLL_BLOCKS) {
+                        memset(current_key,0,sizeof(current_key));
+                        break;
+                    }
+                    UartPollConfig *poll = &mgr->polls[mgr->poll_count];
+
+                    if (strcmp(current_key, "uart") == 0) {
+                        poll->uart_idx = atoi(val);
+                    }
+                    else if (strcmp(current_key, "slave") == 0) {
+                        poll->slave_addr = atoi(val);
+                    }
+                    else if (strcmp(current_key, "func") == 0) {
+                        poll->func_code = (int)strtol(val, NULL, 0);
+                    }
+                    else if (strcmp(current_key, "start") == 0) {
+                        poll->start = atoi(val);
+                    }
+                    else if (strcmp(current_key, "quantity") == 0) {
+                        poll->quantity = atoi(val);
+                    }
+                    else if (strcmp(current_key, "cycle_ms") == 0) {
+                        poll->cycle_ms = atoi(val);
+                    }
+                    else if (strcmp(current_key, "priority") == 0) {
+                        poll->priority = atoi(val);
+                    }
+                    memset(current_key, 0, sizeof(current_key));
+                }
+                else if (in_root_mapping == 1 && in_uart_list_seq == 0) {
+                    if (strlen(current_key) == 0) {
+                        strncpy(current_key, val, sizeof(current_key)-1);
+                    } else {
+                        if (mgr == NULL) {
+                            // Reload: gateway-wide settings keep their startup values
+                        } else if (strcmp(current_key, "server_port") == 0) {
+                            mgr->server_port = atoi(val);
+                        } else if (strcmp(current_key, "metrics_port") == 0) {
+                            mgr->metrics_port = atoi(val);
+                        } else if (strcmp(current_key, "max_clients") == 0) {
+                            mgr->max_clients = atoi(val);
+                        } else if (strcmp(current_key, "listen_backlog") == 0) {
+                            mgr->listen_backlog = atoi(val);
+                        } else if (strcmp(current_key, "udp_port") == 0) {
+                            mgr->udp_port = atoi(val);
+                        }
+                        memset(current_key, 0, sizeof(current_key));   // Scalar value of another root key
+                    }
+                }
                 else if (in_uart_list_seq == 1 && in_uart_item_map == 1 && strlen(current_key) == 0) {
                     strncpy(current_key, val, sizeof(current_key)-1);
                 }
@@ -246,6 +361,33 @@ static int parse_uart_config(const char* config_path, UartConfig* uart_configs,
                     else if (strcmp(current_key, "modbus_enable") == 0) {
                         cfg->modbus_enable = (strcmp(val, "true") == 0) ? 1 : 0;
                     }
+                    else if (strcmp(current_key, "resp_timeout_ms") == 0) {
+                        cfg->resp_timeout_ms = atoi(val);
+                    }
+                    else if (strcmp(current_key, "splice") == 0) {
+                        cfg->splice_enable = (strcmp(val, "true") == 0) ? 1 : 0;
+                    }
+                    else if (strcmp(current_key, "cache_ttl_ms") == 0) {
+                        cfg->cache_ttl_ms = atoi(val);
+                    }
+                    else if (strcmp(current_key, "merge_max_regs") == 0) {
+                        cfg->merge_max_regs = atoi(val);
+                    }
+                    else if (strcmp(current_key, "merge_gap") == 0) {
+                        cfg->merge_gap = atoi(val);
+                    }
+                    else if (strcmp(current_key, "worker") == 0) {
+                        cfg->worker = atoi(val);
+                    }
+                    else if (strcmp(current_key, "worker_cpu") == 0) {
+                        cfg->worker_cpu = atoi(val);
+                    }
+                    else if (strcmp(current_key, "queue_depth") == 0) {
+                        cfg->queue_depth = atoi(val);
+                    }
+                    else if (strcmp(current_key, "tcp_port") == 0) {
+                        cfg->tcp_port = atoi(val);
+                    }
                     memset(current_key, 0, sizeof(current_key));
                 }
                 break;
@@ -271,41 +413,300 @@ parse_done:
 }
 
 /**
- * Handle UART read events (epoll callback)
- * @param mgr: Pointer to UartMgr instance
- * @param fd: UART device file descriptor
+ * Deliver a validated RTU frame to the UART manager callback
+ * @param frame: RTU frame incl. CRC
+ * @param len: Frame length
+ * @param arg: Pointer to UartDev
  */
-static void uart_read_handler(UartMgr* mgr, int fd)
+static void uart_rtu_frame_handler(const uint8_t* frame, int len, void* arg)
 {
-    if (!mgr) return;
+    UartDev* uart = (UartDev*)arg;
+    UartMgr* mgr = uart->mgr;
 
-    UartDev* uart = NULL;
-    for(int i = 0; i < MAX_UART_NUM; i++) {
-        if(mgr->uarts[i].fd == fd) {
-            uart = &mgr->uarts[i];
-            break;
+    TRACE_FRAME(uart->config.idx, TRACE_UART_RX, TRACE_FLAG_RTU, -1, 0, frame, len);
+    if (mgr->on_rx) {
+        mgr->on_rx(uart, frame, len, mgr->rx_arg);
+    }
+}
+
+/**
+ * t3.5 silence timer callback (end pending RTU frame)
+ * @param arg: Pointer to UartDev
+ */
+static void uart_rtu_timer_handler(void* arg)
+{
+    UartDev* uart = (UartDev*)arg;
+    modbus_rtu_deframer_flush(&uart->rtu, uart_rtu_frame_handler, uart);
+}
+
+/**
+ * Close splice pipe of a UART (port falls back to the copy path)
+ * @param uart: Pointer to UartDev
+ */
+static void uart_close_pipe(UartDev* uart)
+{
+    for (int i = 0; i < 2; i++) {
+        if (uart->pipe_fd[i] >= 0) {
+            close(uart->pipe_fd[i]);
+            uart->pipe_fd[i] = -1;
+        }
+    }
+}
+
+/**
+ * Drop bytes the splice consumer left in the pipe
+ * @param uart: Pointer to UartDev
+ */
+static void uart_pipe_discard(UartDev* uart)
+{
+    uint8_t buf[BUF_SIZE];
+    while (read(uart->pipe_fd[0], buf, sizeof(buf)) > 0) {
+    }
+}
+
+/**
+ * Move raw-port RX data into the splice pipe and hand it to the consumer (drain fd until EAGAIN)
+ * @param uart: Pointer to UartDev
+ * @return 0 if the fd was drained, -1 if splice is not supported on the device
+ */
+static int uart_splice_rx(UartDev* uart)
+{
+    UartMgr* mgr = uart->mgr;
+
+    while (uart->fd >= 0) {
+        ssize_t len = splice(uart->fd, NULL, uart->pipe_fd[1], NULL, BUF_SIZE, SPLICE_F_NONBLOCK);
+        if (len > 0) {
+            StatsCtrSlot* ctr = stats_ctr_begin(&uart->ctr);
+            stats_ctr_put(ctr, UART_CTR_RX_BYTES, len);
+            stats_ctr_put(ctr, UART_CTR_RX_SPLICE_BYTES, len);
+            stats_ctr_end(ctr);
+            mgr->on_splice(uart, uart->pipe_fd[0], (int)len, mgr->splice_arg);
+            uart_pipe_discard(uart);
+            continue;
+        }
+        if (len < 0 && errno == EINTR) continue;
+        if (len < 0 && (errno == EINVAL || errno == ENOSYS)) {
+            LOG_WARN("%s does not support splice, use copy path", uart->config.dev_path);
+            uart_close_pipe(uart);
+            return -1;
+        }
+        if (len < 0 && errno != EAGAIN && errno != EWOULDBLOCK) {
+            stats_ctr_add(&uart->ctr, UART_CTR_ERRORS, 1);
+            LOG_ERROR("%s splice error: %s", uart->config.dev_path, strerror(errno));
+        }
+        break;
+    }
+    return 0;
+}
+
+/**
+ * Handle UART read events (reactor callback, drain fd until EAGAIN)
+ * @param handler: Pointer to UART reactor handler
+ * @param events: Ready event mask
+ */
+static void uart_read_handler(ReactorHandler* handler, uint32_t events)
+{
+    UartDev* uart = (UartDev*)handler->ctx;
+    UartMgr* mgr = uart->mgr;
+    uint8_t buf[BUF_SIZE];
+
+    if (uart->pipe_fd[0] >= 0 && mgr->on_splice && uart_splice_rx(uart) == 0) {
+        return;
+    }
+
+    while (uart->fd >= 0) {
+        ssize_t len = read(uart->fd, buf, sizeof(buf));
+        if (len > 0) {
+            StatsCtrSlot* ctr = stats_ctr_begin(&uart->ctr);
+            stats_ctr_put(ctr, UART_CTR_RX_BYTES, len);
+            if (!uart->config.modbus_enable && mgr->on_rx) {
+                stats_ctr_put(ctr, UART_CTR_RX_COPY_BYTES, len);
+            }
+            stats_ctr_end(ctr);
+
+            if (uart->config.modbus_enable) {
+                modbus_rtu_deframer_feed(&uart->rtu, buf, (int)len, reactor_now_ns(),
+                                         uart_rtu_frame_handler, uart);
+            } else if (mgr->on_rx) {
+                TRACE_FRAME(uart->config.idx, TRACE_UART_RX, 0, -1, 0, buf, (int)len);
+                mgr->on_rx(uart, buf, (int)len, mgr->rx_arg);
+            }
+            continue;
+        }
+        if (len < 0 && errno == EINTR) continue;
+        if (len < 0 && errno != EAGAIN && errno != EWOULDBLOCK) {
+            stats_ctr_add(&uart->ctr, UART_CTR_ERRORS, 1);
+            LOG_ERROR("%s read error: %s", uart->config.dev_path, strerror(errno));
         }
+        break;
     }
-    if(!uart) return;
 
-    char buf[BUF_SIZE] = {0};
-    ssize_t len = read(fd, buf, BUF_SIZE - 1);
-    if(len > 0) {
-        buf[len] = '\0';
-        uart->rx_bytes += len;
-        LOG_INFO("%s Read %ld bytes: %s", uart->config.dev_path, len, buf);
-    } else if (len < 0 && errno != EAGAIN) {
-        uart->err_count++;
-        LOG_ERROR("UART read error");
+    // Partial frame: end it after t3.5 of silence
+    if (uart->config.modbus_enable && (uart->rtu.len > 0 || uart->rtu.overrun)) {
+        reactor_timer_start(&uart->rtu_timer, uart->rtu.t35_us, 0);
     }
 }
 
+/**
+ * Copy the settings that can change while the port is open
+ * @param dst: Destination config
+ * @param src: Source config
+ */
+static void uart_config_copy_live(UartConfig* dst, const UartConfig* src)
+{
+    dst->baudrate = src->baudrate;
+    dst->databit = src->databit;
+    dst->stopbit = src->stopbit;
+    dst->parity = src->parity;
+    dst->flow_ctrl = src->flow_ctrl;
+    dst->resp_timeout_ms = src->resp_timeout_ms;
+    dst->merge_max_regs = src->merge_max_regs;
+    dst->merge_gap = src->merge_gap;
+}
+
+/**
+ * Check whether two configs differ in a setting that can change while the port is open
+ * @param a: First config
+ * @param b: Second config
+ * @return 1 if any live setting differs, 0 otherwise
+ */
+static int uart_config_live_differs(const UartConfig* a, const UartConfig* b)
+{
+    return a->baudrate != b->baudrate || a->databit != b->databit || a->stopbit != b->stopbit ||
+           a->parity != b->parity || a->flow_ctrl != b->flow_ctrl ||
+           a->resp_timeout_ms != b->resp_timeout_ms || a->merge_max_regs != b->merge_max_regs ||
+           a->merge_gap != b->merge_gap;
+}
+
+/**
+ * Check whether two configs differ in a setting that is fixed once the port is open
+ * (device, threading, listeners and the Modbus gateway state are set up at startup)
+ * @param a: First config
+ * @param b: Second config
+ * @return 1 if any such setting differs, 0 otherwise
+ */
+static int uart_config_static_differs(const UartConfig* a, const UartConfig* b)
+{
+    return a->idx != b->idx || strcmp(a->dev_path, b->dev_path) != 0 || a->enable != b->enable ||
+           a->modbus_enable != b->modbus_enable || a->splice_enable != b->splice_enable ||
+           a->cache_ttl_ms != b->cache_ttl_ms || a->worker != b->worker ||
+           a->worker_cpu != b->worker_cpu || a->queue_depth != b->queue_depth || a->tcp_port != b->tcp_port;
+}
+
+/**
+ * Publish the live fields of a new config to threads reading it with uart_mgr_get_config
+ * Only the owning thread writes uart->config, so it keeps reading the fields directly
+ * @param uart: Pointer to UartDev
+ * @param config: Applied configuration
+ */
+static void uart_config_publish(UartDev* uart, const UartConfig* config)
+{
+    __atomic_store_n(&uart->config_seq, uart->config_seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    uart_config_copy_live(&uart->config, config);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    __atomic_store_n(&uart->config_seq, uart->config_seq + 1, __ATOMIC_RELAXED);
+}
+
+/**
+ * Apply a pending config once the port is quiet (timer callback on the owning thread)
+ * Waits for the port's user to hold its queue and for the output queue to drain, re-polling
+ * every UART_RECONFIG_POLL_US instead of blocking the loop the other ports share
+ * @param arg: Pointer to UartDev
+ */
+static void uart_config_timer_handler(void* arg)
+{
+    UartDev* uart = (UartDev*)arg;
+    UartMgr* mgr = uart->mgr;
+
+    pthread_mutex_lock(&mgr->config_mutex);
+    int pending = uart->config_pending;
+    pthread_mutex_unlock(&mgr->config_mutex);
+    if (!pending || uart->fd < 0) return;
+
+    uint64_t now = reactor_now_ns();
+    if (uart->hold_start_ns == 0) {
+        uart->hold_start_ns = now;
+    }
+    int idle = 1;
+    if (mgr->on_reconfig) {
+        idle = mgr->on_reconfig(uart, UART_RECONFIG_HOLD, mgr->reconfig_arg);
+    }
+    int outq = 0;
+    if (idle && ioctl(uart->fd, TIOCOUTQ, &outq) < 0) {
+        outq = 0;
+    }
+    if ((!idle || outq > 0) && now - uart->hold_start_ns < UART_RECONFIG_MAX_WAIT_MS * 1000000ULL) {
+        reactor_timer_start(&uart->config_timer, UART_RECONFIG_POLL_US, 0);
+        return;
+    }
+    if (!idle) {
+        LOG_WARN("UART %d still busy after %d ms, reconfigure anyway", uart->config.idx, UART_RECONFIG_MAX_WAIT_MS);
+    }
+
+    // Latest request wins if several arrived while the port was held
+    UartConfig config;
+    pthread_mutex_lock(&mgr->config_mutex);
+    config = uart->config_next;
+    uart->config_pending = 0;
+    pthread_mutex_unlock(&mgr->config_mutex);
+
+    tcdrain(uart->fd);
+    if (uart_set_attr(uart->fd, &config) != 0) {
+        stats_ctr_add(&uart->ctr, UART_CTR_ERRORS, 1);
+        LOG_ERROR("UART %d reconfigure failed, keep old settings", uart->config.idx);
+    } else {
+        if (uart->config.modbus_enable) {
+            reactor_timer_stop(&uart->rtu_timer);
+            modbus_rtu_deframer_set_baud(&uart->rtu, config.baudrate);
+        }
+        uart_config_publish(uart, &config);
+        LOG_INFO("UART %d reconfigured in %.1f ms (baud:%d, data:%d, stop:%d, parity:%c, flow:%d)",
+                 uart->config.idx, (reactor_now_ns() - uart->hold_start_ns) / 1e6, config.baudrate,
+                 config.databit, config.stopbit, config.parity, config.flow_ctrl);
+    }
+    uart->hold_start_ns = 0;
+
+    if (mgr->on_reconfig) {
+        mgr->on_reconfig(uart, UART_RECONFIG_RELEASE, mgr->reconfig_arg);
+    }
+}
+
+/**
+ * Get event loop a UART is served by (creates the worker loop of its thread group)
+ * Only Modbus buses move to workers, raw ports stay on the main loop with the sockets
+ * @param mgr: Pointer to UartMgr instance
+ * @param uart: Pointer to UartDev
+ * @return Worker reactor, or the main reactor on failure / worker 0
+ */
+static Reactor* uart_worker_reactor(UartMgr* mgr, UartDev* uart)
+{
+    int group = uart->config.worker;
+    if (group <= 0) return mgr->reactor;
+    if (group > MAX_UART_NUM || !uart->config.modbus_enable) {
+        LOG_WARN("UART %d: worker %d ignored (raw port or out of range)", uart->config.idx, group);
+        return mgr->reactor;
+    }
+
+    if (!mgr->workers[group]) {
+        mgr->workers[group] = reactor_create();
+        if (!mgr->workers[group]) {
+            LOG_WARN("Create worker %d failed, UART %d stays on the main loop", group, uart->config.idx);
+            return mgr->reactor;
+        }
+    }
+    return mgr->workers[group];
+}
+
 /**
  * Initialize UART manager
  * @param config_path: Path to YAML config file
+ * @param reactor: Event loop that owns the UART fds
+ * @param on_rx: Callback for received data
+ * @param arg: Callback argument
  * @return Pointer to UartMgr instance on success, NULL on failure
  */
-UartMgr* uart_mgr_init(const char* config_path)
+UartMgr* uart_mgr_init(const char* config_path, Reactor* reactor, UartRxCallback on_rx, void* arg)
 {
     UartMgr* mgr = (UartMgr*)malloc(sizeof(UartMgr));
     if(!mgr) {
@@ -313,14 +714,49 @@ UartMgr* uart_mgr_init(const char* config_path)
         return NULL;
     }
     memset(mgr, 0, sizeof(UartMgr));
+    mgr->reactor = reactor;
+    mgr->on_rx = on_rx;
+    mgr->rx_arg = arg;
+    mgr->watch_handler.fd = -1;
+    strncpy(mgr->config_path, config_path, sizeof(mgr->config_path) - 1);
+    for (int i = 0; i < MAX_UART_NUM; i++) {
+        mgr->uarts[i].fd = -1;
+        mgr->uarts[i].handler.fd = -1;
+        mgr->uarts[i].rtu_timer.handler.fd = -1;
+        mgr->uarts[i].config_timer.handler.fd = -1;
+        mgr->uarts[i].pipe_fd[0] = -1;
+        mgr->uarts[i].pipe_fd[1] = -1;
+        mgr->uarts[i].reactor = reactor;
+        mgr->uarts[i].mgr = mgr;
+    }
 
     UartConfig temp_configs[MAX_UART_NUM] = {0};
-    int uart_count = parse_uart_config(config_path, temp_configs, MAX_UART_NUM);
+    int uart_count = parse_uart_config(config_path, temp_configs, MAX_UART_NUM, mgr);
     if(uart_count <= 0) {
         LOG_ERROR("Parse uart config failed, count: %d", uart_count);
         free(mgr);
         return NULL;
     }
+    pthread_mutex_init(&mgr->config_mutex, NULL);
+
+    // Parsed blocks are compacted to the valid ones
+    int poll_count = mgr->poll_count;
+    mgr->poll_count = 0;
+    for (int i = 0; i < poll_count; i++) {
+        UartPollConfig* poll = &mgr->polls[i];
+        if (poll->uart_idx < 0 || poll->uart_idx >= MAX_UART_NUM ||
+            poll->quantity <= 0 || poll->quantity > MODBUS_MAX_READ_REGS || poll->start < 0 || poll->start + poll->quantity > 0x10000 || poll->cycle_ms <= 0 ||
+            (poll->func_code != MODBUS_FC_READ_HOLDING_REGISTERS &&
+             poll->func_code != MODBUS_FC_READ_INPUT_REGISTERS)) {
+            LOG_WARN("Invalid poll block (uart %d, fc %d, %d+%d), skip",
+                     poll->uart_idx, poll->func_code, poll->start, poll->quantity);
+            continue;
+        }
+        if (poll->slave_addr < 0) {
+            poll->slave_addr = poll->uart_idx;
+        }
+        mgr->polls[mgr->poll_count++] = *poll;
+    }
 
     mgr->uart_count = 0;
     for (int i = 0; i < uart_count; i++) {
@@ -333,14 +769,6 @@ UartMgr* uart_mgr_init(const char* config_path)
         mgr->uart_count++;
     }
 
-    mgr->epoll_fd = epoll_create1(0);
-    if(mgr->epoll_fd < 0) {
-        LOG_ERROR("Failed to creat epoll");
-        free(mgr);
-        return NULL;
-    }
-
-    struct epoll_event ev;
     for( int idx = 0; idx < MAX_UART_NUM; idx++){
         UartDev* uart = &mgr->uarts[idx];
         if(!uart->config.enable) {
@@ -353,15 +781,35 @@ UartMgr* uart_mgr_init(const char* config_path)
             continue;
         }
 
-        ev.events = EPOLLIN | EPOLLET;
-        ev.data.fd = uart->fd;
-        if(epoll_ctl(mgr->epoll_fd, EPOLL_CTL_ADD, uart->fd, &ev) < 0) {
-            LOG_ERROR("Failed to epoll_ctl add uart fd");
+        uart->reactor = uart_worker_reactor(mgr, uart);
+        if(reactor_add(uart->reactor, &uart->handler, uart->fd, EPOLLIN | EPOLLET, uart_read_handler, uart) < 0) {
+            LOG_ERROR("Failed to add uart fd to reactor");
             close(uart->fd);
             uart->fd = -1;
             continue;
         }
 
+        if (uart->config.modbus_enable) {
+            modbus_rtu_deframer_init(&uart->rtu, uart->config.baudrate);
+            if (reactor_timer_init(uart->reactor, &uart->rtu_timer, uart_rtu_timer_handler, uart) < 0) {
+                LOG_ERROR("Failed to create uart %d t3.5 timer", idx);
+                reactor_del(uart->reactor, &uart->handler);
+                close(uart->fd);
+                uart->fd = -1;
+                continue;
+            }
+        } else if (uart->config.splice_enable) {
+            if (pipe2(uart->pipe_fd, O_NONBLOCK | O_CLOEXEC) < 0) {
+                LOG_WARN("Create uart %d splice pipe failed: %s, use copy path", idx, strerror(errno));
+                uart->pipe_fd[0] = -1;
+                uart->pipe_fd[1] = -1;
+            }
+        }
+
+        if (reactor_timer_init(uart->reactor, &uart->config_timer, uart_config_timer_handler, uart) < 0) {
+            LOG_WARN("Create uart %d reconfig timer failed, settings fixed until restart", idx);
+        }
+
         LOG_INFO("UART %d init success: %s (baud:%d, data:%d, stop:%d, parity:%c)",
                 idx, uart->config.dev_path, uart->config.baudrate,
                 uart->config.databit, uart->config.stopbit, uart->config.parity);
@@ -370,6 +818,51 @@ UartMgr* uart_mgr_init(const char* config_path)
     return mgr;
 }
 
+/**
+ * Start worker threads of all thread groups (call once every handler is registered)
+ * @param mgr: Pointer to UartMgr instance
+ * @return Number of started workers, -1 on failure
+ */
+int uart_mgr_start_workers(UartMgr* mgr)
+{
+    if (!mgr) return -1;
+
+    int started = 0;
+    for (int g = 1; g <= MAX_UART_NUM; g++) {
+        if (!mgr->workers[g]) continue;
+
+        // First port of the group that sets worker_cpu decides the affinity
+        int cpu = -1;
+        for (int i = 0; i < MAX_UART_NUM && cpu < 0; i++) {
+            if (mgr->uarts[i].reactor == mgr->workers[g]) {
+                cpu = mgr->uarts[i].config.worker_cpu;
+            }
+        }
+
+        char name[16];
+        snprintf(name, sizeof(name), "bus-worker-%d", g);
+        if (reactor_start_thread(mgr->workers[g], name, cpu) != 0) {
+            uart_mgr_stop_workers(mgr);
+            return -1;
+        }
+        LOG_INFO("Worker %d started (cpu %d)", g, mgr->workers[g]->cpu);
+        started++;
+    }
+    return started;
+}
+
+/**
+ * Stop and join worker threads (ports stay registered in their worker loops)
+ * @param mgr: Pointer to UartMgr instance
+ */
+void uart_mgr_stop_workers(UartMgr* mgr)
+{
+    if (!mgr) return;
+    for (int g = 1; g <= MAX_UART_NUM; g++) {
+        reactor_join_thread(mgr->workers[g]);
+    }
+}
+
 /**
  * Destroy UART manager and release resources
  * @param mgr: Pointer to UartMgr instance
@@ -378,22 +871,233 @@ void uart_mgr_destroy(UartMgr* mgr)
 {
     if (!mgr) return;
     
+    uart_mgr_stop_workers(mgr);
+    if (mgr->watch_handler.fd >= 0) {
+        int fd = mgr->watch_handler.fd;
+        reactor_del(mgr->reactor, &mgr->watch_handler);
+        close(fd);
+    }
     for(int i = 0; i < MAX_UART_NUM; i++) {
+        reactor_timer_destroy(&mgr->uarts[i].rtu_timer);
+        reactor_timer_destroy(&mgr->uarts[i].config_timer);
+        uart_close_pipe(&mgr->uarts[i]);
         if(mgr->uarts[i].fd > 0) {
+            reactor_del(mgr->uarts[i].reactor, &mgr->uarts[i].handler);
             close(mgr->uarts[i].fd);
             mgr->uarts[i].fd = -1;
         }
     }
-
-    if(mgr->epoll_fd > 0) {
-        close(mgr->epoll_fd);
+    for (int g = 1; g <= MAX_UART_NUM; g++) {
+        reactor_destroy(mgr->workers[g]);
     }
 
+    pthread_mutex_destroy(&mgr->config_mutex);
     LOG_INFO("Uart manager destroyed");
 
     free(mgr);
 }
 
+/**
+ * Set consumer for spliced raw-port data (ports without it use on_rx)
+ * @param mgr: Pointer to UartMgr instance
+ * @param on_splice: Callback for data waiting in a splice pipe
+ * @param arg: Callback argument
+ */
+void uart_mgr_set_splice_handler(UartMgr* mgr, UartSpliceCallback on_splice, void* arg)
+{
+    if (!mgr) return;
+    mgr->on_splice = on_splice;
+    mgr->splice_arg = arg;
+}
+
+/**
+ * Set the user of a port notified around live reconfigurations (Modbus gateway)
+ * @param mgr: Pointer to UartMgr instance
+ * @param on_reconfig: Callback holding / releasing the port's queue
+ * @param arg: Callback argument
+ */
+void uart_mgr_set_reconfig_handler(UartMgr* mgr, UartReconfigCallback on_reconfig, void* arg)
+{
+    if (!mgr) return;
+    mgr->on_reconfig = on_reconfig;
+    mgr->reconfig_arg = arg;
+}
+
+/**
+ * Reconfigure an open port without restarting it (callable from any thread)
+ * The change is applied asynchronously by the thread owning the port once its queue is held
+ * and its output drained; other ports are not touched
+ * @param mgr: Pointer to UartMgr instance
+ * @param uart_idx: UART index (0 ~ MAX_UART_NUM-1)
+ * @param config: New configuration (only line settings, resp_timeout_ms and merge_* may differ)
+ * @return 0 if the change was queued, -1 on failure
+ */
+int uart_mgr_set_config(UartMgr* mgr, int uart_idx, const UartConfig* config)
+{
+    if (!mgr || !config || uart_idx < 0 || uart_idx >= MAX_UART_NUM) {
+        LOG_ERROR("Invalid params (uart_idx: %d)", uart_idx);
+        return -1;
+    }
+
+    UartDev* uart = &mgr->uarts[uart_idx];
+    if (uart->fd < 0 || uart->config_timer.handler.fd < 0) {
+        LOG_ERROR("UART %d not open, cannot reconfigure", uart_idx);
+        return -1;
+    }
+    if (uart_config_static_differs(&uart->config, config)) {
+        LOG_WARN("UART %d: only baudrate, databit, stopbit, parity, flow_ctrl, resp_timeout_ms and merge_* "
+                 "change at runtime, restart to apply the rest", uart_idx);
+        return -1;
+    }
+    if ((baudrate2bps(config->baudrate) == B115200 && config->baudrate != 115200) ||
+        config->databit < 5 || config->databit > 8 || (config->stopbit != 1 && config->stopbit != 2) ||
+        (config->parity != 'N' && config->parity != 'E' && config->parity != 'O')) {
+        LOG_WARN("UART %d: invalid line settings (baud:%d, data:%d, stop:%d, parity:%c)", uart_idx,
+                 config->baudrate, config->databit, config->stopbit, config->parity);
+        return -1;
+    }
+
+    pthread_mutex_lock(&mgr->config_mutex);
+    uart->config_next = *config;
+    uart->config_pending = 1;
+    pthread_mutex_unlock(&mgr->config_mutex);
+    return reactor_timer_start(&uart->config_timer, 0, 0);
+}
+
+/**
+ * Get the current configuration of a port (consistent while a reconfiguration is published)
+ * @param mgr: Pointer to UartMgr instance
+ * @param uart_idx: UART index (0 ~ MAX_UART_NUM-1)
+ * @param config: Output UartConfig
+ */
+void uart_mgr_get_config(UartMgr* mgr, int uart_idx, UartConfig* config)
+{
+    if (!mgr || uart_idx < 0 || uart_idx >= MAX_UART_NUM) {
+        memset(config, 0, sizeof(UartConfig));
+        return;
+    }
+
+    UartDev* uart = &mgr->uarts[uart_idx];
+    uint32_t seq;
+    do {
+        while ((seq = __atomic_load_n(&uart->config_seq, __ATOMIC_ACQUIRE)) & 1) {
+        }
+        memcpy(config, &uart->config, sizeof(UartConfig));
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    } while (__atomic_load_n(&uart->config_seq, __ATOMIC_RELAXED) != seq);
+}
+
+/**
+ * Re-read the config file and reconfigure the ports whose live settings changed
+ * Gateway-wide keys and settings fixed at startup keep their current values
+ * @param mgr: Pointer to UartMgr instance
+ * @return Number of ports being reconfigured, -1 on failure
+ */
+int uart_mgr_reload(UartMgr* mgr)
+{
+    if (!mgr) return -1;
+
+    UartConfig configs[MAX_UART_NUM];
+    memset(configs, 0, sizeof(configs));
+    int count = parse_uart_config(mgr->config_path, configs, MAX_UART_NUM, NULL);
+    if (count <= 0) {
+        LOG_ERROR("Reload %s failed, keep current settings", mgr->config_path);
+        return -1;
+    }
+
+    int changed = 0;
+    for (int i = 0; i < count && i < MAX_UART_NUM; i++) {
+        int idx = configs[i].idx;
+        if (idx < 0 || idx >= MAX_UART_NUM) continue;
+
+        UartConfig next;
+        uart_mgr_get_config(mgr, idx, &next);
+        if (uart_config_static_differs(&next, &configs[i])) {
+            LOG_WARN("UART %d: settings other than baudrate, databit, stopbit, parity, flow_ctrl, "
+                     "resp_timeout_ms and merge_* need a restart", idx);
+        }
+        if (mgr->uarts[idx].fd < 0 || !uart_config_live_differs(&next, &configs[i])) continue;
+
+        uart_config_copy_live(&next, &configs[i]);
+        if (uart_mgr_set_config(mgr, idx, &next) == 0) {
+            changed++;
+        }
+    }
+    LOG_INFO("Reloaded %s, %d port(s) to reconfigure", mgr->config_path, changed);
+    return changed;
+}
+
+/**
+ * Handle inotify events on the config directory (reload when the config file was rewritten)
+ * @param handler: Pointer to UartMgr.watch_handler
+ * @param events: Ready event mask
+ */
+static void uart_watch_handler(ReactorHandler* handler, uint32_t events)
+{
+    UartMgr* mgr = (UartMgr*)handler->ctx;
+    const char* name = strrchr(mgr->config_path, '/');
+    name = name ? name + 1 : mgr->config_path;
+
+    char buf[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+    int reload = 0;
+    ssize_t len;
+    while ((len = read(handler->fd, buf, sizeof(buf))) > 0) {
+        for (char* p = buf; p < buf + len; ) {
+            struct inotify_event* ev = (struct inotify_event*)p;
+            if (ev->len > 0 && strcmp(ev->name, name) == 0) {
+                reload = 1;
+            }
+            p += sizeof(struct inotify_event) + ev->len;
+        }
+    }
+
+    if (reload) {
+        LOG_INFO("%s changed, reload", mgr->config_path);
+        uart_mgr_reload(mgr);
+    }
+}
+
+/**
+ * Reload the config file whenever it is rewritten (watches its directory so that editors
+ * replacing the file by rename are seen too)
+ * @param mgr: Pointer to UartMgr instance
+ * @return 0 on success, -1 on failure
+ */
+int uart_mgr_watch_config(UartMgr* mgr)
+{
+    if (!mgr || mgr->watch_handler.fd >= 0) return -1;
+
+    char dir[sizeof(mgr->config_path)];
+    strncpy(dir, mgr->config_path, sizeof(dir) - 1);
+    dir[sizeof(dir) - 1] = '\0';
+    char* slash = strrchr(dir, '/');
+    if (!slash) {
+        strcpy(dir, ".");
+    } else if (slash == dir) {
+        slash[1] = '\0';
+    } else {
+        *slash = '\0';
+    }
+
+    int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd < 0) {
+        LOG_ERROR("inotify init failed: %s", strerror(errno));
+        return -1;
+    }
+    if (inotify_add_watch(fd, dir, IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+        LOG_ERROR("Watch %s failed: %s", dir, strerror(errno));
+        close(fd);
+        return -1;
+    }
+    if (reactor_add(mgr->reactor, &mgr->watch_handler, fd, EPOLLIN, uart_watch_handler, mgr) != 0) {
+        mgr->watch_handler.fd = -1;
+        close(fd);
+        return -1;
+    }
+    LOG_INFO("Watching %s for changes", mgr->config_path);
+    return 0;
+}
+
 /**
  * Write data to specified UART port
  * @param mgr: Pointer to UartMgr instance
@@ -417,28 +1121,141 @@ int uart_mgr_write(UartMgr* mgr, int uart_idx, const char* data, int len)
 
     ssize_t ret = write(uart->fd, data, len);
     if(ret > 0) {
-        uart->tx_bytes += ret;
-        LOG_INFO("%s Write %ld bytes success (total tx: %lu)", 
-                uart->config.dev_path, ret, uart->tx_bytes);
+        StatsCtrSlot* ctr = stats_ctr_begin(&uart->ctr);
+        stats_ctr_put(ctr, UART_CTR_TX_BYTES, ret);
+        if (!uart->config.modbus_enable) {
+            stats_ctr_put(ctr, UART_CTR_TX_COPY_BYTES, ret);
+        }
+        stats_ctr_end(ctr);
+        TRACE_FRAME(uart_idx, TRACE_UART_TX, 0, -1, 0, (const uint8_t*)data, (int)ret);
+        LOG_DEBUG("%s Write %ld bytes success", uart->config.dev_path, ret);
     } else {
-        uart->err_count++;
+        stats_ctr_add(&uart->ctr, UART_CTR_ERRORS, 1);
         LOG_ERROR("UART write error");
     }
     return (int)ret;
 }
 
 /**
- * Get UART device status
+ * Write raw-port data waiting in a pipe to a UART (pipe -> tty with splice(), copies if the device refuses)
  * @param mgr: Pointer to UartMgr instance
  * @param uart_idx: UART index (0 ~ MAX_UART_NUM-1)
- * @param status: Output UartDev structure
+ * @param pipe_fd: Read end of the pipe holding the data (bytes left in it are the caller's to drop)
+ * @param len: Length of data in the pipe
+ * @return Number of bytes written on success, -1 on failure
  */
-void uart_mgr_get_status(UartMgr* mgr, int uart_idx, UartDev* status) {
-    if (!mgr || !status || uart_idx < 0 || uart_idx >= MAX_UART_NUM) {
-        memset(status, 0, sizeof(UartDev));
-        return;
+int uart_mgr_write_splice(UartMgr* mgr, int uart_idx, int pipe_fd, int len)
+{
+    if(!mgr || pipe_fd < 0 || len <= 0 || uart_idx < 0 || uart_idx >= MAX_UART_NUM) {
+        LOG_ERROR("Invalid params (uart_idx: %d, len: %d)", uart_idx, len);
+        return -1;
+    }
+
+    UartDev* uart = &mgr->uarts[uart_idx];
+    if(uart->fd < 0 || !uart->config.enable) {
+        LOG_ERROR("%s not enabled or fd invalid", uart->config.dev_path);
+        return -1;
     }
-    memcpy(status, &mgr->uarts[uart_idx], sizeof(UartDev));
+
+    int done = 0;
+    while (!uart->tx_copy && uart->config.splice_enable && done < len) {
+        ssize_t ret = splice(pipe_fd, NULL, uart->fd, NULL, len - done, SPLICE_F_NONBLOCK);
+        if (ret > 0) {
+            done += (int)ret;
+            continue;
+        }
+        if (ret < 0 && errno == EINTR) continue;
+        if (ret < 0 && (errno == EINVAL || errno == ENOSYS) && done == 0) {
+            LOG_WARN("%s does not support splice, use copy path for TX", uart->config.dev_path);
+            __atomic_store_n(&uart->tx_copy, 1, __ATOMIC_RELAXED);
+            break;
+        }
+        if (done == 0) {
+            stats_ctr_add(&uart->ctr, UART_CTR_ERRORS, 1);
+            LOG_ERROR("%s splice write error: %s", uart->config.dev_path, strerror(errno));
+            return -1;
+        }
+        break;
+    }
+    if (done > 0) {
+        StatsCtrSlot* ctr = stats_ctr_begin(&uart->ctr);
+        stats_ctr_put(ctr, UART_CTR_TX_BYTES, done);
+        stats_ctr_put(ctr, UART_CTR_TX_SPLICE_BYTES, done);
+        stats_ctr_end(ctr);
+        LOG_DEBUG("%s Spliced %d bytes", uart->config.dev_path, done);
+        return done;
+    }
+
+    // Copy path: splice disabled or refused by the device
+    char buf[BUF_SIZE];
+    while (done < len) {
+        ssize_t got = read(pipe_fd, buf, len - done < (int)sizeof(buf) ? len - done : (int)sizeof(buf));
+        if (got < 0 && errno == EINTR) continue;
+        if (got <= 0) break;
+        int ret = uart_mgr_write(mgr, uart_idx, buf, (int)got);
+        if (ret <= 0) return done > 0 ? done : -1;
+        done += ret;
+        if (ret < got) break;
+    }
+    return done;
+}
+
+/**
+ * Get UART device status (any thread: never reads state the owning loop is updating unprotected)
+ * @param mgr: Pointer to UartMgr instance
+ * @param uart_idx: UART index (0 ~ MAX_UART_NUM-1)
+ * @param status: Output UartStatus structure
+ */
+void uart_mgr_get_status(UartMgr* mgr, int uart_idx, UartStatus* status)
+{
+    if (!status) return;
+    memset(status, 0, sizeof(UartStatus));
+    status->fd = -1;
+    if (!mgr || uart_idx < 0 || uart_idx >= MAX_UART_NUM) return;
+
+    UartDev* uart = &mgr->uarts[uart_idx];
+    uart_mgr_get_config(mgr, uart_idx, &status->config);
+    uart_mgr_get_counters(mgr, uart_idx, &status->counters);
+    status->t15_us = __atomic_load_n(&uart->rtu.t15_us, __ATOMIC_RELAXED);
+    status->t35_us = __atomic_load_n(&uart->rtu.t35_us, __ATOMIC_RELAXED);
+
+    // Set up by uart_mgr_init before any thread runs, fixed afterwards
+    status->fd = uart->fd;
+    status->splice_active = uart->pipe_fd[0] >= 0;
+    status->tx_splice_active = status->config.splice_enable && status->config.tcp_port > 0 &&
+                               !__atomic_load_n(&uart->tx_copy, __ATOMIC_RELAXED);
+    status->worker = uart->reactor && uart->reactor != mgr->reactor ? status->config.worker : 0;
+    status->worker_cpu = uart->reactor ? uart->reactor->cpu : -1;
+}
+
+/**
+ * Get traffic counters of a UART (consistent per updating thread, no lock on the data path)
+ * @param mgr: Pointer to UartMgr instance
+ * @param uart_idx: UART index (0 ~ MAX_UART_NUM-1)
+ * @param counters: Output UartCounters
+ */
+void uart_mgr_get_counters(UartMgr* mgr, int uart_idx, UartCounters* counters)
+{
+    memset(counters, 0, sizeof(UartCounters));
+    if (!mgr || uart_idx < 0 || uart_idx >= MAX_UART_NUM) return;
+
+    UartDev* uart = &mgr->uarts[uart_idx];
+    uint64_t v[UART_CTR_NUM];
+    stats_ctr_snapshot(&uart->ctr, v, UART_CTR_NUM);
+    counters->rx_bytes = v[UART_CTR_RX_BYTES];
+    counters->tx_bytes = v[UART_CTR_TX_BYTES];
+    counters->err_count = v[UART_CTR_ERRORS];
+    counters->rx_splice_bytes = v[UART_CTR_RX_SPLICE_BYTES];
+    counters->rx_copy_bytes = v[UART_CTR_RX_COPY_BYTES];
+    counters->tx_splice_bytes = v[UART_CTR_TX_SPLICE_BYTES];
+    counters->tx_copy_bytes = v[UART_CTR_TX_COPY_BYTES];
+
+    uint64_t rtu[MODBUS_RTU_CTR_NUM];
+    stats_ctr_snapshot(&uart->rtu.ctr, rtu, MODBUS_RTU_CTR_NUM);
+    counters->rtu_frames = rtu[MODBUS_RTU_CTR_FRAMES];
+    counters->rtu_frame_err = rtu[MODBUS_RTU_CTR_FRAME_ERR];
+    counters->rtu_crc_err = rtu[MODBUS_RTU_CTR_CRC_ERR];
+    counters->rtu_overrun_err = rtu[MODBUS_RTU_CTR_OVERRUN_ERR];
 }
 
 /**
@@ -468,7 +1285,7 @@ int modbus_rtu_frame_write(UartMgr* mgr, int uart_idx, const ModbusRTUFrame* rtu
         LOG_ERROR("Invalid input params");
         return -1;
     }
-    if (rtu_frame->data_len > (MODBUS_MAX_FRAME_LEN - 3)) {
+    if (rtu_frame->data_len > (MODBUS_MAX_FRAME_LEN - 4)) {
         LOG_ERROR("Modbus RTU frame data len exceed max");
         return -1;
     }
@@ -477,7 +1294,8 @@ int modbus_rtu_frame_write(UartMgr* mgr, int uart_idx, const ModbusRTUFrame* rtu
         return -2;
     }
 */
-    static uint8_t send_buf[MODBUS_MAX_FRAME_LEN] = {0};
+    // Per call: buses on different worker threads write at the same time
+    uint8_t send_buf[MODBUS_MAX_FRAME_LEN];
     int total_send_len = 1 + 1 + rtu_frame->data_len + 2;
     int offset = 0;
 
@@ -485,8 +1303,9 @@ int modbus_rtu_frame_write(UartMgr* mgr, int uart_idx, const ModbusRTUFrame* rtu
     send_buf[offset++] = rtu_frame->func_code;
     memcpy(&send_buf[offset], rtu_frame->data, rtu_frame->data_len);
     offset += rtu_frame->data_len;
-    send_buf[offset++] = rtu_frame->crc & 0xFF;  
-    send_buf[offset++] = (rtu_frame->crc >> 8) & 0xFF; 
+    // modbus_crc16 returns the CRC byte-swapped: high byte is sent first (CRC low byte on the wire)
+    send_buf[offset++] = (rtu_frame->crc >> 8) & 0xFF;
+    send_buf[offset++] = rtu_frame->crc & 0xFF;
 
     UartDev* uart = &mgr->uarts[uart_idx];
     if(uart->fd < 0 || !uart->config.enable) {
@@ -496,11 +1315,11 @@ int modbus_rtu_frame_write(UartMgr* mgr, int uart_idx, const ModbusRTUFrame* rtu
 
     ssize_t ret = write(uart->fd, send_buf, total_send_len);
     if(ret > 0) {
-        uart->tx_bytes += ret;
-        LOG_INFO("%s Write %ld bytes success (total tx: %lu)", 
-                uart->config.dev_path, ret, uart->tx_bytes);
+        stats_ctr_add(&uart->ctr, UART_CTR_TX_BYTES, ret);
+        TRACE_FRAME(uart_idx, TRACE_UART_TX, TRACE_FLAG_RTU, -1, 0, send_buf, (int)ret);
+        LOG_DEBUG("%s Write %ld bytes success", uart->config.dev_path, ret);
     } else {
-        uart->err_count++;
+        stats_ctr_add(&uart->ctr, UART_CTR_ERRORS, 1);
         LOG_ERROR("UART write error");
     }
     return (int)ret;
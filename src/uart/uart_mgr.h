@@ -10,14 +10,23 @@
 #include <termios.h>
 #include <errno.h>
 #include <sys/epoll.h>
+#include <sys/ioctl.h>
+#include <sys/inotify.h>
 #include <string.h>
+#include <pthread.h>
 #include <yaml.h>
 #include "../modbus/modbus_core.h"
+#include "../modbus/modbus_rtu.h"
+#include "../reactor/reactor.h"
 
 // Global constants for UART management
 #define MAX_UART_NUM 17          // Maximum number of UART devices supported
 #define BUF_SIZE 1024            // Default buffer size for UART data transmission/reception
-#define EPOLL_MAX_EVENTS 32      // Max epoll events to monitor for UART read/write
+#define MAX_POLL_BLOCKS 64       // Maximum number of register blocks polled by the gateway
+#define POLL_DEFAULT_CYCLE_MS 1000 // Poll cycle if the block sets none
+#define MAX_UPSTREAMS 8          // Maximum number of collectors in the upstreams section
+#define UART_RECONFIG_POLL_US 1000     // Retry period while a port being reconfigured is busy
+#define UART_RECONFIG_MAX_WAIT_MS 5000 // Apply anyway once a port stayed busy this long
 
 // Configuration structure for UART device parameters (parsed from YAML config file)
 typedef struct {
@@ -30,31 +39,164 @@ typedef struct {
     int flow_ctrl;
     int enable;
     int modbus_enable;
+    int resp_timeout_ms;         // Modbus response timeout (0 = default)
+    int splice_enable;           // Raw port: move RX data to sockets with splice()
+    int cache_ttl_ms;            // Modbus FC03/FC04 response cache TTL (0 = disabled)
+    int merge_max_regs;          // Merge queued adjacent reads up to this many registers (0 = disabled)
+    int merge_gap;               // Max unrequested registers between merged reads
+    int worker;                  // Modbus bus I/O thread group (0 = main event loop, 1~MAX_UART_NUM)
+    int worker_cpu;              // CPU the worker thread is pinned to (-1 = any)
+    int queue_depth;             // Max outstanding Modbus transactions (0 = MODBUS_GW_MAX_PENDING)
+    int tcp_port;                // Own TCP listener of the port (0 = shared port, unit ID selects the UART)
 } UartConfig;
 
-// Runtime status structure for a single UART device
+// Reconfiguration step reported to the port's user (see UartReconfigCallback)
+typedef enum {
+    UART_RECONFIG_HOLD,          // Stop writing to the port, return 1 once nothing is in flight
+    UART_RECONFIG_RELEASE        // New settings are active, resume
+} UartReconfigPhase;
+
+// Register block polled by the gateway itself (parsed from the poll_list section)
+typedef struct {
+    int uart_idx;
+    int slave_addr;              // -1 in YAML = same as uart_idx (unit ID routing)
+    int func_code;               // 0x03 / 0x04
+    int start;
+    int quantity;
+    int cycle_ms;                // Poll period
+    int priority;                // 0 = highest, due blocks are queued in priority order
+} UartPollConfig;
+
+// Collector the gateway dials out to (parsed from the upstreams section, "host:port")
+typedef struct {
+    char host[64];
+    int port;
+} UartUpstreamConfig;
+
+// Traffic counters of a UART (index into UartDev.ctr)
+typedef enum {
+    UART_CTR_RX_BYTES,
+    UART_CTR_TX_BYTES,
+    UART_CTR_ERRORS,
+    UART_CTR_RX_SPLICE_BYTES,    // RX bytes moved through the pipe (never copied to user space)
+    UART_CTR_RX_COPY_BYTES,      // RX bytes of raw ports read into user space
+    UART_CTR_TX_SPLICE_BYTES,    // TX bytes moved from a socket pipe (never copied to user space)
+    UART_CTR_TX_COPY_BYTES,      // TX bytes of raw ports written from user space
+    UART_CTR_NUM
+} UartCtr;
+
+// Consistent snapshot of the UART and RTU deframer counters
 typedef struct {
-    int fd;
-    UartConfig config;
     uint64_t rx_bytes;
     uint64_t tx_bytes;
-    uint32_t err_count;
+    uint64_t err_count;
+    uint64_t rx_splice_bytes;
+    uint64_t rx_copy_bytes;
+    uint64_t tx_splice_bytes;
+    uint64_t tx_copy_bytes;
+    uint64_t rtu_frames;
+    uint64_t rtu_frame_err;
+    uint64_t rtu_crc_err;
+    uint64_t rtu_overrun_err;
+} UartCounters;
+
+// Status snapshot of a UART (built from seqlock / atomic reads, safe while the port is in use)
+typedef struct {
+    UartConfig config;
+    UartCounters counters;
+    int fd;                      // -1 = port not open
+    uint32_t t15_us;             // RTU inter-character timeout in use
+    uint32_t t35_us;             // RTU end-of-frame silence in use
+    int splice_active;           // Raw port RX goes through the splice pipe
+    int tx_splice_active;        // Raw port TX from its own listener is spliced (device accepts splice)
+    int worker;                  // Thread group owning the port (0 = main event loop)
+    int worker_cpu;              // CPU the owning loop is pinned to (-1 = any)
+} UartStatus;
+
+// Runtime status structure for a single UART device
+typedef struct UartDev {
+    int fd;
+    UartConfig config;
+    StatsCounters ctr;           // UartCtr, updated by whichever thread reads / writes the port
+    ModbusRtuDeframer rtu;       // RTU response deframer (modbus_enable ports)
+    ReactorTimer rtu_timer;      // t3.5 end-of-frame timer
+    ReactorHandler handler;      // Event source in the reactor (data.ptr)
+    Reactor* reactor;            // Event loop owning the port (main loop or its worker)
+    int pipe_fd[2];              // splice pipe (raw ports), -1 = copy path
+    int tx_copy;                 // Device refused splice() of TX data, uart_mgr_write_splice copies
+    uint32_t config_seq;         // Seqlock of the live config fields (odd while they are rewritten)
+    UartConfig config_next;      // Requested config (UartMgr.config_mutex)
+    int config_pending;          // config_next waits for the port to go idle
+    uint64_t hold_start_ns;      // When the pending reconfiguration started holding the port
+    ReactorTimer config_timer;   // Applies config_next on the owning thread
+    struct UartMgr* mgr;
 } UartDev;
 
+// Callback for data read from a UART (called on the reactor thread)
+// Modbus ports deliver one validated RTU frame per call, raw ports deliver bytes as read
+typedef void (*UartRxCallback)(UartDev* uart, const uint8_t* data, int len, void* arg);
+
+// Callback for raw-port data spliced into uart->pipe_fd (called on the reactor thread)
+// len bytes are waiting in pipe_fd; bytes still in the pipe when it returns are dropped
+typedef void (*UartSpliceCallback)(UartDev* uart, int pipe_fd, int len, void* arg);
+
+// Callback around a live reconfiguration (called on the reactor thread owning the port)
+// HOLD is repeated every UART_RECONFIG_POLL_US until it returns 1, RELEASE follows once applied
+typedef int (*UartReconfigCallback)(UartDev* uart, UartReconfigPhase phase, void* arg);
+
 // Manager structure for global UART device management
-typedef struct {
+typedef struct UartMgr {
     UartDev uarts[MAX_UART_NUM];
-    int epoll_fd;
+    Reactor* reactor;
+    Reactor* workers[MAX_UART_NUM + 1];  // Worker event loop per thread group (index 0 unused)
+    UartRxCallback on_rx;
+    void* rx_arg;
+    UartSpliceCallback on_splice;
+    void* splice_arg;
+    UartReconfigCallback on_reconfig;
+    void* reconfig_arg;
+    pthread_mutex_t config_mutex; // Guards config_next / config_pending of every port
+    char config_path[256];       // YAML file the ports were configured from (reload source)
+    ReactorHandler watch_handler; // inotify on the directory of config_path
     int uart_count;
+    UartPollConfig polls[MAX_POLL_BLOCKS];
+    int poll_count;
+    int server_port;             // Shared Modbus TCP port (root key server_port, 0 = TCP_PORT)
+    int metrics_port;            // Prometheus endpoint on 127.0.0.1 (root key metrics_port, 0 = off)
+    int max_clients;             // Connected TCP client limit (root key max_clients, 0 = default)
+    int listen_backlog;          // TCP listen backlog (root key listen_backlog, 0 = default)
+    int udp_port;                // Modbus/UDP port (root key udp_port, 0 = off)
+    UartUpstreamConfig upstreams[MAX_UPSTREAMS];
+    int upstream_count;
 } UartMgr;
 
-UartMgr* uart_mgr_init(const char* config_path);
+UartMgr* uart_mgr_init(const char* config_path, Reactor* reactor, UartRxCallback on_rx, void* arg);
 
 void uart_mgr_destroy(UartMgr* mgr);
 
+void uart_mgr_set_splice_handler(UartMgr* mgr, UartSpliceCallback on_splice, void* arg);
+
+void uart_mgr_set_reconfig_handler(UartMgr* mgr, UartReconfigCallback on_reconfig, void* arg);
+
+int uart_mgr_set_config(UartMgr* mgr, int uart_idx, const UartConfig* config);
+
+void uart_mgr_get_config(UartMgr* mgr, int uart_idx, UartConfig* config);
+
+int uart_mgr_reload(UartMgr* mgr);
+
+int uart_mgr_watch_config(UartMgr* mgr);
+
+int uart_mgr_start_workers(UartMgr* mgr);
+
+void uart_mgr_stop_workers(UartMgr* mgr);
+
 int uart_mgr_write(UartMgr* mgr, int uart_idx, const char* data, int len);
 
-void uart_mgr_get_status(UartMgr* mgr, int uart_idx, UartDev* status);
+int uart_mgr_write_splice(UartMgr* mgr, int uart_idx, int pipe_fd, int len);
+
+void uart_mgr_get_status(UartMgr* mgr, int uart_idx, UartStatus* status);
+
+void uart_mgr_get_counters(UartMgr* mgr, int uart_idx, UartCounters* counters);
 
 UartDev* uart_mgr_get_uart_by_idx(UartMgr* mgr, int uart_idx);
 